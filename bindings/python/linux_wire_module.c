@@ -0,0 +1,954 @@
+/*
+ * CPython bindings for the linux-wire C core.
+ *
+ *   import linux_wire
+ *   bus = linux_wire.Bus("/dev/i2c-1")
+ *   buf = bytearray(6)
+ *   bus.read_into(0x68, buf, reg=0x3B)
+ *
+ * Every transfer reads into, or writes from, the caller's own buffer
+ * (bytearray, memoryview, array.array, numpy array: anything exporting a
+ * C-contiguous buffer) without an intermediate copy, and runs with the
+ * GIL released, so threads driving different buses overlap.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include "linux_wire.h"
+#include "linux_wire_broker.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    lw_i2c_bus bus;
+    lw_broker_client client;
+    int open;
+    int brokered;
+    /* Serializes calls made with the GIL released, and close() */
+    PyThread_type_lock lock;
+} BusObject;
+
+typedef struct
+{
+    PyObject_HEAD
+    BusObject *owner;
+    Py_buffer view;
+    lw_prepared prep;
+} PreparedObject;
+
+static PyTypeObject Bus_Type;
+static PyTypeObject Prepared_Type;
+
+/* Take the bus lock without holding the GIL; fails if the bus is closed */
+static int bus_enter(BusObject *self)
+{
+    if (!self->open)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed bus");
+        return -1;
+    }
+    if (!PyThread_acquire_lock(self->lock, NOWAIT_LOCK))
+    {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+    if (!self->open)
+    {
+        PyThread_release_lock(self->lock);
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed bus");
+        return -1;
+    }
+    return 0;
+}
+
+static void bus_leave(BusObject *self)
+{
+    PyThread_release_lock(self->lock);
+}
+
+/* Big-endian register bytes, as lw_gather_read() and lw_prepare_read() send them */
+static int reg_bytes(unsigned long reg, int reg_len, uint8_t out[4])
+{
+    if (reg_len < 1 || reg_len > 4)
+    {
+        PyErr_SetString(PyExc_ValueError, "reg_len must be 1-4");
+        return -1;
+    }
+    if (reg_len < 4 && reg >> (8 * reg_len) != 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "reg does not fit in reg_len bytes");
+        return -1;
+    }
+    for (int i = 0; i < reg_len; ++i)
+    {
+        out[i] = (uint8_t)(reg >> (8 * (reg_len - 1 - i)));
+    }
+    return 0;
+}
+
+/* Optional `reg` argument: None for no register write */
+static int parse_reg(PyObject *reg, int reg_len, uint8_t out[4], size_t *len)
+{
+    *len = 0;
+    if (reg == NULL || reg == Py_None)
+    {
+        return 0;
+    }
+    const unsigned long value = PyLong_AsUnsignedLong(reg);
+    if (value == (unsigned long)-1 && PyErr_Occurred())
+    {
+        return -1;
+    }
+    if (reg_bytes(value, reg_len, out) != 0)
+    {
+        return -1;
+    }
+    *len = (size_t)reg_len;
+    return 0;
+}
+
+/* "O&" converter for 16-bit fields; "H" would silently truncate */
+static int u16_converter(PyObject *obj, void *out)
+{
+    const long value = PyLong_AsLong(obj);
+    if (value == -1 && PyErr_Occurred())
+    {
+        return 0;
+    }
+    if (value < 0 || value > UINT16_MAX)
+    {
+        PyErr_SetString(PyExc_ValueError, "value out of range 0-65535");
+        return 0;
+    }
+    *(uint16_t *)out = (uint16_t)value;
+    return 1;
+}
+
+static int check_len(Py_ssize_t len)
+{
+    if (len > UINT16_MAX)
+    {
+        PyErr_SetString(PyExc_ValueError, "buffer longer than 65535 bytes");
+        return -1;
+    }
+    return 0;
+}
+
+static int Bus_init(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"path", NULL};
+    PyObject *path_arg;
+    PyObject *path = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &path_arg) ||
+        !PyUnicode_FSConverter(path_arg, &path))
+    {
+        return -1;
+    }
+    if (self->open)
+    {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_ValueError, "bus is already open");
+        return -1;
+    }
+
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = lw_open_bus(&self->bus, PyBytes_AS_STRING(path));
+    Py_END_ALLOW_THREADS
+    if (rc != 0)
+    {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_arg);
+        Py_DECREF(path);
+        return -1;
+    }
+    Py_DECREF(path);
+
+    /* Errors surface as exceptions; perror output would only duplicate them */
+    lw_set_error_logging(&self->bus, 0);
+    self->open = 1;
+    return 0;
+}
+
+static PyObject *Bus_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    (void)args;
+    (void)kwds;
+    BusObject *self = (BusObject *)type->tp_alloc(type, 0);
+    if (!self)
+    {
+        return NULL;
+    }
+    self->bus.fd = -1;
+    self->lock = PyThread_allocate_lock();
+    if (!self->lock)
+    {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)self;
+}
+
+static void bus_close_locked(BusObject *self)
+{
+    if (self->brokered)
+    {
+        lw_broker_disconnect(&self->client);
+    }
+    else
+    {
+        lw_close_bus(&self->bus);
+    }
+    self->open = 0;
+    self->brokered = 0;
+}
+
+static void Bus_dealloc(BusObject *self)
+{
+    if (self->open)
+    {
+        bus_close_locked(self);
+    }
+    if (self->lock)
+    {
+        PyThread_free_lock(self->lock);
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyDoc_STRVAR(Bus_connect_doc,
+             "connect(socket_path) -> Bus\n\n"
+             "Open a bus served by linux-wire-brokerd instead of a local adapter.");
+
+static PyObject *Bus_connect(PyTypeObject *type, PyObject *args)
+{
+    PyObject *path_arg;
+    PyObject *path = NULL;
+    if (!PyArg_ParseTuple(args, "O:connect", &path_arg) || !PyUnicode_FSConverter(path_arg, &path))
+    {
+        return NULL;
+    }
+    BusObject *self = (BusObject *)Bus_new(type, NULL, NULL);
+    if (!self)
+    {
+        Py_DECREF(path);
+        return NULL;
+    }
+
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = lw_broker_connect(&self->client, &self->bus, PyBytes_AS_STRING(path));
+    Py_END_ALLOW_THREADS
+    if (rc != 0)
+    {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_arg);
+        Py_DECREF(path);
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_DECREF(path);
+
+    lw_set_error_logging(&self->bus, 0);
+    self->open = 1;
+    self->brokered = 1;
+    return (PyObject *)self;
+}
+
+PyDoc_STRVAR(Bus_close_doc,
+             "close()\n\n"
+             "Close the bus. Waits for a transfer running in another thread.");
+
+static PyObject *Bus_close(BusObject *self, PyObject *unused)
+{
+    (void)unused;
+    if (self->open)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+        if (self->open)
+        {
+            bus_close_locked(self);
+        }
+        PyThread_release_lock(self->lock);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *Bus_enter(BusObject *self, PyObject *unused)
+{
+    (void)unused;
+    if (!self->open)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed bus");
+        return NULL;
+    }
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *Bus_exit(BusObject *self, PyObject *args)
+{
+    (void)args;
+    return Bus_close(self, NULL);
+}
+
+PyDoc_STRVAR(Bus_read_into_doc,
+             "read_into(addr, buf, reg=None, reg_len=1) -> int\n\n"
+             "Fill the writable buffer `buf` from device `addr`. With `reg`, the\n"
+             "register address is written first (big-endian, `reg_len` bytes) and\n"
+             "the read follows with a repeated START. Returns the bytes read.");
+
+static PyObject *Bus_read_into(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "buf", "reg", "reg_len", NULL};
+    uint16_t addr;
+    Py_buffer view;
+    PyObject *reg = NULL;
+    int reg_len = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&w*|Oi:read_into", kwlist,
+                                     u16_converter, &addr, &view, &reg, &reg_len))
+    {
+        return NULL;
+    }
+
+    uint8_t iaddr[4];
+    size_t iaddr_len;
+    if (parse_reg(reg, reg_len, iaddr, &iaddr_len) != 0 || bus_enter(self) != 0)
+    {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    ssize_t n;
+    Py_BEGIN_ALLOW_THREADS
+    n = lw_ioctl_read(&self->bus, addr, iaddr_len ? iaddr : NULL, iaddr_len,
+                      (uint8_t *)view.buf, (size_t)view.len, 0);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+    PyBuffer_Release(&view);
+
+    if (n < 0)
+    {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    return PyLong_FromSsize_t(n);
+}
+
+PyDoc_STRVAR(Bus_read_doc,
+             "read(addr, length, reg=None, reg_len=1) -> bytes\n\n"
+             "Like read_into(), returning a new bytes object.");
+
+static PyObject *Bus_read(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "length", "reg", "reg_len", NULL};
+    uint16_t addr;
+    Py_ssize_t length;
+    PyObject *reg = NULL;
+    int reg_len = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&n|Oi:read", kwlist,
+                                     u16_converter, &addr, &length, &reg, &reg_len))
+    {
+        return NULL;
+    }
+    if (length < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "length must not be negative");
+        return NULL;
+    }
+
+    uint8_t iaddr[4];
+    size_t iaddr_len;
+    if (parse_reg(reg, reg_len, iaddr, &iaddr_len) != 0)
+    {
+        return NULL;
+    }
+    PyObject *out = PyBytes_FromStringAndSize(NULL, length);
+    if (!out)
+    {
+        return NULL;
+    }
+    if (bus_enter(self) != 0)
+    {
+        Py_DECREF(out);
+        return NULL;
+    }
+
+    ssize_t n;
+    Py_BEGIN_ALLOW_THREADS
+    n = lw_ioctl_read(&self->bus, addr, iaddr_len ? iaddr : NULL, iaddr_len,
+                      (uint8_t *)PyBytes_AS_STRING(out), (size_t)length, 0);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+
+    if (n < 0)
+    {
+        Py_DECREF(out);
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    if (n != length && _PyBytes_Resize(&out, n) != 0)
+    {
+        return NULL;
+    }
+    return out;
+}
+
+PyDoc_STRVAR(Bus_write_doc,
+             "write(addr, data, reg=None, reg_len=1) -> int\n\n"
+             "Write the bytes-like `data` to device `addr`, preceded by the\n"
+             "register address when `reg` is given, in one message. Returns the\n"
+             "payload bytes written.");
+
+static PyObject *Bus_write(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "data", "reg", "reg_len", NULL};
+    uint16_t addr;
+    Py_buffer view;
+    PyObject *reg = NULL;
+    int reg_len = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&y*|Oi:write", kwlist,
+                                     u16_converter, &addr, &view, &reg, &reg_len))
+    {
+        return NULL;
+    }
+
+    uint8_t iaddr[4];
+    size_t iaddr_len;
+    if (parse_reg(reg, reg_len, iaddr, &iaddr_len) != 0 || bus_enter(self) != 0)
+    {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    ssize_t n;
+    Py_BEGIN_ALLOW_THREADS
+    n = lw_ioctl_write(&self->bus, addr, iaddr_len ? iaddr : NULL, iaddr_len,
+                       (const uint8_t *)view.buf, (size_t)view.len, 0);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+    PyBuffer_Release(&view);
+
+    if (n < 0)
+    {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    return PyLong_FromSsize_t(n);
+}
+
+PyDoc_STRVAR(Bus_transfer_doc,
+             "transfer(msgs) -> int\n\n"
+             "Run a list of (addr, flags, buf) messages as one combined\n"
+             "transaction with repeated STARTs. Messages with MSG_RD in `flags`\n"
+             "are read into `buf`, which must then be writable. At most MAX_MSGS\n"
+             "messages. Returns the number of messages.");
+
+static PyObject *Bus_transfer(BusObject *self, PyObject *args)
+{
+    PyObject *seq_arg;
+    if (!PyArg_ParseTuple(args, "O:transfer", &seq_arg))
+    {
+        return NULL;
+    }
+    PyObject *seq = PySequence_Fast(seq_arg, "msgs must be a sequence");
+    if (!seq)
+    {
+        return NULL;
+    }
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+    if (count > LW_MAX_MSGS)
+    {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "at most %d messages", LW_MAX_MSGS);
+        return NULL;
+    }
+
+    Py_buffer views[LW_MAX_MSGS];
+    lw_msg msgs[LW_MAX_MSGS];
+    Py_ssize_t held = 0;
+    PyObject *result = NULL;
+
+    for (; held < count; ++held)
+    {
+        uint16_t addr;
+        uint16_t flags;
+        PyObject *buf;
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, held);
+        if (!PyTuple_Check(item) ||
+            !PyArg_ParseTuple(item, "O&O&O;msgs items are (addr, flags, buf)",
+                              u16_converter, &addr, u16_converter, &flags, &buf))
+        {
+            if (!PyErr_Occurred())
+            {
+                PyErr_SetString(PyExc_TypeError, "msgs items are (addr, flags, buf)");
+            }
+            goto out;
+        }
+        const int want = (flags & LW_MSG_RD) ? PyBUF_WRITABLE : PyBUF_SIMPLE;
+        if (PyObject_GetBuffer(buf, &views[held], want) != 0)
+        {
+            goto out;
+        }
+        if (check_len(views[held].len) != 0)
+        {
+            PyBuffer_Release(&views[held]);
+            goto out;
+        }
+        msgs[held].addr = addr;
+        msgs[held].flags = flags;
+        msgs[held].len = (uint16_t)views[held].len;
+        msgs[held].buf = (uint8_t *)views[held].buf;
+    }
+
+    if (bus_enter(self) != 0)
+    {
+        goto out;
+    }
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = lw_transfer(&self->bus, msgs, (size_t)count);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+    result = rc < 0 ? PyErr_SetFromErrno(PyExc_OSError) : PyLong_FromLong(rc);
+
+out:
+    for (Py_ssize_t i = 0; i < held; ++i)
+    {
+        PyBuffer_Release(&views[i]);
+    }
+    Py_DECREF(seq);
+    return result;
+}
+
+PyDoc_STRVAR(Bus_gather_read_doc,
+             "gather_read(addr, items, reg_len=1) -> int\n\n"
+             "Read several register blocks of one device in a single transaction.\n"
+             "`items` is a list of (reg, buf) pairs; each writable `buf` is filled\n"
+             "from `reg`. At most GATHER_MAX items. Returns the total bytes read.");
+
+static PyObject *Bus_gather_read(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "items", "reg_len", NULL};
+    uint16_t addr;
+    PyObject *items_arg;
+    int reg_len = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O|i:gather_read", kwlist,
+                                     u16_converter, &addr, &items_arg, &reg_len))
+    {
+        return NULL;
+    }
+    uint8_t unused[4];
+    if (reg_bytes(0, reg_len, unused) != 0)
+    {
+        return NULL;
+    }
+    PyObject *seq = PySequence_Fast(items_arg, "items must be a sequence");
+    if (!seq)
+    {
+        return NULL;
+    }
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+    if (count > LW_GATHER_MAX)
+    {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "at most %d items", LW_GATHER_MAX);
+        return NULL;
+    }
+
+    Py_buffer views[LW_GATHER_MAX];
+    lw_gather_item items[LW_GATHER_MAX];
+    Py_ssize_t held = 0;
+    PyObject *result = NULL;
+
+    for (; held < count; ++held)
+    {
+        unsigned long reg;
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, held);
+        if (!PyTuple_Check(item) ||
+            !PyArg_ParseTuple(item, "kw*;items are (reg, buf)", &reg, &views[held]))
+        {
+            if (!PyErr_Occurred())
+            {
+                PyErr_SetString(PyExc_TypeError, "items are (reg, buf)");
+            }
+            goto out;
+        }
+        if (check_len(views[held].len) != 0 || reg_bytes(reg, reg_len, unused) != 0)
+        {
+            PyBuffer_Release(&views[held]);
+            goto out;
+        }
+        items[held].reg = (uint32_t)reg;
+        items[held].reg_len = (uint8_t)reg_len;
+        items[held].len = (uint16_t)views[held].len;
+        items[held].dst = (uint8_t *)views[held].buf;
+    }
+
+    if (bus_enter(self) != 0)
+    {
+        goto out;
+    }
+    ssize_t n;
+    Py_BEGIN_ALLOW_THREADS
+    n = lw_gather_read(&self->bus, addr, items, (size_t)count);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+    result = n < 0 ? PyErr_SetFromErrno(PyExc_OSError) : PyLong_FromSsize_t(n);
+
+out:
+    for (Py_ssize_t i = 0; i < held; ++i)
+    {
+        PyBuffer_Release(&views[i]);
+    }
+    Py_DECREF(seq);
+    return result;
+}
+
+PyDoc_STRVAR(Bus_scan_doc,
+             "scan(first=0x08, last=0x77) -> list\n\n"
+             "Addresses in [first, last] that acknowledge a probe (a zero-length\n"
+             "write, or a one-byte read on adapters that refuse it).");
+
+static PyObject *Bus_scan(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"first", "last", NULL};
+    uint16_t first = 0x08;
+    uint16_t last = 0x77;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&O&:scan", kwlist,
+                                     u16_converter, &first, u16_converter, &last))
+    {
+        return NULL;
+    }
+    if (first > last || last > 0x7F)
+    {
+        PyErr_SetString(PyExc_ValueError, "need first <= last <= 0x7F");
+        return NULL;
+    }
+    if (bus_enter(self) != 0)
+    {
+        return NULL;
+    }
+
+    uint8_t found[0x80];
+    size_t nfound = 0;
+    int err = 0;
+    Py_BEGIN_ALLOW_THREADS
+    for (unsigned int addr = first; addr <= last; ++addr)
+    {
+        if (lw_wait_ready(&self->bus, (uint16_t)addr, 0, 0, 0) == 0)
+        {
+            found[nfound++] = (uint8_t)addr;
+        }
+        else if (errno != ETIMEDOUT)
+        {
+            err = errno;
+            break;
+        }
+    }
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+
+    if (err != 0)
+    {
+        errno = err;
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    PyObject *list = PyList_New((Py_ssize_t)nfound);
+    if (!list)
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < nfound; ++i)
+    {
+        PyObject *value = PyLong_FromLong(found[i]);
+        if (!value)
+        {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, value);
+    }
+    return list;
+}
+
+PyDoc_STRVAR(Bus_wait_ready_doc,
+             "wait_ready(addr, timeout_us, interval_us=1000, spin=False)\n\n"
+             "ACK-poll `addr` until it responds. Raises TimeoutError after\n"
+             "`timeout_us`.");
+
+static PyObject *Bus_wait_ready(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "timeout_us", "interval_us", "spin", NULL};
+    uint16_t addr;
+    unsigned int timeout_us;
+    unsigned int interval_us = 1000;
+    int spin = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&I|Ip:wait_ready", kwlist,
+                                     u16_converter, &addr, &timeout_us, &interval_us, &spin))
+    {
+        return NULL;
+    }
+    if (bus_enter(self) != 0)
+    {
+        return NULL;
+    }
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = lw_wait_ready(&self->bus, addr, timeout_us, interval_us, spin ? LW_WAIT_SPIN : 0);
+    Py_END_ALLOW_THREADS
+    bus_leave(self);
+    if (rc != 0)
+    {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(Bus_prepare_read_doc,
+             "prepare_read(addr, reg, buf, reg_len=1) -> Prepared\n\n"
+             "Validate a register read into `buf` once. Prepared.exec() then\n"
+             "refills `buf` with a single ioctl and no argument parsing, for tight\n"
+             "polling loops. `buf` stays exported (so it cannot be resized) until\n"
+             "the Prepared object is released.");
+
+static PyObject *Bus_prepare_read(BusObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"addr", "reg", "buf", "reg_len", NULL};
+    uint16_t addr;
+    unsigned long reg;
+    PyObject *buf;
+    int reg_len = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&kO|i:prepare_read", kwlist,
+                                     u16_converter, &addr, &reg, &buf, &reg_len))
+    {
+        return NULL;
+    }
+    uint8_t unused[4];
+    if (reg_bytes(reg, reg_len, unused) != 0)
+    {
+        return NULL;
+    }
+    PreparedObject *prep = PyObject_New(PreparedObject, &Prepared_Type);
+    if (!prep)
+    {
+        return NULL;
+    }
+    prep->owner = NULL;
+    if (PyObject_GetBuffer(buf, &prep->view, PyBUF_WRITABLE) != 0)
+    {
+        prep->view.obj = NULL;
+        Py_DECREF(prep);
+        return NULL;
+    }
+    if (check_len(prep->view.len) != 0)
+    {
+        Py_DECREF(prep);
+        return NULL;
+    }
+    if (bus_enter(self) != 0)
+    {
+        Py_DECREF(prep);
+        return NULL;
+    }
+    const int rc = lw_prepare_read(&prep->prep, &self->bus, addr, (uint32_t)reg, (uint8_t)reg_len,
+                                   (uint8_t *)prep->view.buf, (uint16_t)prep->view.len);
+    bus_leave(self);
+    if (rc != 0)
+    {
+        PyErr_SetFromErrno(PyExc_OSError);
+        Py_DECREF(prep);
+        return NULL;
+    }
+    Py_INCREF(self);
+    prep->owner = self;
+    return (PyObject *)prep;
+}
+
+static PyObject *Bus_fileno(BusObject *self, PyObject *unused)
+{
+    (void)unused;
+    if (!self->open)
+    {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed bus");
+        return NULL;
+    }
+    if (self->bus.fd < 0)
+    {
+        errno = EBADF;
+        return PyErr_SetFromErrno(PyExc_OSError); /* broker bus: no local fd */
+    }
+    return PyLong_FromLong(self->bus.fd);
+}
+
+static PyObject *Bus_get_closed(BusObject *self, void *closure)
+{
+    (void)closure;
+    return PyBool_FromLong(!self->open);
+}
+
+static PyObject *Bus_get_path(BusObject *self, void *closure)
+{
+    (void)closure;
+    return PyUnicode_DecodeFSDefault(self->bus.device_path);
+}
+
+static PyObject *Bus_get_name(BusObject *self, void *closure)
+{
+    (void)closure;
+    if (!(self->bus.caps.flags & LW_CAPS_NAME))
+    {
+        Py_RETURN_NONE;
+    }
+    return PyUnicode_DecodeFSDefault(self->bus.caps.name);
+}
+
+static PyObject *Bus_get_funcs(BusObject *self, void *closure)
+{
+    (void)closure;
+    if (!(self->bus.caps.flags & LW_CAPS_FUNCS))
+    {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLong(self->bus.caps.funcs);
+}
+
+static PyObject *Bus_get_bus_hz(BusObject *self, void *closure)
+{
+    (void)closure;
+    if (!(self->bus.caps.flags & LW_CAPS_BUS_HZ))
+    {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLong(self->bus.caps.bus_hz);
+}
+
+static PyMethodDef Bus_methods[] = {
+    {"connect", (PyCFunction)Bus_connect, METH_VARARGS | METH_CLASS, Bus_connect_doc},
+    {"close", (PyCFunction)Bus_close, METH_NOARGS, Bus_close_doc},
+    {"fileno", (PyCFunction)Bus_fileno, METH_NOARGS, NULL},
+    {"read_into", (PyCFunction)(void (*)(void))Bus_read_into, METH_VARARGS | METH_KEYWORDS, Bus_read_into_doc},
+    {"read", (PyCFunction)(void (*)(void))Bus_read, METH_VARARGS | METH_KEYWORDS, Bus_read_doc},
+    {"write", (PyCFunction)(void (*)(void))Bus_write, METH_VARARGS | METH_KEYWORDS, Bus_write_doc},
+    {"transfer", (PyCFunction)Bus_transfer, METH_VARARGS, Bus_transfer_doc},
+    {"gather_read", (PyCFunction)(void (*)(void))Bus_gather_read, METH_VARARGS | METH_KEYWORDS, Bus_gather_read_doc},
+    {"scan", (PyCFunction)(void (*)(void))Bus_scan, METH_VARARGS | METH_KEYWORDS, Bus_scan_doc},
+    {"wait_ready", (PyCFunction)(void (*)(void))Bus_wait_ready, METH_VARARGS | METH_KEYWORDS, Bus_wait_ready_doc},
+    {"prepare_read", (PyCFunction)(void (*)(void))Bus_prepare_read, METH_VARARGS | METH_KEYWORDS, Bus_prepare_read_doc},
+    {"__enter__", (PyCFunction)Bus_enter, METH_NOARGS, NULL},
+    {"__exit__", (PyCFunction)Bus_exit, METH_VARARGS, NULL},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyGetSetDef Bus_getset[] = {
+    {"closed", (getter)Bus_get_closed, NULL, "True once close() has been called.", NULL},
+    {"path", (getter)Bus_get_path, NULL, "Adapter device path.", NULL},
+    {"name", (getter)Bus_get_name, NULL, "Adapter name from sysfs, or None.", NULL},
+    {"funcs", (getter)Bus_get_funcs, NULL, "I2C_FUNCS bitmask (FUNC_*), or None.", NULL},
+    {"bus_hz", (getter)Bus_get_bus_hz, NULL, "Bus clock from the device tree, or None.", NULL},
+    {NULL, NULL, NULL, NULL, NULL},
+};
+
+PyDoc_STRVAR(Bus_doc,
+             "Bus(path)\n\n"
+             "An open /dev/i2c-N adapter. One Bus may be shared between threads;\n"
+             "its calls are serialized. Use one Bus per adapter to run adapters in\n"
+             "parallel.");
+
+static PyTypeObject Bus_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "linux_wire.Bus",
+    .tp_basicsize = sizeof(BusObject),
+    .tp_dealloc = (destructor)Bus_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = Bus_doc,
+    .tp_methods = Bus_methods,
+    .tp_getset = Bus_getset,
+    .tp_init = (initproc)Bus_init,
+    .tp_new = Bus_new,
+};
+
+static void Prepared_dealloc(PreparedObject *self)
+{
+    if (self->view.obj)
+    {
+        PyBuffer_Release(&self->view);
+    }
+    Py_XDECREF(self->owner);
+    PyObject_Free(self);
+}
+
+PyDoc_STRVAR(Prepared_exec_doc,
+             "exec()\n\n"
+             "Run the prepared read, refilling its buffer.");
+
+static PyObject *Prepared_exec(PreparedObject *self, PyObject *unused)
+{
+    (void)unused;
+    if (bus_enter(self->owner) != 0)
+    {
+        return NULL;
+    }
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = lw_prepared_exec(&self->prep);
+    Py_END_ALLOW_THREADS
+    bus_leave(self->owner);
+    if (rc != 0)
+    {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef Prepared_methods[] = {
+    {"exec", (PyCFunction)Prepared_exec, METH_NOARGS, Prepared_exec_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyTypeObject Prepared_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "linux_wire.Prepared",
+    .tp_basicsize = sizeof(PreparedObject),
+    .tp_dealloc = (destructor)Prepared_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "A register read prepared by Bus.prepare_read().",
+    .tp_methods = Prepared_methods,
+};
+
+static struct PyModuleDef linux_wire_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "linux_wire",
+    .m_doc = "Zero-copy I2C access over the linux-wire C core.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_linux_wire(void)
+{
+    if (PyType_Ready(&Bus_Type) < 0 || PyType_Ready(&Prepared_Type) < 0)
+    {
+        return NULL;
+    }
+    PyObject *m = PyModule_Create(&linux_wire_module);
+    if (!m)
+    {
+        return NULL;
+    }
+    Py_INCREF(&Bus_Type);
+    Py_INCREF(&Prepared_Type);
+    if (PyModule_AddObject(m, "Bus", (PyObject *)&Bus_Type) != 0 ||
+        PyModule_AddObject(m, "Prepared", (PyObject *)&Prepared_Type) != 0 ||
+        PyModule_AddIntConstant(m, "MSG_RD", LW_MSG_RD) != 0 ||
+        PyModule_AddIntConstant(m, "MAX_MSGS", LW_MAX_MSGS) != 0 ||
+        PyModule_AddIntConstant(m, "GATHER_MAX", LW_GATHER_MAX) != 0 ||
+        PyModule_AddIntConstant(m, "FUNC_I2C", (long)LW_FUNC_I2C) != 0 ||
+        PyModule_AddIntConstant(m, "FUNC_10BIT_ADDR", (long)LW_FUNC_10BIT_ADDR) != 0)
+    {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -3,12 +3,10 @@
  * Sends a byte to a device and reads the response (expected multiply result).
  */
 
-#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
 #include <stdint.h>
 #include <sys/types.h>
 #include <unistd.h>
-#include <time.h>
 #include "linux_wire.h"
 
 static const uint16_t DEVICE_ADDR = 0x40;
@@ -34,9 +32,13 @@ int main(void)
         return 1;
     }
 
-    /* sleep ~1ms */
-    struct timespec ts = { .tv_sec = 0, .tv_nsec = 1000 * 1000 };
-    nanosleep(&ts, NULL);
+    /* The peripheral holds off its next address ACK until the receive
+       callback has stored the result, so poll instead of sleeping ~1ms */
+    if (lw_wait_ready(&bus, DEVICE_ADDR, 5000, 50, 0) != 0) {
+        perror("Device not ready");
+        lw_close_bus(&bus);
+        return 1;
+    }
 
     uint8_t result = 0;
     ssize_t r = lw_ioctl_read(&bus, DEVICE_ADDR, NULL, 0, &result, 1, 0);
@@ -3,8 +3,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 
 #include "linux_wire.h"
+#include "linux_wire_combine.h"
+#include "linux_wire_hotplug.h"
+#include "linux_wire_readahead.h"
 
 /**
  * Buffer size, mirroring Arduino's default BUFFER_LENGTH (32).
@@ -18,6 +23,59 @@
 #define LINUX_WIRE_BUFFER_LENGTH 32
 #endif
 
+/**
+ * Number of endTransmission(false) segments TwoWire can queue before
+ * they are sent, together with the closing write or read, as one
+ * combined transaction. At most LW_MAX_MSGS - 2.
+ */
+#ifndef LINUX_WIRE_MAX_PENDING_SEGMENTS
+#define LINUX_WIRE_MAX_PENDING_SEGMENTS 8
+#endif
+
+/**
+ * Non-owning view of a contiguous byte range (a C++17 stand-in for
+ * std::span). Constructible from pointer + length, a C array, or any
+ * container with data()/size() such as std::vector or std::array.
+ *
+ * The view does not extend the lifetime of the underlying storage.
+ */
+template <typename T>
+class WireSpan
+{
+public:
+    constexpr WireSpan() noexcept : data_(nullptr), size_(0) {}
+    constexpr WireSpan(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+    template <std::size_t N>
+    constexpr WireSpan(T (&array)[N]) noexcept : data_(array), size_(N) {}
+
+    template <typename Container,
+              typename = typename std::enable_if<
+                  std::is_convertible<decltype(std::declval<Container &>().data()), T *>::value>::type,
+              typename = decltype(std::declval<Container &>().size())>
+    constexpr WireSpan(Container &container) noexcept
+        : data_(container.data()), size_(container.size())
+    {
+    }
+
+    template <typename U,
+              typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+    constexpr WireSpan(const WireSpan<U> &other) noexcept : data_(other.data()), size_(other.size())
+    {
+    }
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T *begin() const noexcept { return data_; }
+    constexpr T *end() const noexcept { return data_ + size_; }
+    constexpr T &operator[](std::size_t index) const noexcept { return data_[index]; }
+
+private:
+    T *data_;
+    std::size_t size_;
+};
+
 /**
  * A minimal, Arduino-compatible TwoWire implementation for Linux.
  *
@@ -29,23 +87,34 @@
  *  - No inheritance from Stream / Print classes
  *  - setClock() is a no-op (bus speed configured via device tree/kernel)
  *  - flush() is a no-op (no hardware FIFO in userspace)
- *  - Repeated starts are emulated via I2C_RDWR ioctl calls; they work when using endTransmission(false) + requestFrom().
+ *  - Repeated starts are emulated via I2C_RDWR ioctl calls: segments ended with
+ *    endTransmission(false) are queued and sent, with repeated STARTs between
+ *    them, as one transaction with the next requestFrom(), transfer() or
+ *    endTransmission(true).
  *
  * Thread Safety:
  *  - This class is NOT thread-safe
  *  - Do not call methods from multiple threads without external synchronization
- *  - Each TwoWire instance should be used by only one thread
+ *  - Each TwoWire instance should be used by only one thread at a time;
+ *    an instance may be moved into (and then used by) another thread
  *
  * Resource Management:
  *  - Manages a file descriptor to /dev/i2c-X
  *  - Copy construction and assignment are deleted (non-copyable resource)
- *  - Move operations could be added in future versions if needed
+ *  - Move construction and assignment transfer the open bus, buffered data
+ *    and configuration; the moved-from object is left closed but reusable
+ *  - Instances can be stored by value in standard containers, e.g. one
+ *    per adapter: std::vector<TwoWire> buses;
+ *    buses.push_back(TwoWire::forAdapter(1));
  */
 class TwoWire
 {
 public:
     static constexpr std::size_t INTERNAL_ADDRESS_MAX = 4;
 
+    using ByteSpan = WireSpan<uint8_t>;
+    using ConstByteSpan = WireSpan<const uint8_t>;
+
     TwoWire();
     ~TwoWire();
 
@@ -53,6 +122,39 @@ public:
     TwoWire(const TwoWire &) = delete;
     TwoWire &operator=(const TwoWire &) = delete;
 
+    /* Move operations transfer ownership of the file descriptor */
+    TwoWire(TwoWire &&other) noexcept;
+    TwoWire &operator=(TwoWire &&other) noexcept;
+
+    /**
+     * Create an instance already opened on "/dev/i2c-<adapter>".
+     *
+     * @param adapter Adapter number (the N in /dev/i2c-N)
+     *
+     * @return A TwoWire instance; check isOpen() to see whether the open
+     *         succeeded (a failed open yields a closed instance, exactly as
+     *         begin() would).
+     *
+     * Example:
+     *   std::vector<TwoWire> buses;
+     *   for (int n : {0, 1, 3})
+     *       buses.push_back(TwoWire::forAdapter(n));
+     */
+    static TwoWire forAdapter(unsigned int adapter);
+
+    /**
+     * Create an instance already opened on an explicit device path.
+     * Same semantics as constructing a TwoWire and calling begin(device).
+     */
+    static TwoWire forDevice(const char *device);
+
+    /**
+     * Check whether the bus is currently open.
+     *
+     * @return true after a successful begin()/factory open, false otherwise
+     */
+    bool isOpen() const;
+
     /**
      * Initialize I2C communication on a specific device path.
      *
@@ -162,13 +264,24 @@ public:
      *         1 = data too long for buffer
      *         4 = other error (bus not open, NACK, etc.)
      *
-     * Note: sendStop=0 enables repeated-start emulation for the next
-     *       requestFrom() call, avoiding an intervening STOP condition.
-     *       The actual STOP is still issued by the kernel driver; this
-     *       just controls whether to use combined ioctl transactions.
-     *       If an older deferred write must be auto-flushed first and that
-     *       flush fails, this method returns 4 and does not send the new
-     *       transmission.
+     * Note: sendStop=0 queues the segment instead of sending it. Up to
+     *       LINUX_WIRE_MAX_PENDING_SEGMENTS segments, to any addresses,
+     *       accumulate this way; the next requestFrom(), transfer() or
+     *       endTransmission(true) sends all of them plus its own message
+     *       as one I2C_RDWR transaction, with repeated STARTs between the
+     *       segments and a single STOP at the end. When the queue is full,
+     *       the segment is dropped and 1 is returned.
+     *       If the combined transaction fails, this method returns 4 and
+     *       the queued segments are discarded with it.
+     *
+     * Example (chained restarts across two devices):
+     *   Wire.beginTransmission(0x70);
+     *   Wire.write(0x04);          // select mux channel 2
+     *   Wire.endTransmission(false);
+     *   Wire.beginTransmission(0x48);
+     *   Wire.write(0x00);          // register pointer
+     *   Wire.endTransmission(false);
+     *   Wire.requestFrom(0x48, 2); // one I2C_RDWR: write, write, read
      */
     uint8_t endTransmission(uint8_t sendStop);
     uint8_t endTransmission(void);
@@ -187,9 +300,9 @@ public:
      * After successful call, use available(), read(), and peek() to
      * access the received data.
      *
-     * If a deferred write from `endTransmission(false)` must be auto-flushed
-     * before starting this read and that flush fails, this method returns 0
-     * and does not start the read.
+     * Segments queued by `endTransmission(false)` are sent first, in the
+     * same combined transaction. If that transaction fails, this method
+     * returns 0 and the queued segments are discarded.
      *
      * Examples:
      *   // Simple read
@@ -248,6 +361,154 @@ public:
      */
     int peek(void);
 
+    /**
+     * Copy up to `length` unread bytes from the RX buffer in one call.
+     *
+     * @param buffer Destination, or nullptr to discard the bytes
+     * @param length Maximum number of bytes to consume
+     *
+     * @return Number of bytes consumed (0 if nothing is buffered)
+     *
+     * Equivalent to calling read() `length` times, without the per-byte
+     * call and bounds check.
+     */
+    size_t readBytes(uint8_t *buffer, size_t length);
+
+    /**
+     * View of the unread part of the RX buffer filled by requestFrom().
+     * Reading through the view does not consume bytes; call
+     * readBytes(nullptr, n) afterwards to mark them as read.
+     *
+     * The view is invalidated by the next requestFrom(), end() or move.
+     */
+    ConstByteSpan rxView() const;
+
+    /**
+     * One-shot write + repeated-start read straight into the caller's
+     * buffer, bypassing the TX/RX buffers and LINUX_WIRE_BUFFER_LENGTH.
+     *
+     * @param address 7-bit I2C slave address
+     * @param tx      Bytes to write first (e.g. register address); may be empty
+     * @param rx      Buffer to fill; may be empty for a write-only transfer
+     *
+     * @return true if the whole combined transaction completed
+     *
+     * Both parts are issued as a single I2C_RDWR transaction (no STOP
+     * between them), after any segments queued by endTransmission(false).
+     * Each part is limited to 65535 bytes. The RX buffer used by
+     * read()/available() is left untouched.
+     *
+     * Example:
+     *   uint8_t reg = 0x3B;
+     *   uint8_t sample[14];
+     *   Wire.transfer(0x68, {&reg, 1}, sample);
+     */
+    bool transfer(uint8_t address, ConstByteSpan tx, ByteSpan rx);
+
+    /**
+     * Route completed writes through a write combiner.
+     *
+     * @param combiner Combiner to buffer into (see linux_wire_combine.h),
+     *                 or nullptr to send every write at once again
+     *
+     * While a combiner is attached, endTransmission() (with STOP) to a
+     * device declared with lw_combine_add_device() buffers the write and
+     * returns 0 without touching the bus; writes to consecutive registers
+     * are merged into one auto-increment write. A write to any other
+     * device flushes the buffer and goes out at once with its STOP.
+     * Buffered writes are sent, in order, by commitWrites() and before
+     * every requestFrom(), transfer(), endTransmission() that closes
+     * queued repeated-start segments, zero-length probe, begin() and
+     * end(). If that flush fails, the operation that triggered it fails
+     * too (returns 0, 4 or false) and the buffered writes are lost.
+     *
+     * Any writes still buffered are flushed before the combiner is
+     * replaced. The combiner must outlive its attachment; it moves with
+     * the instance.
+     *
+     * Example (PCA9685: 64 LED registers in one transaction):
+     *   lw_combiner comb;
+     *   lw_combine_init(&comb, 0);
+     *   lw_combine_add_device(&comb, 0x40, 1, 0);
+     *   Wire.setWriteCombiner(&comb);
+     *   for (uint8_t reg = 0x06; reg < 0x46; ++reg)
+     *   {
+     *       Wire.beginTransmission(0x40);
+     *       Wire.write(reg);
+     *       Wire.write(value[reg - 0x06]);
+     *       Wire.endTransmission();
+     *   }
+     *   Wire.commitWrites();
+     */
+    void setWriteCombiner(lw_combiner *combiner);
+
+    /**
+     * Send every write buffered by the attached combiner now.
+     *
+     * @return true on success or when nothing is buffered, false if the
+     *         transaction failed (the buffered writes are discarded) or
+     *         the bus is not open, e.g. while a hot-plugged adapter is
+     *         away (the buffered writes are kept)
+     */
+    bool commitWrites();
+
+    /**
+     * Serve register reads through a read-ahead cache.
+     *
+     * @param readahead Read-ahead state with the devices to cache (see
+     *                  linux_wire_readahead.h), or nullptr to read every
+     *                  register from the device again
+     *
+     * While attached, register reads (the iaddress form of requestFrom()
+     * and a register pointer queued with endTransmission(false) followed
+     * by requestFrom() of the same device) go through
+     * lw_readahead_read(): sequential single-register reads of a declared
+     * device are answered from one block fetch. Every write TwoWire sends
+     * to a device, and every plain requestFrom() from it, drops that
+     * device's cached block.
+     *
+     * Writes made to the device without this TwoWire instance are not
+     * seen; call lw_readahead_invalidate() for them. The state must
+     * outlive its attachment; it moves with the instance.
+     *
+     * Example (magnetometer read one register at a time by its driver):
+     *   lw_readahead ra;
+     *   lw_readahead_init(&ra);
+     *   lw_readahead_add_device(&ra, 0x1E, 1, 0, 6, 10000);
+     *   Wire.setReadAhead(&ra);
+     */
+    void setReadAhead(lw_readahead *readahead);
+
+    /**
+     * Follow an adapter that can be unplugged and come back under a
+     * different /dev/i2c-N (USB bridges).
+     *
+     * @param hotplug Monitor holding the adapter's slot (see
+     *                linux_wire_hotplug.h), or nullptr to stop following
+     * @param slot    Index returned by lw_hotplug_add()
+     *
+     * The bus is opened on the adapter the slot resolves to right away.
+     * After that, every operation first checks the slot's generation (one
+     * atomic load) and, when the monitor has seen the adapter go or come
+     * back, reopens the bus on its current node with the stored timeout
+     * and logging preferences. While the adapter is absent the bus is
+     * closed and operations fail as on a closed bus. The timeout reopen
+     * of setWireTimeout() uses the current node as well.
+     *
+     * Someone must run the monitor, e.g. lw_hotplug_run_once() on a
+     * thread of its own. begin() and end() stop following the slot;
+     * detaching leaves the bus as it is. The monitor must outlive its
+     * attachment; it moves with the instance.
+     *
+     * Example (CP2112 on a given USB port):
+     *   lw_hotplug hp;
+     *   lw_hotplug_init(&hp, nullptr, nullptr, LW_HOTPLUG_UEVENT);
+     *   int slot = lw_hotplug_add(&hp, "CP2112", "1-1.2:");
+     *   Wire.setHotplug(&hp, slot);
+     *   // monitor thread: for (;;) lw_hotplug_run_once(&hp, -1);
+     */
+    void setHotplug(lw_hotplug *hotplug, int slot);
+
     /**
      * Flush output buffer.
      *
@@ -264,7 +525,17 @@ private:
     char devicePath_[LINUX_WIRE_DEVICE_PATH_MAX];
     uint8_t txAddress_;
     bool transmitting_;
-    bool hasPendingTxForRead_;
+
+    /* Segments ended with endTransmission(false), stored back to back */
+    struct PendingSegment
+    {
+        uint8_t address;
+        std::size_t length;
+    };
+    PendingSegment pending_[LINUX_WIRE_MAX_PENDING_SEGMENTS];
+    std::size_t pendingCount_;
+    uint8_t pendingData_[LINUX_WIRE_MAX_PENDING_SEGMENTS * LINUX_WIRE_BUFFER_LENGTH];
+    std::size_t pendingBytes_;
 
     uint8_t txBuffer_[LINUX_WIRE_BUFFER_LENGTH];
     std::size_t txBufferIndex_;
@@ -279,9 +550,17 @@ private:
     bool wireResetOnTimeout_;
     bool inTimeoutHandler_;
 
+    lw_combiner *combiner_;
+    lw_readahead *readAhead_;
+    lw_hotplug *hotplug_;
+    int hotplugSlot_;
+    uint64_t busGeneration_;
+
     void resetTxBuffer();
     void resetRxBuffer();
+    void resetPendingSegments();
     void applyBusConfiguration();
+    void takeStateFrom(TwoWire &other) noexcept;
 
     uint8_t requestFrom(uint8_t address,
                         uint8_t quantity,
@@ -290,7 +569,17 @@ private:
                         uint8_t sendStop,
                         bool consumePendingTx);
 
+    uint8_t requestChained(uint8_t address,
+                           uint8_t quantity,
+                           const uint8_t *internalAddress,
+                           std::size_t internalAddressLength);
+
+    std::size_t pendingMessages(lw_msg *msgs);
+    bool runCombined(const lw_msg *msgs, std::size_t count);
+
+    void invalidateReadAhead(uint8_t address);
     void handleTimeoutFromErrno();
+    bool refreshBus();
     bool reopenBus(const char *device);
     bool flushPendingRepeatedStart();
 };
@@ -311,8 +600,9 @@ private:
  *   per thread, each with its own device path.
  *
  * Note: Only one global instance is provided. For multiple I2C buses,
- *       create separate TwoWire instances and call begin() with different
- *       device paths (e.g., "/dev/i2c-0", "/dev/i2c-1").
+ *       create separate TwoWire instances with TwoWire::forAdapter() or
+ *       call begin() with different device paths (e.g., "/dev/i2c-0",
+ *       "/dev/i2c-1").
  */
 extern TwoWire Wire;
 
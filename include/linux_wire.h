@@ -18,6 +18,240 @@ extern "C"
 #define LINUX_WIRE_DEVICE_PATH_MAX 64
 #endif
 
+/**
+ * Maximum number of messages in one lw_transfer() call.
+ * Mirrors the kernel's I2C_RDWR_IOCTL_MAX_MSGS.
+ */
+#define LW_MAX_MSGS 42
+
+/** lw_msg.flags bit marking a read message (same value as I2C_M_RD). */
+#define LW_MSG_RD 0x0001
+
+/** Maximum registers per lw_gather_read() (one write + one read message each). */
+#define LW_GATHER_MAX (LW_MAX_MSGS / 2)
+
+/** Maximum messages in one lw_prepared transaction. */
+#ifndef LW_PREPARED_MAX_MSGS
+#define LW_PREPARED_MAX_MSGS 8
+#endif
+
+    /**
+     * Fixed-capacity scratch arena for transaction descriptors and payload
+     * staging buffers.
+     *
+     * The caller provides the backing storage (static array, mlock'd region,
+     * etc.); the library never frees it. Space is handed out for the
+     * duration of a single call and returned before the call completes, so
+     * the arena only needs to hold the largest single transaction.
+     *
+     * Fields (read-only for callers; use lw_pool_get_stats()):
+     *   base       - Start of caller storage
+     *   capacity   - Size of caller storage in bytes
+     *   used       - Bytes currently handed out
+     *   high_water - Largest `used` value observed
+     *   hits       - Requests served from the arena
+     *   misses     - Requests that fell back to malloc()
+     */
+    typedef struct
+    {
+        uint8_t *base;
+        size_t capacity;
+        size_t used;
+        size_t high_water;
+        uint64_t hits;
+        uint64_t misses;
+    } lw_pool;
+
+    /**
+     * Snapshot of pool usage counters.
+     */
+    typedef struct
+    {
+        uint64_t hits;
+        uint64_t misses;
+        size_t capacity;
+        size_t high_water;
+    } lw_pool_stats;
+
+/**
+ * Capacity of an lw_error_ring, in records. Must be a power of two.
+ */
+#ifndef LINUX_WIRE_ERROR_RING_SIZE
+#define LINUX_WIRE_ERROR_RING_SIZE 64
+#endif
+
+/**
+ * Scratch bytes lw_open_bus_rt() preallocates when no pool is supplied.
+ * Covers the largest lw_ioctl_write() payload plus a full LW_MAX_MSGS
+ * descriptor array.
+ */
+#ifndef LINUX_WIRE_RT_DEFAULT_POOL
+#define LINUX_WIRE_RT_DEFAULT_POOL 8192
+#endif
+
+/** lw_rt_config.flags: mlockall(MCL_CURRENT | MCL_FUTURE) at open. */
+#define LW_RT_MLOCKALL 0x0001u
+
+/** lw_error_record.addr when the failing call has no address argument. */
+#define LW_ADDR_UNKNOWN 0xFFFFu
+
+    /**
+     * Operation that produced an lw_error_record.
+     */
+    typedef enum
+    {
+        LW_OP_OPEN = 0,
+        LW_OP_SET_SLAVE,
+        LW_OP_WRITE,
+        LW_OP_READ,
+        LW_OP_IOCTL_READ,
+        LW_OP_IOCTL_WRITE,
+        LW_OP_TRANSFER,
+        LW_OP_ALLOC,
+        LW_OP_PROBE
+    } lw_op;
+
+    /**
+     * One failure captured in realtime mode.
+     *
+     * Fields:
+     *   seq  - Running sequence number (gaps mean records were dropped)
+     *   err  - errno reported to the caller
+     *   addr - Device address, or LW_ADDR_UNKNOWN (lw_read/lw_write)
+     *   op   - Failing operation
+     */
+    typedef struct
+    {
+        uint32_t seq;
+        int err;
+        uint16_t addr;
+        uint8_t op;
+    } lw_error_record;
+
+    /**
+     * Lock-free single-producer/single-consumer ring of error records.
+     *
+     * The realtime thread that owns the bus is the only producer; one other
+     * thread (e.g. a logger) may drain it with lw_error_ring_pop(). When the
+     * ring is full new records are dropped and counted in `dropped`.
+     *
+     * Treat all fields as private.
+     */
+    typedef struct
+    {
+        lw_error_record entries[LINUX_WIRE_ERROR_RING_SIZE];
+        uint32_t head;
+        uint32_t tail;
+        uint32_t seq;
+        uint32_t dropped;
+    } lw_error_ring;
+
+/**
+ * Adapter functionality bits reported by I2C_FUNCS (same values as the
+ * kernel's I2C_FUNC_* constants), for use with lw_bus_supports().
+ */
+#define LW_FUNC_I2C 0x00000001ul
+#define LW_FUNC_10BIT_ADDR 0x00000002ul
+#define LW_FUNC_PROTOCOL_MANGLING 0x00000004ul
+#define LW_FUNC_SMBUS_PEC 0x00000008ul
+#define LW_FUNC_NOSTART 0x00000010ul
+#define LW_FUNC_SMBUS_QUICK 0x00010000ul
+#define LW_FUNC_SMBUS_READ_BLOCK_DATA 0x01000000ul
+#define LW_FUNC_SMBUS_WRITE_BLOCK_DATA 0x02000000ul
+#define LW_FUNC_SMBUS_READ_I2C_BLOCK 0x04000000ul
+#define LW_FUNC_SMBUS_WRITE_I2C_BLOCK 0x08000000ul
+
+/** lw_adapter_caps.flags: `funcs` holds a valid I2C_FUNCS result. */
+#define LW_CAPS_FUNCS 0x0001u
+/** lw_adapter_caps.flags: `name` was read from sysfs. */
+#define LW_CAPS_NAME 0x0002u
+/** lw_adapter_caps.flags: `bus_hz` was read from the device tree node. */
+#define LW_CAPS_BUS_HZ 0x0004u
+
+/**
+ * Default sysfs directory holding the i2c-N adapter entries.
+ */
+#ifndef LINUX_WIRE_SYSFS_I2C_ROOT
+#define LINUX_WIRE_SYSFS_I2C_ROOT "/sys/bus/i2c/devices"
+#endif
+
+/** Size of lw_adapter_caps.name, including the terminator. */
+#define LINUX_WIRE_ADAPTER_NAME_MAX 48
+
+    /**
+     * Adapter capabilities discovered once when the bus is opened.
+     *
+     * Fields:
+     *   flags  - LW_CAPS_* bits saying which fields below are valid
+     *   funcs  - LW_FUNC_* bitmask from the I2C_FUNCS ioctl
+     *   bus_hz - Bus clock from the adapter's device tree node (0 = unknown)
+     *   name   - Adapter name from sysfs (e.g. "bcm2835 (i2c@7e804000)")
+     *
+     * Missing information is never an error: a field whose flag is clear
+     * is simply unknown, and lw_bus_supports() then assumes support.
+     */
+    typedef struct
+    {
+        unsigned int flags;
+        unsigned long funcs;
+        uint32_t bus_hz;
+        char name[LINUX_WIRE_ADAPTER_NAME_MAX];
+    } lw_adapter_caps;
+
+    /**
+     * One segment of a combined I2C transaction, mirroring struct i2c_msg.
+     *
+     * Fields:
+     *   addr  - 7-bit (or 10-bit with I2C_M_TEN) device address
+     *   flags - i2c_msg flags; LW_MSG_RD for a read segment
+     *   len   - Number of bytes to transfer
+     *   buf   - Source (write) or destination (read) buffer
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint16_t flags;
+        uint16_t len;
+        uint8_t *buf;
+    } lw_msg;
+
+    /**
+     * One bus transaction as seen by an lw_observer_fn.
+     *
+     * Fields:
+     *   op           - Operation that issued it
+     *   addr         - Device address, or LW_ADDR_UNKNOWN (lw_read/lw_write)
+     *   msgs         - Messages (START/repeated START segments)
+     *   ten_bit_msgs - Messages using 10-bit addressing
+     *   bytes        - Payload bytes, excluding address bytes
+     *   err          - 0 on success, else the errno reported to the caller
+     */
+    typedef struct
+    {
+        uint8_t op;
+        uint16_t addr;
+        uint16_t msgs;
+        uint16_t ten_bit_msgs;
+        uint32_t bytes;
+        int err;
+    } lw_xfer_event;
+
+    /**
+     * Callback invoked after every transaction that reached the kernel,
+     * on the thread that issued it. Must not call back into the bus.
+     */
+    typedef void (*lw_observer_fn)(void *arg, const lw_xfer_event *event);
+
+    /**
+     * Replacement for the kernel installed with lw_open_backend(): runs
+     * `count` lw_msg segments (same layout as struct i2c_msg) as one
+     * combined transaction, filling read segments in place.
+     *
+     * @return 0 (or any non-negative value) on success, -1 on error
+     *         (errno set)
+     */
+    typedef int (*lw_backend_fn)(void *arg, lw_msg *msgs, size_t count);
+
     /**
      * Simple I2C bus handle for /dev/i2c-* devices.
      * This structure is intentionally minimal for clarity and robustness.
@@ -28,6 +262,19 @@ extern "C"
      *   timeout_us  - Timeout value in microseconds (0 = no timeout)
      *                 Currently informational only; not enforced by implementation
      *   log_errors  - Non-zero enables perror logging for low-level failures
+     *   pool        - Optional scratch arena (NULL = stack/heap only);
+     *                 see lw_bus_attach_pool()
+     *   rt_flags    - Realtime-mode state (private; see lw_open_bus_rt())
+     *   errors      - Error ring used instead of perror in realtime mode
+     *   caps        - Adapter capabilities cached at open
+     *                 (see lw_bus_probe_caps())
+     *   observer    - Transaction callback (see lw_bus_set_observer())
+     *   observer_arg - User pointer passed to `observer`
+     *   backend     - Transport used instead of the kernel (NULL = fd);
+     *                 see lw_open_backend()
+     *   backend_arg - User pointer passed to `backend`
+     *   slave_addr  - Address from lw_set_slave(), used by lw_read() and
+     *                 lw_write() on a backend bus
      */
     typedef struct
     {
@@ -35,8 +282,75 @@ extern "C"
         char device_path[LINUX_WIRE_DEVICE_PATH_MAX];
         uint32_t timeout_us;
         int log_errors;
+        lw_pool *pool;
+        unsigned int rt_flags;
+        lw_error_ring *errors;
+        lw_adapter_caps caps;
+        lw_observer_fn observer;
+        void *observer_arg;
+        lw_backend_fn backend;
+        void *backend_arg;
+        uint16_t slave_addr;
     } lw_i2c_bus;
 
+    /**
+     * Realtime-mode settings for lw_open_bus_rt().
+     *
+     * Fields:
+     *   pool      - Caller-provided scratch pool, or NULL to have one of
+     *               `pool_size` bytes allocated (and pre-faulted) at open
+     *   pool_size - Size of the library-allocated pool
+     *               (0 = LINUX_WIRE_RT_DEFAULT_POOL)
+     *   errors    - Ring that receives failure records (NULL = errno only)
+     *   flags     - Bitfield of LW_RT_* options
+     */
+    typedef struct
+    {
+        lw_pool *pool;
+        size_t pool_size;
+        lw_error_ring *errors;
+        unsigned int flags;
+    } lw_rt_config;
+
+    /**
+     * One register block for lw_gather_read().
+     *
+     * Fields:
+     *   reg     - Register address, sent big-endian in `reg_len` bytes
+     *   reg_len - Register address size: 1-4 bytes
+     *   len     - Bytes to read starting at `reg` (> 0)
+     *   dst     - Destination buffer of at least `len` bytes
+     */
+    typedef struct
+    {
+        uint32_t reg;
+        uint8_t reg_len;
+        uint16_t len;
+        uint8_t *dst;
+    } lw_gather_item;
+
+    /**
+     * A transaction validated and laid out once by lw_prepare_transfer()
+     * or lw_prepare_read(), then run any number of times with
+     * lw_prepared_exec().
+     *
+     * The message array already has the kernel's struct i2c_msg layout,
+     * so execution is one I2C_RDWR ioctl with no checks or copying. It may
+     * point into the object itself (register bytes): prepare it where it
+     * will be used and do not copy it afterwards.
+     *
+     * Treat all fields as private.
+     */
+    typedef struct
+    {
+        lw_i2c_bus *bus;
+        lw_msg msgs[LW_PREPARED_MAX_MSGS];
+        uint32_t count;
+        uint32_t bytes;
+        uint16_t ten_bit_msgs;
+        uint8_t reg[4];
+    } lw_prepared;
+
     /**
      * Open an I2C bus at the specified device path.
      *
@@ -51,9 +365,14 @@ extern "C"
      *   ENOENT - Device file doesn't exist
      *   EACCES - Permission denied (user may need to be in 'i2c' group)
      *
-     * On success, bus->fd contains a valid file descriptor.
+     * On success, bus->fd contains a valid file descriptor and bus->caps
+     * holds the adapter capabilities (see lw_bus_probe_caps()).
      * On failure, the bus handle is reset to a closed state (`fd == -1`).
      *
+     * The handle is reset without being read, so it may be uninitialized.
+     * Close a handle opened in realtime mode with lw_close_bus() before
+     * reopening it, or its library-allocated pool leaks.
+     *
      * Example:
      *   lw_i2c_bus bus;
      *   if (lw_open_bus(&bus, "/dev/i2c-1") == 0) {
@@ -62,6 +381,74 @@ extern "C"
      */
     int lw_open_bus(lw_i2c_bus *bus, const char *device_path);
 
+    /**
+     * Open an I2C bus in realtime mode, for use from PREEMPT_RT control
+     * loops.
+     *
+     * @param bus         Pointer to lw_i2c_bus structure to initialize
+     * @param device_path Same rules as lw_open_bus()
+     * @param config      Realtime settings (NULL = defaults)
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   As lw_open_bus(), plus:
+     *   ENOMEM - Pool allocation failed
+     *   EPERM  - LW_RT_MLOCKALL requested without CAP_IPC_LOCK / RLIMIT_MEMLOCK
+     *
+     * All allocation happens here. Afterwards, on this bus:
+     *   - lw_write, lw_read, lw_ioctl_read/write and lw_transfer make no
+     *     heap allocations; requests that do not fit the pool fail with
+     *     ENOMEM instead of falling back to malloc()
+     *   - nothing is printed; failures are pushed to `config->errors`
+     *   - the only system call per transfer is the read/write/ioctl itself
+     *   - the library takes no locks on the transfer path
+     * Debug builds (no NDEBUG) assert on any attempted heap fallback; that
+     * is the only part checked at run time.
+     *
+     * The guarantee covers the library's own path. The bus observer runs
+     * inline (lw_monitor records without locks; a custom observer must not
+     * block), and lw_sched arbitration waits for other clients by design,
+     * so a realtime thread should own its bus rather than share it through
+     * a scheduler.
+     *
+     * Close with lw_close_bus(), which also frees a library-allocated pool.
+     * As with lw_open_bus(), close a realtime handle before reopening it.
+     */
+    int lw_open_bus_rt(lw_i2c_bus *bus, const char *device_path, const lw_rt_config *config);
+
+    /**
+     * Switch an already-open bus to realtime mode (see lw_open_bus_rt()).
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL bus, or a pool without backing storage
+     *   EBADF  - Bus not open
+     *   ENOMEM - Pool allocation failed
+     *   EPERM  - mlockall() not permitted
+     */
+    int lw_bus_enable_rt(lw_i2c_bus *bus, const lw_rt_config *config);
+
+    /**
+     * Open a bus handle whose transactions go to `fn` instead of a
+     * /dev/i2c-* file descriptor (a broker connection, a simulated device,
+     * a test double). Every call in this header then works unchanged:
+     * combined transactions reach `fn` as built, and lw_read()/lw_write()
+     * become a single message to the lw_set_slave() address.
+     *
+     * @param bus   Pointer to lw_i2c_bus structure to initialize
+     * @param label Name reported as bus->device_path (e.g. "/dev/i2c-1")
+     * @param fn    Transport callback
+     * @param arg   User pointer passed to `fn`
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     *
+     * bus->fd stays -1 and bus->caps starts empty; the owner of the
+     * transport may fill it in. lw_close_bus() only detaches `fn`.
+     */
+    int lw_open_backend(lw_i2c_bus *bus, const char *label, lw_backend_fn fn, void *arg);
+
     /**
      * Close an I2C bus and release its file descriptor.
      * Safe to call multiple times or on an already-closed bus.
@@ -72,6 +459,56 @@ extern "C"
      */
     void lw_close_bus(lw_i2c_bus *bus);
 
+    /**
+     * Query the adapter's capabilities and store them in bus->caps.
+     * lw_open_bus() and lw_open_bus_rt() already do this; call it again
+     * only to re-read them or to use a different sysfs tree.
+     *
+     * @param bus        Pointer to open lw_i2c_bus
+     * @param sysfs_root Directory containing the i2c-N entries
+     *                   (NULL = LINUX_WIRE_SYSFS_I2C_ROOT)
+     *
+     * @return 0 on success (even if nothing could be discovered),
+     *         -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL bus
+     *   EBADF  - Bus not open
+     *
+     * Sources: the I2C_FUNCS ioctl for `funcs`, `<root>/i2c-N/name` and
+     * `<root>/i2c-N/of_node/clock-frequency`, where N comes from the
+     * device path. Each source is optional.
+     */
+    int lw_bus_probe_caps(lw_i2c_bus *bus, const char *sysfs_root);
+
+    /**
+     * Check whether the adapter supports every LW_FUNC_* bit in `funcs`.
+     *
+     * @return 1 when supported or when the capabilities are unknown,
+     *         0 when the adapter is known to lack one of them
+     *
+     * lw_ioctl_read(), lw_ioctl_write() and lw_transfer() use this to fail
+     * with EOPNOTSUPP without a system call on SMBus-only controllers, and
+     * when I2C_M_TEN is requested from an adapter without 10-bit support.
+     * Higher layers can use it to pick a different path up front.
+     *
+     * Example:
+     *   if (!lw_bus_supports(&bus, LW_FUNC_I2C)) {
+     *       // SMBus-only controller: no combined transactions
+     *   }
+     */
+    int lw_bus_supports(const lw_i2c_bus *bus, unsigned long funcs);
+
+    /**
+     * Install (or, with NULL, remove) a callback that sees every
+     * transaction on this bus, successful or not. Used by the utilization
+     * monitor in linux_wire_monitor.h. lw_open_bus() clears it.
+     *
+     * The callback runs synchronously after the system call, so keep it
+     * short; errno is preserved around it.
+     */
+    void lw_bus_set_observer(lw_i2c_bus *bus, lw_observer_fn fn, void *arg);
+
     /**
      * Set the I2C slave address for subsequent read/write operations.
      *
@@ -156,6 +593,7 @@ extern "C"
      *   EBADF    - Bus not open
      *   ENXIO    - No device at address (NACK)
      *   EOVERFLOW - Size calculation overflow
+     *   EOPNOTSUPP - Adapter lacks plain-I2C (or requested 10-bit) support
      *
      * This function is useful for reading device registers:
      *   uint8_t reg_addr = 0x10;
@@ -194,9 +632,10 @@ extern "C"
      * Error conditions:
      *   EINVAL    - Invalid parameters or size limits exceeded
      *   EBADF     - Bus not open
-     *   ENOMEM    - Memory allocation failed (for large transfers)
+     *   ENOMEM    - Memory allocation failed (large transfers without pool room)
      *   ENXIO     - No device at address (NACK)
      *   EOVERFLOW - Size calculation overflow
+     *   EOPNOTSUPP - Adapter lacks plain-I2C (or requested 10-bit) support
      *
      * Example (write 0xFF to register 0x10 of device at 0x40):
      *   uint8_t reg = 0x10;
@@ -204,7 +643,8 @@ extern "C"
      *   lw_ioctl_write(&bus, 0x40, &reg, 1, &value, 1, 0);
      *
      * Performance note: For transfers <= 256 bytes, this function uses stack
-     * allocation. Larger transfers use heap allocation (malloc/free).
+     * allocation. Larger transfers use the bus pool when one is attached and
+     * has room, and heap allocation (malloc/free) otherwise.
      */
     ssize_t lw_ioctl_write(lw_i2c_bus *bus,
                            uint16_t addr,
@@ -214,6 +654,225 @@ extern "C"
                            size_t len,
                            uint16_t flags);
 
+    /**
+     * Execute several messages as one combined transaction (single I2C_RDWR).
+     *
+     * @param bus   Pointer to open lw_i2c_bus
+     * @param msgs  Array of messages, executed in order with repeated starts
+     * @param count Number of messages (1..LW_MAX_MSGS)
+     *
+     * @return Number of messages transferred on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Invalid parameters (NULL pointers, count out of range,
+     *            NULL buffer with len > 0)
+     *   EBADF  - Bus not open
+     *   ENOMEM - Descriptor array allocation failed
+     *   ENXIO  - A device did not acknowledge
+     *   EOPNOTSUPP - Adapter lacks plain-I2C (or requested 10-bit) support
+     *
+     * Up to 8 messages are staged on the stack. Larger batches take their
+     * descriptor array from the bus pool when one is attached (see
+     * lw_bus_attach_pool()) and from the heap otherwise.
+     */
+    int lw_transfer(lw_i2c_bus *bus, const lw_msg *msgs, size_t count);
+
+    /**
+     * Read several scattered register blocks of one device in a single
+     * combined transaction.
+     *
+     * @param bus   Pointer to open lw_i2c_bus
+     * @param addr  7-bit (or 10-bit) device address
+     * @param items Register blocks, read in order
+     * @param count Number of blocks (1..LW_GATHER_MAX)
+     *
+     * @return Total bytes read on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Invalid parameters (count out of range, reg_len not 1-4,
+     *            zero length or NULL destination)
+     *   EBADF  - Bus not open
+     *   plus any errno reported by lw_transfer()
+     *
+     * The blocks become alternating register-write/read messages in one
+     * I2C_RDWR call: one system call and one bus hold instead of `count`
+     * lw_ioctl_read() calls, and the values form a consistent snapshot.
+     *
+     * Example (STATUS, DATA and TEMP of an accelerometer):
+     *   uint8_t status, xyz[6], temp[2];
+     *   lw_gather_item regs[3] = {
+     *       {0x00, 1, 1, &status}, {0x28, 1, 6, xyz}, {0x41, 1, 2, temp}};
+     *   lw_gather_read(&bus, 0x19, regs, 3);
+     */
+    ssize_t lw_gather_read(lw_i2c_bus *bus,
+                           uint16_t addr,
+                           const lw_gather_item *items,
+                           size_t count);
+
+    /**
+     * Validate `msgs` once and store them in `prep` for repeated
+     * execution.
+     *
+     * @param prep  Transaction to fill in
+     * @param bus   Pointer to open lw_i2c_bus; must outlive `prep`
+     * @param msgs  Messages to copy (their data buffers are bound by
+     *              pointer and must stay valid)
+     * @param count Number of messages (1..LW_PREPARED_MAX_MSGS)
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Invalid parameters (NULL pointers, count out of range,
+     *            NULL buffer with len > 0)
+     *   EBADF  - Bus not open
+     *   EOPNOTSUPP - Adapter lacks plain-I2C (or requested 10-bit) support
+     */
+    int lw_prepare_transfer(lw_prepared *prep,
+                            lw_i2c_bus *bus,
+                            const lw_msg *msgs,
+                            size_t count);
+
+    /**
+     * Prepare the common register read: write `reg` (big-endian,
+     * `reg_len` bytes), repeated START, read `len` bytes into `dst`.
+     *
+     * @return 0 on success, -1 on error (errno set, as
+     *         lw_prepare_transfer(); EINVAL also for reg_len not 1-4,
+     *         zero `len` or NULL `dst`)
+     *
+     * Example (IMU sampling loop):
+     *   uint8_t xyz[6];
+     *   lw_prepared rd;
+     *   lw_prepare_read(&rd, &bus, 0x68, 0x3B, 1, xyz, sizeof(xyz));
+     *   for (;;) {
+     *       if (lw_prepared_exec(&rd) == 0)
+     *           consume(xyz);
+     *   }
+     */
+    int lw_prepare_read(lw_prepared *prep,
+                        lw_i2c_bus *bus,
+                        uint16_t addr,
+                        uint32_t reg,
+                        uint8_t reg_len,
+                        uint8_t *dst,
+                        uint16_t len);
+
+    /**
+     * Run a prepared transaction: a single I2C_RDWR ioctl.
+     *
+     * @return 0 on success, -1 on error (errno from the ioctl; EBADF once
+     *         the bus has been closed)
+     *
+     * Errors are still reported through the bus (perror or the realtime
+     * error ring) and the observer still sees the transaction.
+     */
+    int lw_prepared_exec(lw_prepared *prep);
+
+    /**
+     * Initialize a pool over caller-provided storage.
+     *
+     * @param pool    Pool to initialize
+     * @param storage Backing memory (must outlive every bus using the pool)
+     * @param size    Size of `storage` in bytes
+     *
+     * Storage of any alignment works; hand-outs are aligned for
+     * struct i2c_msg, so up to 15 bytes of a misaligned arena go unused.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     *
+     * Example:
+     *   static uint8_t arena[8192];
+     *   static lw_pool pool;
+     *   lw_pool_init(&pool, arena, sizeof(arena));
+     *   lw_bus_attach_pool(&bus, &pool);
+     */
+    int lw_pool_init(lw_pool *pool, void *storage, size_t size);
+
+    /**
+     * Attach (or, with NULL, detach) a scratch pool to an open bus.
+     *
+     * While attached, lw_ioctl_write() payloads above the stack threshold
+     * and large lw_transfer() descriptor arrays come from the pool, so
+     * steady-state operation makes no heap allocations. Requests that do
+     * not fit fall back to malloc() and are counted as misses.
+     *
+     * A pool may be shared by several buses only if they are used from the
+     * same thread. lw_open_bus() detaches any previous pool.
+     *
+     * On a realtime bus the pool allocated by lw_open_bus_rt() or
+     * lw_bus_enable_rt() is freed and replaced; realtime mode stays on.
+     * Detaching (NULL) there leaves no pool, so every request above the
+     * stack threshold then fails with ENOMEM.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_bus_attach_pool(lw_i2c_bus *bus, lw_pool *pool);
+
+    /**
+     * Copy the pool usage counters into `stats`.
+     */
+    void lw_pool_get_stats(const lw_pool *pool, lw_pool_stats *stats);
+
+    /**
+     * Reset hit/miss counters and the high-water mark.
+     */
+    void lw_pool_reset_stats(lw_pool *pool);
+
+    /**
+     * Initialize (empty) an error ring.
+     */
+    void lw_error_ring_init(lw_error_ring *ring);
+
+    /**
+     * Take the oldest record from an error ring. Safe to call from one
+     * consumer thread while the bus owner keeps producing.
+     *
+     * @return 1 if a record was stored in `record`, 0 if the ring is empty
+     */
+    int lw_error_ring_pop(lw_error_ring *ring, lw_error_record *record);
+
+    /**
+     * Option bits for lw_wait_ready().
+     *
+     *   LW_WAIT_SPIN - Busy-wait between probes instead of sleeping. Use for
+     *                  intervals below ~100 us, where nanosleep() wake-up
+     *                  latency would dominate the wait.
+     */
+#define LW_WAIT_SPIN 0x0001u
+
+    /**
+     * Wait until a device acknowledges its address (ACK polling).
+     *
+     * @param bus         Pointer to open lw_i2c_bus
+     * @param addr        7-bit device address to probe
+     * @param timeout_us  Deadline for the device to respond (0 = probe once)
+     * @param interval_us Delay between probes (0 = back-to-back)
+     * @param options     Bitfield of LW_WAIT_* options
+     *
+     * @return 0 once the device ACKs, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL    - Invalid parameters
+     *   EBADF     - Bus not open
+     *   ETIMEDOUT - Device still NACKing when the deadline passed
+     *   EOPNOTSUPP - Adapter is known to lack I2C_RDWR support
+     *
+     * Each probe is a zero-length write (address + STOP, no data), which is
+     * harmless for EEPROMs and sensors that NACK while busy. Adapters that
+     * reject zero-length messages are probed with a one-byte read instead.
+     * NACKs are expected while waiting and are never logged.
+     *
+     * Typical use replaces a worst-case sleep after a write cycle or
+     * conversion start:
+     *   lw_ioctl_write(&bus, 0x50, addr, 2, page, 32, 0);
+     *   lw_wait_ready(&bus, 0x50, 10000, 50, 0);
+     */
+    int lw_wait_ready(lw_i2c_bus *bus,
+                      uint16_t addr,
+                      uint32_t timeout_us,
+                      uint32_t interval_us,
+                      unsigned int options);
+
     /**
      * Set timeout value for I2C operations.
      *
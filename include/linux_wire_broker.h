@@ -0,0 +1,226 @@
+#ifndef LINUX_WIRE_BROKER_H
+#define LINUX_WIRE_BROKER_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Requests one client can have in flight (power of two). */
+#ifndef LINUX_WIRE_BROKER_RING_SIZE
+#define LINUX_WIRE_BROKER_RING_SIZE 8
+#endif
+
+/** Largest payload of one request: all write and read bytes together. */
+#ifndef LINUX_WIRE_BROKER_PAYLOAD_MAX
+#define LINUX_WIRE_BROKER_PAYLOAD_MAX 4096
+#endif
+
+/** Clients one broker serves at a time. */
+#ifndef LINUX_WIRE_BROKER_MAX_CLIENTS
+#define LINUX_WIRE_BROKER_MAX_CLIENTS 32
+#endif
+
+/** Requests run per wake-up before the broker checks for new clients. */
+#ifndef LINUX_WIRE_BROKER_BATCH
+#define LINUX_WIRE_BROKER_BATCH 64
+#endif
+
+/** Default time a client spins for its reply before sleeping. */
+#ifndef LINUX_WIRE_BROKER_SPIN_US
+#define LINUX_WIRE_BROKER_SPIN_US 20u
+#endif
+
+/** Default limit on how long lw_broker_begin() may keep the bus idle. */
+#ifndef LINUX_WIRE_BROKER_HOLD_US
+#define LINUX_WIRE_BROKER_HOLD_US 100000u
+#endif
+
+/** Size of the broker's socket path, including the terminator. */
+#define LINUX_WIRE_BROKER_PATH_MAX 108
+
+    /**
+     * One connected client, as seen by the broker. Private.
+     */
+    typedef struct
+    {
+        int sock;
+        int req_fd;
+        int resp_fd;
+        void *ring;
+        uint32_t done;
+        int hold_expired;
+    } lw_broker_conn;
+
+    /**
+     * Bus broker: the single owner of one adapter, serving transactions
+     * for any number of local processes.
+     *
+     * Each client gets a private shared-memory ring of requests plus two
+     * eventfds, handed over once on the Unix socket. After that the socket
+     * only signals disconnects: requests, read data and results travel
+     * through the ring. Each request runs as one lw_transfer(), so the
+     * combined transaction of one client is never split by another.
+     *
+     * Scheduling: on every wake-up the broker runs pending requests from
+     * all clients back to back, highest priority first and round-robin
+     * between clients of equal priority. A client's own requests always
+     * run in submission order.
+     *
+     * Fields (read-only for callers):
+     *   bus         - Bus being served
+     *   hold_us     - Hold limit (see lw_broker_begin()); may be changed
+     *                 before lw_broker_run()
+     *   clients     - Clients currently connected
+     *   requests    - Requests executed
+     *   failures    - Requests that returned an error
+     *   wakeups     - Scheduling rounds (requests / wakeups = batch size)
+     *   hold_timeouts - Holds broken by `hold_us`
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        lw_i2c_bus *bus;
+        char socket_path[LINUX_WIRE_BROKER_PATH_MAX];
+        int listen_fd;
+        int epoll_fd;
+        int wake_fd;
+        int stop;
+        uint32_t hold_us;
+        int holder;
+        uint64_t hold_deadline_us;
+        unsigned int cursor;
+        unsigned int clients;
+        uint64_t requests;
+        uint64_t failures;
+        uint64_t wakeups;
+        uint64_t hold_timeouts;
+        lw_broker_conn conns[LINUX_WIRE_BROKER_MAX_CLIENTS];
+    } lw_broker;
+
+    /**
+     * Client side of a broker connection. Not thread-safe: use one client
+     * (and one bus handle) per thread.
+     *
+     * Fields:
+     *   spin_us  - Time to busy-wait for a reply before sleeping on the
+     *              eventfd (default LINUX_WIRE_BROKER_SPIN_US; 0 = never)
+     *   priority - Priority of subsequent requests (0-255, higher first)
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        int sock;
+        int req_fd;
+        int resp_fd;
+        void *ring;
+        uint32_t head;
+        uint32_t spin_us;
+        uint8_t priority;
+        int holding;
+        lw_i2c_bus *bus;
+    } lw_broker_client;
+
+    /**
+     * Start serving `bus` on the Unix socket `socket_path`. A stale socket
+     * file is replaced; access is governed by its permissions (set the
+     * umask or chmod() it afterwards).
+     *
+     * The broker only calls lw_transfer() on `bus`, so any open handle
+     * works, including realtime-mode and backend buses. Error logging on
+     * `bus` is left as configured; NACKs from clients' devices will be
+     * printed unless it is disabled.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL       - NULL arguments or closed bus
+     *   ENAMETOOLONG - Path does not fit a sockaddr_un
+     *   plus any errno from socket(), bind(), listen(), epoll_create1()
+     *   or eventfd()
+     */
+    int lw_broker_init(lw_broker *broker, lw_i2c_bus *bus, const char *socket_path);
+
+    /**
+     * Wait up to `timeout_ms` (-1 = forever) for work, accept and drop
+     * clients, and run up to LINUX_WIRE_BROKER_BATCH pending requests.
+     *
+     * @return Number of requests run, -1 on error (errno set)
+     */
+    int lw_broker_run_once(lw_broker *broker, int timeout_ms);
+
+    /**
+     * Serve until lw_broker_stop().
+     *
+     * @return 0 after a stop request, -1 on error (errno set)
+     */
+    int lw_broker_run(lw_broker *broker);
+
+    /**
+     * Ask lw_broker_run() to return. Safe to call from another thread or
+     * a signal handler.
+     */
+    void lw_broker_stop(lw_broker *broker);
+
+    /**
+     * Disconnect every client, close the socket and remove its file. The
+     * bus itself stays open.
+     */
+    void lw_broker_destroy(lw_broker *broker);
+
+    /**
+     * Connect to the broker at `socket_path` and open `bus` as a backend
+     * bus (see lw_open_backend()) whose transactions go through it. The
+     * whole linux_wire.h API then works on `bus` as on a local adapter;
+     * bus->device_path and bus->caps are those of the broker's adapter.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL       - NULL arguments
+     *   ENAMETOOLONG - Path does not fit a sockaddr_un
+     *   EPROTO       - Peer is not a compatible broker
+     *   EUSERS       - Broker already serves LINUX_WIRE_BROKER_MAX_CLIENTS
+     *   plus any errno from socket(), connect(), recvmsg() or mmap()
+     *
+     * Every transaction on `bus` fails with ECONNRESET once the broker
+     * has gone away, and with EMSGSIZE if its payload exceeds
+     * LINUX_WIRE_BROKER_PAYLOAD_MAX.
+     */
+    int lw_broker_connect(lw_broker_client *client, lw_i2c_bus *bus, const char *socket_path);
+
+    /**
+     * Keep the bus for this client from its next request until
+     * lw_broker_end(), so a multi-transaction sequence (write, wait, read
+     * back) is not interleaved with other clients' traffic.
+     *
+     * If the client leaves the bus idle for longer than the broker's
+     * `hold_us`, the hold is broken and the client's next held request
+     * fails with ETIMEDOUT, so a sequence is never silently split.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_broker_begin(lw_broker_client *client);
+
+    /**
+     * Release the bus taken with lw_broker_begin().
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_broker_end(lw_broker_client *client);
+
+    /**
+     * Close the connection and the bus handle opened by
+     * lw_broker_connect().
+     */
+    void lw_broker_disconnect(lw_broker_client *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_BROKER_H */
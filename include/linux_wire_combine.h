@@ -0,0 +1,221 @@
+#ifndef LINUX_WIRE_COMBINE_H
+#define LINUX_WIRE_COMBINE_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Buffered write messages before a flush is forced. */
+#ifndef LINUX_WIRE_COMBINE_MAX_RUNS
+#define LINUX_WIRE_COMBINE_MAX_RUNS 16
+#endif
+
+/** Data bytes one combined message can carry (after the register address). */
+#ifndef LINUX_WIRE_COMBINE_RUN_MAX
+#define LINUX_WIRE_COMBINE_RUN_MAX 128
+#endif
+
+/** Devices that can be declared with lw_combine_add_device(). */
+#ifndef LINUX_WIRE_COMBINE_MAX_DEVICES
+#define LINUX_WIRE_COMBINE_MAX_DEVICES 8
+#endif
+
+    /**
+     * A device whose register pointer auto-increments, so consecutive
+     * register writes may be merged. Private; see lw_combine_add_device().
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t reg_len;
+        uint32_t autoinc;
+    } lw_combine_device;
+
+    /**
+     * One buffered write message. Private.
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t reg_len; /* 0 = raw message, never merged */
+        uint32_t autoinc;
+        uint32_t reg;
+        uint16_t len;
+        uint8_t buf[4 + LINUX_WIRE_COMBINE_RUN_MAX]; /* register bytes end at buf[4] */
+    } lw_combine_run;
+
+    /**
+     * Write combiner: buffers register writes and sends them later as few
+     * messages as possible, all in one combined transaction.
+     *
+     * A register write to a declared device that continues the previous
+     * buffered write (same device, next register) is appended to it, so
+     * the device receives one auto-increment write instead of many. Other
+     * writes to declared devices are buffered as separate messages.
+     *
+     * Only declared devices are buffered, because buffered writes are
+     * joined by repeated STARTs. A write to any other device may need its
+     * STOP (an EEPROM page write, a mux channel select), so it flushes the
+     * buffer and goes out at once as its own transaction. Writes are always
+     * sent in the order they were made.
+     *
+     * Buffered writes are sent:
+     *   - by lw_combine_read(), in the same transaction as the read;
+     *   - by lw_combine_flush(), or lw_combine_commit() closing the
+     *     outermost frame;
+     *   - when the buffer is full;
+     *   - by the first lw_combine_write*() or lw_combine_poll() call more
+     *     than `window_us` after the oldest buffered write, unless a frame
+     *     is open.
+     *
+     * A failed flush drops every buffered write: the caller learns that
+     * the batch failed, not which write.
+     *
+     * Fields (read-only for callers):
+     *   writes       - Writes accepted
+     *   merged       - Writes appended to the previous one
+     *   transactions - Bus transactions issued (flushes, reads,
+     *                  oversized writes and writes to undeclared devices)
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        uint32_t window_us;
+        unsigned int depth;
+        uint64_t deadline_us;
+        size_t run_count;
+        size_t device_count;
+        lw_combine_device devices[LINUX_WIRE_COMBINE_MAX_DEVICES];
+        lw_combine_run runs[LINUX_WIRE_COMBINE_MAX_RUNS];
+        uint64_t writes;
+        uint64_t merged;
+        uint64_t transactions;
+    } lw_combiner;
+
+    /**
+     * Initialize an empty combiner.
+     *
+     * @param window_us Longest time a write may stay buffered outside a
+     *                  frame (0 = until read, commit or flush)
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_combine_init(lw_combiner *comb, uint32_t window_us);
+
+    /**
+     * Declare that device `addr` auto-increments its register pointer, one
+     * register per data byte, so its consecutive register writes may be
+     * merged.
+     *
+     * @param reg_len  Register address size: 1-4 bytes
+     * @param autoinc  Bits OR-ed into the register address of a merged
+     *                 write to turn auto-increment on (e.g. 0x80 for
+     *                 ST sensors), 0 if the device always increments
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL combiner, reg_len not 1-4, or `autoinc` does not fit
+     *            in reg_len bytes
+     *   ENOSPC - LINUX_WIRE_COMBINE_MAX_DEVICES already declared
+     */
+    int lw_combine_add_device(lw_combiner *comb, uint16_t addr, uint8_t reg_len, uint32_t autoinc);
+
+    /**
+     * Buffer a write of `len` bytes to register `reg` of device `addr`.
+     * The register address is sent big-endian in `reg_len` bytes.
+     *
+     * A write to an undeclared device, or one larger than
+     * LINUX_WIRE_COMBINE_RUN_MAX, is not buffered: the buffer is flushed
+     * and the write sent at once with a STOP.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers, reg_len not 1-4, zero `len`
+     *   plus any errno from a flush this call had to make
+     */
+    int lw_combine_write(lw_i2c_bus *bus,
+                         lw_combiner *comb,
+                         uint16_t addr,
+                         uint32_t reg,
+                         uint8_t reg_len,
+                         const uint8_t *data,
+                         size_t len);
+
+    /**
+     * Buffer one write message as it would go on the wire. For a declared
+     * device, the leading reg_len bytes are taken as the register address
+     * and the write may be merged like lw_combine_write(); a shorter
+     * message is buffered as is. A message to any other device is sent at
+     * once, after a flush. This is the form TwoWire uses.
+     *
+     * @return 0 on success, -1 on error (errno set, as lw_combine_write())
+     */
+    int lw_combine_write_msg(lw_i2c_bus *bus,
+                             lw_combiner *comb,
+                             uint16_t addr,
+                             const uint8_t *data,
+                             size_t len);
+
+    /**
+     * Read `len` bytes from register `reg` (`reg_len` 0-4 bytes, 0 = no
+     * register write) after every buffered write, in a single combined
+     * transaction.
+     *
+     * @return Bytes read, -1 on error (errno set; the buffered writes are
+     *         dropped either way)
+     */
+    ssize_t lw_combine_read(lw_i2c_bus *bus,
+                            lw_combiner *comb,
+                            uint16_t addr,
+                            uint32_t reg,
+                            uint8_t reg_len,
+                            uint8_t *dst,
+                            size_t len);
+
+    /**
+     * Open a frame: until the matching lw_combine_commit(), buffered
+     * writes are not flushed by the window. Frames nest.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_combine_begin(lw_combiner *comb);
+
+    /**
+     * Close a frame; closing the outermost one flushes.
+     *
+     * @return 0 on success, -1 on error (errno set; EINVAL without an
+     *         open frame)
+     */
+    int lw_combine_commit(lw_i2c_bus *bus, lw_combiner *comb);
+
+    /**
+     * Send every buffered write now, as one lw_transfer().
+     *
+     * @return 0 on success (also when nothing was buffered), -1 on error
+     *         (errno from lw_transfer())
+     */
+    int lw_combine_flush(lw_i2c_bus *bus, lw_combiner *comb);
+
+    /**
+     * Flush if the oldest buffered write has waited `window_us` and no
+     * frame is open. Call it from the application's loop when writes may
+     * otherwise sit in the buffer.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_combine_poll(lw_i2c_bus *bus, lw_combiner *comb);
+
+    /** Number of buffered write messages. */
+    size_t lw_combine_pending(const lw_combiner *comb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_COMBINE_H */
@@ -0,0 +1,119 @@
+#ifndef LINUX_WIRE_DECODE_H
+#define LINUX_WIRE_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * Byte order of multi-byte values on the wire.
+     * Most sensors send MSB first (LW_BIG_ENDIAN); some IMUs and fuel gauges
+     * use LSB first (LW_LITTLE_ENDIAN).
+     */
+    typedef enum
+    {
+        LW_BIG_ENDIAN = 0,
+        LW_LITTLE_ENDIAN = 1
+    } lw_endian;
+
+    /**
+     * Layout of one sample in a received buffer.
+     *
+     * Fields:
+     *   width     - Bytes per sample: 1, 2, 3 or 4
+     *   endian    - Byte order of the sample
+     *   bits      - Significant bits after shifting (0 = width * 8)
+     *   shift     - Right shift applied first, for left-justified data
+     *               (e.g. a 12-bit accelerometer in the top of 16 bits:
+     *               width = 2, shift = 4, bits = 12)
+     *   is_signed - Non-zero to sign-extend from `bits`
+     *   scale     - Multiplier for float output (e.g. LSB -> g)
+     *   offset    - Added after scaling for float output
+     */
+    typedef struct
+    {
+        uint8_t width;
+        lw_endian endian;
+        uint8_t bits;
+        uint8_t shift;
+        int is_signed;
+        float scale;
+        float offset;
+    } lw_sample_format;
+
+    /**
+     * Decode `count` 16-bit signed samples.
+     *
+     * Uses SSE2 or NEON when available, scalar code otherwise. `src` needs
+     * no particular alignment.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL for NULL buffers)
+     */
+    int lw_decode_i16(const uint8_t *src, size_t count, lw_endian endian, int16_t *dst);
+
+    /**
+     * Decode `count` 16-bit signed samples and multiply each by `scale`.
+     * Typical use is a whole IMU FIFO burst of interleaved X/Y/Z words.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL for NULL buffers)
+     */
+    int lw_decode_i16_to_float(const uint8_t *src,
+                               size_t count,
+                               lw_endian endian,
+                               float scale,
+                               float *dst);
+
+    /**
+     * Decode `count` samples described by `fmt` into 32-bit integers
+     * (sign-extended when `fmt->is_signed`).
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL for NULL pointers or
+     *         an invalid format)
+     */
+    int lw_decode_samples(const lw_sample_format *fmt,
+                          const uint8_t *src,
+                          size_t count,
+                          int32_t *dst);
+
+    /**
+     * Decode `count` samples described by `fmt` into floats
+     * (`value * scale + offset`). Plain signed 16-bit formats take the
+     * vectorized lw_decode_i16_to_float() path.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_decode_samples_float(const lw_sample_format *fmt,
+                                const uint8_t *src,
+                                size_t count,
+                                float *dst);
+
+    /**
+     * Decode multi-channel frames, e.g. 3-axis sensor records in a FIFO
+     * dump that carries a header or other sensors' data in each record.
+     *
+     * @param fmt      Sample format shared by all channels
+     * @param src      First frame
+     * @param frames   Number of frames
+     * @param stride   Bytes from one frame to the next
+     * @param channels Consecutive samples to decode at the start of each frame
+     * @param dst      Output, `frames * channels` floats, interleaved per frame
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL, including a stride
+     *         smaller than `channels * fmt->width`)
+     */
+    int lw_decode_frames_float(const lw_sample_format *fmt,
+                               const uint8_t *src,
+                               size_t frames,
+                               size_t stride,
+                               size_t channels,
+                               float *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_DECODE_H */
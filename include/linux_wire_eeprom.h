@@ -0,0 +1,170 @@
+#ifndef LINUX_WIRE_EEPROM_H
+#define LINUX_WIRE_EEPROM_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Largest write page supported by the streaming writer, in bytes.
+ * 256 covers the biggest serial EEPROM pages in common use (24CM02).
+ */
+#ifndef LINUX_WIRE_EEPROM_PAGE_MAX
+#define LINUX_WIRE_EEPROM_PAGE_MAX 256
+#endif
+
+/** Default worst-case write cycle (tWR) used as the ACK-poll deadline. */
+#ifndef LINUX_WIRE_EEPROM_WRITE_CYCLE_US
+#define LINUX_WIRE_EEPROM_WRITE_CYCLE_US 10000
+#endif
+
+/** Default spacing between ACK polls while a write cycle is in progress. */
+#ifndef LINUX_WIRE_EEPROM_POLL_INTERVAL_US
+#define LINUX_WIRE_EEPROM_POLL_INTERVAL_US 100
+#endif
+
+    /**
+     * Description of a page-organised I2C memory (24Cxx EEPROM, FRAM, flash).
+     *
+     * Fields:
+     *   addr             - 7-bit device address (block-select bits cleared)
+     *   addr_width       - Internal address size in bytes: 1, 2 or 4
+     *   addr_spill_bits  - Memory address bits above the internal address
+     *                      that are carried in the device address low bits
+     *                      (24C04 = 1, 24C08 = 2, 24C16 = 3, otherwise 0)
+     *   page_size        - Write page size in bytes (1..LINUX_WIRE_EEPROM_PAGE_MAX)
+     *   capacity         - Total size in bytes (0 = not range-checked)
+     *   max_transfer     - Largest read per I2C transfer, in bytes
+     *   write_cycle_us   - ACK-poll deadline after each page write
+     *   poll_interval_us - Delay between ACK polls (0 = back-to-back)
+     *
+     * Initialize with lw_eeprom_init() and adjust fields afterwards if the
+     * datasheet calls for it.
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t addr_width;
+        uint8_t addr_spill_bits;
+        uint16_t page_size;
+        uint32_t capacity;
+        uint16_t max_transfer;
+        uint32_t write_cycle_us;
+        uint32_t poll_interval_us;
+    } lw_eeprom;
+
+    /**
+     * In-progress streaming write.
+     *
+     * Data handed to lw_eeprom_stream_write() is packed into a page frame
+     * (internal address + payload) as it arrives; a frame is only sent once
+     * it reaches a page boundary. The next frame is therefore assembled while
+     * the device is still busy with the previous write cycle, and the ACK
+     * poll happens immediately before the next transfer instead of after a
+     * fixed sleep.
+     *
+     * Treat all fields as private.
+     */
+    typedef struct
+    {
+        lw_i2c_bus *bus;
+        const lw_eeprom *dev;
+        uint32_t frame_addr;
+        size_t frame_fill;
+        size_t written;
+        int cycle_pending;
+        uint8_t frame[4 + LINUX_WIRE_EEPROM_PAGE_MAX];
+    } lw_eeprom_stream;
+
+    /**
+     * Fill `dev` with defaults for a memory at `addr`.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL for a NULL handle,
+     *         an address width other than 1/2/4, or an unsupported page size)
+     */
+    int lw_eeprom_init(lw_eeprom *dev,
+                       uint16_t addr,
+                       uint8_t addr_width,
+                       uint16_t page_size,
+                       uint32_t capacity);
+
+    /**
+     * Read `len` bytes starting at memory address `mem_addr`.
+     *
+     * The read is split at `max_transfer` and at block-select boundaries;
+     * each piece is a combined address-write + read transaction.
+     *
+     * @return Number of bytes read on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments or range beyond `capacity`
+     *   plus any errno reported by lw_ioctl_read()
+     */
+    ssize_t lw_eeprom_read(lw_i2c_bus *bus,
+                           const lw_eeprom *dev,
+                           uint32_t mem_addr,
+                           uint8_t *data,
+                           size_t len);
+
+    /**
+     * Write `len` bytes starting at `mem_addr`, splitting at page boundaries
+     * and ACK-polling the write cycle between pages. Returns once the final
+     * write cycle has completed.
+     *
+     * @return Number of bytes written on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL    - Bad arguments or range beyond `capacity`
+     *   ETIMEDOUT - Device did not finish a write cycle within write_cycle_us
+     *   plus any errno reported by lw_ioctl_write()
+     */
+    ssize_t lw_eeprom_write(lw_i2c_bus *bus,
+                            const lw_eeprom *dev,
+                            uint32_t mem_addr,
+                            const uint8_t *data,
+                            size_t len);
+
+    /**
+     * Poll the device until it acknowledges (write cycle finished) or
+     * `write_cycle_us` elapses. Thin wrapper over lw_wait_ready() using the
+     * device's poll interval.
+     *
+     * @return 0 when ready, -1 on error (errno = ETIMEDOUT on deadline)
+     */
+    int lw_eeprom_wait_ready(lw_i2c_bus *bus, const lw_eeprom *dev);
+
+    /**
+     * Start a streaming write at `mem_addr`.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_eeprom_stream_begin(lw_eeprom_stream *stream,
+                               lw_i2c_bus *bus,
+                               const lw_eeprom *dev,
+                               uint32_t mem_addr);
+
+    /**
+     * Append data to a streaming write. Full pages are sent as they fill.
+     *
+     * @return Number of bytes accepted on success, -1 on error (errno set).
+     *         After an error the stream must be restarted.
+     */
+    ssize_t lw_eeprom_stream_write(lw_eeprom_stream *stream,
+                                   const uint8_t *data,
+                                   size_t len);
+
+    /**
+     * Send any partial page and wait for the last write cycle to finish.
+     *
+     * @return Total bytes written by the stream on success, -1 on error
+     */
+    ssize_t lw_eeprom_stream_finish(lw_eeprom_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_EEPROM_H */
@@ -0,0 +1,241 @@
+#ifndef LINUX_WIRE_FAULT_H
+#define LINUX_WIRE_FAULT_H
+
+#include "linux_wire.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Rules an lw_fault can hold. */
+#ifndef LINUX_WIRE_FAULT_MAX_RULES
+#define LINUX_WIRE_FAULT_MAX_RULES 8
+#endif
+
+/** Latency histogram buckets: bucket i counts durations below 2^i us. */
+#define LINUX_WIRE_FAULT_BUCKETS 32
+
+/** lw_fault_rule.addr matching every address. */
+#define LW_FAULT_ANY 0xFFFF
+
+/** Probabilities are given in parts per million. */
+#define LW_FAULT_PPM 1000000u
+
+    /**
+     * What happened to a transaction. Every transaction is counted in
+     * exactly one class: the injected error if there was one, otherwise
+     * LW_FAULT_DELAY if latency was injected, otherwise LW_FAULT_CLEAN
+     * (which includes errors of the lower bus itself).
+     *
+     * Injected errors use the errno the kernel's I2C adapters report:
+     *   LW_FAULT_NACK        - ENXIO, address not acknowledged
+     *   LW_FAULT_EIO         - EIO, generic transfer failure
+     *   LW_FAULT_TIMEOUT     - ETIMEDOUT, after lw_fault.timeout_us
+     *   LW_FAULT_ARBITRATION - EAGAIN, arbitration lost to another master
+     *   LW_FAULT_STUCK       - EBUSY, SDA held low (see lw_fault_stick())
+     */
+    typedef enum
+    {
+        LW_FAULT_CLEAN = 0,
+        LW_FAULT_DELAY,
+        LW_FAULT_NACK,
+        LW_FAULT_EIO,
+        LW_FAULT_TIMEOUT,
+        LW_FAULT_ARBITRATION,
+        LW_FAULT_STUCK,
+        LW_FAULT_CLASS_COUNT
+    } lw_fault_class;
+
+    /** Distribution of injected latency. */
+    typedef enum
+    {
+        LW_FAULT_DELAY_FIXED = 0,   /* always delay_min_us */
+        LW_FAULT_DELAY_UNIFORM,     /* uniform in [delay_min_us, delay_max_us] */
+        LW_FAULT_DELAY_EXPONENTIAL  /* delay_min_us plus an exponential tail
+                                       with mean delay_max_us */
+    } lw_fault_delay_kind;
+
+    /**
+     * Faults injected into messages for one address.
+     *
+     * A message uses the rule for its own address if there is one, else
+     * the LW_FAULT_ANY rule, regardless of the order they were added in.
+     *
+     * Fields:
+     *   addr            - Target address, or LW_FAULT_ANY
+     *   nack_ppm, eio_ppm, timeout_ppm, arbitration_ppm
+     *                   - Chance per message of each error (their sum,
+     *                     plus stuck_ppm, is at most LW_FAULT_PPM)
+     *   stuck_ppm       - Chance per message that the device starts
+     *                     holding SDA low for `stuck_us`
+     *   stuck_us        - Length of such a stuck-bus period
+     *   delay_ppm       - Chance per message of added latency
+     *   delay_kind      - Distribution of that latency
+     *   delay_min_us, delay_max_us - Its parameters
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint32_t nack_ppm;
+        uint32_t eio_ppm;
+        uint32_t timeout_ppm;
+        uint32_t arbitration_ppm;
+        uint32_t stuck_ppm;
+        uint32_t stuck_us;
+        uint32_t delay_ppm;
+        lw_fault_delay_kind delay_kind;
+        uint32_t delay_min_us;
+        uint32_t delay_max_us;
+    } lw_fault_rule;
+
+    /**
+     * Time spent by the transactions of one class. Private; read it
+     * through lw_fault_summary().
+     */
+    typedef struct
+    {
+        uint64_t count;
+        uint64_t total_ns;
+        uint64_t max_ns;
+        uint64_t buckets[LINUX_WIRE_FAULT_BUCKETS];
+    } lw_fault_class_stats;
+
+    /**
+     * Fault injector between the core and a lower bus.
+     *
+     * Opened with lw_fault_open(), it serves a bus handle through
+     * lw_open_backend(). Each transaction is checked against the rules
+     * (the first rule matching a message's address applies to it), the
+     * drawn latency is slept, and the transaction is then either failed
+     * with the drawn error or passed to the lower bus with lw_transfer().
+     * An injected error fails the whole transaction before any of it
+     * reaches the lower bus.
+     *
+     * All draws come from one generator seeded by lw_fault_init(), so the
+     * same seed and the same sequence of transactions give the same
+     * faults. With several threads the sequence depends on their order.
+     *
+     * Every transaction's wall time, from entry to return, is recorded
+     * under its lw_fault_class for lw_fault_summary() and
+     * lw_fault_write_report().
+     *
+     * Fields (set after lw_fault_init()):
+     *   timeout_us - Time an injected timeout, or a transaction on a
+     *                stuck bus, waits before failing (the adapter
+     *                timeout; 0 = fail at once)
+     *   enabled    - Zero passes everything through (still recorded)
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        pthread_mutex_t lock;
+        lw_i2c_bus *lower;
+        uint64_t rng;
+        uint32_t timeout_us;
+        int enabled;
+        uint64_t stuck_until_ns;
+        size_t rule_count;
+        lw_fault_rule rules[LINUX_WIRE_FAULT_MAX_RULES];
+        lw_fault_class_stats stats[LW_FAULT_CLASS_COUNT];
+    } lw_fault;
+
+    /**
+     * Cost of one fault class.
+     *
+     * Fields:
+     *   count      - Transactions in the class
+     *   share      - Fraction of all transactions (0.0-1.0)
+     *   time_share - Fraction of the total time spent in transactions,
+     *                i.e. the throughput the class takes away
+     *   mean_us, p50_us, p99_us, p999_us, max_us - Latency of its
+     *                transactions (percentiles are histogram upper
+     *                bounds, so within a factor of two)
+     */
+    typedef struct
+    {
+        uint64_t count;
+        double share;
+        double time_share;
+        double mean_us;
+        uint64_t p50_us;
+        uint64_t p99_us;
+        uint64_t p999_us;
+        uint64_t max_us;
+    } lw_fault_cost;
+
+    /**
+     * Initialize an injector with no rules over `lower`.
+     *
+     * @param lower Bus the surviving transactions go to (a real bus, a
+     *              simulated one, a broker connection); must outlive the
+     *              injector
+     * @param seed  Generator seed
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_fault_init(lw_fault *fault, lw_i2c_bus *lower, uint64_t seed);
+
+    /** Release the injector's lock. Close buses opened on it first. */
+    void lw_fault_destroy(lw_fault *fault);
+
+    /**
+     * Open `bus` on the injector.
+     *
+     * @param label Reported as bus->device_path (NULL = the lower bus's)
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     *
+     * bus->caps is copied from the lower bus.
+     */
+    int lw_fault_open(lw_fault *fault, lw_i2c_bus *bus, const char *label);
+
+    /**
+     * Add a rule, or replace the rule for the same address.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers, error chances adding up to more than
+     *            LW_FAULT_PPM, delay_ppm above it, unknown delay_kind or
+     *            a uniform range with delay_max_us < delay_min_us
+     *   ENOSPC - LINUX_WIRE_FAULT_MAX_RULES rules already set
+     */
+    int lw_fault_add_rule(lw_fault *fault, const lw_fault_rule *rule);
+
+    /** Remove every rule and end any stuck-bus period. */
+    void lw_fault_clear_rules(lw_fault *fault);
+
+    /** Hold the bus stuck for `us` microseconds from now (0 releases it). */
+    void lw_fault_stick(lw_fault *fault, uint32_t us);
+
+    /** Restart the measurements (rules and generator are kept). */
+    void lw_fault_reset_stats(lw_fault *fault);
+
+    /**
+     * Cost of one class since init or the last lw_fault_reset_stats().
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_fault_summary(lw_fault *fault, lw_fault_class cls, lw_fault_cost *out);
+
+    /** Short name of a class ("clean", "nack", ...), or NULL. */
+    const char *lw_fault_class_name(lw_fault_class cls);
+
+    /**
+     * Write a table of every class with transactions: count, share of
+     * transactions, share of time, mean and tail latency.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_fault_write_report(lw_fault *fault, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_FAULT_H */
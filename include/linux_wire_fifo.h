@@ -0,0 +1,145 @@
+#ifndef LINUX_WIRE_FIFO_H
+#define LINUX_WIRE_FIFO_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Default largest single read message while draining, in bytes. Matches
+ * the core's ioctl payload limit; lower it for adapters with a smaller
+ * maximum read length (e.g. 255 on SMBus-oriented controllers).
+ */
+#ifndef LINUX_WIRE_FIFO_DEFAULT_CHUNK
+#define LINUX_WIRE_FIFO_DEFAULT_CHUNK 4096
+#endif
+
+    /**
+     * Caller-owned byte ring that lw_fifo_drain() writes into.
+     *
+     * `head` and `tail` are free-running byte counters; the storage index is
+     * the counter modulo `size`. One producer (the drain) and one consumer
+     * may use the ring; it is not safe for concurrent use without external
+     * locking.
+     *
+     * Treat all fields as private.
+     */
+    typedef struct
+    {
+        uint8_t *buf;
+        size_t size;
+        size_t head;
+        size_t tail;
+    } lw_fifo_ring;
+
+    /**
+     * Description of a sensor FIFO: a fill-level (count) register and a data
+     * register that pops one byte per read.
+     *
+     * Fields:
+     *   addr          - 7-bit device address
+     *   count_reg     - Register address of the count (big-endian bytes)
+     *   count_reg_len - Bytes in `count_reg` (0-4; 0 = count is read with no
+     *                   register write)
+     *   count_width   - Size of the count value: 1 or 2 bytes
+     *   count_le      - Non-zero when a 2-byte count is LSB first
+     *   count_mask    - Valid bits of the count (0 = all bits)
+     *   count_unit    - Bytes per count LSB (1 when the count is in bytes,
+     *                   e.g. 6 for a sensor that counts XYZ samples)
+     *   data_reg      - Register address of the FIFO data port
+     *   data_reg_len  - Bytes in `data_reg` (0-4)
+     *   frame_size    - Bytes per FIFO record; reads never split a record
+     *   max_chunk     - Largest single read message (adapter limit)
+     *   prefetch      - Data bytes read speculatively in the same transfer
+     *                   as the count (0 = off). Must be a multiple of
+     *                   `frame_size` and no larger than the fill level the
+     *                   FIFO is drained at (e.g. its watermark), because
+     *                   bytes read beyond the reported count are discarded.
+     *   overreads     - Incremented when a prefetch exceeded the count
+     *
+     * Initialize with lw_fifo_init() and adjust fields afterwards.
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t count_reg[4];
+        uint8_t count_reg_len;
+        uint8_t count_width;
+        uint8_t count_le;
+        uint16_t count_mask;
+        uint16_t count_unit;
+        uint8_t data_reg[4];
+        uint8_t data_reg_len;
+        uint16_t frame_size;
+        uint16_t max_chunk;
+        uint16_t prefetch;
+        uint32_t overreads;
+    } lw_fifo;
+
+    /**
+     * Attach `storage` (`size` bytes) to `ring` and empty it.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_fifo_ring_init(lw_fifo_ring *ring, uint8_t *storage, size_t size);
+
+    /** Number of bytes waiting to be consumed. */
+    size_t lw_fifo_ring_used(const lw_fifo_ring *ring);
+
+    /**
+     * Contiguous readable region starting at the oldest byte.
+     *
+     * @param len Set to the region length (may be less than
+     *            lw_fifo_ring_used() when the data wraps)
+     *
+     * @return Pointer into the ring storage, or NULL when empty
+     */
+    const uint8_t *lw_fifo_ring_peek(const lw_fifo_ring *ring, size_t *len);
+
+    /** Drop `len` bytes (clamped to the used count) after lw_fifo_ring_peek(). */
+    void lw_fifo_ring_consume(lw_fifo_ring *ring, size_t len);
+
+    /**
+     * Copy out and consume up to `len` bytes.
+     *
+     * @return Number of bytes copied
+     */
+    size_t lw_fifo_ring_pop(lw_fifo_ring *ring, uint8_t *dst, size_t len);
+
+    /**
+     * Fill `fifo` with defaults for a device with 1-byte count and data
+     * registers: 2-byte big-endian count in bytes, 1-byte frames,
+     * LINUX_WIRE_FIFO_DEFAULT_CHUNK reads, no prefetch.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_fifo_init(lw_fifo *fifo, uint16_t addr, uint8_t count_reg, uint8_t data_reg);
+
+    /**
+     * Read the FIFO level and move every complete frame into `ring`.
+     *
+     * The count read (plus any prefetch) is one combined I2C_RDWR
+     * transaction. The remaining data is then read in `max_chunk` pieces,
+     * each preceded by a data-register write, batched into as few
+     * lw_transfer() calls as LW_MAX_MSGS allows. Reads land directly in the
+     * ring storage, split at the wrap point. If the ring cannot hold the
+     * whole FIFO, only the frames that fit are read and the rest stay in
+     * the device for the next call.
+     *
+     * @return Number of bytes appended to `ring` on success, -1 on error
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments, an invalid lw_fifo description, or a ring
+     *            whose size is not a multiple of `frame_size`
+     *   plus any errno reported by lw_transfer()
+     */
+    ssize_t lw_fifo_drain(lw_i2c_bus *bus, lw_fifo *fifo, lw_fifo_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_FIFO_H */
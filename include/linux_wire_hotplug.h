@@ -0,0 +1,191 @@
+#ifndef LINUX_WIRE_HOTPLUG_H
+#define LINUX_WIRE_HOTPLUG_H
+
+#include "linux_wire.h"
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Adapters one lw_hotplug can follow. */
+#ifndef LINUX_WIRE_HOTPLUG_MAX_SLOTS
+#define LINUX_WIRE_HOTPLUG_MAX_SLOTS 8
+#endif
+
+/** Size of the identity strings in lw_hotplug_slot, including the terminator. */
+#define LINUX_WIRE_HOTPLUG_MATCH_MAX 128
+
+/** Size of the directory names in lw_hotplug, including the terminator. */
+#define LINUX_WIRE_HOTPLUG_ROOT_MAX 128
+
+/** lw_hotplug_init() flag: also listen to kernel uevents (netlink). */
+#define LW_HOTPLUG_UEVENT 0x0001u
+
+    /**
+     * One adapter followed by its identity. Private; see lw_hotplug_add().
+     *
+     * `generation` changes every time the adapter appears, disappears or
+     * is replaced; handles opened at an older generation are stale.
+     */
+    typedef struct
+    {
+        char name[LINUX_WIRE_HOTPLUG_MATCH_MAX];
+        char parent[LINUX_WIRE_HOTPLUG_MATCH_MAX];
+        char device_path[LINUX_WIRE_DEVICE_PATH_MAX];
+        int adapter;
+        int lost;
+        uint64_t generation;
+    } lw_hotplug_slot;
+
+    /**
+     * Hot-plug monitor for I2C adapters that come and go, such as USB
+     * bridges (CP2112, MCP2221) that reappear as a different /dev/i2c-N.
+     *
+     * Each slot names an adapter by a stable identity instead of its
+     * number: a prefix of its sysfs `name` and/or a substring of its
+     * resolved sysfs device path (e.g. the USB port "1-1.2:"). The monitor
+     * watches the device directory with inotify, and optionally kernel
+     * uevents, and re-resolves the slots when an i2c-N node is created,
+     * removed or has its permissions changed. No polling is involved: the
+     * caller waits in lw_hotplug_run_once(), typically on its own thread.
+     *
+     * An adapter counts as present once its node exists and is readable
+     * and writable, so a node still waiting for udev to fix its
+     * permissions is not reported early.
+     *
+     * Handles are reopened lazily by their owner with lw_hotplug_reopen()
+     * (TwoWire does this itself, see TwoWire::setHotplug()), so the
+     * monitor never touches a handle another thread is using.
+     *
+     * Fields (read-only for callers):
+     *   inotify_fd - Watch on the device directory
+     *   uevent_fd  - Kernel uevent socket (-1 when not requested or not
+     *                available)
+     *   events     - Notifications that caused a rescan
+     *   changes    - Slot appearances, disappearances and replacements
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        pthread_mutex_t lock;
+        int inotify_fd;
+        int uevent_fd;
+        char dev_root[LINUX_WIRE_HOTPLUG_ROOT_MAX];
+        char sysfs_root[LINUX_WIRE_HOTPLUG_ROOT_MAX];
+        lw_hotplug_slot slots[LINUX_WIRE_HOTPLUG_MAX_SLOTS];
+        size_t count;
+        uint64_t events;
+        uint64_t changes;
+    } lw_hotplug;
+
+    /**
+     * Find the adapter with the given identity.
+     *
+     * @param name       Prefix of the adapter's sysfs name (NULL or "" = any)
+     * @param parent     Substring of its resolved sysfs path (NULL or "" = any)
+     * @param sysfs_root NULL = LINUX_WIRE_SYSFS_I2C_ROOT
+     * @param adapter    Receives N of the lowest-numbered match
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL `adapter`
+     *   ENOENT - No adapter matches
+     */
+    int lw_adapter_find(const char *name, const char *parent, const char *sysfs_root, unsigned int *adapter);
+
+    /**
+     * Start watching for adapters.
+     *
+     * @param dev_root   Directory holding the i2c-N nodes (NULL = "/dev");
+     *                   node paths must fit LINUX_WIRE_DEVICE_PATH_MAX
+     * @param sysfs_root NULL = LINUX_WIRE_SYSFS_I2C_ROOT
+     * @param flags      0 or LW_HOTPLUG_UEVENT; the uevent socket is
+     *                   skipped silently when it cannot be opened
+     *
+     * @return 0 on success, -1 on error (errno set by inotify; EINVAL for
+     *         bad arguments or roots too long)
+     */
+    int lw_hotplug_init(lw_hotplug *hp, const char *dev_root, const char *sysfs_root, unsigned int flags);
+
+    /** Close the notification descriptors. */
+    void lw_hotplug_close(lw_hotplug *hp);
+
+    /**
+     * Follow the adapter with the given identity (see lw_adapter_find()).
+     * The slot is resolved at once.
+     *
+     * @return Slot index on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL `hp`, or an identity string too long
+     *   ENOSPC - LINUX_WIRE_HOTPLUG_MAX_SLOTS slots in use
+     */
+    int lw_hotplug_add(lw_hotplug *hp, const char *name, const char *parent);
+
+    /**
+     * Wait up to `timeout_ms` for device notifications, then re-resolve
+     * the slots.
+     *
+     * @param timeout_ms Maximum wait in milliseconds (-1 = no limit)
+     *
+     * @return Number of slots that changed (0 on timeout), -1 on error
+     *         (errno set by poll())
+     */
+    int lw_hotplug_run_once(lw_hotplug *hp, int timeout_ms);
+
+    /**
+     * Re-resolve every slot now.
+     *
+     * @return Number of slots that changed, -1 on error (errno = EINVAL)
+     */
+    int lw_hotplug_rescan(lw_hotplug *hp);
+
+    /** Current generation of a slot (0 for an unknown slot). Lock-free. */
+    uint64_t lw_hotplug_generation(lw_hotplug *hp, size_t slot);
+
+    /**
+     * Copy the node a slot currently resolves to.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments or unknown slot
+     *   ENODEV - Adapter not present
+     */
+    int lw_hotplug_path(lw_hotplug *hp, size_t slot, char *path, size_t size);
+
+    /**
+     * Bring `bus` up to date with a slot. `*generation` records the slot
+     * generation the handle was opened at (start with 0).
+     *
+     * @return 1 when the bus was (re)opened, 0 when it was already
+     *         current, -1 on error (errno set; the bus is closed on every
+     *         error except a NULL `bus`)
+     *
+     * Error conditions:
+     *   EINVAL - NULL `bus` or `generation`, or unknown slot
+     *   ENODEV - Adapter not present
+     *   plus any errno reported by lw_open_bus()
+     *
+     * Cheap when nothing changed: one atomic load. Call it before using
+     * the handle, on the thread that owns it.
+     *
+     * Once the handle has been opened here (`*generation` non-zero), a
+     * reopen keeps its timeout, error logging, observer, scratch pool and
+     * realtime mode with its error ring; the pool allocated by
+     * lw_bus_enable_rt() is reused, not reallocated. A failed reopen
+     * leaves them on the closed handle for the next call, so release the
+     * handle with lw_close_bus() when giving up on it.
+     */
+    int lw_hotplug_reopen(lw_hotplug *hp, size_t slot, lw_i2c_bus *bus, uint64_t *generation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_HOTPLUG_H */
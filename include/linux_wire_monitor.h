@@ -0,0 +1,185 @@
+#ifndef LINUX_WIRE_MONITOR_H
+#define LINUX_WIRE_MONITOR_H
+
+#include "linux_wire.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Number of history slots; the longest window is slots * slot_us. */
+#ifndef LINUX_WIRE_MONITOR_SLOTS
+#define LINUX_WIRE_MONITOR_SLOTS 240
+#endif
+
+/** Default slot length: 240 x 250 ms covers a 60 s window. */
+#ifndef LINUX_WIRE_MONITOR_SLOT_US
+#define LINUX_WIRE_MONITOR_SLOT_US 250000u
+#endif
+
+/** Clock assumed when the adapter does not report one (standard mode). */
+#ifndef LINUX_WIRE_MONITOR_DEFAULT_HZ
+#define LINUX_WIRE_MONITOR_DEFAULT_HZ 100000u
+#endif
+
+/** Size of lw_monitor.label, including the terminator. */
+#define LINUX_WIRE_MONITOR_LABEL_MAX 32
+
+    /**
+     * Busy time accumulated in one history slot. Private.
+     */
+    typedef struct
+    {
+        uint64_t index;
+        uint64_t busy_ns;
+    } lw_monitor_slot;
+
+    /**
+     * Utilization monitor for one bus.
+     *
+     * Each observed transaction is converted into an estimated on-wire
+     * time: START or repeated START, address byte(s) with ACK, 9 bit times
+     * per payload byte and a STOP, at `bus_hz`. The estimate ignores clock
+     * stretching and inter-byte gaps, so real occupancy is somewhat higher.
+     *
+     * Recording takes no locks, so a monitor may observe a realtime bus
+     * (see lw_open_bus_rt()). One thread records at a time, which holds
+     * for a bus observer since a bus is used by one thread at a time;
+     * queries may run concurrently on other threads.
+     *
+     * Fields (read-only for callers):
+     *   label  - Bus label used in reports (e.g. "i2c-1")
+     *   bus_hz - Clock used for the estimate
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        char label[LINUX_WIRE_MONITOR_LABEL_MAX];
+        uint32_t bus_hz;
+        uint32_t slot_us;
+        uint64_t started_us;
+        uint64_t transactions;
+        uint64_t bytes;
+        uint64_t errors;
+        uint64_t busy_ns;
+        lw_monitor_slot slots[LINUX_WIRE_MONITOR_SLOTS];
+    } lw_monitor;
+
+    /**
+     * Snapshot of a monitor.
+     *
+     * Fields:
+     *   transactions - Transactions observed (including failed ones)
+     *   bytes        - Payload bytes moved
+     *   errors       - Transactions that failed
+     *   busy_ns      - Estimated total on-wire time
+     *   busy_1s, busy_10s, busy_60s - Busy fraction (0.0-1.0) over the
+     *                  last 1, 10 and 60 seconds (clipped to the history
+     *                  length and to the monitor's age)
+     */
+    typedef struct
+    {
+        uint64_t transactions;
+        uint64_t bytes;
+        uint64_t errors;
+        uint64_t busy_ns;
+        double busy_1s;
+        double busy_10s;
+        double busy_60s;
+    } lw_monitor_stats;
+
+    /**
+     * Initialize a monitor for `bus`. The clock comes from the adapter's
+     * device tree node (bus->caps.bus_hz) when known, else
+     * LINUX_WIRE_MONITOR_DEFAULT_HZ; the label is the device name
+     * ("i2c-1" for "/dev/i2c-1").
+     *
+     * @param bus     Bus the figures describe (may be closed; NULL = "i2c")
+     * @param slot_us History resolution (0 = LINUX_WIRE_MONITOR_SLOT_US)
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL for a NULL monitor)
+     */
+    int lw_monitor_init(lw_monitor *mon, const lw_i2c_bus *bus, uint32_t slot_us);
+
+    /**
+     * Override the clock used for the estimate (e.g. when the adapter has
+     * no device tree node).
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_monitor_set_bus_hz(lw_monitor *mon, uint32_t bus_hz);
+
+    /**
+     * Record every transaction on `bus` from now on (installs the bus
+     * observer). Remove with lw_bus_set_observer(bus, NULL, NULL).
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_monitor_attach(lw_monitor *mon, lw_i2c_bus *bus);
+
+    /**
+     * Estimated on-wire time of one transaction, in nanoseconds.
+     * A failed transaction counts as its first address byte and a STOP.
+     */
+    uint64_t lw_monitor_wire_ns(uint32_t bus_hz, const lw_xfer_event *event);
+
+    /**
+     * Record one transaction that completed now. Usable directly as an
+     * lw_observer_fn with the monitor as `arg`.
+     */
+    void lw_monitor_record(void *mon, const lw_xfer_event *event);
+
+    /**
+     * Record one transaction that completed at `now_us` (CLOCK_MONOTONIC
+     * microseconds). For replaying traces and for tests.
+     */
+    void lw_monitor_record_at(lw_monitor *mon, const lw_xfer_event *event, uint64_t now_us);
+
+    /**
+     * Busy fraction over the last `window_us`, evaluated at `now_us`
+     * (0 = now). Only completed slots count, so the figure lags by up to
+     * one slot.
+     *
+     * @return Fraction between 0.0 and 1.0 (0.0 for a NULL monitor)
+     */
+    double lw_monitor_busy_ratio(lw_monitor *mon, uint64_t window_us, uint64_t now_us);
+
+    /**
+     * Snapshot counters and the standard windows.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_monitor_get_stats(lw_monitor *mon, lw_monitor_stats *stats);
+
+    /**
+     * Write the monitors in Prometheus text exposition format:
+     * linux_wire_bus_busy_ratio{bus,window}, linux_wire_bus_clock_hz and
+     * the transactions/bytes/errors/busy-seconds counters, one label set
+     * per monitor.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_monitor_write_prometheus(lw_monitor *const *mons, size_t count, FILE *out);
+
+    /**
+     * Write the Prometheus text to `path` atomically (temporary file +
+     * rename()), as expected by the node_exporter textfile collector.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_monitor_dump_prometheus(lw_monitor *const *mons, size_t count, const char *path);
+
+    /**
+     * Release the monitor. Detach it from its bus first.
+     */
+    void lw_monitor_destroy(lw_monitor *mon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_MONITOR_H */
@@ -0,0 +1,187 @@
+#ifndef LINUX_WIRE_MUX_H
+#define LINUX_WIRE_MUX_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Channels of the largest supported switch (TCA9548A/PCA9548A). */
+#define LINUX_WIRE_MUX_MAX_CHANNELS 8
+
+/** lw_mux_select() channel that disconnects every downstream segment. */
+#define LW_MUX_NONE (-1)
+
+/** lw_mux.current when the switch state is unknown. */
+#define LW_MUX_UNKNOWN (-2)
+
+/**
+ * lw_mux.flags: the switch applies a new control byte as soon as it is
+ * acknowledged, so the selection can share an I2C_RDWR with the device
+ * transfer (repeated START, no STOP). Do NOT set this for the PCA954x /
+ * TCA954x family: those only connect the new channel after a STOP.
+ */
+#define LW_MUX_SELECT_ON_ACK 0x0001u
+
+    /**
+     * Userspace-managed I2C switch (PCA9543/9545/9546/9548, TCA9548A and
+     * compatibles) whose control register holds one bit per channel.
+     *
+     * The last written selection is cached, so transfers to a device on
+     * the channel that is already connected cost no extra bus traffic.
+     * The cache assumes this handle is the only writer of the switch; call
+     * lw_mux_invalidate() if another process or master may have changed
+     * it. Failed transfers invalidate it automatically.
+     *
+     * Fields (read-only for callers):
+     *   current  - Selected channel, LW_MUX_NONE or LW_MUX_UNKNOWN
+     *   switches - Control-register writes issued
+     *   skipped  - Selections satisfied from the cache
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        lw_i2c_bus *bus;
+        uint16_t addr;
+        uint8_t channels;
+        unsigned int flags;
+        int current;
+        uint8_t control;
+        uint64_t switches;
+        uint64_t skipped;
+    } lw_mux;
+
+    /**
+     * One unit of work for lw_mux_run().
+     *
+     * Fields:
+     *   channel - Downstream channel of the target device
+     *   msgs    - Messages to run on that channel
+     *   count   - Number of messages
+     *   result  - lw_transfer() return value (set by lw_mux_run())
+     *   error   - errno when `result` is -1, else 0
+     */
+    typedef struct
+    {
+        uint8_t channel;
+        const lw_msg *msgs;
+        size_t count;
+        int result;
+        int error;
+    } lw_mux_job;
+
+    /**
+     * Where a kernel-managed mux channel (a virtual /dev/i2c-N created by
+     * an i2c-mux driver) sits on its parent bus.
+     *
+     * Fields:
+     *   parent  - Parent adapter number
+     *   addr    - Address of the switch on the parent
+     *   channel - Channel number, or -1 if it could not be determined
+     */
+    typedef struct
+    {
+        unsigned int parent;
+        uint16_t addr;
+        int channel;
+    } lw_mux_adapter;
+
+    /**
+     * Initialize a switch at `addr` with `channels` channels (1-8). The
+     * state starts as LW_MUX_UNKNOWN, so the first transfer always
+     * selects.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_mux_init(lw_mux *mux, lw_i2c_bus *bus, uint16_t addr, uint8_t channels);
+
+    /**
+     * Connect `channel` (or disconnect all with LW_MUX_NONE). No bus
+     * traffic when the cached state already matches.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Channel out of range
+     *   plus any errno reported by lw_ioctl_write()
+     */
+    int lw_mux_select(lw_mux *mux, int channel);
+
+    /**
+     * Forget the cached selection (e.g. after another master used the
+     * switch or the switch was reset).
+     */
+    void lw_mux_invalidate(lw_mux *mux);
+
+    /**
+     * Run `msgs` on a device behind `channel`, selecting it first when
+     * needed. With LW_MUX_SELECT_ON_ACK the selection is the first message
+     * of the same I2C_RDWR; otherwise it is a separate write.
+     *
+     * @return Number of device messages transferred, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments, or count + 1 above LW_MAX_MSGS when the
+     *            selection is folded in
+     *   plus any errno reported by lw_ioctl_write() or lw_transfer()
+     */
+    int lw_mux_transfer(lw_mux *mux, uint8_t channel, const lw_msg *msgs, size_t count);
+
+    /**
+     * Register read from a device behind `channel`: register write
+     * (big-endian, `reg_len` bytes) and read of `len` bytes into `dst`.
+     *
+     * @return Bytes read on success, -1 on error (errno set)
+     */
+    ssize_t lw_mux_read_reg(lw_mux *mux,
+                            uint8_t channel,
+                            uint16_t addr,
+                            uint32_t reg,
+                            uint8_t reg_len,
+                            uint8_t *dst,
+                            uint16_t len);
+
+    /**
+     * Run a batch of jobs, grouped by channel to minimise switching: jobs
+     * on the currently selected channel run first, then the remaining
+     * channels in ascending order. Jobs on the same channel keep their
+     * relative order. Each job's outcome is stored in the job.
+     *
+     * @return Number of jobs that failed, -1 on error (errno = EINVAL)
+     */
+    int lw_mux_run(lw_mux *mux, lw_mux_job *jobs, size_t count);
+
+    /**
+     * Resolve a kernel i2c-mux virtual adapter to its parent bus, switch
+     * address and channel, using `<root>/i2c-N/mux_device` and the switch's
+     * `channel-K` links.
+     *
+     * @param sysfs_root NULL = LINUX_WIRE_SYSFS_I2C_ROOT
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL `info`
+     *   ENOENT - Adapter does not exist or is not a mux channel
+     */
+    int lw_mux_find_parent(unsigned int adapter, const char *sysfs_root, lw_mux_adapter *info);
+
+    /**
+     * Check whether a kernel driver already owns the switch at `addr` on
+     * adapter `parent`. Such a switch must not also be driven with lw_mux;
+     * use its virtual adapters instead.
+     *
+     * @param sysfs_root NULL = LINUX_WIRE_SYSFS_I2C_ROOT
+     *
+     * @return 1 if bound to a driver, 0 otherwise
+     */
+    int lw_mux_kernel_owned(unsigned int parent, uint16_t addr, const char *sysfs_root);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_MUX_H */
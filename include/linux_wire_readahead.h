@@ -0,0 +1,143 @@
+#ifndef LINUX_WIRE_READAHEAD_H
+#define LINUX_WIRE_READAHEAD_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Largest read-ahead block (and largest read served from the cache). */
+#ifndef LINUX_WIRE_READAHEAD_BLOCK_MAX
+#define LINUX_WIRE_READAHEAD_BLOCK_MAX 64
+#endif
+
+/** Devices that can be declared with lw_readahead_add_device(). */
+#ifndef LINUX_WIRE_READAHEAD_MAX_DEVICES
+#define LINUX_WIRE_READAHEAD_MAX_DEVICES 8
+#endif
+
+/** lw_readahead_invalidate() address selecting every device. */
+#define LW_READAHEAD_ALL 0xFFFF
+
+    /**
+     * Read-ahead state of one device. Private; see lw_readahead_add_device().
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t reg_len;
+        uint8_t has_next;
+        uint32_t autoinc;
+        uint16_t block;
+        uint32_t max_age_us;
+        uint32_t next;  /* register after the last one read */
+        uint32_t base;  /* register of data[0] */
+        uint16_t valid; /* cached bytes, 0 = empty */
+        uint64_t fetched_us;
+        uint8_t data[LINUX_WIRE_READAHEAD_BLOCK_MAX];
+    } lw_readahead_device;
+
+    /**
+     * Register read-ahead for auto-incrementing devices.
+     *
+     * A register read that starts where the previous read of the same
+     * device ended is treated as sequential access: instead of the
+     * requested bytes, a whole block is fetched in one transaction, and
+     * the following forward reads are served from it without touching the
+     * bus. A driver reading registers N, N+1, N+2, ... one byte at a time
+     * then costs one transaction per block instead of one per register.
+     *
+     * The cached block is dropped when it is older than the device's age
+     * limit, on lw_readahead_invalidate() (call it for every write to the
+     * device), and on a failed read. A read that goes backwards (for
+     * instance polling the same status register again) is never served
+     * from the cache.
+     *
+     * Fields (read-only for callers):
+     *   reads   - lw_readahead_read() calls
+     *   hits    - Reads served from a cached block
+     *   fetches - Block fetches triggered by sequential access
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        size_t device_count;
+        lw_readahead_device devices[LINUX_WIRE_READAHEAD_MAX_DEVICES];
+        uint64_t reads;
+        uint64_t hits;
+        uint64_t fetches;
+    } lw_readahead;
+
+    /**
+     * Initialize read-ahead with no devices declared.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_readahead_init(lw_readahead *ra);
+
+    /**
+     * Enable read-ahead for device `addr`. Redeclaring a device replaces
+     * its settings and drops its cached block.
+     *
+     * @param reg_len    Register address size: 1-4 bytes
+     * @param autoinc    Bits OR-ed into the register address of a block
+     *                   fetch to turn auto-increment on (e.g. 0x80 for ST
+     *                   sensors), 0 if the device always increments.
+     *                   Ignored when matching registers.
+     * @param block      Bytes fetched per block (1..LINUX_WIRE_READAHEAD_BLOCK_MAX).
+     *                   Fetches run past the last register read, so keep
+     *                   `block` within the device's register map.
+     * @param max_age_us Longest time a block may serve reads (0 = until
+     *                   invalidated)
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointer, reg_len not 1-4, `autoinc` does not fit in
+     *            reg_len bytes, or `block` out of range
+     *   ENOSPC - LINUX_WIRE_READAHEAD_MAX_DEVICES already declared
+     */
+    int lw_readahead_add_device(lw_readahead *ra,
+                                uint16_t addr,
+                                uint8_t reg_len,
+                                uint32_t autoinc,
+                                uint16_t block,
+                                uint32_t max_age_us);
+
+    /**
+     * Read `len` bytes from register `reg` (big-endian, `reg_len` 0-4
+     * bytes), from the cached block when possible.
+     *
+     * Reads from undeclared devices, with a different register size or
+     * longer than LINUX_WIRE_READAHEAD_BLOCK_MAX go straight to
+     * lw_ioctl_read().
+     *
+     * @return Bytes read on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers, zero `len`, reg_len above 4
+     *   plus any errno reported by lw_ioctl_read()
+     */
+    ssize_t lw_readahead_read(lw_i2c_bus *bus,
+                              lw_readahead *ra,
+                              uint16_t addr,
+                              uint32_t reg,
+                              uint8_t reg_len,
+                              uint8_t *dst,
+                              size_t len);
+
+    /**
+     * Drop the cached block and sequence of device `addr` (or of every
+     * device with LW_READAHEAD_ALL). Call after writing to the device, or
+     * after anything else that may change its registers or pointer.
+     */
+    void lw_readahead_invalidate(lw_readahead *ra, uint16_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_READAHEAD_H */
@@ -0,0 +1,188 @@
+#ifndef LINUX_WIRE_RUNTIME_H
+#define LINUX_WIRE_RUNTIME_H
+
+#include "linux_wire.h"
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Maximum number of adapters (workers) one runtime can drive. */
+#ifndef LINUX_WIRE_RUNTIME_MAX_WORKERS
+#define LINUX_WIRE_RUNTIME_MAX_WORKERS 8
+#endif
+
+    /**
+     * Work executed on an adapter's worker thread with exclusive use of
+     * that adapter's bus handle.
+     *
+     * @return Non-negative on success, -1 on error with errno set; both are
+     *         reported back through lw_job.
+     */
+    typedef int (*lw_job_fn)(lw_i2c_bus *bus, void *arg);
+
+    struct lw_worker;
+
+    /**
+     * One queued unit of work. Caller-owned: it must stay valid until
+     * lw_runtime_wait() returns for it.
+     *
+     * Fields:
+     *   fn, arg - Work to run (set by the caller)
+     *   result  - Return value of fn (valid after completion)
+     *   error   - errno captured when fn returned -1, else 0
+     *
+     * The remaining fields are private.
+     */
+    typedef struct lw_job
+    {
+        lw_job_fn fn;
+        void *arg;
+        int result;
+        int error;
+        int done;
+        struct lw_worker *owner;
+        struct lw_job *next;
+    } lw_job;
+
+    /**
+     * Placement of one worker.
+     *
+     * Fields:
+     *   adapter  - Adapter number; the worker opens /dev/i2c-<adapter>
+     *   cpu      - CPU to pin the worker to (-1 = no pinning)
+     *   priority - SCHED_FIFO priority (0 = normal SCHED_OTHER thread).
+     *              Real-time priorities need CAP_SYS_NICE or an
+     *              RLIMIT_RTPRIO allowance.
+     */
+    typedef struct
+    {
+        unsigned int adapter;
+        int cpu;
+        int priority;
+    } lw_worker_config;
+
+    /**
+     * Per-worker utilization counters.
+     *
+     * Fields:
+     *   jobs        - Jobs completed
+     *   busy_us     - Time spent inside job functions
+     *   elapsed_us  - Time since the worker started
+     *   queue_depth - Jobs currently queued (not yet started)
+     *
+     * Utilization is busy_us / elapsed_us.
+     */
+    typedef struct
+    {
+        uint64_t jobs;
+        uint64_t busy_us;
+        uint64_t elapsed_us;
+        uint32_t queue_depth;
+    } lw_worker_stats;
+
+    /**
+     * Worker thread state. Private; declared here so lw_runtime can be
+     * allocated statically.
+     */
+    typedef struct lw_worker
+    {
+        lw_worker_config config;
+        lw_i2c_bus bus;
+        pthread_t thread;
+        pthread_mutex_t lock;
+        pthread_cond_t work_cond;
+        pthread_cond_t done_cond;
+        lw_job *head;
+        lw_job *tail;
+        int stopping;
+        uint64_t started_us;
+        uint64_t busy_us;
+        uint64_t jobs;
+        uint32_t queue_depth;
+    } lw_worker;
+
+    /**
+     * Set of per-adapter workers. Each adapter gets its own thread, bus
+     * handle and queue, so traffic on different adapters never contends on
+     * a shared lock and can run on separate cores.
+     *
+     * Add all workers before submitting work; submission from any number of
+     * threads is then safe. Treat all fields as private.
+     */
+    typedef struct
+    {
+        lw_worker workers[LINUX_WIRE_RUNTIME_MAX_WORKERS];
+        size_t count;
+    } lw_runtime;
+
+    /**
+     * Initialize an empty runtime.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_runtime_init(lw_runtime *rt);
+
+    /**
+     * Open /dev/i2c-<adapter> and start its worker thread with the
+     * requested CPU affinity and scheduling priority.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers, negative priority or CPU out of range
+     *   EEXIST - A worker for this adapter already exists
+     *   ENOSPC - LINUX_WIRE_RUNTIME_MAX_WORKERS reached
+     *   EPERM  - Not allowed to use SCHED_FIFO at the requested priority
+     *   plus any errno reported by lw_open_bus() or pthread_create()
+     */
+    int lw_runtime_add_worker(lw_runtime *rt, const lw_worker_config *config);
+
+    /**
+     * Queue `job` on the worker that owns `adapter`. Returns immediately.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers or job->fn not set
+     *   ENODEV - No worker for `adapter`
+     *   ESHUTDOWN - Runtime is shutting down
+     */
+    int lw_runtime_submit(lw_runtime *rt, unsigned int adapter, lw_job *job);
+
+    /**
+     * Block until a submitted job has run.
+     *
+     * @return job->result; errno is set to job->error when it is -1
+     */
+    int lw_runtime_wait(lw_job *job);
+
+    /**
+     * Run fn(bus, arg) on the adapter's worker and wait for it
+     * (submit + wait with a stack job).
+     *
+     * @return Return value of fn, or -1 with errno set
+     */
+    int lw_runtime_call(lw_runtime *rt, unsigned int adapter, lw_job_fn fn, void *arg);
+
+    /**
+     * Snapshot the utilization counters of the worker for `adapter`.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL or ENODEV)
+     */
+    int lw_runtime_get_stats(lw_runtime *rt, unsigned int adapter, lw_worker_stats *stats);
+
+    /**
+     * Stop all workers after they finish their queued jobs, then close
+     * their buses. The runtime can be re-initialized afterwards.
+     */
+    void lw_runtime_shutdown(lw_runtime *rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_RUNTIME_H */
@@ -0,0 +1,180 @@
+#ifndef LINUX_WIRE_SCHED_H
+#define LINUX_WIRE_SCHED_H
+
+#include "linux_wire.h"
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Default preemption granularity for chunked transfers, in payload bytes.
+ * Small enough that a waiting high-priority client never sits behind more
+ * than ~3 ms of traffic at 100 kHz.
+ */
+#ifndef LINUX_WIRE_SCHED_DEFAULT_CHUNK
+#define LINUX_WIRE_SCHED_DEFAULT_CHUNK 32
+#endif
+
+    /**
+     * Ordering policy used when several clients wait for the bus.
+     *
+     *   LW_SCHED_PRIORITY - highest lw_sched_tag.priority runs first
+     *   LW_SCHED_EDF      - earliest absolute deadline runs first; waiters
+     *                       without a deadline run after all deadlined work
+     *
+     * Ties are always broken in arrival (FIFO) order.
+     */
+    typedef enum
+    {
+        LW_SCHED_PRIORITY = 0,
+        LW_SCHED_EDF = 1
+    } lw_sched_policy;
+
+    /**
+     * Per-transaction scheduling tag supplied by the client.
+     *
+     * Fields:
+     *   priority    - Larger value wins under LW_SCHED_PRIORITY
+     *   deadline_us - Relative deadline in microseconds, measured from the
+     *                 start of the transaction (0 = no deadline). Used by
+     *                 LW_SCHED_EDF. Chunked transfers keep the deadline of
+     *                 the whole transaction for every chunk.
+     */
+    typedef struct
+    {
+        int priority;
+        uint32_t deadline_us;
+    } lw_sched_tag;
+
+    struct lw_sched_waiter;
+
+    /**
+     * Priority-aware arbiter for one shared lw_i2c_bus.
+     *
+     * Every client thread goes through the scheduler instead of calling the
+     * lw_ioctl_* helpers directly. Large transfers are split into chunks of
+     * `chunk_size` bytes and the bus is re-arbitrated between chunks, so a
+     * kilobyte EEPROM dump cannot hold off a control-loop read for longer
+     * than one chunk.
+     *
+     * The structure is transparent so it can live on the stack or in static
+     * storage; treat all fields as private and use the functions below.
+     * Waiter bookkeeping uses stack nodes of the calling threads, so
+     * arbitration never allocates. It does take a mutex and waits for the
+     * current owner, so it is outside the realtime-mode guarantee of
+     * lw_open_bus_rt().
+     */
+    typedef struct
+    {
+        lw_i2c_bus *bus;
+        lw_sched_policy policy;
+        size_t chunk_size;
+        pthread_mutex_t lock;
+        pthread_cond_t cond;
+        int busy;
+        uint64_t next_ticket;
+        struct lw_sched_waiter *waiters;
+    } lw_sched;
+
+    /**
+     * Initialize a scheduler for an already-open bus.
+     *
+     * @param sched  Scheduler to initialize
+     * @param bus    Open bus handle shared by all clients (not owned)
+     * @param policy Queue ordering policy
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers or unknown policy
+     *   ENOMEM/EAGAIN - pthread primitive initialization failed
+     */
+    int lw_sched_init(lw_sched *sched, lw_i2c_bus *bus, lw_sched_policy policy);
+
+    /**
+     * Release scheduler resources. No client may be inside the scheduler.
+     * The bus itself is left open.
+     */
+    void lw_sched_destroy(lw_sched *sched);
+
+    /**
+     * Set the preemption granularity for chunked transfers. Safe to call
+     * while transfers run; each transfer keeps the size in effect when it
+     * started.
+     *
+     * @param chunk_size Payload bytes per chunk (must be > 0)
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_sched_set_chunk_size(lw_sched *sched, size_t chunk_size);
+
+    /**
+     * Block until the calling thread owns the bus.
+     *
+     * @param sched Scheduler
+     * @param tag   Scheduling tag (NULL = priority 0, no deadline)
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Use this to make a multi-step sequence atomic with respect to other
+     * scheduler clients; always pair with lw_sched_release().
+     */
+    int lw_sched_acquire(lw_sched *sched, const lw_sched_tag *tag);
+
+    /**
+     * Give up bus ownership and wake the next waiter chosen by the policy.
+     */
+    void lw_sched_release(lw_sched *sched);
+
+    /**
+     * Number of clients currently queued for the bus (excluding the owner).
+     */
+    size_t lw_sched_waiting(lw_sched *sched);
+
+    /**
+     * Scheduled, chunked equivalent of lw_ioctl_read().
+     *
+     * Reads longer than the chunk size are split; the bus is re-arbitrated
+     * between chunks. When `iaddr_len > 0` the internal address is treated
+     * as a big-endian counter and advanced by the chunk length, which
+     * matches auto-incrementing devices (EEPROMs, register files).
+     *
+     * @return Total bytes read on success, -1 on error (errno set). A failed
+     *         chunk aborts the remaining chunks.
+     */
+    ssize_t lw_sched_ioctl_read(lw_sched *sched,
+                                const lw_sched_tag *tag,
+                                uint16_t addr,
+                                const uint8_t *iaddr,
+                                size_t iaddr_len,
+                                uint8_t *data,
+                                size_t len,
+                                uint16_t flags);
+
+    /**
+     * Scheduled, chunked equivalent of lw_ioctl_write().
+     *
+     * Same chunking and address-advance rules as lw_sched_ioctl_read().
+     * Callers writing to page-organised memories should keep the chunk
+     * size a divisor of the page size.
+     *
+     * @return Total data bytes written on success, -1 on error (errno set)
+     */
+    ssize_t lw_sched_ioctl_write(lw_sched *sched,
+                                 const lw_sched_tag *tag,
+                                 uint16_t addr,
+                                 const uint8_t *iaddr,
+                                 size_t iaddr_len,
+                                 const uint8_t *data,
+                                 size_t len,
+                                 uint16_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_SCHED_H */
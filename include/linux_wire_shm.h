@@ -0,0 +1,207 @@
+#ifndef LINUX_WIRE_SHM_H
+#define LINUX_WIRE_SHM_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Largest register block one slot holds, in bytes. */
+#define LINUX_WIRE_SHM_VALUE_MAX 32
+
+/** Maximum slots in one segment. */
+#ifndef LINUX_WIRE_SHM_MAX_SLOTS
+#define LINUX_WIRE_SHM_MAX_SLOTS 256
+#endif
+
+/** Maximum length of a segment name, including the leading '/'. */
+#define LINUX_WIRE_SHM_NAME_MAX 64
+
+/** Segment identification ("LWSH") and layout version. */
+#define LINUX_WIRE_SHM_MAGIC 0x4C575348u
+#define LINUX_WIRE_SHM_VERSION 1u
+
+    /**
+     * Register published by lw_shm_publisher_open().
+     *
+     * Fields:
+     *   addr    - 7-bit device address
+     *   reg     - Register address, sent big-endian in `reg_len` bytes
+     *   reg_len - 1-4
+     *   len     - Bytes to read (1..LINUX_WIRE_SHM_VALUE_MAX)
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint32_t reg;
+        uint8_t reg_len;
+        uint8_t len;
+    } lw_shm_reg;
+
+    /**
+     * One published value in shared memory. Written only by the publisher
+     * under the slot's sequence counter: odd while an update is in
+     * progress, even when stable.
+     */
+    typedef struct
+    {
+        uint32_t seq;
+        uint16_t addr;
+        uint8_t reg_len;
+        uint8_t len;
+        uint32_t reg;
+        int32_t err;
+        uint64_t timestamp_us;
+        uint64_t updates;
+        uint8_t value[LINUX_WIRE_SHM_VALUE_MAX];
+    } lw_shm_slot;
+
+    /**
+     * Segment header; `slot_count` lw_shm_slot entries follow it directly.
+     */
+    typedef struct
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t slot_size;
+    } lw_shm_segment;
+
+    /**
+     * Consistent copy of one slot, as returned by lw_shm_read().
+     *
+     * Fields:
+     *   addr, reg    - Register the value came from
+     *   len          - Valid bytes in `value`
+     *   err          - errno of the latest read attempt (0 = value is fresh)
+     *   timestamp_us - CLOCK_MONOTONIC time of the latest update
+     *   updates      - Number of updates so far (0 = never read yet)
+     *   value        - Last successfully read contents
+     */
+    typedef struct
+    {
+        uint16_t addr;
+        uint32_t reg;
+        uint8_t len;
+        int err;
+        uint64_t timestamp_us;
+        uint64_t updates;
+        uint8_t value[LINUX_WIRE_SHM_VALUE_MAX];
+    } lw_shm_sample;
+
+    /**
+     * Writer side. Treat all fields as private.
+     */
+    typedef struct
+    {
+        char name[LINUX_WIRE_SHM_NAME_MAX];
+        lw_shm_segment *seg;
+        size_t map_size;
+    } lw_shm_publisher;
+
+    /**
+     * Reader side. Treat all fields as private.
+     */
+    typedef struct
+    {
+        const lw_shm_segment *seg;
+        size_t map_size;
+    } lw_shm_reader;
+
+    /**
+     * Create (or replace) the POSIX shared-memory segment `name` with one
+     * slot per entry of `regs`.
+     *
+     * @param name  Segment name: leading '/', no other '/' (e.g. "/imu0")
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad name, count 0 or above LINUX_WIRE_SHM_MAX_SLOTS, or a
+     *            register with reg_len not 1-4 or len not
+     *            1..LINUX_WIRE_SHM_VALUE_MAX
+     *   plus any errno reported by shm_open(), ftruncate() or mmap()
+     */
+    int lw_shm_publisher_open(lw_shm_publisher *pub,
+                              const char *name,
+                              const lw_shm_reg *regs,
+                              size_t count);
+
+    /**
+     * Read every configured register and publish the results. Consecutive
+     * slots for the same device are fetched together with lw_gather_read(),
+     * so one bus transaction serves every reader.
+     *
+     * A failed read keeps the previous value and records the errno in the
+     * affected slots.
+     *
+     * @return Number of slots whose read failed, -1 on error (errno = EINVAL)
+     */
+    int lw_shm_publisher_poll(lw_shm_publisher *pub, lw_i2c_bus *bus);
+
+    /**
+     * Publish a value obtained elsewhere into `slot` (e.g. from a FIFO
+     * drain or an lw_watcher callback).
+     *
+     * @param err 0 for a fresh value; otherwise the value is left as is and
+     *            only the error and timestamp are updated
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_shm_publish(lw_shm_publisher *pub, size_t slot, const uint8_t *value, size_t len, int err);
+
+    /**
+     * Unmap the segment; with `unlink_segment` non-zero also remove its
+     * name so new readers cannot attach.
+     */
+    void lw_shm_publisher_close(lw_shm_publisher *pub, int unlink_segment);
+
+    /**
+     * Attach read-only to a published segment.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad name
+     *   ENOENT - No such segment
+     *   EPROTO - Segment has a different magic, version or layout
+     */
+    int lw_shm_reader_open(lw_shm_reader *reader, const char *name);
+
+    /**
+     * Number of slots in the attached segment (0 if not attached).
+     */
+    size_t lw_shm_reader_slots(const lw_shm_reader *reader);
+
+    /**
+     * Index of the slot publishing `reg` of device `addr`.
+     *
+     * @return Slot index, -1 if not published (errno = ENOENT)
+     */
+    int lw_shm_find(const lw_shm_reader *reader, uint16_t addr, uint32_t reg);
+
+    /**
+     * Copy a consistent snapshot of one slot. Lock-free and free of system
+     * calls: the copy is retried while the publisher is updating the slot.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments or slot out of range
+     *   EAGAIN - No stable copy after many retries (publisher stalled
+     *            mid-update)
+     */
+    int lw_shm_read(const lw_shm_reader *reader, size_t slot, lw_shm_sample *sample);
+
+    /**
+     * Detach from the segment.
+     */
+    void lw_shm_reader_close(lw_shm_reader *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_SHM_H */
@@ -0,0 +1,319 @@
+#ifndef LINUX_WIRE_SIM_H
+#define LINUX_WIRE_SIM_H
+
+#include "linux_wire.h"
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Largest EEPROM page lw_sim_eeprom can latch. */
+#ifndef LINUX_WIRE_SIM_PAGE_MAX
+#define LINUX_WIRE_SIM_PAGE_MAX 256
+#endif
+
+/** Bytes an lw_sim_imu FIFO can hold. */
+#ifndef LINUX_WIRE_SIM_FIFO_MAX
+#define LINUX_WIRE_SIM_FIFO_MAX 1024
+#endif
+
+/** Result bytes an lw_sim_stretch conversion can return. */
+#ifndef LINUX_WIRE_SIM_RESULT_MAX
+#define LINUX_WIRE_SIM_RESULT_MAX 8
+#endif
+
+    typedef struct lw_sim_device lw_sim_device;
+
+    /**
+     * Behaviour of a simulated device, called with the bus lock held.
+     *
+     * Fields:
+     *   write - One write message addressed to the device (len may be 0)
+     *   read  - Fill one read message
+     *   stop  - STOP condition at the end of a transaction the device
+     *           took part in (NULL if not needed)
+     *
+     * `now_ns` is the simulated time at the start of the message. write
+     * and read return 0 when the device ACKs its address and -1 to NACK
+     * it (the transaction then fails with ENXIO). They may add to
+     * `*stretch_ns` the time the device holds SCL low.
+     */
+    typedef struct
+    {
+        int (*write)(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns);
+        int (*read)(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns);
+        void (*stop)(lw_sim_device *dev, uint64_t now_ns);
+    } lw_sim_ops;
+
+    /**
+     * Common part of every simulated device; the models below embed it as
+     * their first member. Only `addr` and `ops` are set by the model's
+     * init function; the rest belongs to the bus.
+     */
+    struct lw_sim_device
+    {
+        uint16_t addr;
+        const lw_sim_ops *ops;
+        lw_sim_device *next;
+        lw_sim_device *parent; /* lw_sim_mux the device sits behind */
+        uint8_t channel;
+        uint8_t touched;
+    };
+
+    /**
+     * Simulated I2C bus, served to the core through lw_open_backend().
+     *
+     * Each transaction advances a simulated clock by its time on the wire
+     * at `bus_hz`: a START and address byte per message, 9 bit times per
+     * data byte, any clock stretching, a STOP, plus `overhead_ns` per
+     * transaction for the system call and adapter setup. In realtime mode
+     * the calling thread also sleeps until the wall clock catches up, so
+     * schedulers and timeouts see real durations; otherwise the clock only
+     * moves with bus traffic and lw_sim_advance().
+     *
+     * A stretch longer than `timeout_us` (when non-zero) fails the
+     * transaction with ETIMEDOUT, as the adapter would.
+     *
+     * Fields (set after lw_sim_init()):
+     *   bus_hz      - SCL frequency
+     *   overhead_ns - Fixed cost of every transaction
+     *   timeout_us  - Adapter clock-stretch timeout (0 = none)
+     *
+     * Fields (read-only for callers):
+     *   transactions, messages, bytes - Traffic served
+     *   nacks, timeouts               - Failed transactions
+     *   busy_ns                       - Simulated time the bus was busy
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct
+    {
+        pthread_mutex_t lock;
+        lw_sim_device *devices;
+        uint32_t bus_hz;
+        uint32_t overhead_ns;
+        uint32_t timeout_us;
+        int realtime;
+        uint64_t now_ns;
+        uint64_t epoch_ns;
+        uint64_t transactions;
+        uint64_t messages;
+        uint64_t bytes;
+        uint64_t nacks;
+        uint64_t timeouts;
+        uint64_t busy_ns;
+    } lw_sim_bus;
+
+    /**
+     * Initialize an empty simulated bus.
+     *
+     * @param bus_hz SCL frequency (0 = 100 kHz)
+     *
+     * @return 0 on success, -1 on error (errno set)
+     */
+    int lw_sim_init(lw_sim_bus *sim, uint32_t bus_hz);
+
+    /** Release the bus lock. Devices are owned by the caller. */
+    void lw_sim_destroy(lw_sim_bus *sim);
+
+    /**
+     * Open `bus` on the simulated bus. Every linux_wire.h call (and
+     * everything built on it) then talks to the simulated devices.
+     *
+     * @param label Reported as bus->device_path (NULL = "/dev/i2c-sim")
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_sim_open(lw_sim_bus *sim, lw_i2c_bus *bus, const char *label);
+
+    /**
+     * Put a device on the bus. With `mux` non-NULL the device sits on
+     * downstream channel `channel` (0-7) of that switch and only answers
+     * while the channel is enabled. The first device found at an address
+     * answers it.
+     *
+     * @return 0 on success, -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - NULL pointers, no ops, channel above 7, or `mux` is
+     *            not an lw_sim_mux already on the bus
+     *   EEXIST - Device already on the bus
+     */
+    int lw_sim_attach(lw_sim_bus *sim, lw_sim_device *dev, lw_sim_device *mux, uint8_t channel);
+
+    /** lw_sim_attach() on the root segment. */
+    int lw_sim_add(lw_sim_bus *sim, lw_sim_device *dev);
+
+    /**
+     * Switch realtime mode on or off (see lw_sim_bus). Switching it on
+     * aligns the simulated clock with the wall clock from now on.
+     */
+    void lw_sim_set_realtime(lw_sim_bus *sim, int enable);
+
+    /** Let `us` microseconds of idle time pass on the simulated clock. */
+    void lw_sim_advance(lw_sim_bus *sim, uint64_t us);
+
+    /** Current simulated time in microseconds. */
+    uint64_t lw_sim_now_us(lw_sim_bus *sim);
+
+    /**
+     * 24Cxx-style EEPROM.
+     *
+     * A write sets the address pointer from its first `addr_bytes` bytes
+     * and latches the rest into the current page, wrapping within the
+     * page. STOP commits the latch and starts the write cycle, during
+     * which the device NACKs its address (ACK polling works). Reads are
+     * sequential from the pointer and wrap at the end of memory.
+     *
+     * Fields after init: `writes` counts completed write cycles.
+     */
+    typedef struct
+    {
+        lw_sim_device dev;
+        uint8_t *mem;
+        size_t size;
+        uint16_t page_size;
+        uint8_t addr_bytes;
+        uint32_t write_cycle_us;
+        uint32_t ptr;
+        uint64_t busy_until_ns;
+        uint16_t latched;
+        uint8_t latch[LINUX_WIRE_SIM_PAGE_MAX];
+        uint8_t latch_set[LINUX_WIRE_SIM_PAGE_MAX];
+        uint32_t latch_page;
+        uint64_t writes;
+    } lw_sim_eeprom;
+
+    /**
+     * @param mem        Backing memory (caller-owned, `size` bytes)
+     * @param page_size  Page size (1..LINUX_WIRE_SIM_PAGE_MAX, dividing size)
+     * @param addr_bytes Memory address size: 1 or 2 bytes
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_sim_eeprom_init(lw_sim_eeprom *m,
+                           uint16_t addr,
+                           uint8_t *mem,
+                           size_t size,
+                           uint16_t page_size,
+                           uint8_t addr_bytes,
+                           uint32_t write_cycle_us);
+
+    /**
+     * Register-file sensor with an 8-bit register pointer.
+     *
+     * The first byte of a write sets the pointer; further bytes are
+     * stored at it. Reads return registers from the pointer. With
+     * `inc_bit` 0 the pointer advances after every byte; otherwise it only
+     * advances when the pointer write had `inc_bit` set (ST style), and
+     * the bit is not part of the register number. Registers are
+     * caller-owned, so tests can change readings between transactions.
+     */
+    typedef struct
+    {
+        lw_sim_device dev;
+        uint8_t *regs;
+        size_t count;
+        uint8_t inc_bit;
+        uint8_t ptr;
+        uint8_t inc;
+    } lw_sim_regs;
+
+    /** @return 0 on success, -1 on error (errno = EINVAL; count 1-256) */
+    int lw_sim_regs_init(lw_sim_regs *m, uint16_t addr, uint8_t *regs, size_t count, uint8_t inc_bit);
+
+    /**
+     * IMU with a sample FIFO (MPU-6050 layout by default: FIFO_COUNTH at
+     * 0x72, FIFO_R_W at 0x74).
+     *
+     * Frames of `frame_size` bytes enter the FIFO at `sample_hz` in
+     * simulated time. Byte i of frame n holds (n * frame_size + i) & 0xFF,
+     * so readers can check order and loss. `count_reg` reads the fill
+     * level in bytes, big-endian; reads of `data_reg` pop the FIFO
+     * without moving the pointer (0 when empty); writes to it are
+     * discarded and the pointer moves on. Frames that do not fit are
+     * dropped and counted in `overflows`. Every other register is a
+     * plain auto-increment register file in `regs`.
+     */
+    typedef struct
+    {
+        lw_sim_device dev;
+        uint8_t regs[256];
+        uint8_t count_reg;
+        uint8_t data_reg;
+        uint16_t frame_size;
+        uint32_t sample_hz;
+        uint16_t capacity;
+        uint8_t ptr;
+        uint8_t fifo[LINUX_WIRE_SIM_FIFO_MAX];
+        size_t head;
+        size_t tail;
+        uint64_t frames;
+        uint64_t overflows;
+    } lw_sim_imu;
+
+    /**
+     * @param capacity FIFO size in bytes (1..LINUX_WIRE_SIM_FIFO_MAX)
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_sim_imu_init(lw_sim_imu *m,
+                        uint16_t addr,
+                        uint16_t frame_size,
+                        uint32_t sample_hz,
+                        uint16_t capacity);
+
+    /**
+     * TCA9548A-style 8-channel I2C switch. Writing a byte sets the
+     * channel-enable mask; reading returns it. Attach downstream devices
+     * with lw_sim_attach(sim, dev, &mux.dev, channel).
+     */
+    typedef struct
+    {
+        lw_sim_device dev;
+        uint8_t control;
+        uint64_t selects;
+    } lw_sim_mux;
+
+    /** @return 0 on success, -1 on error (errno = EINVAL) */
+    int lw_sim_mux_init(lw_sim_mux *m, uint16_t addr);
+
+    /**
+     * Clock-stretching sensor in "hold master" mode (HTU21D style).
+     *
+     * A write starts a conversion lasting `conversion_us`. The next read
+     * holds SCL low until the conversion is done, then returns the
+     * `result` bytes (repeated when more are read). A read with no
+     * conversion pending returns the last result without stretching.
+     */
+    typedef struct
+    {
+        lw_sim_device dev;
+        uint32_t conversion_us;
+        uint8_t result[LINUX_WIRE_SIM_RESULT_MAX];
+        uint8_t result_len;
+        uint64_t ready_ns;
+        int converting;
+        uint64_t conversions;
+    } lw_sim_stretch;
+
+    /**
+     * @param result_len Result size (1..LINUX_WIRE_SIM_RESULT_MAX);
+     *                   `result` may be changed later
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_sim_stretch_init(lw_sim_stretch *m,
+                            uint16_t addr,
+                            uint32_t conversion_us,
+                            const uint8_t *result,
+                            uint8_t result_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_SIM_H */
@@ -0,0 +1,179 @@
+#ifndef LINUX_WIRE_WATCH_H
+#define LINUX_WIRE_WATCH_H
+
+#include "linux_wire.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Maximum registers one watcher tracks (all read in one transaction, so
+    at most LW_GATHER_MAX). */
+#ifndef LINUX_WIRE_WATCH_MAX_REGS
+#define LINUX_WIRE_WATCH_MAX_REGS 8
+#endif
+
+/** Largest register block a watcher compares, in bytes. */
+#ifndef LINUX_WIRE_WATCH_VALUE_MAX
+#define LINUX_WIRE_WATCH_VALUE_MAX 16
+#endif
+
+/** Edge selection for lw_watch_use_gpio(). */
+#define LW_WATCH_EDGE_RISING 0x0001u
+#define LW_WATCH_EDGE_FALLING 0x0002u
+
+    struct lw_watcher;
+
+    /**
+     * Change callback.
+     *
+     * @param watcher Watcher that detected the change
+     * @param index   Index returned by lw_watch_add()
+     * @param value   New register contents (`len` bytes)
+     * @param arg     User pointer given to lw_watch_add()
+     */
+    typedef void (*lw_watch_fn)(struct lw_watcher *watcher,
+                                size_t index,
+                                const uint8_t *value,
+                                size_t len,
+                                void *arg);
+
+    /**
+     * One watched register block. Private; see lw_watch_add().
+     */
+    typedef struct
+    {
+        uint32_t reg;
+        uint8_t reg_len;
+        uint8_t len;
+        int has_value;
+        uint8_t value[LINUX_WIRE_WATCH_VALUE_MAX];
+        uint8_t scratch[LINUX_WIRE_WATCH_VALUE_MAX];
+        lw_watch_fn fn;
+        void *arg;
+    } lw_watch_reg;
+
+    /**
+     * Change-detecting watcher for one device.
+     *
+     * The watched registers are only read when a trigger fires: an edge on
+     * the device's interrupt line (GPIO character device), readability of a
+     * stand-in fd, or expiry of the polling period. All registers are read
+     * in one combined transaction and callbacks run only for blocks whose
+     * contents differ from the previous read.
+     *
+     * A trigger fd and a period may be combined; the period then acts as a
+     * safety net for missed interrupts.
+     *
+     * Fields (read-only for callers):
+     *   triggers - Trigger events handled (interrupts + period expiries)
+     *   reads    - Register snapshots taken
+     *   changes  - Callbacks invoked
+     *
+     * Treat the remaining fields as private.
+     */
+    typedef struct lw_watcher
+    {
+        lw_i2c_bus *bus;
+        uint16_t addr;
+        int trigger_fd;
+        int owns_fd;
+        uint32_t period_us;
+        uint64_t next_poll_us;
+        lw_watch_reg regs[LINUX_WIRE_WATCH_MAX_REGS];
+        size_t count;
+        uint64_t triggers;
+        uint64_t reads;
+        uint64_t changes;
+    } lw_watcher;
+
+    /**
+     * Initialize a watcher for the device at `addr` on an open bus.
+     * Starts with no trigger source; configure one with
+     * lw_watch_use_gpio(), lw_watch_use_fd() and/or lw_watch_set_period().
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_watch_init(lw_watcher *watcher, lw_i2c_bus *bus, uint16_t addr);
+
+    /**
+     * Watch `len` bytes starting at register `reg`.
+     *
+     * @return Index of the block (passed to `fn`) on success, -1 on error
+     *
+     * Error conditions:
+     *   EINVAL - Bad arguments (reg_len not 1-4, len 0 or above
+     *            LINUX_WIRE_WATCH_VALUE_MAX, NULL callback)
+     *   ENOSPC - LINUX_WIRE_WATCH_MAX_REGS blocks already registered
+     */
+    int lw_watch_add(lw_watcher *watcher,
+                     uint32_t reg,
+                     uint8_t reg_len,
+                     uint8_t len,
+                     lw_watch_fn fn,
+                     void *arg);
+
+    /**
+     * Trigger on edges of a GPIO line, e.g. the device's INT/DRDY pin.
+     *
+     * @param chip_path GPIO character device (e.g. "/dev/gpiochip0")
+     * @param line      Line offset on that chip
+     * @param edges     LW_WATCH_EDGE_RISING and/or LW_WATCH_EDGE_FALLING
+     *
+     * @return 0 on success, -1 on error (errno set by open() or the
+     *         GPIO_V2_GET_LINE_IOCTL request; ENOSYS when built against
+     *         kernel headers without the v2 GPIO uAPI)
+     */
+    int lw_watch_use_gpio(lw_watcher *watcher, const char *chip_path, unsigned int line, unsigned int edges);
+
+    /**
+     * Trigger whenever `fd` becomes readable; pending data is drained with
+     * one read() per trigger. Use for an already-requested GPIO line fd,
+     * an eventfd, or a pipe in tests. The fd is not closed by the watcher.
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_watch_use_fd(lw_watcher *watcher, int fd);
+
+    /**
+     * Poll every `period_us` microseconds (0 = no periodic reads).
+     *
+     * @return 0 on success, -1 on error (errno = EINVAL)
+     */
+    int lw_watch_set_period(lw_watcher *watcher, uint32_t period_us);
+
+    /**
+     * Wait up to `timeout_ms` for a trigger, then read and compare.
+     *
+     * @param timeout_ms Maximum wait in milliseconds (-1 = no limit)
+     *
+     * @return Number of callbacks invoked (0 when the wait timed out or
+     *         nothing changed), -1 on error (errno set)
+     *
+     * Error conditions:
+     *   EINVAL - No registers or no trigger configured
+     *   plus any errno reported by poll(), read() or lw_gather_read()
+     *
+     * The first read of each block always counts as a change, so callers
+     * receive the initial values.
+     */
+    int lw_watch_run_once(lw_watcher *watcher, int timeout_ms);
+
+    /**
+     * Read and compare immediately, as if a trigger had fired.
+     *
+     * @return Number of callbacks invoked, -1 on error
+     */
+    int lw_watch_sample(lw_watcher *watcher);
+
+    /**
+     * Release the GPIO line requested by lw_watch_use_gpio().
+     */
+    void lw_watch_close(lw_watcher *watcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINUX_WIRE_WATCH_H */
@@ -3,16 +3,24 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <cassert>
 
+static_assert(LINUX_WIRE_MAX_PENDING_SEGMENTS >= 1 && LINUX_WIRE_MAX_PENDING_SEGMENTS <= LW_MAX_MSGS - 2,
+              "LINUX_WIRE_MAX_PENDING_SEGMENTS must leave room for a write and a read message");
+
+/* Queued segments plus at most two closing messages */
+static constexpr std::size_t kMaxCombinedMsgs = LINUX_WIRE_MAX_PENDING_SEGMENTS + 2;
+
 TwoWire::TwoWire()
     : bus_open_(false),
       errorLoggingEnabled_(true),
       devicePath_{0},
       txAddress_(0),
       transmitting_(false),
-      hasPendingTxForRead_(false),
+      pendingCount_(0),
+      pendingBytes_(0),
       txBufferIndex_(0),
       txBufferLength_(0),
       rxBufferIndex_(0),
@@ -20,12 +28,26 @@ TwoWire::TwoWire()
       wireTimeoutUs_(0),
       wireTimeoutFlag_(false),
       wireResetOnTimeout_(false),
-      inTimeoutHandler_(false)
+      inTimeoutHandler_(false),
+      combiner_(nullptr),
+      readAhead_(nullptr),
+      hotplug_(nullptr),
+      hotplugSlot_(0),
+      busGeneration_(0)
 {
     bus_.fd = -1;
     bus_.device_path[0] = '\0';
     bus_.timeout_us = 0;
     bus_.log_errors = 1;
+    bus_.pool = nullptr;
+    bus_.rt_flags = 0;
+    bus_.errors = nullptr;
+    std::memset(&bus_.caps, 0, sizeof(bus_.caps));
+    bus_.observer = nullptr;
+    bus_.observer_arg = nullptr;
+    bus_.backend = nullptr;
+    bus_.backend_arg = nullptr;
+    bus_.slave_addr = 0;
 }
 
 TwoWire::~TwoWire()
@@ -33,6 +55,41 @@ TwoWire::~TwoWire()
     end();
 }
 
+TwoWire::TwoWire(TwoWire &&other) noexcept
+    : TwoWire()
+{
+    takeStateFrom(other);
+}
+
+TwoWire &TwoWire::operator=(TwoWire &&other) noexcept
+{
+    if (this != &other)
+    {
+        end();
+        takeStateFrom(other);
+    }
+    return *this;
+}
+
+TwoWire TwoWire::forAdapter(unsigned int adapter)
+{
+    char path[LINUX_WIRE_DEVICE_PATH_MAX];
+    std::snprintf(path, sizeof(path), "/dev/i2c-%u", adapter);
+    return forDevice(path);
+}
+
+TwoWire TwoWire::forDevice(const char *device)
+{
+    TwoWire instance;
+    instance.begin(device);
+    return instance;
+}
+
+bool TwoWire::isOpen() const
+{
+    return bus_open_;
+}
+
 void TwoWire::begin(const char *device)
 {
     if (!device || device[0] == '\0')
@@ -43,7 +100,8 @@ void TwoWire::begin(const char *device)
     /* Clean up existing connection fully before attempting new one */
     if (bus_open_)
     {
-        bool flushed = flushPendingRepeatedStart();
+        bool flushed = commitWrites();
+        flushed = flushPendingRepeatedStart() && flushed;
         resetTxBuffer();
         resetRxBuffer();
         lw_close_bus(&bus_);
@@ -53,6 +111,7 @@ void TwoWire::begin(const char *device)
             return;
         }
     }
+    hotplug_ = nullptr;
 
     /* Copy device path */
     size_t len = std::strlen(device);
@@ -89,10 +148,12 @@ void TwoWire::end()
 {
     if (bus_open_)
     {
+        commitWrites();
         flushPendingRepeatedStart();
         lw_close_bus(&bus_);
     }
     bus_open_ = false;
+    hotplug_ = nullptr;
     resetTxBuffer();
     resetRxBuffer();
 }
@@ -136,12 +197,8 @@ void TwoWire::setErrorLogging(bool enable)
 
 void TwoWire::beginTransmission(uint8_t address)
 {
-    if (!flushPendingRepeatedStart())
-    {
-        transmitting_ = false;
-        return;
-    }
-
+    /* Segments queued by endTransmission(false) stay queued: this one is
+       the next link of the same combined transaction */
     transmitting_ = true;
     txAddress_ = address;
     resetTxBuffer();
@@ -154,7 +211,7 @@ void TwoWire::beginTransmission(int address)
 
 uint8_t TwoWire::endTransmission(uint8_t sendStop)
 {
-    if (!bus_open_)
+    if (!refreshBus())
     {
         return 4; // other error
     }
@@ -172,22 +229,73 @@ uint8_t TwoWire::endTransmission(uint8_t sendStop)
         return 1; // data too long
     }
 
-    /* sendStop == 0 means "don't send STOP, prepare for repeated start"
-       This allows the next requestFrom() to use a combined write+read
-       transaction without an intervening STOP condition. */
+    /* sendStop == 0 means "don't send STOP, prepare for repeated start":
+       queue the segment so the next requestFrom()/transfer()/endTransmission()
+       sends it in the same combined transaction. */
     if (sendStop == 0)
     {
         transmitting_ = false;
-        hasPendingTxForRead_ = (txBufferLength_ > 0);
+        if (txBufferLength_ == 0)
+        {
+            return 0;
+        }
+        if (pendingCount_ == LINUX_WIRE_MAX_PENDING_SEGMENTS)
+        {
+            resetTxBuffer();
+            return 1; // no room for another segment
+        }
+        std::memcpy(&pendingData_[pendingBytes_], txBuffer_, txBufferLength_);
+        pending_[pendingCount_].address = txAddress_;
+        pending_[pendingCount_].length = txBufferLength_;
+        ++pendingCount_;
+        pendingBytes_ += txBufferLength_;
+        resetTxBuffer();
         return 0;
     }
 
-    if (!flushPendingRepeatedStart())
+    if (txBufferLength_ > 0)
+    {
+        invalidateReadAhead(txAddress_);
+    }
+
+    /* A combiner buffers the write; probes and chains go out now, after
+       whatever it holds */
+    if (combiner_ && pendingCount_ == 0 && txBufferLength_ > 0)
     {
+        transmitting_ = false;
+        const int rc = lw_combine_write_msg(&bus_, combiner_, txAddress_, txBuffer_, txBufferLength_);
+        resetTxBuffer();
+        if (rc != 0)
+        {
+            handleTimeoutFromErrno();
+            return 4;
+        }
+        return 0;
+    }
+    if (!commitWrites())
+    {
+        resetTxBuffer();
         transmitting_ = false;
         return 4;
     }
 
+    /* Queued segments and this write go out as one transaction */
+    if (pendingCount_ > 0)
+    {
+        lw_msg msgs[kMaxCombinedMsgs];
+        std::size_t count = pendingMessages(msgs);
+        msgs[count].addr = txAddress_;
+        msgs[count].flags = 0;
+        msgs[count].len = static_cast<uint16_t>(txBufferLength_);
+        msgs[count].buf = txBuffer_;
+        ++count;
+
+        transmitting_ = false;
+        const bool sent = runCombined(msgs, count);
+        resetTxBuffer();
+        return sent ? 0 : 4;
+    }
+
     /* Select slave */
     if (lw_set_slave(&bus_, txAddress_) != 0)
     {
@@ -219,26 +327,25 @@ uint8_t TwoWire::endTransmission(void)
 
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
 {
-    const uint8_t *internal = nullptr;
-    std::size_t internalLen = 0;
-    bool consumePendingTx = false;
+    if (!commitWrites())
+    {
+        resetRxBuffer();
+        return 0;
+    }
 
-    if (hasPendingTxForRead_ && txAddress_ == address)
+    /* The common register read (one short pointer write to the same device)
+       keeps the lw_ioctl_read() path; longer chains go through lw_transfer() */
+    if (pendingCount_ == 1 && pending_[0].address == address &&
+        pending_[0].length <= INTERNAL_ADDRESS_MAX)
     {
-        internal = txBuffer_;
-        internalLen = txBufferLength_;
-        consumePendingTx = true;
+        return requestFrom(address, quantity, pendingData_, pending_[0].length, sendStop, true);
     }
-    else if (hasPendingTxForRead_ && txAddress_ != address)
+    if (pendingCount_ > 0)
     {
-        if (!flushPendingRepeatedStart())
-        {
-            resetRxBuffer();
-            return 0;
-        }
+        return requestChained(address, quantity, nullptr, 0);
     }
 
-    return requestFrom(address, quantity, internal, internalLen, sendStop, consumePendingTx);
+    return requestFrom(address, quantity, nullptr, 0, sendStop, false);
 }
 
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
@@ -254,16 +361,20 @@ uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddres
         isize = INTERNAL_ADDRESS_MAX;
     }
 
-    if (hasPendingTxForRead_ && !flushPendingRepeatedStart())
+    resetTxBuffer();
+
+    if (!commitWrites())
     {
         resetRxBuffer();
         return 0;
     }
 
-    resetTxBuffer();
-
     if (isize == 0)
     {
+        if (pendingCount_ > 0)
+        {
+            return requestChained(address, quantity, nullptr, 0);
+        }
         return requestFrom(address, quantity, nullptr, 0, sendStop, false);
     }
 
@@ -277,6 +388,10 @@ uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddres
         iaddr_buf[i] = static_cast<uint8_t>((iaddress >> shift) & 0xFF);
     }
 
+    if (pendingCount_ > 0)
+    {
+        return requestChained(address, quantity, iaddr_buf, isize);
+    }
     return requestFrom(address, quantity, iaddr_buf, isize, sendStop, false);
 }
 
@@ -380,6 +495,102 @@ int TwoWire::peek(void)
     return rxBuffer_[rxBufferIndex_];
 }
 
+size_t TwoWire::readBytes(uint8_t *buffer, size_t length)
+{
+    const std::size_t unread = rxBufferLength_ - rxBufferIndex_;
+    const std::size_t count = (length < unread) ? length : unread;
+
+    if (buffer && count > 0)
+    {
+        std::memcpy(buffer, &rxBuffer_[rxBufferIndex_], count);
+    }
+    rxBufferIndex_ += count;
+    return count;
+}
+
+TwoWire::ConstByteSpan TwoWire::rxView() const
+{
+    return ConstByteSpan(&rxBuffer_[rxBufferIndex_], rxBufferLength_ - rxBufferIndex_);
+}
+
+bool TwoWire::transfer(uint8_t address, ConstByteSpan tx, ByteSpan rx)
+{
+    if (!refreshBus() || (tx.empty() && rx.empty()) ||
+        tx.size() > UINT16_MAX || rx.size() > UINT16_MAX)
+    {
+        return false;
+    }
+
+    if (!commitWrites())
+    {
+        return false;
+    }
+
+    /* Messages point straight at the caller's buffers: no staging copy
+       through txBuffer_/rxBuffer_ and no LINUX_WIRE_BUFFER_LENGTH cap.
+       Queued endTransmission(false) segments lead the transaction. */
+    lw_msg msgs[kMaxCombinedMsgs];
+    std::size_t count = pendingMessages(msgs);
+
+    if (!tx.empty())
+    {
+        msgs[count].addr = address;
+        msgs[count].flags = 0;
+        msgs[count].len = static_cast<uint16_t>(tx.size());
+        msgs[count].buf = const_cast<uint8_t *>(tx.data());
+        ++count;
+    }
+    if (!rx.empty())
+    {
+        msgs[count].addr = address;
+        msgs[count].flags = LW_MSG_RD;
+        msgs[count].len = static_cast<uint16_t>(rx.size());
+        msgs[count].buf = rx.data();
+        ++count;
+    }
+
+    return runCombined(msgs, count);
+}
+
+void TwoWire::setWriteCombiner(lw_combiner *combiner)
+{
+    commitWrites();
+    combiner_ = combiner;
+}
+
+bool TwoWire::commitWrites()
+{
+    if (!combiner_ || lw_combine_pending(combiner_) == 0)
+    {
+        return true;
+    }
+
+    if (!refreshBus())
+    {
+        return false; // adapter gone: keep the writes for its return
+    }
+    if (lw_combine_flush(&bus_, combiner_) != 0)
+    {
+        handleTimeoutFromErrno();
+        return false;
+    }
+    return true;
+}
+
+void TwoWire::setReadAhead(lw_readahead *readahead)
+{
+    readAhead_ = readahead;
+}
+
+void TwoWire::setHotplug(lw_hotplug *hotplug, int slot)
+{
+    commitWrites();
+    hotplug_ = slot >= 0 ? hotplug : nullptr;
+    hotplugSlot_ = slot;
+    busGeneration_ = 0;
+    refreshBus();
+}
+
 void TwoWire::flush(void)
 {
     /* No underlying hardware FIFO in Linux userspace I2C; nothing to do.
@@ -390,7 +601,6 @@ void TwoWire::resetTxBuffer()
 {
     txBufferIndex_ = 0;
     txBufferLength_ = 0;
-    hasPendingTxForRead_ = false;
 }
 
 void TwoWire::resetRxBuffer()
@@ -399,12 +609,61 @@ void TwoWire::resetRxBuffer()
     rxBufferLength_ = 0;
 }
 
+void TwoWire::resetPendingSegments()
+{
+    pendingCount_ = 0;
+    pendingBytes_ = 0;
+}
+
 void TwoWire::applyBusConfiguration()
 {
     lw_set_timeout(&bus_, wireTimeoutUs_);
     lw_set_error_logging(&bus_, errorLoggingEnabled_ ? 1 : 0);
 }
 
+void TwoWire::takeStateFrom(TwoWire &other) noexcept
+{
+    /* Plain member-wise transfer; the handle and buffers hold no pointers
+       back into the object, so a byte copy of each member is sufficient. */
+    bus_ = other.bus_;
+    bus_open_ = other.bus_open_;
+    errorLoggingEnabled_ = other.errorLoggingEnabled_;
+    std::memcpy(devicePath_, other.devicePath_, sizeof(devicePath_));
+    txAddress_ = other.txAddress_;
+    transmitting_ = other.transmitting_;
+    std::memcpy(pending_, other.pending_, other.pendingCount_ * sizeof(pending_[0]));
+    pendingCount_ = other.pendingCount_;
+    std::memcpy(pendingData_, other.pendingData_, other.pendingBytes_);
+    pendingBytes_ = other.pendingBytes_;
+    std::memcpy(txBuffer_, other.txBuffer_, other.txBufferLength_);
+    txBufferIndex_ = other.txBufferIndex_;
+    txBufferLength_ = other.txBufferLength_;
+    std::memcpy(rxBuffer_, other.rxBuffer_, other.rxBufferLength_);
+    rxBufferIndex_ = other.rxBufferIndex_;
+    rxBufferLength_ = other.rxBufferLength_;
+    wireTimeoutUs_ = other.wireTimeoutUs_;
+    wireTimeoutFlag_ = other.wireTimeoutFlag_;
+    wireResetOnTimeout_ = other.wireResetOnTimeout_;
+    inTimeoutHandler_ = false;
+    combiner_ = other.combiner_;
+    readAhead_ = other.readAhead_;
+    hotplug_ = other.hotplug_;
+    hotplugSlot_ = other.hotplugSlot_;
+    busGeneration_ = other.busGeneration_;
+
+    /* Leave the source closed so its destructor does not touch the fd */
+    other.bus_.fd = -1;
+    other.bus_.device_path[0] = '\0';
+    other.bus_open_ = false;
+    other.transmitting_ = false;
+    other.combiner_ = nullptr;
+    other.readAhead_ = nullptr;
+    other.hotplug_ = nullptr;
+    other.resetPendingSegments();
+    other.resetTxBuffer();
+    other.resetRxBuffer();
+}
+
 uint8_t TwoWire::requestFrom(uint8_t address,
                              uint8_t quantity,
                              const uint8_t *internalAddress,
@@ -421,16 +680,16 @@ uint8_t TwoWire::requestFrom(uint8_t address,
     {
         if (consumePendingTx)
         {
-            resetTxBuffer();
+            resetPendingSegments();
         }
         return 0;
     }
 
-    if (!bus_open_ || quantity == 0)
+    if (!refreshBus() || quantity == 0)
     {
         if (consumePendingTx)
         {
-            resetTxBuffer();
+            resetPendingSegments();
         }
         return 0;
     }
@@ -442,14 +701,31 @@ uint8_t TwoWire::requestFrom(uint8_t address,
 
     ssize_t result = 0;
 
-    if (internalAddress && internalAddressLength > 0)
+    if (internalAddress && internalAddressLength > 0 && readAhead_)
+    {
+        uint32_t reg = 0;
+        for (std::size_t i = 0; i < internalAddressLength; ++i)
+        {
+            reg = (reg << 8) | internalAddress[i];
+        }
+        result = lw_readahead_read(&bus_,
+                                   readAhead_,
+                                   address,
+                                   reg,
+                                   static_cast<uint8_t>(internalAddressLength),
+                                   rxBuffer_,
+                                   quantity);
+    }
+    else if (internalAddress && internalAddressLength > 0)
     {
         /* Use combined write+read ioctl for repeated-start behavior */
         result = lw_ioctl_read(&bus_, address, internalAddress, internalAddressLength, rxBuffer_, quantity, 0);
-        hasPendingTxForRead_ = false;
     }
     else
     {
+        /* A plain read moves the device's register pointer */
+        invalidateReadAhead(address);
+
         /* Standard read: set slave address then read */
         if (lw_set_slave(&bus_, address) != 0)
         {
@@ -457,7 +733,7 @@ uint8_t TwoWire::requestFrom(uint8_t address,
             resetRxBuffer();
             if (consumePendingTx)
             {
-                resetTxBuffer();
+                resetPendingSegments();
             }
             return 0;
         }
@@ -467,7 +743,7 @@ uint8_t TwoWire::requestFrom(uint8_t address,
 
     if (consumePendingTx)
     {
-        resetTxBuffer();
+        resetPendingSegments();
     }
 
     if (result <= 0)
@@ -509,6 +785,7 @@ void TwoWire::handleTimeoutFromErrno()
         }
 
         /* Always clean up transaction state */
+        resetPendingSegments();
         resetTxBuffer();
         resetRxBuffer();
 
@@ -516,6 +793,29 @@ void TwoWire::handleTimeoutFromErrno()
     }
 }
 
+bool TwoWire::refreshBus()
+{
+    if (!hotplug_)
+    {
+        return bus_open_;
+    }
+
+    /* One atomic load unless the adapter came, went or was replaced */
+    const int rc = lw_hotplug_reopen(hotplug_, static_cast<std::size_t>(hotplugSlot_), &bus_, &busGeneration_);
+    if (rc == 1)
+    {
+        bus_open_ = true;
+        std::memcpy(devicePath_, bus_.device_path, sizeof(devicePath_));
+        applyBusConfiguration();
+        lw_readahead_invalidate(readAhead_, LW_READAHEAD_ALL);
+    }
+    else if (rc < 0)
+    {
+        bus_open_ = false;
+    }
+    return bus_open_;
+}
+
 bool TwoWire::reopenBus(const char *device)
 {
     if (!device || device[0] == '\0')
@@ -537,40 +837,133 @@ bool TwoWire::reopenBus(const char *device)
     return false;
 }
 
-bool TwoWire::flushPendingRepeatedStart()
+uint8_t TwoWire::requestChained(uint8_t address,
+                                uint8_t quantity,
+                                const uint8_t *internalAddress,
+                                std::size_t internalAddressLength)
 {
-    if (!hasPendingTxForRead_)
+    if (!refreshBus() || quantity == 0)
     {
-        return true;
+        resetPendingSegments();
+        resetRxBuffer();
+        return 0;
     }
 
-    if (!bus_open_ || txBufferLength_ == 0)
+    if (quantity > LINUX_WIRE_BUFFER_LENGTH)
     {
-        hasPendingTxForRead_ = false;
-        resetTxBuffer();
-        return false;
+        quantity = LINUX_WIRE_BUFFER_LENGTH;
     }
 
-    if (lw_set_slave(&bus_, txAddress_) != 0)
+    lw_msg msgs[kMaxCombinedMsgs];
+    std::size_t count = pendingMessages(msgs);
+    if (internalAddressLength > 0)
+    {
+        msgs[count].addr = address;
+        msgs[count].flags = 0;
+        msgs[count].len = static_cast<uint16_t>(internalAddressLength);
+        msgs[count].buf = const_cast<uint8_t *>(internalAddress);
+        ++count;
+    }
+    msgs[count].addr = address;
+    msgs[count].flags = LW_MSG_RD;
+    msgs[count].len = quantity;
+    msgs[count].buf = rxBuffer_;
+    ++count;
+
+    if (!runCombined(msgs, count))
+    {
+        resetRxBuffer();
+        return 0;
+    }
+
+    rxBufferIndex_ = 0;
+    rxBufferLength_ = quantity;
+    return quantity;
+}
+
+std::size_t TwoWire::pendingMessages(lw_msg *msgs)
+{
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < pendingCount_; ++i)
+    {
+        msgs[i].addr = pending_[i].address;
+        msgs[i].flags = 0;
+        msgs[i].len = static_cast<uint16_t>(pending_[i].length);
+        msgs[i].buf = &pendingData_[offset];
+        offset += pending_[i].length;
+    }
+    return pendingCount_;
+}
+
+void TwoWire::invalidateReadAhead(uint8_t address)
+{
+    if (readAhead_)
+    {
+        lw_readahead_invalidate(readAhead_, address);
+    }
+}
+
+bool TwoWire::runCombined(const lw_msg *msgs, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!(msgs[i].flags & LW_MSG_RD))
+        {
+            invalidateReadAhead(static_cast<uint8_t>(msgs[i].addr));
+        }
+    }
+
+    const int result = lw_transfer(&bus_, msgs, count);
+
+    /* Sent or failed, the queued segments are consumed */
+    resetPendingSegments();
+    if (result < 0)
     {
         handleTimeoutFromErrno();
-        hasPendingTxForRead_ = false;
-        resetTxBuffer();
         return false;
     }
+    return true;
+}
 
-    ssize_t written = lw_write(&bus_, txBuffer_, txBufferLength_, 1);
-    hasPendingTxForRead_ = false;
+bool TwoWire::flushPendingRepeatedStart()
+{
+    if (pendingCount_ == 0)
+    {
+        return true;
+    }
 
-    if (written < 0 || static_cast<std::size_t>(written) != txBufferLength_)
+    if (!refreshBus())
     {
-        handleTimeoutFromErrno();
-        resetTxBuffer();
+        resetPendingSegments();
         return false;
     }
 
-    resetTxBuffer();
-    return true;
+    /* A lone segment is a plain write; no need for I2C_RDWR */
+    if (pendingCount_ == 1)
+    {
+        const uint8_t address = pending_[0].address;
+        const std::size_t length = pending_[0].length;
+        resetPendingSegments();
+        invalidateReadAhead(address);
+
+        if (lw_set_slave(&bus_, address) != 0)
+        {
+            handleTimeoutFromErrno();
+            return false;
+        }
+
+        ssize_t written = lw_write(&bus_, pendingData_, length, 1);
+        if (written < 0 || static_cast<std::size_t>(written) != length)
+        {
+            handleTimeoutFromErrno();
+            return false;
+        }
+        return true;
+    }
+
+    lw_msg msgs[kMaxCombinedMsgs];
+    const std::size_t count = pendingMessages(msgs);
+    return runCombined(msgs, count);
 }
 
 /* Global instance, matching Arduino Wire API */
@@ -1,12 +1,19 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "linux_wire.h"
+#include "linux_wire_internal.h"
 
+#include <assert.h>
 #include <errno.h>
+#include <stddef.h>
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
 #include <linux/i2c.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -18,6 +25,43 @@
 /* Maximum payload for ioctl operations */
 #define LW_MAX_IOCTL_PAYLOAD 4096
 
+/* Message descriptors staged on the stack before using pool/heap */
+#define LW_STACK_MSG_COUNT 8
+
+/* Alignment of every pool hand-out (covers struct i2c_msg) */
+#define LW_POOL_ALIGN 16
+
+/* Private lw_i2c_bus.rt_flags bits (public LW_RT_* options use the low byte) */
+#define LW_RT_ENABLED 0x0100u
+#define LW_RT_OWNS_POOL 0x0200u
+
+/* LW_FUNC_* mirror the kernel values so callers need no linux/ headers */
+_Static_assert(LW_FUNC_I2C == I2C_FUNC_I2C, "LW_FUNC_I2C");
+_Static_assert(LW_FUNC_10BIT_ADDR == I2C_FUNC_10BIT_ADDR, "LW_FUNC_10BIT_ADDR");
+_Static_assert(LW_FUNC_PROTOCOL_MANGLING == I2C_FUNC_PROTOCOL_MANGLING, "LW_FUNC_PROTOCOL_MANGLING");
+_Static_assert(LW_FUNC_SMBUS_PEC == I2C_FUNC_SMBUS_PEC, "LW_FUNC_SMBUS_PEC");
+_Static_assert(LW_FUNC_NOSTART == I2C_FUNC_NOSTART, "LW_FUNC_NOSTART");
+_Static_assert(LW_FUNC_SMBUS_QUICK == I2C_FUNC_SMBUS_QUICK, "LW_FUNC_SMBUS_QUICK");
+_Static_assert(LW_FUNC_SMBUS_READ_BLOCK_DATA == I2C_FUNC_SMBUS_READ_BLOCK_DATA, "LW_FUNC_SMBUS_READ_BLOCK_DATA");
+_Static_assert(LW_FUNC_SMBUS_WRITE_BLOCK_DATA == I2C_FUNC_SMBUS_WRITE_BLOCK_DATA, "LW_FUNC_SMBUS_WRITE_BLOCK_DATA");
+_Static_assert(LW_FUNC_SMBUS_READ_I2C_BLOCK == I2C_FUNC_SMBUS_READ_I2C_BLOCK, "LW_FUNC_SMBUS_READ_I2C_BLOCK");
+_Static_assert(LW_FUNC_SMBUS_WRITE_I2C_BLOCK == I2C_FUNC_SMBUS_WRITE_I2C_BLOCK, "LW_FUNC_SMBUS_WRITE_I2C_BLOCK");
+
+/* lw_msg is passed to I2C_RDWR unchanged by lw_prepared_exec() */
+_Static_assert(sizeof(lw_msg) == sizeof(struct i2c_msg), "lw_msg size");
+_Static_assert(offsetof(lw_msg, addr) == offsetof(struct i2c_msg, addr), "lw_msg.addr");
+_Static_assert(offsetof(lw_msg, flags) == offsetof(struct i2c_msg, flags), "lw_msg.flags");
+_Static_assert(offsetof(lw_msg, len) == offsetof(struct i2c_msg, len), "lw_msg.len");
+_Static_assert(offsetof(lw_msg, buf) == offsetof(struct i2c_msg, buf), "lw_msg.buf");
+
+/* Where a scratch buffer came from, so it can be returned correctly */
+typedef struct
+{
+    void *ptr;
+    size_t pool_mark;
+    int from_heap;
+} lw_scratch;
+
 static void lw_reset_bus_handle(lw_i2c_bus *bus)
 {
     if (!bus)
@@ -29,18 +73,192 @@ static void lw_reset_bus_handle(lw_i2c_bus *bus)
     bus->device_path[0] = '\0';
     bus->timeout_us = 0;
     bus->log_errors = 1;
+    bus->pool = NULL;
+    bus->rt_flags = 0;
+    bus->errors = NULL;
+    memset(&bus->caps, 0, sizeof(bus->caps));
+    bus->observer = NULL;
+    bus->observer_arg = NULL;
+    bus->backend = NULL;
+    bus->backend_arg = NULL;
+    bus->slave_addr = 0;
 }
 
-int lw_open_bus(lw_i2c_bus *bus, const char *device_path)
+/* Open on either a kernel fd or a backend */
+static int lw_bus_is_open(const lw_i2c_bus *bus)
 {
-    if (!bus)
+    return bus->fd >= 0 || bus->backend != NULL;
+}
+
+/* Run one combined transaction through the kernel or the installed
+   backend. lw_msg and struct i2c_msg share a layout (asserted above). */
+static int lw_rdwr(lw_i2c_bus *bus, struct i2c_msg *msgs, size_t count)
+{
+    if (bus->backend)
     {
-        errno = EINVAL;
-        return -1;
+        return bus->backend(bus->backend_arg, (lw_msg *)(void *)msgs, count);
     }
 
-    lw_reset_bus_handle(bus);
+    struct i2c_rdwr_ioctl_data rdwr;
+    rdwr.msgs = msgs;
+    rdwr.nmsgs = (uint32_t)count;
+    return ioctl(bus->fd, I2C_RDWR, &rdwr);
+}
+
+static void lw_error_ring_push(lw_error_ring *ring, lw_op op, uint16_t addr, int err)
+{
+    const uint32_t head = ring->head;
+    const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const uint32_t seq = ring->seq++;
+
+    if (head - tail >= LINUX_WIRE_ERROR_RING_SIZE)
+    {
+        ++ring->dropped;
+        return;
+    }
+
+    lw_error_record *rec = &ring->entries[head & (LINUX_WIRE_ERROR_RING_SIZE - 1)];
+    rec->seq = seq;
+    rec->err = err;
+    rec->addr = addr;
+    rec->op = (uint8_t)op;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Report a failed operation: error ring in realtime mode, perror otherwise.
+   Preserves errno. */
+static void lw_report_error(lw_i2c_bus *bus, lw_op op, uint16_t addr, const char *what)
+{
+    const int saved_errno = errno;
+    if (bus->rt_flags & LW_RT_ENABLED)
+    {
+        if (bus->errors)
+        {
+            lw_error_ring_push(bus->errors, op, addr, saved_errno);
+        }
+    }
+    else if (bus->log_errors)
+    {
+        perror(what);
+    }
+    errno = saved_errno;
+}
 
+/* Tell the bus observer about a transaction that reached the kernel.
+   Preserves errno. */
+static void lw_notify(lw_i2c_bus *bus,
+                      lw_op op,
+                      uint16_t addr,
+                      size_t msgs,
+                      size_t ten_bit_msgs,
+                      size_t bytes,
+                      int failed)
+{
+    if (!bus->observer)
+    {
+        return;
+    }
+
+    const int saved_errno = errno;
+    lw_xfer_event event;
+    event.op = (uint8_t)op;
+    event.addr = addr;
+    event.msgs = (uint16_t)msgs;
+    event.ten_bit_msgs = (uint16_t)ten_bit_msgs;
+    event.bytes = (uint32_t)bytes;
+    event.err = failed ? saved_errno : 0;
+    bus->observer(bus->observer_arg, &event);
+    errno = saved_errno;
+}
+
+/* Fail fast (EOPNOTSUPP) when the cached capabilities rule out I2C_RDWR
+   with these message flags. */
+static int lw_rdwr_check(lw_i2c_bus *bus, lw_op op, uint16_t addr, uint16_t flags, const char *what)
+{
+    unsigned long needed = LW_FUNC_I2C;
+    if (flags & I2C_M_TEN)
+    {
+        needed |= LW_FUNC_10BIT_ADDR;
+    }
+    if (lw_bus_supports(bus, needed))
+    {
+        return 0;
+    }
+    errno = EOPNOTSUPP;
+    lw_report_error(bus, op, addr, what);
+    return -1;
+}
+
+/* Take `size` bytes from the bus pool, falling back to the heap.
+   Returns NULL (errno = ENOMEM) only if both fail. */
+static void *lw_scratch_get(lw_i2c_bus *bus, size_t size, lw_scratch *scratch)
+{
+    lw_pool *pool = bus->pool;
+
+    scratch->ptr = NULL;
+    scratch->pool_mark = 0;
+    scratch->from_heap = 0;
+
+    if (pool)
+    {
+        /* Align the address, not the offset: caller arenas can start anywhere */
+        const uintptr_t start = (uintptr_t)(pool->base + pool->used);
+        const uintptr_t aligned = (start + (LW_POOL_ALIGN - 1)) & ~(uintptr_t)(LW_POOL_ALIGN - 1);
+        size_t offset = pool->used + (size_t)(aligned - start);
+        if (offset <= pool->capacity && size <= pool->capacity - offset)
+        {
+            scratch->pool_mark = pool->used;
+            scratch->ptr = pool->base + offset;
+            pool->used = offset + size;
+            if (pool->used > pool->high_water)
+            {
+                pool->high_water = pool->used;
+            }
+            ++pool->hits;
+            return scratch->ptr;
+        }
+        ++pool->misses;
+    }
+
+    if (bus->rt_flags & LW_RT_ENABLED)
+    {
+        /* Realtime mode never touches the allocator after open */
+        assert(!"linux-wire: heap allocation attempted in realtime mode");
+        errno = ENOMEM;
+        lw_report_error(bus, LW_OP_ALLOC, LW_ADDR_UNKNOWN, "lw_scratch_get");
+        return NULL;
+    }
+
+    scratch->ptr = malloc(size);
+    if (!scratch->ptr)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    scratch->from_heap = 1;
+    return scratch->ptr;
+}
+
+static void lw_scratch_put(lw_i2c_bus *bus, lw_scratch *scratch)
+{
+    if (!scratch->ptr)
+    {
+        return;
+    }
+    if (scratch->from_heap)
+    {
+        free(scratch->ptr);
+    }
+    else if (bus->pool)
+    {
+        bus->pool->used = scratch->pool_mark;
+    }
+    scratch->ptr = NULL;
+}
+
+/* Validate `device_path` and open it into an already-reset handle */
+static int lw_open_fd(lw_i2c_bus *bus, const char *device_path)
+{
     if (!device_path || device_path[0] == '\0')
     {
         errno = EINVAL;
@@ -76,9 +294,7 @@ int lw_open_bus(lw_i2c_bus *bus, const char *device_path)
 
     if (fd < 0)
     {
-        int saved_errno = errno;
-        perror("lw_open_bus: open");
-        errno = saved_errno;
+        lw_report_error(bus, LW_OP_OPEN, LW_ADDR_UNKNOWN, "lw_open_bus: open");
         return -1;
     }
 
@@ -96,6 +312,232 @@ int lw_open_bus(lw_i2c_bus *bus, const char *device_path)
     bus->timeout_us = 0;
     bus->log_errors = 1;
 
+    /* Capabilities are optional; a failed probe leaves them unknown */
+    const int saved_errno = errno;
+    lw_bus_probe_caps(bus, NULL);
+    errno = saved_errno;
+
+    return 0;
+}
+
+/* Read up to `size - 1` bytes of a sysfs attribute into `buf` (NUL
+   terminated). Returns the byte count, or -1. */
+static ssize_t lw_read_sysfs(const char *path, char *buf, size_t size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0)
+    {
+        return -1;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+int lw_bus_probe_caps(lw_i2c_bus *bus, const char *sysfs_root)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (bus->fd < 0)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    lw_adapter_caps *caps = &bus->caps;
+    memset(caps, 0, sizeof(*caps));
+
+    unsigned long funcs = 0;
+    if (ioctl(bus->fd, I2C_FUNCS, &funcs) == 0)
+    {
+        caps->funcs = funcs;
+        caps->flags |= LW_CAPS_FUNCS;
+    }
+
+    /* sysfs entries are keyed by the adapter number in the device path */
+    if (strncmp(bus->device_path, "/dev/i2c-", 9) != 0)
+    {
+        return 0;
+    }
+    const char *adapter = bus->device_path + 9;
+    if (!sysfs_root)
+    {
+        sysfs_root = LINUX_WIRE_SYSFS_I2C_ROOT;
+    }
+
+    char path[PATH_MAX];
+    char value[LINUX_WIRE_ADAPTER_NAME_MAX];
+    int len = snprintf(path, sizeof(path), "%s/i2c-%s/name", sysfs_root, adapter);
+    if (len > 0 && (size_t)len < sizeof(path) &&
+        lw_read_sysfs(path, value, sizeof(value)) > 0)
+    {
+        value[strcspn(value, "\n")] = '\0';
+        memcpy(caps->name, value, sizeof(caps->name));
+        caps->flags |= LW_CAPS_NAME;
+    }
+
+    /* Device tree property: one big-endian 32-bit cell */
+    len = snprintf(path, sizeof(path), "%s/i2c-%s/of_node/clock-frequency", sysfs_root, adapter);
+    if (len > 0 && (size_t)len < sizeof(path) &&
+        lw_read_sysfs(path, value, sizeof(value)) == 4)
+    {
+        const uint8_t *cell = (const uint8_t *)value;
+        caps->bus_hz = ((uint32_t)cell[0] << 24) | ((uint32_t)cell[1] << 16) |
+                       ((uint32_t)cell[2] << 8) | (uint32_t)cell[3];
+        caps->flags |= LW_CAPS_BUS_HZ;
+    }
+
+    return 0;
+}
+
+int lw_bus_supports(const lw_i2c_bus *bus, unsigned long funcs)
+{
+    if (!bus || !(bus->caps.flags & LW_CAPS_FUNCS))
+    {
+        return 1;
+    }
+    return (bus->caps.funcs & funcs) == funcs;
+}
+
+void lw_bus_set_observer(lw_i2c_bus *bus, lw_observer_fn fn, void *arg)
+{
+    if (!bus)
+    {
+        return;
+    }
+    bus->observer = fn;
+    bus->observer_arg = fn ? arg : NULL;
+}
+
+int lw_open_bus(lw_i2c_bus *bus, const char *device_path)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_reset_bus_handle(bus);
+    return lw_open_fd(bus, device_path);
+}
+
+int lw_open_backend(lw_i2c_bus *bus, const char *label, lw_backend_fn fn, void *arg)
+{
+    if (!bus || !fn)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_reset_bus_handle(bus);
+    if (label)
+    {
+        strncpy(bus->device_path, label, sizeof(bus->device_path) - 1);
+        bus->device_path[sizeof(bus->device_path) - 1] = '\0';
+    }
+    bus->backend = fn;
+    bus->backend_arg = arg;
+    return 0;
+}
+
+int lw_bus_enable_rt(lw_i2c_bus *bus, const lw_rt_config *config)
+{
+    const lw_rt_config defaults = {NULL, 0, NULL, 0};
+
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!lw_bus_is_open(bus))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!config)
+    {
+        config = &defaults;
+    }
+
+    if (config->pool && !config->pool->base)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((config->flags & LW_RT_MLOCKALL) && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        return -1;
+    }
+
+    lw_pool *pool = config->pool;
+    unsigned int owns = 0;
+    if (!pool)
+    {
+        const size_t size = config->pool_size ? config->pool_size : LINUX_WIRE_RT_DEFAULT_POOL;
+        uint8_t *block = (uint8_t *)malloc(sizeof(lw_pool) + size);
+        if (!block)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        /* Touch every page now so the hot path never takes a page fault */
+        memset(block, 0, sizeof(lw_pool) + size);
+        pool = (lw_pool *)(void *)block;
+        lw_pool_init(pool, block + sizeof(lw_pool), size);
+        owns = LW_RT_OWNS_POOL;
+    }
+
+    if (bus->rt_flags & LW_RT_OWNS_POOL)
+    {
+        free(bus->pool);
+    }
+
+    bus->pool = pool;
+    bus->errors = config->errors;
+    bus->rt_flags = LW_RT_ENABLED | owns | (config->flags & 0xFFu);
+    return 0;
+}
+
+int lw_open_bus_rt(lw_i2c_bus *bus, const char *device_path, const lw_rt_config *config)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_reset_bus_handle(bus);
+
+    /* Route a failed open to the error ring rather than stderr too */
+    bus->rt_flags = LW_RT_ENABLED;
+    bus->errors = config ? config->errors : NULL;
+    const int rc = lw_open_fd(bus, device_path);
+    bus->rt_flags = 0;
+    bus->errors = NULL;
+    if (rc != 0)
+    {
+        return -1;
+    }
+
+    if (lw_bus_enable_rt(bus, config) != 0)
+    {
+        const int saved_errno = errno;
+        lw_close_bus(bus);
+        errno = saved_errno;
+        return -1;
+    }
     return 0;
 }
 
@@ -110,8 +552,46 @@ void lw_close_bus(lw_i2c_bus *bus)
         close(bus->fd);
         bus->fd = -1;
     }
+    if (bus->rt_flags & LW_RT_OWNS_POOL)
+    {
+        free(bus->pool);
+        bus->pool = NULL;
+    }
+    bus->rt_flags = 0;
+    bus->errors = NULL;
     bus->device_path[0] = '\0';
     bus->timeout_us = 0;
+    memset(&bus->caps, 0, sizeof(bus->caps));
+    bus->backend = NULL;
+    bus->backend_arg = NULL;
+    bus->slave_addr = 0;
+}
+
+void lw_error_ring_init(lw_error_ring *ring)
+{
+    if (!ring)
+    {
+        return;
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+int lw_error_ring_pop(lw_error_ring *ring, lw_error_record *record)
+{
+    if (!ring || !record)
+    {
+        return 0;
+    }
+
+    const uint32_t tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return 0;
+    }
+
+    *record = ring->entries[tail & (LINUX_WIRE_ERROR_RING_SIZE - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
 }
 
 int lw_set_slave(lw_i2c_bus *bus, uint8_t addr)
@@ -122,7 +602,7 @@ int lw_set_slave(lw_i2c_bus *bus, uint8_t addr)
         return -1;
     }
 
-    if (bus->fd < 0)
+    if (!lw_bus_is_open(bus))
     {
         errno = EBADF;
         return -1;
@@ -134,17 +614,13 @@ int lw_set_slave(lw_i2c_bus *bus, uint8_t addr)
         return -1;
     }
 
-    if (ioctl(bus->fd, I2C_SLAVE, addr) < 0)
+    if (!bus->backend && ioctl(bus->fd, I2C_SLAVE, addr) < 0)
     {
-        int saved_errno = errno;
-        if (bus->log_errors)
-        {
-            perror("lw_set_slave: I2C_SLAVE");
-        }
-        errno = saved_errno;
+        lw_report_error(bus, LW_OP_SET_SLAVE, addr, "lw_set_slave: I2C_SLAVE");
         return -1;
     }
 
+    bus->slave_addr = addr;
     return 0;
 }
 
@@ -163,7 +639,7 @@ ssize_t lw_write(lw_i2c_bus *bus,
         return -1;
     }
 
-    if (bus->fd < 0)
+    if (!lw_bus_is_open(bus))
     {
         errno = EBADF;
         return -1;
@@ -180,15 +656,24 @@ ssize_t lw_write(lw_i2c_bus *bus,
         return 0;
     }
 
-    ssize_t written = write(bus->fd, data, len);
+    ssize_t written;
+    if (bus->backend)
+    {
+        /* What i2c-dev does for write(): one message to the slave address */
+        struct i2c_msg msg = {0};
+        msg.addr = bus->slave_addr;
+        msg.len = (uint16_t)(len > UINT16_MAX ? UINT16_MAX : len);
+        msg.buf = (uint8_t *)data;
+        written = lw_rdwr(bus, &msg, 1) < 0 ? -1 : (ssize_t)msg.len;
+    }
+    else
+    {
+        written = write(bus->fd, data, len);
+    }
+    lw_notify(bus, LW_OP_WRITE, LW_ADDR_UNKNOWN, 1, 0, written > 0 ? (size_t)written : 0, written < 0);
     if (written < 0)
     {
-        int saved_errno = errno;
-        if (bus->log_errors)
-        {
-            perror("lw_write: write");
-        }
-        errno = saved_errno;
+        lw_report_error(bus, LW_OP_WRITE, LW_ADDR_UNKNOWN, "lw_write: write");
     }
     return written;
 }
@@ -203,7 +688,7 @@ ssize_t lw_read(lw_i2c_bus *bus,
         return -1;
     }
 
-    if (bus->fd < 0)
+    if (!lw_bus_is_open(bus))
     {
         errno = EBADF;
         return -1;
@@ -220,15 +705,24 @@ ssize_t lw_read(lw_i2c_bus *bus,
         return 0;
     }
 
-    ssize_t r = read(bus->fd, data, len);
+    ssize_t r;
+    if (bus->backend)
+    {
+        struct i2c_msg msg = {0};
+        msg.addr = bus->slave_addr;
+        msg.flags = I2C_M_RD;
+        msg.len = (uint16_t)(len > UINT16_MAX ? UINT16_MAX : len);
+        msg.buf = data;
+        r = lw_rdwr(bus, &msg, 1) < 0 ? -1 : (ssize_t)msg.len;
+    }
+    else
+    {
+        r = read(bus->fd, data, len);
+    }
+    lw_notify(bus, LW_OP_READ, LW_ADDR_UNKNOWN, 1, 0, r > 0 ? (size_t)r : 0, r < 0);
     if (r < 0)
     {
-        int saved_errno = errno;
-        if (bus->log_errors)
-        {
-            perror("lw_read: read");
-        }
-        errno = saved_errno;
+        lw_report_error(bus, LW_OP_READ, LW_ADDR_UNKNOWN, "lw_read: read");
     }
     return r;
 }
@@ -247,7 +741,7 @@ ssize_t lw_ioctl_read(lw_i2c_bus *bus,
         return -1;
     }
 
-    if (bus->fd < 0)
+    if (!lw_bus_is_open(bus))
     {
         errno = EBADF;
         return -1;
@@ -266,8 +760,12 @@ ssize_t lw_ioctl_read(lw_i2c_bus *bus,
         return -1;
     }
 
+    if (lw_rdwr_check(bus, LW_OP_IOCTL_READ, addr, flags, "lw_ioctl_read") != 0)
+    {
+        return -1;
+    }
+
     struct i2c_msg msgs[2] = {{0}};
-    struct i2c_rdwr_ioctl_data rdwr = {0};
 
     int msg_count = 0;
 
@@ -289,17 +787,12 @@ ssize_t lw_ioctl_read(lw_i2c_bus *bus,
     msgs[msg_count].len = (uint16_t)len;
     ++msg_count;
 
-    rdwr.msgs = msgs;
-    rdwr.nmsgs = msg_count;
-
-    if (ioctl(bus->fd, I2C_RDWR, &rdwr) < 0)
+    const int rc = lw_rdwr(bus, msgs, (size_t)msg_count);
+    lw_notify(bus, LW_OP_IOCTL_READ, addr, (size_t)msg_count,
+              (flags & I2C_M_TEN) ? (size_t)msg_count : 0, iaddr_len + len, rc < 0);
+    if (rc < 0)
     {
-        int saved_errno = errno;
-        if (bus->log_errors)
-        {
-            perror("lw_ioctl_read: I2C_RDWR");
-        }
-        errno = saved_errno;
+        lw_report_error(bus, LW_OP_IOCTL_READ, addr, "lw_ioctl_read: I2C_RDWR");
         return -1;
     }
 
@@ -320,7 +813,7 @@ ssize_t lw_ioctl_write(lw_i2c_bus *bus,
         return -1;
     }
 
-    if (bus->fd < 0)
+    if (!lw_bus_is_open(bus))
     {
         errno = EBADF;
         return -1;
@@ -357,10 +850,16 @@ ssize_t lw_ioctl_write(lw_i2c_bus *bus,
         return -1;
     }
 
-    /* PERFORMANCE FIX: Use stack allocation for small buffers */
+    if (lw_rdwr_check(bus, LW_OP_IOCTL_WRITE, addr, flags, "lw_ioctl_write") != 0)
+    {
+        return -1;
+    }
+
+    /* PERFORMANCE FIX: Use stack allocation for small buffers, the bus
+       pool (or heap) for larger ones */
     uint8_t stack_buf[LW_STACK_BUFFER_SIZE];
     uint8_t *buf;
-    int heap_allocated = 0;
+    lw_scratch scratch = {0};
 
     if (total_len <= LW_STACK_BUFFER_SIZE)
     {
@@ -368,13 +867,11 @@ ssize_t lw_ioctl_write(lw_i2c_bus *bus,
     }
     else
     {
-        buf = (uint8_t *)malloc(total_len);
+        buf = (uint8_t *)lw_scratch_get(bus, total_len, &scratch);
         if (!buf)
         {
-            errno = ENOMEM;
             return -1;
         }
-        heap_allocated = 1;
     }
 
     /* Build combined buffer: [iaddr (optional)] [data] */
@@ -384,38 +881,439 @@ ssize_t lw_ioctl_write(lw_i2c_bus *bus,
         memcpy(buf + iaddr_len, data, len);
 
     struct i2c_msg msg = {0};
-    struct i2c_rdwr_ioctl_data rdwr = {0};
 
     msg.addr = addr;
     msg.flags = flags;
     msg.buf = buf;
     msg.len = (uint16_t)total_len;
 
-    rdwr.msgs = &msg;
-    rdwr.nmsgs = 1;
-
-    if (ioctl(bus->fd, I2C_RDWR, &rdwr) < 0)
+    const int rc = lw_rdwr(bus, &msg, 1);
+    lw_notify(bus, LW_OP_IOCTL_WRITE, addr, 1, (flags & I2C_M_TEN) ? 1 : 0, total_len, rc < 0);
+    if (rc < 0)
     {
+        lw_report_error(bus, LW_OP_IOCTL_WRITE, addr, "lw_ioctl_write: I2C_RDWR");
         int saved_errno = errno;
-        if (bus->log_errors)
+        lw_scratch_put(bus, &scratch);
+
+        errno = saved_errno; /* Restore errno AFTER free() */
+        return -1;
+    }
+
+    lw_scratch_put(bus, &scratch);
+
+    return (ssize_t)len;
+}
+
+int lw_transfer(lw_i2c_bus *bus, const lw_msg *msgs, size_t count)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!lw_bus_is_open(bus))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!msgs || count == 0 || count > LW_MAX_MSGS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint16_t all_flags = 0;
+    size_t ten_bit_msgs = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!msgs[i].buf && msgs[i].len > 0)
         {
-            perror("lw_ioctl_write: I2C_RDWR");
+            errno = EINVAL;
+            return -1;
         }
-        if (heap_allocated)
+        all_flags |= msgs[i].flags;
+        ten_bit_msgs += (msgs[i].flags & I2C_M_TEN) ? 1 : 0;
+        bytes += msgs[i].len;
+    }
+
+    if (lw_rdwr_check(bus, LW_OP_TRANSFER, msgs[0].addr, all_flags, "lw_transfer") != 0)
+    {
+        return -1;
+    }
+
+    struct i2c_msg stack_msgs[LW_STACK_MSG_COUNT];
+    struct i2c_msg *kmsgs = stack_msgs;
+    lw_scratch scratch = {0};
+
+    if (count > LW_STACK_MSG_COUNT)
+    {
+        kmsgs = (struct i2c_msg *)lw_scratch_get(bus, count * sizeof(struct i2c_msg), &scratch);
+        if (!kmsgs)
         {
-            free(buf);
+            return -1;
         }
+    }
 
-        errno = saved_errno; /* Restore errno AFTER free() */
+    for (size_t i = 0; i < count; ++i)
+    {
+        kmsgs[i].addr = msgs[i].addr;
+        kmsgs[i].flags = msgs[i].flags;
+        kmsgs[i].len = msgs[i].len;
+        kmsgs[i].buf = msgs[i].buf;
+    }
+
+    int rc = lw_rdwr(bus, kmsgs, count);
+    lw_notify(bus, LW_OP_TRANSFER, msgs[0].addr, count, ten_bit_msgs, bytes, rc < 0);
+    if (rc < 0)
+    {
+        lw_report_error(bus, LW_OP_TRANSFER, msgs[0].addr, "lw_transfer: I2C_RDWR");
+    }
+    int saved_errno = errno;
+    lw_scratch_put(bus, &scratch);
+
+    if (rc < 0)
+    {
+        errno = saved_errno;
         return -1;
     }
+    return (int)count;
+}
 
-    if (heap_allocated)
+ssize_t lw_gather_read(lw_i2c_bus *bus,
+                       uint16_t addr,
+                       const lw_gather_item *items,
+                       size_t count)
+{
+    if (!bus)
     {
-        free(buf);
+        errno = EINVAL;
+        return -1;
     }
 
-    return (ssize_t)len;
+    if (!lw_bus_is_open(bus))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!items || count == 0 || count > LW_GATHER_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint8_t regs[LW_GATHER_MAX][4];
+    lw_msg msgs[LW_MAX_MSGS];
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const lw_gather_item *item = &items[i];
+        if (item->reg_len < 1 || item->reg_len > 4 || item->len == 0 || !item->dst)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+
+        for (uint8_t b = 0; b < item->reg_len; ++b)
+        {
+            regs[i][b] = (uint8_t)(item->reg >> (8U * (item->reg_len - 1U - b)));
+        }
+
+        msgs[2 * i].addr = addr;
+        msgs[2 * i].flags = 0;
+        msgs[2 * i].len = item->reg_len;
+        msgs[2 * i].buf = regs[i];
+
+        msgs[2 * i + 1].addr = addr;
+        msgs[2 * i + 1].flags = LW_MSG_RD;
+        msgs[2 * i + 1].len = item->len;
+        msgs[2 * i + 1].buf = item->dst;
+
+        total += item->len;
+    }
+
+    if (lw_transfer(bus, msgs, 2 * count) < 0)
+    {
+        return -1;
+    }
+    return (ssize_t)total;
+}
+
+int lw_prepare_transfer(lw_prepared *prep,
+                        lw_i2c_bus *bus,
+                        const lw_msg *msgs,
+                        size_t count)
+{
+    if (!prep || !bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!lw_bus_is_open(bus))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!msgs || count == 0 || count > LW_PREPARED_MAX_MSGS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint16_t all_flags = 0;
+    uint32_t bytes = 0;
+    uint16_t ten_bit_msgs = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!msgs[i].buf && msgs[i].len > 0)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        all_flags |= msgs[i].flags;
+        ten_bit_msgs += (msgs[i].flags & I2C_M_TEN) ? 1 : 0;
+        bytes += msgs[i].len;
+    }
+
+    if (lw_rdwr_check(bus, LW_OP_TRANSFER, msgs[0].addr, all_flags, "lw_prepare_transfer") != 0)
+    {
+        return -1;
+    }
+
+    memcpy(prep->msgs, msgs, count * sizeof(*msgs));
+    prep->bus = bus;
+    prep->count = (uint32_t)count;
+    prep->bytes = bytes;
+    prep->ten_bit_msgs = ten_bit_msgs;
+    return 0;
+}
+
+int lw_prepare_read(lw_prepared *prep,
+                    lw_i2c_bus *bus,
+                    uint16_t addr,
+                    uint32_t reg,
+                    uint8_t reg_len,
+                    uint8_t *dst,
+                    uint16_t len)
+{
+    if (!prep || reg_len < 1 || reg_len > 4 || !dst || len == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (uint8_t b = 0; b < reg_len; ++b)
+    {
+        prep->reg[b] = (uint8_t)(reg >> (8U * (reg_len - 1U - b)));
+    }
+
+    lw_msg msgs[2];
+    msgs[0].addr = addr;
+    msgs[0].flags = 0;
+    msgs[0].len = reg_len;
+    msgs[0].buf = prep->reg;
+    msgs[1].addr = addr;
+    msgs[1].flags = LW_MSG_RD;
+    msgs[1].len = len;
+    msgs[1].buf = dst;
+    return lw_prepare_transfer(prep, bus, msgs, 2);
+}
+
+int lw_prepared_exec(lw_prepared *prep)
+{
+    lw_i2c_bus *bus = prep->bus;
+    const int rc = lw_rdwr(bus, (struct i2c_msg *)(void *)prep->msgs, prep->count);
+    lw_notify(bus, LW_OP_TRANSFER, prep->msgs[0].addr, prep->count, prep->ten_bit_msgs, prep->bytes, rc < 0);
+    if (rc < 0)
+    {
+        lw_report_error(bus, LW_OP_TRANSFER, prep->msgs[0].addr, "lw_prepared_exec: I2C_RDWR");
+        return -1;
+    }
+    return 0;
+}
+
+int lw_pool_init(lw_pool *pool, void *storage, size_t size)
+{
+    if (!pool || !storage || size == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pool->base = (uint8_t *)storage;
+    pool->capacity = size;
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->hits = 0;
+    pool->misses = 0;
+    return 0;
+}
+
+int lw_bus_attach_pool(lw_i2c_bus *bus, lw_pool *pool)
+{
+    if (!bus || (pool && !pool->base))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (bus->rt_flags & LW_RT_OWNS_POOL)
+    {
+        /* The realtime pool from lw_bus_enable_rt() is replaced, not leaked */
+        free(bus->pool);
+        bus->rt_flags &= ~LW_RT_OWNS_POOL;
+    }
+    bus->pool = pool;
+    return 0;
+}
+
+void lw_pool_get_stats(const lw_pool *pool, lw_pool_stats *stats)
+{
+    if (!pool || !stats)
+    {
+        return;
+    }
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->capacity = pool->capacity;
+    stats->high_water = pool->high_water;
+}
+
+void lw_pool_reset_stats(lw_pool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    pool->hits = 0;
+    pool->misses = 0;
+    pool->high_water = pool->used;
+}
+
+static void lw_pause_us(uint32_t us, int spin)
+{
+    if (us == 0)
+    {
+        return;
+    }
+
+    if (spin)
+    {
+        const uint64_t until = lw_monotonic_us() + us;
+        while (lw_monotonic_us() < until)
+        {
+        }
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = us / 1000000U;
+    ts.tv_nsec = (long)(us % 1000000U) * 1000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+/* Errors a busy (or absent) device produces when it NACKs its address */
+static int lw_is_nack_errno(int err)
+{
+    return err == ENXIO || err == EREMOTEIO || err == EIO ||
+           err == EAGAIN || err == ETIMEDOUT;
+}
+
+/* One ACK probe. `zero_len_ok` is cleared if the adapter refuses
+   zero-length messages so later probes go straight to the read form. */
+static int lw_probe_address(lw_i2c_bus *bus, uint16_t addr, int *zero_len_ok)
+{
+    uint8_t scratch = 0;
+    struct i2c_msg msg = {0};
+
+    msg.addr = addr;
+
+    if (*zero_len_ok)
+    {
+        msg.flags = 0;
+        msg.len = 0;
+        msg.buf = &scratch;
+        const int rc = lw_rdwr(bus, &msg, 1);
+        lw_notify(bus, LW_OP_PROBE, addr, 1, 0, 0, rc < 0);
+        if (rc >= 0)
+        {
+            return 0;
+        }
+        if (errno != EOPNOTSUPP && errno != EINVAL)
+        {
+            return -1;
+        }
+        *zero_len_ok = 0;
+    }
+
+    msg.flags = I2C_M_RD;
+    msg.len = 1;
+    msg.buf = &scratch;
+    const int rc = lw_rdwr(bus, &msg, 1);
+    lw_notify(bus, LW_OP_PROBE, addr, 1, 0, 1, rc < 0);
+    return rc >= 0 ? 0 : -1;
+}
+
+int lw_wait_ready(lw_i2c_bus *bus,
+                  uint16_t addr,
+                  uint32_t timeout_us,
+                  uint32_t interval_us,
+                  unsigned int options)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!lw_bus_is_open(bus))
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (addr > 0x7F)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* The probes are I2C_RDWR messages; don't poll a doomed ioctl */
+    if (lw_rdwr_check(bus, LW_OP_IOCTL_WRITE, addr, 0, "lw_wait_ready") != 0)
+    {
+        return -1;
+    }
+
+    const int spin = (options & LW_WAIT_SPIN) != 0;
+    const uint64_t deadline = lw_monotonic_us() + timeout_us;
+    int zero_len_ok = 1;
+
+    for (;;)
+    {
+        if (lw_probe_address(bus, addr, &zero_len_ok) == 0)
+        {
+            return 0;
+        }
+        if (!lw_is_nack_errno(errno))
+        {
+            return -1; /* errno from ioctl */
+        }
+        const uint64_t now = lw_monotonic_us();
+        if (now >= deadline)
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        const uint64_t remaining = deadline - now;
+        lw_pause_us(remaining < interval_us ? (uint32_t)remaining : interval_us, spin);
+    }
 }
 
 int lw_set_timeout(lw_i2c_bus *bus, uint32_t timeout_us)
@@ -0,0 +1,959 @@
+#define _GNU_SOURCE
+
+#include "linux_wire_broker.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LW_BROKER_MAGIC 0x4C574252u /* "LWBR" */
+#define LW_BROKER_VERSION 1u
+
+/* lw_broker_slot.flags: keep the bus for this client afterwards */
+#define LW_BROKER_REQ_HOLD 0x0001u
+
+/* epoll tags (upper 32 bits of epoll_data.u64; the lower hold a client) */
+#define LW_BROKER_EV_LISTEN 1u
+#define LW_BROKER_EV_WAKE 2u
+#define LW_BROKER_EV_SOCK 3u
+#define LW_BROKER_EV_REQ 4u
+
+#define LW_BROKER_EVENTS 16
+
+typedef struct
+{
+    uint16_t addr;
+    uint16_t flags;
+    uint16_t len;
+} lw_broker_wire_msg;
+
+/* One request; results and read data are written back in place */
+typedef struct
+{
+    uint32_t count; /* 0 = release the hold */
+    uint32_t flags;
+    uint32_t priority;
+    int32_t result; /* 0 or -errno */
+    lw_broker_wire_msg msgs[LW_MAX_MSGS];
+    uint8_t payload[LINUX_WIRE_BROKER_PAYLOAD_MAX];
+} lw_broker_slot;
+
+/* Per-client shared memory: an SPSC ring of slots. The client produces
+   (`head`), the broker completes in order (`done`). */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t slot_size;
+    _Alignas(64) uint32_t head;
+    _Alignas(64) uint32_t done;
+    uint32_t waiting; /* client may be asleep on resp_fd */
+    _Alignas(64) lw_broker_slot slot[LINUX_WIRE_BROKER_RING_SIZE];
+} lw_broker_ring;
+
+_Static_assert((LINUX_WIRE_BROKER_RING_SIZE & (LINUX_WIRE_BROKER_RING_SIZE - 1)) == 0,
+               "LINUX_WIRE_BROKER_RING_SIZE must be a power of two");
+
+/* Sent by the broker right after accept(), with the ring memfd and the
+   request/response eventfds attached */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t err;
+    uint32_t ring_size;
+    lw_adapter_caps caps;
+    char device_path[LINUX_WIRE_DEVICE_PATH_MAX];
+} lw_broker_hello;
+
+static void lw_broker_close_fd(int *fd)
+{
+    if (*fd >= 0)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+static int lw_broker_fill_addr(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+static int lw_broker_watch(lw_broker *broker, int fd, uint32_t events, uint32_t kind, uint32_t index)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = ((uint64_t)kind << 32) | index;
+    return epoll_ctl(broker->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void lw_broker_signal(int fd)
+{
+    const uint64_t one = 1;
+    ssize_t ignored = write(fd, &one, sizeof(one));
+    (void)ignored; /* a saturated counter still wakes the reader */
+}
+
+static void lw_broker_drain(int fd)
+{
+    uint64_t count;
+    ssize_t ignored = read(fd, &count, sizeof(count));
+    (void)ignored;
+}
+
+/* ------------------------------------------------------------------ */
+/* Broker                                                             */
+/* ------------------------------------------------------------------ */
+
+int lw_broker_init(lw_broker *broker, lw_i2c_bus *bus, const char *socket_path)
+{
+    if (!broker || !bus || !socket_path || (bus->fd < 0 && !bus->backend))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    if (lw_broker_fill_addr(&addr, socket_path) != 0)
+    {
+        return -1;
+    }
+
+    memset(broker, 0, sizeof(*broker));
+    broker->bus = bus;
+    broker->listen_fd = -1;
+    broker->epoll_fd = -1;
+    broker->wake_fd = -1;
+    broker->hold_us = LINUX_WIRE_BROKER_HOLD_US;
+    broker->holder = -1;
+    for (size_t i = 0; i < LINUX_WIRE_BROKER_MAX_CLIENTS; ++i)
+    {
+        broker->conns[i].sock = -1;
+        broker->conns[i].req_fd = -1;
+        broker->conns[i].resp_fd = -1;
+    }
+
+    broker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (broker->epoll_fd < 0)
+    {
+        return -1;
+    }
+
+    broker->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    broker->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (broker->wake_fd < 0 || broker->listen_fd < 0)
+    {
+        goto fail;
+    }
+
+    unlink(socket_path);
+    if (bind(broker->listen_fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        goto fail;
+    }
+    strcpy(broker->socket_path, socket_path);
+
+    if (listen(broker->listen_fd, 16) != 0 ||
+        lw_broker_watch(broker, broker->listen_fd, EPOLLIN, LW_BROKER_EV_LISTEN, 0) != 0 ||
+        lw_broker_watch(broker, broker->wake_fd, EPOLLIN, LW_BROKER_EV_WAKE, 0) != 0)
+    {
+        goto fail;
+    }
+    return 0;
+
+fail:
+    {
+        const int saved_errno = errno;
+        lw_broker_destroy(broker);
+        errno = saved_errno;
+        return -1;
+    }
+}
+
+static void lw_broker_drop(lw_broker *broker, unsigned int index)
+{
+    lw_broker_conn *conn = &broker->conns[index];
+    if (conn->sock < 0)
+    {
+        return;
+    }
+
+    /* The client holds duplicates of the eventfds, so closing ours would
+       not remove them from the epoll set */
+    epoll_ctl(broker->epoll_fd, EPOLL_CTL_DEL, conn->sock, NULL);
+    epoll_ctl(broker->epoll_fd, EPOLL_CTL_DEL, conn->req_fd, NULL);
+    if (conn->ring)
+    {
+        munmap(conn->ring, sizeof(lw_broker_ring));
+        conn->ring = NULL;
+    }
+    lw_broker_close_fd(&conn->sock);
+    lw_broker_close_fd(&conn->req_fd);
+    lw_broker_close_fd(&conn->resp_fd);
+    if (broker->holder == (int)index)
+    {
+        broker->holder = -1;
+    }
+    --broker->clients;
+}
+
+/* Create the ring and eventfds for a new client and hand them over.
+   Takes ownership of `sock`, closing it on failure. */
+static int lw_broker_setup(lw_broker *broker, unsigned int index, int sock)
+{
+    lw_broker_conn *conn = &broker->conns[index];
+    int mem_fd = memfd_create("linux-wire-broker", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mem_fd < 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    /* Sealed size: a client cannot shrink the ring under the broker */
+    void *map = MAP_FAILED;
+    if (ftruncate(mem_fd, sizeof(lw_broker_ring)) == 0 &&
+        fcntl(mem_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0)
+    {
+        map = mmap(NULL, sizeof(lw_broker_ring), PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+    }
+    if (map == MAP_FAILED)
+    {
+        const int saved_errno = errno;
+        close(mem_fd);
+        close(sock);
+        errno = saved_errno;
+        return -1;
+    }
+
+    lw_broker_ring *ring = (lw_broker_ring *)map;
+    ring->magic = LW_BROKER_MAGIC;
+    ring->version = LW_BROKER_VERSION;
+    ring->slots = LINUX_WIRE_BROKER_RING_SIZE;
+    ring->slot_size = (uint32_t)sizeof(lw_broker_slot);
+
+    conn->sock = sock;
+    conn->ring = ring;
+    conn->done = 0;
+    conn->hold_expired = 0;
+    conn->req_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    conn->resp_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ++broker->clients;
+
+    lw_broker_hello hello;
+    memset(&hello, 0, sizeof(hello));
+    hello.magic = LW_BROKER_MAGIC;
+    hello.version = LW_BROKER_VERSION;
+    hello.ring_size = (uint32_t)sizeof(lw_broker_ring);
+    hello.caps = broker->bus->caps;
+    memcpy(hello.device_path, broker->bus->device_path, sizeof(hello.device_path));
+
+    int fds[3] = {mem_fd, conn->req_fd, conn->resp_fd};
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = {&hello, sizeof(hello)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    int rc = -1;
+    if (conn->req_fd >= 0 && conn->resp_fd >= 0 &&
+        sendmsg(sock, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(hello) &&
+        lw_broker_watch(broker, sock, EPOLLIN | EPOLLRDHUP, LW_BROKER_EV_SOCK, index) == 0 &&
+        lw_broker_watch(broker, conn->req_fd, EPOLLIN, LW_BROKER_EV_REQ, index) == 0)
+    {
+        rc = 0;
+    }
+
+    const int saved_errno = errno;
+    close(mem_fd);
+    if (rc != 0)
+    {
+        lw_broker_drop(broker, index); /* also closes `sock` */
+        errno = saved_errno;
+        return -1;
+    }
+    return 0;
+}
+
+static void lw_broker_accept(lw_broker *broker)
+{
+    for (;;)
+    {
+        int sock = accept4(broker->listen_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (sock < 0)
+        {
+            return;
+        }
+
+        unsigned int index = 0;
+        while (index < LINUX_WIRE_BROKER_MAX_CLIENTS && broker->conns[index].sock >= 0)
+        {
+            ++index;
+        }
+        if (index == LINUX_WIRE_BROKER_MAX_CLIENTS)
+        {
+            lw_broker_hello hello;
+            memset(&hello, 0, sizeof(hello));
+            hello.magic = LW_BROKER_MAGIC;
+            hello.version = LW_BROKER_VERSION;
+            hello.err = EUSERS;
+            ssize_t ignored = send(sock, &hello, sizeof(hello), MSG_NOSIGNAL);
+            (void)ignored;
+            close(sock);
+            continue;
+        }
+
+        lw_broker_setup(broker, index, sock);
+    }
+}
+
+/* Requests waiting on `conn`; drops a client whose ring is corrupt */
+static uint32_t lw_broker_pending(lw_broker *broker, unsigned int index)
+{
+    lw_broker_conn *conn = &broker->conns[index];
+    if (conn->sock < 0)
+    {
+        return 0;
+    }
+    const lw_broker_ring *ring = (const lw_broker_ring *)conn->ring;
+    const uint32_t pending = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - conn->done;
+    if (pending > LINUX_WIRE_BROKER_RING_SIZE)
+    {
+        lw_broker_drop(broker, index);
+        return 0;
+    }
+    return pending;
+}
+
+/* Next client to serve: the hold owner, else the highest priority at
+   the head of any ring, round-robin among equals */
+static int lw_broker_pick(lw_broker *broker)
+{
+    if (broker->holder >= 0)
+    {
+        return lw_broker_pending(broker, (unsigned int)broker->holder) ? broker->holder : -1;
+    }
+
+    int best = -1;
+    uint32_t best_priority = 0;
+    for (unsigned int k = 0; k < LINUX_WIRE_BROKER_MAX_CLIENTS; ++k)
+    {
+        const unsigned int index = (broker->cursor + k) % LINUX_WIRE_BROKER_MAX_CLIENTS;
+        if (!lw_broker_pending(broker, index))
+        {
+            continue;
+        }
+        const lw_broker_conn *conn = &broker->conns[index];
+        const lw_broker_ring *ring = (const lw_broker_ring *)conn->ring;
+        const uint32_t priority = ring->slot[conn->done & (LINUX_WIRE_BROKER_RING_SIZE - 1)].priority;
+        if (best < 0 || priority > best_priority)
+        {
+            best = (int)index;
+            best_priority = priority;
+        }
+    }
+    if (best >= 0)
+    {
+        broker->cursor = (unsigned int)best + 1;
+    }
+    return best;
+}
+
+/* Run the request at the head of `index`'s ring and complete it */
+static void lw_broker_execute(lw_broker *broker, unsigned int index)
+{
+    lw_broker_conn *conn = &broker->conns[index];
+    lw_broker_ring *ring = (lw_broker_ring *)conn->ring;
+    lw_broker_slot *slot = &ring->slot[conn->done & (LINUX_WIRE_BROKER_RING_SIZE - 1)];
+
+    /* The client can rewrite the slot at any time: work from copies */
+    const uint32_t count = slot->count;
+    const uint32_t flags = slot->flags;
+    int err = 0;
+
+    if (count == 0)
+    {
+        conn->hold_expired = 0;
+        if (broker->holder == (int)index)
+        {
+            broker->holder = -1;
+        }
+    }
+    else if ((flags & LW_BROKER_REQ_HOLD) && conn->hold_expired)
+    {
+        err = ETIMEDOUT; /* the sequence already lost its exclusivity */
+    }
+    else if (count > LW_MAX_MSGS)
+    {
+        err = EINVAL;
+    }
+    else
+    {
+        lw_msg msgs[LW_MAX_MSGS];
+        size_t offset = 0;
+        for (uint32_t i = 0; i < count && !err; ++i)
+        {
+            const lw_broker_wire_msg wire = slot->msgs[i];
+            if (wire.len > LINUX_WIRE_BROKER_PAYLOAD_MAX - offset)
+            {
+                err = EMSGSIZE;
+                break;
+            }
+            msgs[i].addr = wire.addr;
+            msgs[i].flags = wire.flags;
+            msgs[i].len = wire.len;
+            msgs[i].buf = slot->payload + offset;
+            offset += wire.len;
+        }
+        if (!err && lw_transfer(broker->bus, msgs, count) < 0)
+        {
+            err = errno;
+        }
+
+        if (flags & LW_BROKER_REQ_HOLD)
+        {
+            broker->holder = (int)index;
+            broker->hold_deadline_us = lw_monotonic_us() + broker->hold_us;
+        }
+        else
+        {
+            conn->hold_expired = 0;
+            if (broker->holder == (int)index)
+            {
+                broker->holder = -1;
+            }
+        }
+    }
+
+    slot->result = -err;
+    ++broker->requests;
+    if (err)
+    {
+        ++broker->failures;
+    }
+
+    /* Publish, then wake the client only if it may be asleep (pairs with
+       the fence in lw_broker_wait()) */
+    ++conn->done;
+    __atomic_store_n(&ring->done, conn->done, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_RELAXED))
+    {
+        lw_broker_signal(conn->resp_fd);
+    }
+}
+
+/* Break a hold whose owner has left the bus idle too long */
+static void lw_broker_check_hold(lw_broker *broker, uint64_t now_us)
+{
+    if (broker->holder < 0 || now_us < broker->hold_deadline_us ||
+        lw_broker_pending(broker, (unsigned int)broker->holder))
+    {
+        return;
+    }
+    /* lw_broker_pending() may have dropped the holder */
+    if (broker->holder >= 0)
+    {
+        broker->conns[broker->holder].hold_expired = 1;
+        broker->holder = -1;
+        ++broker->hold_timeouts;
+    }
+}
+
+static int lw_broker_has_work(lw_broker *broker)
+{
+    if (broker->holder >= 0)
+    {
+        return lw_broker_pending(broker, (unsigned int)broker->holder) != 0;
+    }
+    for (unsigned int i = 0; i < LINUX_WIRE_BROKER_MAX_CLIENTS; ++i)
+    {
+        if (lw_broker_pending(broker, i))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int lw_broker_run_once(lw_broker *broker, int timeout_ms)
+{
+    if (!broker || broker->epoll_fd < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_broker_has_work(broker))
+    {
+        timeout_ms = 0;
+    }
+    else if (broker->holder >= 0)
+    {
+        const uint64_t now = lw_monotonic_us();
+        const uint64_t left_us = broker->hold_deadline_us > now ? broker->hold_deadline_us - now : 0;
+        const int left_ms = (int)((left_us + 999) / 1000);
+        if (timeout_ms < 0 || left_ms < timeout_ms)
+        {
+            timeout_ms = left_ms;
+        }
+    }
+
+    struct epoll_event events[LW_BROKER_EVENTS];
+    int n = epoll_wait(broker->epoll_fd, events, LW_BROKER_EVENTS, timeout_ms);
+    if (n < 0)
+    {
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+        n = 0;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        const uint32_t kind = (uint32_t)(events[i].data.u64 >> 32);
+        const unsigned int index = (unsigned int)(events[i].data.u64 & 0xFFFFFFFFu);
+        switch (kind)
+        {
+        case LW_BROKER_EV_LISTEN:
+            lw_broker_accept(broker);
+            break;
+        case LW_BROKER_EV_WAKE:
+            lw_broker_drain(broker->wake_fd);
+            break;
+        case LW_BROKER_EV_SOCK:
+            /* Clients never send after setup: readable means gone */
+            lw_broker_drop(broker, index);
+            break;
+        case LW_BROKER_EV_REQ:
+            if (broker->conns[index].sock >= 0)
+            {
+                lw_broker_drain(broker->conns[index].req_fd);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    lw_broker_check_hold(broker, lw_monotonic_us());
+
+    int ran = 0;
+    while (ran < LINUX_WIRE_BROKER_BATCH)
+    {
+        const int index = lw_broker_pick(broker);
+        if (index < 0)
+        {
+            break;
+        }
+        lw_broker_execute(broker, (unsigned int)index);
+        ++ran;
+    }
+    if (ran > 0)
+    {
+        ++broker->wakeups;
+    }
+    return ran;
+}
+
+int lw_broker_run(lw_broker *broker)
+{
+    if (!broker)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    while (!__atomic_load_n(&broker->stop, __ATOMIC_ACQUIRE))
+    {
+        if (lw_broker_run_once(broker, -1) < 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void lw_broker_stop(lw_broker *broker)
+{
+    if (!broker)
+    {
+        return;
+    }
+    __atomic_store_n(&broker->stop, 1, __ATOMIC_RELEASE);
+    if (broker->wake_fd >= 0)
+    {
+        lw_broker_signal(broker->wake_fd);
+    }
+}
+
+void lw_broker_destroy(lw_broker *broker)
+{
+    if (!broker)
+    {
+        return;
+    }
+    for (unsigned int i = 0; i < LINUX_WIRE_BROKER_MAX_CLIENTS; ++i)
+    {
+        lw_broker_drop(broker, i);
+    }
+    lw_broker_close_fd(&broker->listen_fd);
+    lw_broker_close_fd(&broker->wake_fd);
+    lw_broker_close_fd(&broker->epoll_fd);
+    if (broker->socket_path[0] != '\0')
+    {
+        unlink(broker->socket_path);
+        broker->socket_path[0] = '\0';
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Client                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Wait until the broker has completed request number `target` */
+static int lw_broker_wait(lw_broker_client *client, uint32_t target)
+{
+    lw_broker_ring *ring = (lw_broker_ring *)client->ring;
+
+#define LW_BROKER_DONE() ((int32_t)(__atomic_load_n(&ring->done, __ATOMIC_ACQUIRE) - target) >= 0)
+
+    if (LW_BROKER_DONE())
+    {
+        return 0;
+    }
+
+    /* The broker usually answers within microseconds: spin first */
+    if (client->spin_us > 0)
+    {
+        const uint64_t until = lw_monotonic_us() + client->spin_us;
+        do
+        {
+            if (LW_BROKER_DONE())
+            {
+                return 0;
+            }
+        } while (lw_monotonic_us() < until);
+    }
+
+    for (;;)
+    {
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (LW_BROKER_DONE())
+        {
+            __atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+            return 0;
+        }
+
+        struct pollfd pfd[2];
+        pfd[0].fd = client->resp_fd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = client->sock;
+        pfd[1].events = POLLIN;
+        if (poll(pfd, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (pfd[0].revents & POLLIN)
+        {
+            lw_broker_drain(client->resp_fd);
+        }
+        else if (pfd[1].revents && !LW_BROKER_DONE())
+        {
+            __atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+            errno = ECONNRESET;
+            return -1;
+        }
+    }
+
+#undef LW_BROKER_DONE
+}
+
+static int lw_broker_submit(lw_broker_client *client, const lw_msg *msgs, size_t count, uint32_t flags)
+{
+    if (!client->ring)
+    {
+        errno = ECONNRESET;
+        return -1;
+    }
+    if (count > LW_MAX_MSGS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += msgs[i].len;
+    }
+    if (total > LINUX_WIRE_BROKER_PAYLOAD_MAX)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    lw_broker_ring *ring = (lw_broker_ring *)client->ring;
+    const uint32_t head = client->head;
+    if (head - __atomic_load_n(&ring->done, __ATOMIC_ACQUIRE) >= LINUX_WIRE_BROKER_RING_SIZE &&
+        lw_broker_wait(client, head - LINUX_WIRE_BROKER_RING_SIZE + 1) != 0)
+    {
+        return -1;
+    }
+
+    lw_broker_slot *slot = &ring->slot[head & (LINUX_WIRE_BROKER_RING_SIZE - 1)];
+    slot->count = (uint32_t)count;
+    slot->flags = flags;
+    slot->priority = client->priority;
+    slot->result = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        slot->msgs[i].addr = msgs[i].addr;
+        slot->msgs[i].flags = msgs[i].flags;
+        slot->msgs[i].len = msgs[i].len;
+        if (!(msgs[i].flags & LW_MSG_RD) && msgs[i].len > 0)
+        {
+            memcpy(slot->payload + offset, msgs[i].buf, msgs[i].len);
+        }
+        offset += msgs[i].len;
+    }
+
+    client->head = head + 1;
+    __atomic_store_n(&ring->head, client->head, __ATOMIC_RELEASE);
+    lw_broker_signal(client->req_fd);
+
+    if (lw_broker_wait(client, client->head) != 0)
+    {
+        return -1;
+    }
+
+    if (slot->result < 0)
+    {
+        errno = -slot->result;
+        return -1;
+    }
+
+    offset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if ((msgs[i].flags & LW_MSG_RD) && msgs[i].len > 0)
+        {
+            memcpy(msgs[i].buf, slot->payload + offset, msgs[i].len);
+        }
+        offset += msgs[i].len;
+    }
+    return (int)count;
+}
+
+static int lw_broker_client_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    lw_broker_client *client = (lw_broker_client *)arg;
+    return lw_broker_submit(client, msgs, count, client->holding ? LW_BROKER_REQ_HOLD : 0);
+}
+
+static void lw_broker_client_reset(lw_broker_client *client)
+{
+    memset(client, 0, sizeof(*client));
+    client->sock = -1;
+    client->req_fd = -1;
+    client->resp_fd = -1;
+    client->spin_us = LINUX_WIRE_BROKER_SPIN_US;
+}
+
+int lw_broker_connect(lw_broker_client *client, lw_i2c_bus *bus, const char *socket_path)
+{
+    if (!client || !bus || !socket_path)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_broker_client_reset(client);
+    struct sockaddr_un addr;
+    if (lw_broker_fill_addr(&addr, socket_path) != 0)
+    {
+        return -1;
+    }
+
+    client->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->sock < 0 ||
+        connect(client->sock, (const struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        goto fail;
+    }
+
+    lw_broker_hello hello;
+    int fds[3] = {-1, -1, -1};
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = {&hello, sizeof(hello)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n;
+    do
+    {
+        n = recvmsg(client->sock, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+    {
+        goto fail;
+    }
+
+    size_t nfds = 0;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+    {
+        nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(cmsg), (nfds < 3 ? nfds : 3) * sizeof(int));
+    }
+    client->req_fd = fds[1];
+    client->resp_fd = fds[2];
+
+    int err = 0;
+    if (n != (ssize_t)sizeof(hello) || hello.magic != LW_BROKER_MAGIC ||
+        hello.version != LW_BROKER_VERSION)
+    {
+        err = EPROTO;
+    }
+    else if (hello.err != 0)
+    {
+        err = hello.err;
+    }
+    else if (nfds != 3 || hello.ring_size != sizeof(lw_broker_ring))
+    {
+        err = EPROTO;
+    }
+
+    if (!err)
+    {
+        void *map = mmap(NULL, sizeof(lw_broker_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        if (map == MAP_FAILED)
+        {
+            err = errno;
+        }
+        else
+        {
+            client->ring = map;
+            const lw_broker_ring *ring = (const lw_broker_ring *)map;
+            if (ring->magic != LW_BROKER_MAGIC || ring->slot_size != sizeof(lw_broker_slot))
+            {
+                err = EPROTO;
+            }
+            client->head = ring->head;
+        }
+    }
+    lw_broker_close_fd(&fds[0]);
+    if (err)
+    {
+        errno = err;
+        goto fail;
+    }
+
+    hello.device_path[sizeof(hello.device_path) - 1] = '\0';
+    lw_open_backend(bus, hello.device_path, lw_broker_client_transfer, client);
+    bus->caps = hello.caps;
+    client->bus = bus;
+    return 0;
+
+fail:
+    {
+        const int saved_errno = errno;
+        lw_broker_disconnect(client);
+        errno = saved_errno;
+        return -1;
+    }
+}
+
+int lw_broker_begin(lw_broker_client *client)
+{
+    if (!client || !client->ring)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    client->holding = 1;
+    return 0;
+}
+
+int lw_broker_end(lw_broker_client *client)
+{
+    if (!client || !client->ring)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!client->holding)
+    {
+        return 0;
+    }
+    client->holding = 0;
+    return lw_broker_submit(client, NULL, 0, 0) < 0 ? -1 : 0;
+}
+
+void lw_broker_disconnect(lw_broker_client *client)
+{
+    if (!client)
+    {
+        return;
+    }
+    if (client->bus && client->bus->backend_arg == client)
+    {
+        lw_close_bus(client->bus);
+    }
+    if (client->ring)
+    {
+        munmap(client->ring, sizeof(lw_broker_ring));
+    }
+    lw_broker_close_fd(&client->sock);
+    lw_broker_close_fd(&client->req_fd);
+    lw_broker_close_fd(&client->resp_fd);
+    lw_broker_client_reset(client);
+}
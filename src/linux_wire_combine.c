@@ -0,0 +1,373 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_combine.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/* Every run plus a register write and a read must fit one lw_transfer() */
+_Static_assert(LINUX_WIRE_COMBINE_MAX_RUNS + 2 <= LW_MAX_MSGS, "LINUX_WIRE_COMBINE_MAX_RUNS");
+_Static_assert(LINUX_WIRE_COMBINE_RUN_MAX <= UINT16_MAX - 4, "LINUX_WIRE_COMBINE_RUN_MAX");
+
+static void lw_combine_put_reg(uint8_t *dst, uint32_t reg, uint8_t reg_len)
+{
+    for (uint8_t i = 0; i < reg_len; ++i)
+    {
+        dst[i] = (uint8_t)(reg >> (8u * (reg_len - 1u - i)));
+    }
+}
+
+static uint32_t lw_combine_get_reg(const uint8_t *src, uint8_t reg_len)
+{
+    uint32_t reg = 0;
+    for (uint8_t i = 0; i < reg_len; ++i)
+    {
+        reg = (reg << 8) | src[i];
+    }
+    return reg;
+}
+
+static const lw_combine_device *lw_combine_find(const lw_combiner *comb, uint16_t addr)
+{
+    for (size_t i = 0; i < comb->device_count; ++i)
+    {
+        if (comb->devices[i].addr == addr)
+        {
+            return &comb->devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void lw_combine_clear(lw_combiner *comb)
+{
+    comb->run_count = 0;
+    comb->deadline_us = 0;
+}
+
+/* Write message for one run: register bytes followed by the data */
+static lw_msg lw_combine_msg(lw_combine_run *run)
+{
+    lw_msg msg;
+    msg.addr = run->addr;
+    msg.flags = 0;
+    msg.len = (uint16_t)(run->reg_len + run->len);
+    msg.buf = run->buf + 4 - run->reg_len;
+    return msg;
+}
+
+static size_t lw_combine_fill(lw_combiner *comb, lw_msg *msgs)
+{
+    for (size_t i = 0; i < comb->run_count; ++i)
+    {
+        msgs[i] = lw_combine_msg(&comb->runs[i]);
+    }
+    return comb->run_count;
+}
+
+/* Flush, then send one write as its own transaction, ending in a STOP */
+static int lw_combine_send(lw_i2c_bus *bus,
+                           lw_combiner *comb,
+                           uint16_t addr,
+                           const uint8_t *iaddr,
+                           size_t iaddr_len,
+                           const uint8_t *data,
+                           size_t len)
+{
+    if (lw_combine_flush(bus, comb) != 0)
+    {
+        return -1;
+    }
+    ++comb->transactions;
+    if (lw_ioctl_write(bus, addr, iaddr, iaddr_len, data, len, 0) < 0)
+    {
+        return -1;
+    }
+    ++comb->writes;
+    return 0;
+}
+
+static int lw_combine_due(const lw_combiner *comb)
+{
+    return comb->run_count > 0 && comb->depth == 0 && comb->window_us > 0 &&
+           lw_monotonic_us() >= comb->deadline_us;
+}
+
+/*
+ * Append to the tail run when it continues it, otherwise start a new run.
+ * `reg_len` 0 buffers `data` as a raw message. The caller has checked that
+ * `len` fits LINUX_WIRE_COMBINE_RUN_MAX.
+ */
+static int lw_combine_buffer(lw_i2c_bus *bus,
+                             lw_combiner *comb,
+                             uint16_t addr,
+                             const lw_combine_device *dev,
+                             uint32_t reg,
+                             const uint8_t *data,
+                             size_t len)
+{
+    if (dev && comb->run_count > 0)
+    {
+        lw_combine_run *tail = &comb->runs[comb->run_count - 1];
+        if (tail->addr == addr && tail->reg_len == dev->reg_len &&
+            (reg & ~dev->autoinc) == tail->reg + tail->len &&
+            tail->len + len <= LINUX_WIRE_COMBINE_RUN_MAX)
+        {
+            memcpy(tail->buf + 4 + tail->len, data, len);
+            tail->len = (uint16_t)(tail->len + len);
+            lw_combine_put_reg(tail->buf + 4 - tail->reg_len, tail->reg | tail->autoinc, tail->reg_len);
+            ++comb->merged;
+            ++comb->writes;
+            return 0;
+        }
+    }
+
+    if (comb->run_count == LINUX_WIRE_COMBINE_MAX_RUNS && lw_combine_flush(bus, comb) != 0)
+    {
+        return -1;
+    }
+
+    lw_combine_run *run = &comb->runs[comb->run_count];
+    run->addr = addr;
+    run->reg_len = dev ? dev->reg_len : 0;
+    run->autoinc = dev ? dev->autoinc : 0;
+    run->reg = dev ? (reg & ~dev->autoinc) : 0;
+    run->len = (uint16_t)len;
+    if (dev)
+    {
+        /* A single write keeps its register address exactly as given */
+        lw_combine_put_reg(run->buf + 4 - run->reg_len, reg, run->reg_len);
+    }
+    memcpy(run->buf + 4, data, len);
+
+    if (comb->run_count++ == 0 && comb->window_us > 0)
+    {
+        comb->deadline_us = lw_monotonic_us() + comb->window_us;
+    }
+    ++comb->writes;
+    return 0;
+}
+
+int lw_combine_init(lw_combiner *comb, uint32_t window_us)
+{
+    if (!comb)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(comb, 0, sizeof(*comb));
+    comb->window_us = window_us;
+    return 0;
+}
+
+int lw_combine_add_device(lw_combiner *comb, uint16_t addr, uint8_t reg_len, uint32_t autoinc)
+{
+    if (!comb || reg_len < 1 || reg_len > 4 ||
+        (reg_len < 4 && (autoinc >> (8u * reg_len)) != 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_combine_device *dev = (lw_combine_device *)lw_combine_find(comb, addr);
+    if (!dev)
+    {
+        if (comb->device_count == LINUX_WIRE_COMBINE_MAX_DEVICES)
+        {
+            errno = ENOSPC;
+            return -1;
+        }
+        dev = &comb->devices[comb->device_count++];
+    }
+    dev->addr = addr;
+    dev->reg_len = reg_len;
+    dev->autoinc = autoinc;
+    return 0;
+}
+
+int lw_combine_write(lw_i2c_bus *bus,
+                     lw_combiner *comb,
+                     uint16_t addr,
+                     uint32_t reg,
+                     uint8_t reg_len,
+                     const uint8_t *data,
+                     size_t len)
+{
+    if (!bus || !comb || !data || len == 0 || reg_len < 1 || reg_len > 4)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_combine_due(comb) && lw_combine_flush(bus, comb) != 0)
+    {
+        return -1;
+    }
+
+    /* An undeclared device may act on STOP (EEPROM page write, mux
+       channel select), so its writes never join a combined transaction */
+    const lw_combine_device *dev = lw_combine_find(comb, addr);
+    if (!dev || len > LINUX_WIRE_COMBINE_RUN_MAX)
+    {
+        uint8_t iaddr[4];
+        lw_combine_put_reg(iaddr, reg, reg_len);
+        return lw_combine_send(bus, comb, addr, iaddr, reg_len, data, len);
+    }
+
+    /* Only writes using the declared register size may be merged */
+    if (dev->reg_len == reg_len)
+    {
+        return lw_combine_buffer(bus, comb, addr, dev, reg, data, len);
+    }
+
+    uint8_t raw[4 + LINUX_WIRE_COMBINE_RUN_MAX];
+    lw_combine_put_reg(raw, reg, reg_len);
+    memcpy(raw + reg_len, data, len);
+    if (reg_len + len > LINUX_WIRE_COMBINE_RUN_MAX)
+    {
+        return lw_combine_send(bus, comb, addr, NULL, 0, raw, reg_len + len);
+    }
+    return lw_combine_buffer(bus, comb, addr, NULL, 0, raw, reg_len + len);
+}
+
+int lw_combine_write_msg(lw_i2c_bus *bus,
+                         lw_combiner *comb,
+                         uint16_t addr,
+                         const uint8_t *data,
+                         size_t len)
+{
+    if (!bus || !comb || !data || len == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* A bare register pointer update carries no data and is never merged */
+    const lw_combine_device *dev = lw_combine_find(comb, addr);
+    if (dev && len > dev->reg_len)
+    {
+        return lw_combine_write(bus,
+                                comb,
+                                addr,
+                                lw_combine_get_reg(data, dev->reg_len),
+                                dev->reg_len,
+                                data + dev->reg_len,
+                                len - dev->reg_len);
+    }
+
+    if (lw_combine_due(comb) && lw_combine_flush(bus, comb) != 0)
+    {
+        return -1;
+    }
+
+    if (!dev || len > LINUX_WIRE_COMBINE_RUN_MAX)
+    {
+        return lw_combine_send(bus, comb, addr, NULL, 0, data, len);
+    }
+    return lw_combine_buffer(bus, comb, addr, NULL, 0, data, len);
+}
+
+ssize_t lw_combine_read(lw_i2c_bus *bus,
+                        lw_combiner *comb,
+                        uint16_t addr,
+                        uint32_t reg,
+                        uint8_t reg_len,
+                        uint8_t *dst,
+                        size_t len)
+{
+    if (!bus || !comb || !dst || len == 0 || len > UINT16_MAX || reg_len > 4)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_msg msgs[LINUX_WIRE_COMBINE_MAX_RUNS + 2];
+    uint8_t iaddr[4];
+    size_t count = lw_combine_fill(comb, msgs);
+    if (reg_len > 0)
+    {
+        lw_combine_put_reg(iaddr, reg, reg_len);
+        msgs[count].addr = addr;
+        msgs[count].flags = 0;
+        msgs[count].len = reg_len;
+        msgs[count].buf = iaddr;
+        ++count;
+    }
+    msgs[count].addr = addr;
+    msgs[count].flags = LW_MSG_RD;
+    msgs[count].len = (uint16_t)len;
+    msgs[count].buf = dst;
+    ++count;
+
+    ++comb->transactions;
+    const int rc = lw_transfer(bus, msgs, count);
+    lw_combine_clear(comb);
+    return rc < 0 ? -1 : (ssize_t)len;
+}
+
+int lw_combine_begin(lw_combiner *comb)
+{
+    if (!comb)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ++comb->depth;
+    return 0;
+}
+
+int lw_combine_commit(lw_i2c_bus *bus, lw_combiner *comb)
+{
+    if (!comb || comb->depth == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (--comb->depth > 0)
+    {
+        return 0;
+    }
+    return lw_combine_flush(bus, comb);
+}
+
+int lw_combine_flush(lw_i2c_bus *bus, lw_combiner *comb)
+{
+    if (!bus || !comb)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (comb->run_count == 0)
+    {
+        return 0;
+    }
+
+    lw_msg msgs[LINUX_WIRE_COMBINE_MAX_RUNS];
+    const size_t count = lw_combine_fill(comb, msgs);
+    ++comb->transactions;
+    const int rc = lw_transfer(bus, msgs, count);
+    lw_combine_clear(comb);
+    return rc < 0 ? -1 : 0;
+}
+
+int lw_combine_poll(lw_i2c_bus *bus, lw_combiner *comb)
+{
+    if (!bus || !comb)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return lw_combine_due(comb) ? lw_combine_flush(bus, comb) : 0;
+}
+
+size_t lw_combine_pending(const lw_combiner *comb)
+{
+    return comb ? comb->run_count : 0;
+}
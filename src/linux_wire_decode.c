@@ -0,0 +1,257 @@
+#include "linux_wire_decode.h"
+
+#include <errno.h>
+
+/* Vector paths assume a little-endian host, which covers every x86 and
+   AArch64/ARMv7 Linux target this library runs on. Define
+   LINUX_WIRE_DECODE_NO_SIMD to force the scalar code. */
+#if !defined(LINUX_WIRE_DECODE_NO_SIMD) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LW_DECODE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LW_DECODE_NEON 1
+#endif
+#endif
+
+static int16_t lw_load_i16(const uint8_t *p, lw_endian endian)
+{
+    uint16_t v = (endian == LW_BIG_ENDIAN)
+                     ? (uint16_t)(((uint16_t)p[0] << 8) | p[1])
+                     : (uint16_t)(((uint16_t)p[1] << 8) | p[0]);
+    return (int16_t)v;
+}
+
+static uint32_t lw_load_raw(const uint8_t *p, uint8_t width, lw_endian endian)
+{
+    uint32_t v = 0;
+    if (endian == LW_BIG_ENDIAN)
+    {
+        for (uint8_t i = 0; i < width; ++i)
+        {
+            v = (v << 8) | p[i];
+        }
+    }
+    else
+    {
+        for (uint8_t i = width; i > 0; --i)
+        {
+            v = (v << 8) | p[i - 1];
+        }
+    }
+    return v;
+}
+
+static unsigned lw_format_bits(const lw_sample_format *fmt)
+{
+    return fmt->bits ? fmt->bits : (unsigned)(fmt->width * 8U - fmt->shift);
+}
+
+static int lw_format_valid(const lw_sample_format *fmt)
+{
+    if (!fmt || fmt->width < 1 || fmt->width > 4)
+    {
+        return 0;
+    }
+    const unsigned total = fmt->width * 8U;
+    return fmt->shift < total && lw_format_bits(fmt) >= 1 &&
+           lw_format_bits(fmt) + fmt->shift <= total;
+}
+
+/* Shift, mask and (optionally) sign-extend one raw sample. */
+static uint32_t lw_extract(const lw_sample_format *fmt, uint32_t raw)
+{
+    const unsigned bits = lw_format_bits(fmt);
+    raw >>= fmt->shift;
+    if (bits < 32)
+    {
+        const uint32_t mask = (1UL << bits) - 1U;
+        raw &= mask;
+        if (fmt->is_signed && (raw & (1UL << (bits - 1))))
+        {
+            raw |= ~mask;
+        }
+    }
+    return raw;
+}
+
+int lw_decode_i16(const uint8_t *src, size_t count, lw_endian endian, int16_t *dst)
+{
+    if ((!src || !dst) && count > 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t i = 0;
+
+#if defined(LW_DECODE_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + 2 * i));
+        if (endian == LW_BIG_ENDIAN)
+        {
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        }
+        _mm_storeu_si128((__m128i *)(void *)(dst + i), v);
+    }
+#elif defined(LW_DECODE_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x16_t b = vld1q_u8(src + 2 * i);
+        if (endian == LW_BIG_ENDIAN)
+        {
+            b = vrev16q_u8(b);
+        }
+        vst1q_s16(dst + i, vreinterpretq_s16_u8(b));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dst[i] = lw_load_i16(src + 2 * i, endian);
+    }
+    return 0;
+}
+
+int lw_decode_i16_to_float(const uint8_t *src,
+                           size_t count,
+                           lw_endian endian,
+                           float scale,
+                           float *dst)
+{
+    if ((!src || !dst) && count > 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t i = 0;
+
+#if defined(LW_DECODE_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + 2 * i));
+        if (endian == LW_BIG_ENDIAN)
+        {
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        }
+        /* Duplicate each word into a 32-bit lane, then arithmetic-shift
+           down to sign-extend (SSE2 has no pmovsxwd). */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#elif defined(LW_DECODE_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x16_t b = vld1q_u8(src + 2 * i);
+        if (endian == LW_BIG_ENDIAN)
+        {
+            b = vrev16q_u8(b);
+        }
+        int16x8_t v = vreinterpretq_s16_u8(b);
+        int32x4_t lo = vmovl_s16(vget_low_s16(v));
+        int32x4_t hi = vmovl_s16(vget_high_s16(v));
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(lo), scale));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(hi), scale));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dst[i] = (float)lw_load_i16(src + 2 * i, endian) * scale;
+    }
+    return 0;
+}
+
+int lw_decode_samples(const lw_sample_format *fmt,
+                      const uint8_t *src,
+                      size_t count,
+                      int32_t *dst)
+{
+    if (!lw_format_valid(fmt) || ((!src || !dst) && count > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t raw = lw_load_raw(src + i * fmt->width, fmt->width, fmt->endian);
+        dst[i] = (int32_t)lw_extract(fmt, raw);
+    }
+    return 0;
+}
+
+static int lw_is_plain_i16(const lw_sample_format *fmt)
+{
+    return fmt->width == 2 && fmt->shift == 0 && fmt->is_signed &&
+           lw_format_bits(fmt) == 16;
+}
+
+int lw_decode_samples_float(const lw_sample_format *fmt,
+                            const uint8_t *src,
+                            size_t count,
+                            float *dst)
+{
+    if (!lw_format_valid(fmt) || ((!src || !dst) && count > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_is_plain_i16(fmt))
+    {
+        lw_decode_i16_to_float(src, count, fmt->endian, fmt->scale, dst);
+        if (fmt->offset != 0.0f)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                dst[i] += fmt->offset;
+            }
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t raw = lw_load_raw(src + i * fmt->width, fmt->width, fmt->endian);
+        const uint32_t v = lw_extract(fmt, raw);
+        const float f = fmt->is_signed ? (float)(int32_t)v : (float)v;
+        dst[i] = f * fmt->scale + fmt->offset;
+    }
+    return 0;
+}
+
+int lw_decode_frames_float(const lw_sample_format *fmt,
+                           const uint8_t *src,
+                           size_t frames,
+                           size_t stride,
+                           size_t channels,
+                           float *dst)
+{
+    if (!lw_format_valid(fmt) || channels == 0 ||
+        stride < channels * fmt->width ||
+        ((!src || !dst) && frames > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Tightly packed frames are just one long sample run */
+    if (stride == channels * fmt->width)
+    {
+        return lw_decode_samples_float(fmt, src, frames * channels, dst);
+    }
+
+    for (size_t f = 0; f < frames; ++f)
+    {
+        lw_decode_samples_float(fmt, src + f * stride, channels, dst + f * channels);
+    }
+    return 0;
+}
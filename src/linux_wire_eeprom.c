@@ -0,0 +1,301 @@
+#include "linux_wire_eeprom.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Default largest single read, matching the core's ioctl payload limit */
+#define LW_EEPROM_DEFAULT_MAX_TRANSFER 4096
+
+static int lw_eeprom_valid(const lw_eeprom *dev)
+{
+    return dev &&
+           (dev->addr_width == 1 || dev->addr_width == 2 || dev->addr_width == 4) &&
+           dev->page_size > 0 && dev->page_size <= LINUX_WIRE_EEPROM_PAGE_MAX &&
+           dev->max_transfer > 0 &&
+           dev->addr_spill_bits <= 3 &&
+           (dev->addr_width < 4 || dev->addr_spill_bits == 0);
+}
+
+static int lw_eeprom_range_ok(const lw_eeprom *dev, uint32_t mem_addr, size_t len)
+{
+    if (dev->capacity == 0)
+    {
+        return 1;
+    }
+    return mem_addr <= dev->capacity && len <= (size_t)(dev->capacity - mem_addr);
+}
+
+/* Device address for `mem_addr`, including block-select spill bits. */
+static uint16_t lw_eeprom_device_addr(const lw_eeprom *dev, uint32_t mem_addr)
+{
+    if (dev->addr_spill_bits == 0)
+    {
+        return dev->addr;
+    }
+    uint32_t block = mem_addr >> (8U * dev->addr_width);
+    return (uint16_t)(dev->addr | (block & ((1U << dev->addr_spill_bits) - 1U)));
+}
+
+static void lw_eeprom_encode_addr(const lw_eeprom *dev, uint32_t mem_addr, uint8_t *out)
+{
+    for (uint8_t i = 0; i < dev->addr_width; ++i)
+    {
+        const unsigned shift = (unsigned)(dev->addr_width - 1U - i) * 8U;
+        out[i] = (uint8_t)((mem_addr >> shift) & 0xFF);
+    }
+}
+
+/* Bytes from `mem_addr` to the next internal-address wrap (0 = no limit). */
+static size_t lw_eeprom_block_remaining(const lw_eeprom *dev, uint32_t mem_addr)
+{
+    if (dev->addr_width >= 4)
+    {
+        return 0;
+    }
+    uint32_t block_size = 1U << (8U * dev->addr_width);
+    return block_size - (mem_addr & (block_size - 1U));
+}
+
+int lw_eeprom_init(lw_eeprom *dev,
+                   uint16_t addr,
+                   uint8_t addr_width,
+                   uint16_t page_size,
+                   uint32_t capacity)
+{
+    if (!dev)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(dev, 0, sizeof(*dev));
+    dev->addr = addr;
+    dev->addr_width = addr_width;
+    dev->page_size = page_size;
+    dev->capacity = capacity;
+    dev->max_transfer = LW_EEPROM_DEFAULT_MAX_TRANSFER;
+    dev->write_cycle_us = LINUX_WIRE_EEPROM_WRITE_CYCLE_US;
+    dev->poll_interval_us = LINUX_WIRE_EEPROM_POLL_INTERVAL_US;
+
+    if (!lw_eeprom_valid(dev))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int lw_eeprom_wait_ready(lw_i2c_bus *bus, const lw_eeprom *dev)
+{
+    if (!bus || !lw_eeprom_valid(dev))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return lw_wait_ready(bus, dev->addr, dev->write_cycle_us, dev->poll_interval_us, 0);
+}
+
+ssize_t lw_eeprom_read(lw_i2c_bus *bus,
+                       const lw_eeprom *dev,
+                       uint32_t mem_addr,
+                       uint8_t *data,
+                       size_t len)
+{
+    if (!bus || !lw_eeprom_valid(dev) || !data || len == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!lw_eeprom_range_ok(dev, mem_addr, len))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < len)
+    {
+        const uint32_t cur = mem_addr + (uint32_t)done;
+        size_t chunk = len - done;
+        if (chunk > dev->max_transfer)
+        {
+            chunk = dev->max_transfer;
+        }
+        const size_t block_left = lw_eeprom_block_remaining(dev, cur);
+        if (block_left != 0 && chunk > block_left)
+        {
+            chunk = block_left;
+        }
+
+        uint8_t iaddr[4];
+        lw_eeprom_encode_addr(dev, cur, iaddr);
+
+        ssize_t r = lw_ioctl_read(bus, lw_eeprom_device_addr(dev, cur),
+                                  iaddr, dev->addr_width, data + done, chunk, 0);
+        if (r < 0)
+        {
+            return -1;
+        }
+        if ((size_t)r != chunk)
+        {
+            errno = EIO;
+            return -1;
+        }
+        done += chunk;
+    }
+
+    return (ssize_t)done;
+}
+
+int lw_eeprom_stream_begin(lw_eeprom_stream *stream,
+                           lw_i2c_bus *bus,
+                           const lw_eeprom *dev,
+                           uint32_t mem_addr)
+{
+    if (!stream || !bus || !lw_eeprom_valid(dev))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    stream->bus = bus;
+    stream->dev = dev;
+    stream->frame_addr = mem_addr;
+    stream->frame_fill = 0;
+    stream->written = 0;
+    stream->cycle_pending = 0;
+    return 0;
+}
+
+/* Send the current frame, first ACK-polling any write cycle still running. */
+static int lw_eeprom_stream_flush(lw_eeprom_stream *stream)
+{
+    const lw_eeprom *dev = stream->dev;
+
+    if (stream->frame_fill == 0)
+    {
+        return 0;
+    }
+
+    if (stream->cycle_pending && lw_eeprom_wait_ready(stream->bus, dev) != 0)
+    {
+        return -1;
+    }
+
+    lw_eeprom_encode_addr(dev, stream->frame_addr, stream->frame);
+
+    ssize_t w = lw_ioctl_write(stream->bus,
+                               lw_eeprom_device_addr(dev, stream->frame_addr),
+                               stream->frame, dev->addr_width,
+                               stream->frame + dev->addr_width, stream->frame_fill, 0);
+    if (w < 0)
+    {
+        return -1;
+    }
+    if ((size_t)w != stream->frame_fill)
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    stream->cycle_pending = 1;
+    stream->written += stream->frame_fill;
+    stream->frame_addr += (uint32_t)stream->frame_fill;
+    stream->frame_fill = 0;
+    return 0;
+}
+
+ssize_t lw_eeprom_stream_write(lw_eeprom_stream *stream,
+                               const uint8_t *data,
+                               size_t len)
+{
+    if (!stream || !stream->dev || (!data && len > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const lw_eeprom *dev = stream->dev;
+    const uint32_t end_addr = stream->frame_addr + (uint32_t)stream->frame_fill;
+    if (!lw_eeprom_range_ok(dev, end_addr, len))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t consumed = 0;
+    while (consumed < len)
+    {
+        const uint32_t page_off = (stream->frame_addr + (uint32_t)stream->frame_fill) % dev->page_size;
+        size_t room = dev->page_size - page_off;
+        size_t take = len - consumed;
+        if (take > room)
+        {
+            take = room;
+        }
+
+        /* Stage the payload before polling so the next page is ready the
+           moment the device finishes its current write cycle. */
+        memcpy(stream->frame + dev->addr_width + stream->frame_fill, data + consumed, take);
+        stream->frame_fill += take;
+        consumed += take;
+
+        if (take == room && lw_eeprom_stream_flush(stream) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return (ssize_t)consumed;
+}
+
+ssize_t lw_eeprom_stream_finish(lw_eeprom_stream *stream)
+{
+    if (!stream || !stream->dev)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_eeprom_stream_flush(stream) != 0)
+    {
+        return -1;
+    }
+
+    if (stream->cycle_pending)
+    {
+        if (lw_eeprom_wait_ready(stream->bus, stream->dev) != 0)
+        {
+            return -1;
+        }
+        stream->cycle_pending = 0;
+    }
+
+    return (ssize_t)stream->written;
+}
+
+ssize_t lw_eeprom_write(lw_i2c_bus *bus,
+                        const lw_eeprom *dev,
+                        uint32_t mem_addr,
+                        const uint8_t *data,
+                        size_t len)
+{
+    if (!data || len == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_eeprom_stream stream;
+    if (lw_eeprom_stream_begin(&stream, bus, dev, mem_addr) != 0)
+    {
+        return -1;
+    }
+    if (lw_eeprom_stream_write(&stream, data, len) < 0)
+    {
+        return -1;
+    }
+    return lw_eeprom_stream_finish(&stream);
+}
@@ -0,0 +1,407 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_fault.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+/* splitmix64: any seed, including 0, gives a full-period sequence */
+static uint64_t lw_fault_next(lw_fault *fault)
+{
+    uint64_t z = (fault->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint32_t lw_fault_draw_ppm(lw_fault *fault)
+{
+    return (uint32_t)(lw_fault_next(fault) % LW_FAULT_PPM);
+}
+
+static uint64_t lw_fault_draw_delay_ns(lw_fault *fault, const lw_fault_rule *rule)
+{
+    uint64_t us = rule->delay_min_us;
+    switch (rule->delay_kind)
+    {
+    case LW_FAULT_DELAY_UNIFORM:
+        us += lw_fault_next(fault) % ((uint64_t)rule->delay_max_us - rule->delay_min_us + 1u);
+        break;
+    case LW_FAULT_DELAY_EXPONENTIAL:
+    {
+        /* 53 random bits in (0, 1] so the logarithm stays finite */
+        const double u = (double)((lw_fault_next(fault) >> 11) + 1u) / 9007199254740992.0;
+        us += (uint64_t)(-log(u) * rule->delay_max_us);
+        break;
+    }
+    default:
+        break;
+    }
+    return us * 1000ULL;
+}
+
+/* The rule for `addr` itself wins over an LW_FAULT_ANY rule, whatever the order */
+static const lw_fault_rule *lw_fault_find(const lw_fault *fault, uint16_t addr)
+{
+    const lw_fault_rule *any = NULL;
+    for (size_t i = 0; i < fault->rule_count; ++i)
+    {
+        if (fault->rules[i].addr == addr)
+        {
+            return &fault->rules[i];
+        }
+        if (fault->rules[i].addr == LW_FAULT_ANY)
+        {
+            any = &fault->rules[i];
+        }
+    }
+    return any;
+}
+
+static void lw_fault_record(lw_fault *fault, lw_fault_class cls, uint64_t ns)
+{
+    lw_fault_class_stats *s = &fault->stats[cls];
+    ++s->count;
+    s->total_ns += ns;
+    if (ns > s->max_ns)
+    {
+        s->max_ns = ns;
+    }
+
+    uint64_t us = ns / 1000ULL;
+    unsigned int bucket = 0;
+    while (us > 0 && bucket < LINUX_WIRE_FAULT_BUCKETS - 1)
+    {
+        us >>= 1;
+        ++bucket;
+    }
+    ++s->buckets[bucket];
+}
+
+/* Draws the fate of one transaction. Called with the lock held. */
+static lw_fault_class lw_fault_decide(lw_fault *fault,
+                                      const lw_msg *msgs,
+                                      size_t count,
+                                      uint64_t now_ns,
+                                      uint64_t *delay_ns)
+{
+    if (now_ns < fault->stuck_until_ns)
+    {
+        return LW_FAULT_STUCK;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const lw_fault_rule *rule = lw_fault_find(fault, msgs[i].addr);
+        if (!rule)
+        {
+            continue;
+        }
+
+        if (rule->delay_ppm > 0 && lw_fault_draw_ppm(fault) < rule->delay_ppm)
+        {
+            *delay_ns += lw_fault_draw_delay_ns(fault, rule);
+        }
+
+        /* One draw picks at most one error: the chances are stacked */
+        const uint32_t r = lw_fault_draw_ppm(fault);
+        uint32_t edge = rule->nack_ppm;
+        if (r < edge)
+        {
+            return LW_FAULT_NACK;
+        }
+        edge += rule->eio_ppm;
+        if (r < edge)
+        {
+            return LW_FAULT_EIO;
+        }
+        edge += rule->timeout_ppm;
+        if (r < edge)
+        {
+            return LW_FAULT_TIMEOUT;
+        }
+        edge += rule->arbitration_ppm;
+        if (r < edge)
+        {
+            return LW_FAULT_ARBITRATION;
+        }
+        edge += rule->stuck_ppm;
+        if (r < edge)
+        {
+            fault->stuck_until_ns = now_ns + (uint64_t)rule->stuck_us * 1000ULL;
+            return LW_FAULT_STUCK;
+        }
+    }
+    return *delay_ns > 0 ? LW_FAULT_DELAY : LW_FAULT_CLEAN;
+}
+
+static int lw_fault_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    static const int errnos[LW_FAULT_CLASS_COUNT] = {
+        [LW_FAULT_NACK] = ENXIO,
+        [LW_FAULT_EIO] = EIO,
+        [LW_FAULT_TIMEOUT] = ETIMEDOUT,
+        [LW_FAULT_ARBITRATION] = EAGAIN,
+        [LW_FAULT_STUCK] = EBUSY,
+    };
+    lw_fault *fault = (lw_fault *)arg;
+    const uint64_t start_ns = lw_monotonic_ns();
+    uint64_t wait_ns = 0;
+    lw_fault_class cls = LW_FAULT_CLEAN;
+
+    pthread_mutex_lock(&fault->lock);
+    if (fault->enabled)
+    {
+        cls = lw_fault_decide(fault, msgs, count, start_ns, &wait_ns);
+    }
+    if (cls == LW_FAULT_TIMEOUT || cls == LW_FAULT_STUCK)
+    {
+        wait_ns += (uint64_t)fault->timeout_us * 1000ULL;
+    }
+    pthread_mutex_unlock(&fault->lock);
+
+    if (wait_ns > 0)
+    {
+        lw_sleep_until_ns(start_ns + wait_ns);
+    }
+
+    int rc = -1;
+    int err = errnos[cls];
+    if (err == 0)
+    {
+        rc = lw_transfer(fault->lower, msgs, count);
+        err = errno;
+    }
+
+    const uint64_t elapsed_ns = lw_monotonic_ns() - start_ns;
+    pthread_mutex_lock(&fault->lock);
+    lw_fault_record(fault, cls, elapsed_ns);
+    pthread_mutex_unlock(&fault->lock);
+
+    if (rc < 0)
+    {
+        errno = err;
+        return -1;
+    }
+    return rc;
+}
+
+int lw_fault_init(lw_fault *fault, lw_i2c_bus *lower, uint64_t seed)
+{
+    if (!fault || !lower)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(fault, 0, sizeof(*fault));
+    const int rc = pthread_mutex_init(&fault->lock, NULL);
+    if (rc != 0)
+    {
+        errno = rc;
+        return -1;
+    }
+    fault->lower = lower;
+    fault->rng = seed;
+    fault->enabled = 1;
+    return 0;
+}
+
+void lw_fault_destroy(lw_fault *fault)
+{
+    if (fault)
+    {
+        pthread_mutex_destroy(&fault->lock);
+    }
+}
+
+int lw_fault_open(lw_fault *fault, lw_i2c_bus *bus, const char *label)
+{
+    if (!fault || !bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_open_backend(bus, label ? label : fault->lower->device_path, lw_fault_transfer, fault) < 0)
+    {
+        return -1;
+    }
+    bus->caps = fault->lower->caps;
+    return 0;
+}
+
+int lw_fault_add_rule(lw_fault *fault, const lw_fault_rule *rule)
+{
+    if (!fault || !rule)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const uint64_t errors = (uint64_t)rule->nack_ppm + rule->eio_ppm + rule->timeout_ppm +
+                            rule->arbitration_ppm + rule->stuck_ppm;
+    if (errors > LW_FAULT_PPM || rule->delay_ppm > LW_FAULT_PPM ||
+        rule->delay_kind > LW_FAULT_DELAY_EXPONENTIAL ||
+        (rule->delay_kind == LW_FAULT_DELAY_UNIFORM && rule->delay_max_us < rule->delay_min_us))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&fault->lock);
+    size_t slot = 0;
+    while (slot < fault->rule_count && fault->rules[slot].addr != rule->addr)
+    {
+        ++slot;
+    }
+    if (slot == LINUX_WIRE_FAULT_MAX_RULES)
+    {
+        pthread_mutex_unlock(&fault->lock);
+        errno = ENOSPC;
+        return -1;
+    }
+    fault->rules[slot] = *rule;
+    if (slot == fault->rule_count)
+    {
+        ++fault->rule_count;
+    }
+    pthread_mutex_unlock(&fault->lock);
+    return 0;
+}
+
+void lw_fault_clear_rules(lw_fault *fault)
+{
+    if (!fault)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&fault->lock);
+    fault->rule_count = 0;
+    fault->stuck_until_ns = 0;
+    pthread_mutex_unlock(&fault->lock);
+}
+
+void lw_fault_stick(lw_fault *fault, uint32_t us)
+{
+    if (!fault)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&fault->lock);
+    fault->stuck_until_ns = us ? lw_monotonic_ns() + (uint64_t)us * 1000ULL : 0;
+    pthread_mutex_unlock(&fault->lock);
+}
+
+void lw_fault_reset_stats(lw_fault *fault)
+{
+    if (!fault)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&fault->lock);
+    memset(fault->stats, 0, sizeof(fault->stats));
+    pthread_mutex_unlock(&fault->lock);
+}
+
+static uint64_t lw_fault_percentile_us(const lw_fault_class_stats *s, double q)
+{
+    const uint64_t max_us = s->max_ns / 1000ULL;
+    uint64_t rank = (uint64_t)ceil(q * (double)s->count);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < LINUX_WIRE_FAULT_BUCKETS; ++i)
+    {
+        seen += s->buckets[i];
+        if (seen >= rank)
+        {
+            const uint64_t bound = 1ULL << i;
+            return bound < max_us ? bound : max_us;
+        }
+    }
+    return max_us;
+}
+
+int lw_fault_summary(lw_fault *fault, lw_fault_class cls, lw_fault_cost *out)
+{
+    if (!fault || !out || (unsigned int)cls >= LW_FAULT_CLASS_COUNT)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&fault->lock);
+    uint64_t all_count = 0;
+    uint64_t all_ns = 0;
+    for (unsigned int i = 0; i < LW_FAULT_CLASS_COUNT; ++i)
+    {
+        all_count += fault->stats[i].count;
+        all_ns += fault->stats[i].total_ns;
+    }
+
+    const lw_fault_class_stats *s = &fault->stats[cls];
+    out->count = s->count;
+    if (s->count > 0)
+    {
+        out->share = (double)s->count / (double)all_count;
+        out->time_share = all_ns ? (double)s->total_ns / (double)all_ns : 0.0;
+        out->mean_us = (double)s->total_ns / (double)s->count / 1000.0;
+        out->p50_us = lw_fault_percentile_us(s, 0.50);
+        out->p99_us = lw_fault_percentile_us(s, 0.99);
+        out->p999_us = lw_fault_percentile_us(s, 0.999);
+        out->max_us = s->max_ns / 1000ULL;
+    }
+    pthread_mutex_unlock(&fault->lock);
+    return 0;
+}
+
+const char *lw_fault_class_name(lw_fault_class cls)
+{
+    static const char *const names[LW_FAULT_CLASS_COUNT] = {
+        "clean", "delay", "nack", "eio", "timeout", "arbitration", "stuck",
+    };
+    return (unsigned int)cls < LW_FAULT_CLASS_COUNT ? names[cls] : NULL;
+}
+
+int lw_fault_write_report(lw_fault *fault, FILE *out)
+{
+    if (!fault || !out)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int rc = fprintf(out, "%-12s %10s %7s %7s %10s %8s %8s %8s %8s\n",
+                     "class", "count", "share", "time", "mean_us", "p50_us", "p99_us", "p999_us", "max_us") < 0;
+    for (unsigned int i = 0; i < LW_FAULT_CLASS_COUNT; ++i)
+    {
+        lw_fault_cost c;
+        lw_fault_summary(fault, (lw_fault_class)i, &c);
+        if (c.count == 0)
+        {
+            continue;
+        }
+        rc |= fprintf(out, "%-12s %10llu %6.2f%% %6.2f%% %10.1f %8llu %8llu %8llu %8llu\n",
+                      lw_fault_class_name((lw_fault_class)i),
+                      (unsigned long long)c.count,
+                      c.share * 100.0,
+                      c.time_share * 100.0,
+                      c.mean_us,
+                      (unsigned long long)c.p50_us,
+                      (unsigned long long)c.p99_us,
+                      (unsigned long long)c.p999_us,
+                      (unsigned long long)c.max_us) < 0;
+    }
+    return rc ? -1 : 0;
+}
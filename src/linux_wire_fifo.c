@@ -0,0 +1,240 @@
+#include "linux_wire_fifo.h"
+
+#include <errno.h>
+#include <string.h>
+
+int lw_fifo_ring_init(lw_fifo_ring *ring, uint8_t *storage, size_t size)
+{
+    if (!ring || !storage || size == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ring->buf = storage;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    return 0;
+}
+
+size_t lw_fifo_ring_used(const lw_fifo_ring *ring)
+{
+    return ring ? ring->head - ring->tail : 0;
+}
+
+const uint8_t *lw_fifo_ring_peek(const lw_fifo_ring *ring, size_t *len)
+{
+    const size_t used = lw_fifo_ring_used(ring);
+    if (used == 0)
+    {
+        if (len)
+        {
+            *len = 0;
+        }
+        return NULL;
+    }
+
+    const size_t idx = ring->tail % ring->size;
+    const size_t contig = ring->size - idx;
+    if (len)
+    {
+        *len = (used < contig) ? used : contig;
+    }
+    return ring->buf + idx;
+}
+
+void lw_fifo_ring_consume(lw_fifo_ring *ring, size_t len)
+{
+    const size_t used = lw_fifo_ring_used(ring);
+    if (ring)
+    {
+        ring->tail += (len < used) ? len : used;
+    }
+}
+
+size_t lw_fifo_ring_pop(lw_fifo_ring *ring, uint8_t *dst, size_t len)
+{
+    size_t copied = 0;
+    while (copied < len)
+    {
+        size_t avail = 0;
+        const uint8_t *src = lw_fifo_ring_peek(ring, &avail);
+        if (!src)
+        {
+            break;
+        }
+        if (avail > len - copied)
+        {
+            avail = len - copied;
+        }
+        memcpy(dst + copied, src, avail);
+        lw_fifo_ring_consume(ring, avail);
+        copied += avail;
+    }
+    return copied;
+}
+
+static int lw_fifo_valid(const lw_fifo *fifo)
+{
+    return fifo &&
+           fifo->count_reg_len <= 4 && fifo->data_reg_len <= 4 &&
+           (fifo->count_width == 1 || fifo->count_width == 2) &&
+           fifo->count_unit > 0 &&
+           fifo->frame_size > 0 &&
+           fifo->max_chunk >= fifo->frame_size &&
+           fifo->prefetch % fifo->frame_size == 0;
+}
+
+int lw_fifo_init(lw_fifo *fifo, uint16_t addr, uint8_t count_reg, uint8_t data_reg)
+{
+    if (!fifo)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->addr = addr;
+    fifo->count_reg[0] = count_reg;
+    fifo->count_reg_len = 1;
+    fifo->count_width = 2;
+    fifo->count_unit = 1;
+    fifo->data_reg[0] = data_reg;
+    fifo->data_reg_len = 1;
+    fifo->frame_size = 1;
+    fifo->max_chunk = LINUX_WIRE_FIFO_DEFAULT_CHUNK;
+    return 0;
+}
+
+/* Append a register-address write for `reg` to `msgs` when it is non-empty. */
+static size_t lw_fifo_add_reg(lw_msg *msgs, size_t n, uint16_t addr, const uint8_t *reg, uint8_t reg_len)
+{
+    if (reg_len == 0)
+    {
+        return n;
+    }
+    msgs[n].addr = addr;
+    msgs[n].flags = 0;
+    msgs[n].len = reg_len;
+    msgs[n].buf = (uint8_t *)reg;
+    return n + 1;
+}
+
+static size_t lw_fifo_add_read(lw_msg *msgs, size_t n, uint16_t addr, uint8_t *buf, size_t len)
+{
+    msgs[n].addr = addr;
+    msgs[n].flags = LW_MSG_RD;
+    msgs[n].len = (uint16_t)len;
+    msgs[n].buf = buf;
+    return n + 1;
+}
+
+/* Fill level in bytes, rounded down to whole frames. */
+static size_t lw_fifo_count_bytes(const lw_fifo *fifo, const uint8_t *raw)
+{
+    uint32_t count = raw[0];
+    if (fifo->count_width == 2)
+    {
+        count = fifo->count_le ? (uint32_t)(raw[0] | (raw[1] << 8))
+                               : (uint32_t)((raw[0] << 8) | raw[1]);
+    }
+    if (fifo->count_mask)
+    {
+        count &= fifo->count_mask;
+    }
+
+    size_t bytes = (size_t)count * fifo->count_unit;
+    return bytes - bytes % fifo->frame_size;
+}
+
+ssize_t lw_fifo_drain(lw_i2c_bus *bus, lw_fifo *fifo, lw_fifo_ring *ring)
+{
+    if (!bus || !lw_fifo_valid(fifo) || !ring || !ring->buf ||
+        ring->size % fifo->frame_size != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const size_t frame = fifo->frame_size;
+    const size_t chunk_max = fifo->max_chunk - fifo->max_chunk % frame;
+    const size_t free_bytes = ring->size - lw_fifo_ring_used(ring);
+    size_t room = free_bytes - free_bytes % frame;
+
+    /* Count read, optionally followed by a speculative data read, as one
+       combined transaction. */
+    lw_msg msgs[LW_MAX_MSGS];
+    uint8_t count_raw[2] = {0, 0};
+    size_t n = lw_fifo_add_reg(msgs, 0, fifo->addr, fifo->count_reg, fifo->count_reg_len);
+    n = lw_fifo_add_read(msgs, n, fifo->addr, count_raw, fifo->count_width);
+
+    size_t pre = 0;
+    if (fifo->prefetch > 0 && room >= fifo->prefetch)
+    {
+        const size_t idx = ring->head % ring->size;
+        const size_t contig = ring->size - idx;
+        pre = (fifo->prefetch < contig) ? fifo->prefetch : contig;
+        if (pre > chunk_max)
+        {
+            pre = chunk_max;
+        }
+        n = lw_fifo_add_reg(msgs, n, fifo->addr, fifo->data_reg, fifo->data_reg_len);
+        n = lw_fifo_add_read(msgs, n, fifo->addr, ring->buf + idx, pre);
+    }
+
+    if (lw_transfer(bus, msgs, n) < 0)
+    {
+        return -1;
+    }
+
+    const size_t level = lw_fifo_count_bytes(fifo, count_raw);
+    size_t appended = pre;
+    if (pre > level)
+    {
+        ++fifo->overreads;
+        appended = level;
+    }
+    ring->head += appended;
+    room -= appended;
+
+    size_t remaining = level - appended;
+    if (remaining > room)
+    {
+        remaining = room;
+    }
+
+    const size_t per_chunk = (fifo->data_reg_len ? 2U : 1U);
+    while (remaining > 0)
+    {
+        size_t batch = 0;
+        n = 0;
+        while (remaining > 0 && n + per_chunk <= LW_MAX_MSGS)
+        {
+            const size_t idx = (ring->head + batch) % ring->size;
+            size_t chunk = ring->size - idx;
+            if (chunk > remaining)
+            {
+                chunk = remaining;
+            }
+            if (chunk > chunk_max)
+            {
+                chunk = chunk_max;
+            }
+            n = lw_fifo_add_reg(msgs, n, fifo->addr, fifo->data_reg, fifo->data_reg_len);
+            n = lw_fifo_add_read(msgs, n, fifo->addr, ring->buf + idx, chunk);
+            batch += chunk;
+            remaining -= chunk;
+        }
+
+        /* Frames from earlier batches stay committed if this one fails */
+        if (lw_transfer(bus, msgs, n) < 0)
+        {
+            return -1;
+        }
+        ring->head += batch;
+        appended += batch;
+    }
+
+    return (ssize_t)appended;
+}
@@ -0,0 +1,542 @@
+#define _GNU_SOURCE
+
+#include "linux_wire_hotplug.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LW_HOTPLUG_DEV_ROOT "/dev"
+#define LW_HOTPLUG_EVENT_BUF 4096
+
+static int lw_hotplug_copy(char *dst, size_t size, const char *src)
+{
+    const size_t len = src ? strlen(src) : 0;
+    if (len >= size)
+    {
+        return -1;
+    }
+    memcpy(dst, src ? src : "", len);
+    dst[len] = '\0';
+    return 0;
+}
+
+/* Does adapter `n` carry the identity? Empty strings match anything. */
+static int lw_hotplug_matches(const char *sysfs_root, unsigned int n, const char *name, const char *parent)
+{
+    char path[PATH_MAX];
+    if (name && name[0] != '\0')
+    {
+        snprintf(path, sizeof(path), "%s/i2c-%u/name", sysfs_root, n);
+        FILE *f = fopen(path, "r");
+        if (!f)
+        {
+            return 0;
+        }
+        char text[LINUX_WIRE_HOTPLUG_MATCH_MAX];
+        const int ok = fgets(text, sizeof(text), f) != NULL;
+        fclose(f);
+        if (!ok || strncmp(text, name, strlen(name)) != 0)
+        {
+            return 0;
+        }
+    }
+    if (parent && parent[0] != '\0')
+    {
+        /* The entry is a link into the device tree, e.g.
+           .../usb1/1-1/1-1.2/1-1.2:1.0/0003:10C4:EA90.0004/i2c-7 */
+        char real[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/i2c-%u", sysfs_root, n);
+        if (!realpath(path, real) || !strstr(real, parent))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Lowest-numbered matching adapter (whose node is usable, with `dev_root`) */
+static int lw_hotplug_scan(const char *sysfs_root,
+                           const char *dev_root,
+                           const char *name,
+                           const char *parent,
+                           unsigned int *adapter)
+{
+    DIR *dir = opendir(sysfs_root);
+    if (!dir)
+    {
+        return -1;
+    }
+
+    int found = -1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        unsigned int n = 0;
+        char check[32];
+        if (sscanf(entry->d_name, "i2c-%u", &n) != 1)
+        {
+            continue;
+        }
+        snprintf(check, sizeof(check), "i2c-%u", n);
+        if (strcmp(check, entry->d_name) != 0 || (found >= 0 && n >= (unsigned int)found) ||
+            !lw_hotplug_matches(sysfs_root, n, name, parent))
+        {
+            continue;
+        }
+        if (dev_root)
+        {
+            char node[PATH_MAX];
+            snprintf(node, sizeof(node), "%s/i2c-%u", dev_root, n);
+            if (access(node, R_OK | W_OK) != 0)
+            {
+                continue;
+            }
+        }
+        found = (int)n;
+    }
+    closedir(dir);
+
+    if (found < 0)
+    {
+        return -1;
+    }
+    *adapter = (unsigned int)found;
+    return 0;
+}
+
+int lw_adapter_find(const char *name, const char *parent, const char *sysfs_root, unsigned int *adapter)
+{
+    if (!adapter)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_hotplug_scan(sysfs_root ? sysfs_root : LINUX_WIRE_SYSFS_I2C_ROOT, NULL, name, parent, adapter) != 0)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
+/* Re-resolves one slot; returns 1 when it changed. Called with the lock held. */
+static int lw_hotplug_resolve(lw_hotplug *hp, lw_hotplug_slot *slot)
+{
+    unsigned int n = 0;
+    char path[PATH_MAX] = "";
+    int adapter = -1;
+    if (lw_hotplug_scan(hp->sysfs_root, hp->dev_root, slot->name, slot->parent, &n) == 0)
+    {
+        snprintf(path, sizeof(path), "%s/i2c-%u", hp->dev_root, n);
+        adapter = (int)n;
+    }
+
+    /* A node removed and recreated between two scans is still a new adapter */
+    if (!slot->lost && adapter == slot->adapter && strcmp(path, slot->device_path) == 0)
+    {
+        return 0;
+    }
+    slot->lost = 0;
+    slot->adapter = adapter;
+    lw_hotplug_copy(slot->device_path, sizeof(slot->device_path), path);
+    __atomic_store_n(&slot->generation, slot->generation + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int lw_hotplug_rescan_locked(lw_hotplug *hp)
+{
+    int changed = 0;
+    for (size_t i = 0; i < hp->count; ++i)
+    {
+        changed += lw_hotplug_resolve(hp, &hp->slots[i]);
+    }
+    hp->changes += (uint64_t)changed;
+    return changed;
+}
+
+/* Marks the slots whose node `name` went away. Called with the lock held. */
+static void lw_hotplug_mark_lost(lw_hotplug *hp, const char *name)
+{
+    for (size_t i = 0; i < hp->count; ++i)
+    {
+        const char *node = strrchr(hp->slots[i].device_path, '/');
+        if (node && strcmp(node + 1, name) == 0)
+        {
+            hp->slots[i].lost = 1;
+        }
+    }
+}
+
+/* Drains the inotify queue; returns 1 if an i2c-N node was affected */
+static int lw_hotplug_drain_inotify(lw_hotplug *hp)
+{
+    char buf[LW_HOTPLUG_EVENT_BUF] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int relevant = 0;
+    for (;;)
+    {
+        const ssize_t n = read(hp->inotify_fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            break;
+        }
+        for (ssize_t off = 0; off < n;)
+        {
+            const struct inotify_event *ev = (const struct inotify_event *)(buf + off);
+            off += (ssize_t)(sizeof(*ev) + ev->len);
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                relevant = 1;
+                continue;
+            }
+            if (ev->len == 0 || strncmp(ev->name, "i2c-", 4) != 0)
+            {
+                continue;
+            }
+            relevant = 1;
+            if (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                lw_hotplug_mark_lost(hp, ev->name);
+            }
+        }
+    }
+    return relevant;
+}
+
+/* Drains kernel uevents ("ACTION=...\0SUBSYSTEM=...\0DEVNAME=...\0") */
+static int lw_hotplug_drain_uevents(lw_hotplug *hp)
+{
+    char buf[LW_HOTPLUG_EVENT_BUF];
+    int relevant = 0;
+    for (;;)
+    {
+        const ssize_t n = recv(hp->uevent_fd, buf, sizeof(buf) - 1, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        buf[n] = '\0';
+
+        int i2c = 0;
+        int remove = 0;
+        const char *devname = NULL;
+        for (const char *field = buf; field < buf + n; field += strlen(field) + 1)
+        {
+            if (strncmp(field, "SUBSYSTEM=i2c", 13) == 0)
+            {
+                i2c = 1;
+            }
+            else if (strcmp(field, "ACTION=remove") == 0)
+            {
+                remove = 1;
+            }
+            else if (strncmp(field, "DEVNAME=", 8) == 0)
+            {
+                devname = field + 8;
+            }
+        }
+        if (!i2c)
+        {
+            continue;
+        }
+        relevant = 1;
+        if (remove && devname && strncmp(devname, "i2c-", 4) == 0)
+        {
+            lw_hotplug_mark_lost(hp, devname);
+        }
+    }
+    return relevant;
+}
+
+static int lw_hotplug_open_uevents(void)
+{
+    const int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1; /* kernel events, not the udev daemon's */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int lw_hotplug_init(lw_hotplug *hp, const char *dev_root, const char *sysfs_root, unsigned int flags)
+{
+    if (!hp)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(hp, 0, sizeof(*hp));
+    hp->inotify_fd = -1;
+    hp->uevent_fd = -1;
+    if (lw_hotplug_copy(hp->dev_root, sizeof(hp->dev_root), dev_root ? dev_root : LW_HOTPLUG_DEV_ROOT) != 0 ||
+        lw_hotplug_copy(hp->sysfs_root,
+                        sizeof(hp->sysfs_root),
+                        sysfs_root ? sysfs_root : LINUX_WIRE_SYSFS_I2C_ROOT) != 0 ||
+        strlen(hp->dev_root) + sizeof("/i2c-4294967295") > LINUX_WIRE_DEVICE_PATH_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    hp->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (hp->inotify_fd < 0)
+    {
+        return -1;
+    }
+    /* IN_ATTRIB: udev fixes the node's mode and owner after creation */
+    if (inotify_add_watch(hp->inotify_fd,
+                          hp->dev_root,
+                          IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO) < 0)
+    {
+        const int err = errno;
+        close(hp->inotify_fd);
+        hp->inotify_fd = -1;
+        errno = err;
+        return -1;
+    }
+    if (flags & LW_HOTPLUG_UEVENT)
+    {
+        hp->uevent_fd = lw_hotplug_open_uevents();
+    }
+
+    const int rc = pthread_mutex_init(&hp->lock, NULL);
+    if (rc != 0)
+    {
+        if (hp->uevent_fd >= 0)
+        {
+            close(hp->uevent_fd);
+        }
+        close(hp->inotify_fd);
+        hp->uevent_fd = -1;
+        hp->inotify_fd = -1;
+        errno = rc;
+        return -1;
+    }
+    return 0;
+}
+
+void lw_hotplug_close(lw_hotplug *hp)
+{
+    if (!hp)
+    {
+        return;
+    }
+
+    if (hp->uevent_fd >= 0)
+    {
+        close(hp->uevent_fd);
+        hp->uevent_fd = -1;
+    }
+    if (hp->inotify_fd >= 0)
+    {
+        close(hp->inotify_fd);
+        hp->inotify_fd = -1;
+        pthread_mutex_destroy(&hp->lock);
+    }
+}
+
+int lw_hotplug_add(lw_hotplug *hp, const char *name, const char *parent)
+{
+    if (!hp || hp->inotify_fd < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&hp->lock);
+    if (hp->count == LINUX_WIRE_HOTPLUG_MAX_SLOTS)
+    {
+        pthread_mutex_unlock(&hp->lock);
+        errno = ENOSPC;
+        return -1;
+    }
+    lw_hotplug_slot *slot = &hp->slots[hp->count];
+    memset(slot, 0, sizeof(*slot));
+    if (lw_hotplug_copy(slot->name, sizeof(slot->name), name) != 0 ||
+        lw_hotplug_copy(slot->parent, sizeof(slot->parent), parent) != 0)
+    {
+        pthread_mutex_unlock(&hp->lock);
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Generation 1 is the first resolution, present or not */
+    slot->adapter = -1;
+    slot->lost = 1;
+    lw_hotplug_resolve(hp, slot);
+    const int index = (int)hp->count++;
+    pthread_mutex_unlock(&hp->lock);
+    return index;
+}
+
+int lw_hotplug_run_once(lw_hotplug *hp, int timeout_ms)
+{
+    if (!hp || hp->inotify_fd < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+    fds[nfds].fd = hp->inotify_fd;
+    fds[nfds++].events = POLLIN;
+    if (hp->uevent_fd >= 0)
+    {
+        fds[nfds].fd = hp->uevent_fd;
+        fds[nfds++].events = POLLIN;
+    }
+
+    const int ready = poll(fds, nfds, timeout_ms);
+    if (ready <= 0)
+    {
+        return ready;
+    }
+
+    pthread_mutex_lock(&hp->lock);
+    int relevant = lw_hotplug_drain_inotify(hp);
+    if (hp->uevent_fd >= 0)
+    {
+        relevant |= lw_hotplug_drain_uevents(hp);
+    }
+    int changed = 0;
+    if (relevant)
+    {
+        ++hp->events;
+        changed = lw_hotplug_rescan_locked(hp);
+    }
+    pthread_mutex_unlock(&hp->lock);
+    return changed;
+}
+
+int lw_hotplug_rescan(lw_hotplug *hp)
+{
+    if (!hp || hp->inotify_fd < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&hp->lock);
+    const int changed = lw_hotplug_rescan_locked(hp);
+    pthread_mutex_unlock(&hp->lock);
+    return changed;
+}
+
+uint64_t lw_hotplug_generation(lw_hotplug *hp, size_t slot)
+{
+    if (!hp || slot >= LINUX_WIRE_HOTPLUG_MAX_SLOTS)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&hp->slots[slot].generation, __ATOMIC_ACQUIRE);
+}
+
+int lw_hotplug_path(lw_hotplug *hp, size_t slot, char *path, size_t size)
+{
+    if (!hp || !path || size == 0 || lw_hotplug_generation(hp, slot) == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&hp->lock);
+    const int absent = hp->slots[slot].adapter < 0;
+    const int rc = absent ? 0 : lw_hotplug_copy(path, size, hp->slots[slot].device_path);
+    pthread_mutex_unlock(&hp->lock);
+    if (absent || rc != 0)
+    {
+        errno = absent ? ENODEV : EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int lw_hotplug_reopen(lw_hotplug *hp, size_t slot, lw_i2c_bus *bus, uint64_t *generation)
+{
+    if (!bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    const uint64_t current = lw_hotplug_generation(hp, slot);
+    if (!generation || current == 0)
+    {
+        if (bus->fd >= 0)
+        {
+            lw_close_bus(bus);
+        }
+        errno = EINVAL;
+        return -1;
+    }
+    if (current == *generation && bus->fd >= 0)
+    {
+        return 0;
+    }
+
+    /* A handle this function opened before keeps its settings: lw_open_bus()
+       starts from a blank handle, so carry them over by hand. A library
+       realtime pool moves along instead of being freed by the close. */
+    const int carry = *generation != 0;
+    lw_i2c_bus saved;
+    if (carry)
+    {
+        saved = *bus;
+        bus->rt_flags = 0;
+    }
+    if (bus->fd >= 0)
+    {
+        lw_close_bus(bus);
+    }
+
+    char path[LINUX_WIRE_DEVICE_PATH_MAX];
+    pthread_mutex_lock(&hp->lock);
+    *generation = hp->slots[slot].generation;
+    const int absent = hp->slots[slot].adapter < 0;
+    memcpy(path, hp->slots[slot].device_path, sizeof(path));
+    pthread_mutex_unlock(&hp->lock);
+
+    int rc = 1;
+    if (absent)
+    {
+        errno = ENODEV;
+        rc = -1;
+    }
+    else if (lw_open_bus(bus, path) != 0)
+    {
+        rc = -1;
+    }
+
+    /* Also on failure, so the settings are back once the adapter returns */
+    if (carry)
+    {
+        bus->timeout_us = saved.timeout_us;
+        bus->log_errors = saved.log_errors;
+        bus->pool = saved.pool;
+        bus->rt_flags = saved.rt_flags;
+        bus->errors = saved.errors;
+        bus->observer = saved.observer;
+        bus->observer_arg = saved.observer_arg;
+    }
+    return rc;
+}
@@ -0,0 +1,38 @@
+#ifndef LINUX_WIRE_INTERNAL_H
+#define LINUX_WIRE_INTERNAL_H
+
+/*
+ * Helpers shared by the library's translation units. Not installed; the
+ * including file defines _POSIX_C_SOURCE first.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+/* CLOCK_MONOTONIC in nanoseconds */
+static inline uint64_t lw_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* CLOCK_MONOTONIC in microseconds */
+static inline uint64_t lw_monotonic_us(void)
+{
+    return lw_monotonic_ns() / 1000ULL;
+}
+
+/* Sleep until an absolute lw_monotonic_ns() time, resuming after signals */
+static inline void lw_sleep_until_ns(uint64_t abs_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(abs_ns / 1000000000ULL);
+    ts.tv_nsec = (long)(abs_ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+#endif /* LINUX_WIRE_INTERNAL_H */
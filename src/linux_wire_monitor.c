@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_monitor.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Bit times: START/repeated START, address + ACK, data byte + ACK, STOP */
+#define LW_BITS_START 1u
+#define LW_BITS_BYTE 9u
+#define LW_BITS_STOP 1u
+
+/* lw_monitor_slot.index while the recorder is recycling the slot */
+#define LW_MONITOR_SLOT_BUSY UINT64_MAX
+
+/* Single-writer counter update: plain read-modify-write, atomic store */
+#define LW_MONITOR_ADD(field, v, order) \
+    __atomic_store_n(&(field), __atomic_load_n(&(field), __ATOMIC_RELAXED) + (v), (order))
+
+int lw_monitor_init(lw_monitor *mon, const lw_i2c_bus *bus, uint32_t slot_us)
+{
+    if (!mon)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(mon, 0, sizeof(*mon));
+    const char *label = "i2c";
+    if (bus && bus->device_path[0] != '\0')
+    {
+        const char *slash = strrchr(bus->device_path, '/');
+        label = slash ? slash + 1 : bus->device_path;
+    }
+    strncpy(mon->label, label, sizeof(mon->label) - 1);
+
+    mon->bus_hz = (bus && bus->caps.bus_hz) ? bus->caps.bus_hz : LINUX_WIRE_MONITOR_DEFAULT_HZ;
+    mon->slot_us = slot_us ? slot_us : LINUX_WIRE_MONITOR_SLOT_US;
+    mon->started_us = lw_monotonic_us();
+    return 0;
+}
+
+int lw_monitor_set_bus_hz(lw_monitor *mon, uint32_t bus_hz)
+{
+    if (!mon || bus_hz == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    __atomic_store_n(&mon->bus_hz, bus_hz, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int lw_monitor_attach(lw_monitor *mon, lw_i2c_bus *bus)
+{
+    if (!mon || !bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_bus_set_observer(bus, lw_monitor_record, mon);
+    return 0;
+}
+
+uint64_t lw_monitor_wire_ns(uint32_t bus_hz, const lw_xfer_event *event)
+{
+    if (!event || bus_hz == 0)
+    {
+        return 0;
+    }
+
+    uint64_t bits;
+    if (event->err != 0)
+    {
+        /* Where it failed is unknown; assume the first address was NACKed */
+        bits = LW_BITS_START + LW_BITS_BYTE + LW_BITS_STOP;
+    }
+    else
+    {
+        bits = (uint64_t)event->msgs * (LW_BITS_START + LW_BITS_BYTE) +
+               (uint64_t)event->ten_bit_msgs * LW_BITS_BYTE +
+               (uint64_t)event->bytes * LW_BITS_BYTE + LW_BITS_STOP;
+    }
+    return bits * 1000000000ULL / bus_hz;
+}
+
+void lw_monitor_record_at(lw_monitor *mon, const lw_xfer_event *event, uint64_t now_us)
+{
+    if (!mon || !event)
+    {
+        return;
+    }
+
+    /* No lock: this runs inside every transfer, realtime buses included.
+       There is one recorder at a time, so only readers race with it. */
+    const uint64_t ns = lw_monitor_wire_ns(__atomic_load_n(&mon->bus_hz, __ATOMIC_RELAXED), event);
+    const uint64_t index = now_us / mon->slot_us;
+    lw_monitor_slot *slot = &mon->slots[index % LINUX_WIRE_MONITOR_SLOTS];
+    if (__atomic_load_n(&slot->index, __ATOMIC_RELAXED) != index)
+    {
+        /* Readers skip the slot until it holds the new index */
+        __atomic_store_n(&slot->index, LW_MONITOR_SLOT_BUSY, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&slot->busy_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->index, index, __ATOMIC_RELEASE);
+    }
+    LW_MONITOR_ADD(slot->busy_ns, ns, __ATOMIC_RELAXED);
+
+    /* Transactions first: a reader that sees an error also sees its transaction */
+    LW_MONITOR_ADD(mon->transactions, 1, __ATOMIC_RELAXED);
+    LW_MONITOR_ADD(mon->bytes, event->err ? 0 : event->bytes, __ATOMIC_RELEASE);
+    LW_MONITOR_ADD(mon->errors, event->err ? 1 : 0, __ATOMIC_RELEASE);
+    LW_MONITOR_ADD(mon->busy_ns, ns, __ATOMIC_RELEASE);
+}
+
+void lw_monitor_record(void *mon, const lw_xfer_event *event)
+{
+    lw_monitor_record_at((lw_monitor *)mon, event, lw_monotonic_us());
+}
+
+/* Busy time of a completed slot among the last `nslots`, else 0 */
+static uint64_t lw_monitor_slot_busy(const lw_monitor_slot *slot, uint64_t current, uint64_t nslots)
+{
+    const uint64_t index = __atomic_load_n(&slot->index, __ATOMIC_ACQUIRE);
+    if (index >= current || current - index > nslots)
+    {
+        return 0; /* current, too old, or being recycled */
+    }
+    const uint64_t busy_ns = __atomic_load_n(&slot->busy_ns, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->index, __ATOMIC_RELAXED) == index ? busy_ns : 0;
+}
+
+/* Busy fraction over the completed slots covering `window_us`, so a
+   partially elapsed current slot never skews the figure. */
+static double lw_monitor_ratio(const lw_monitor *mon, uint64_t window_us, uint64_t now_us)
+{
+    const uint64_t current = now_us / mon->slot_us;
+    const uint64_t first = mon->started_us / mon->slot_us;
+    uint64_t nslots = (window_us + mon->slot_us - 1) / mon->slot_us;
+    if (nslots > LINUX_WIRE_MONITOR_SLOTS)
+    {
+        nslots = LINUX_WIRE_MONITOR_SLOTS;
+    }
+    if (current < first + nslots)
+    {
+        nslots = current > first ? current - first : 0; /* younger than the window */
+    }
+    if (nslots == 0)
+    {
+        return 0.0;
+    }
+
+    uint64_t busy_ns = 0;
+    for (size_t i = 0; i < LINUX_WIRE_MONITOR_SLOTS; ++i)
+    {
+        busy_ns += lw_monitor_slot_busy(&mon->slots[i], current, nslots);
+    }
+
+    const double ratio = (double)busy_ns / ((double)nslots * mon->slot_us * 1000.0);
+    return ratio > 1.0 ? 1.0 : ratio;
+}
+
+double lw_monitor_busy_ratio(lw_monitor *mon, uint64_t window_us, uint64_t now_us)
+{
+    if (!mon)
+    {
+        return 0.0;
+    }
+
+    if (now_us == 0)
+    {
+        now_us = lw_monotonic_us();
+    }
+
+    return lw_monitor_ratio(mon, window_us, now_us);
+}
+
+int lw_monitor_get_stats(lw_monitor *mon, lw_monitor_stats *stats)
+{
+    if (!mon || !stats)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const uint64_t now = lw_monotonic_us();
+    /* Reverse of the recording order, so errors never exceed transactions */
+    stats->busy_ns = __atomic_load_n(&mon->busy_ns, __ATOMIC_ACQUIRE);
+    stats->errors = __atomic_load_n(&mon->errors, __ATOMIC_ACQUIRE);
+    stats->bytes = __atomic_load_n(&mon->bytes, __ATOMIC_ACQUIRE);
+    stats->transactions = __atomic_load_n(&mon->transactions, __ATOMIC_RELAXED);
+    stats->busy_1s = lw_monitor_ratio(mon, 1000000ULL, now);
+    stats->busy_10s = lw_monitor_ratio(mon, 10000000ULL, now);
+    stats->busy_60s = lw_monitor_ratio(mon, 60000000ULL, now);
+    return 0;
+}
+
+int lw_monitor_write_prometheus(lw_monitor *const *mons, size_t count, FILE *out)
+{
+    if ((!mons && count > 0) || !out)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* One snapshot per monitor, so every family of a scrape agrees */
+    lw_monitor_stats *snaps = NULL;
+    if (count > 0)
+    {
+        snaps = (lw_monitor_stats *)calloc(count, sizeof(*snaps));
+        if (!snaps)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (lw_monitor_get_stats(mons[i], &snaps[i]) != 0)
+        {
+            free(snaps);
+            return -1;
+        }
+    }
+
+    int rc = 0;
+    rc |= fprintf(out, "# HELP linux_wire_bus_busy_ratio Estimated fraction of time the bus is occupied.\n"
+                       "# TYPE linux_wire_bus_busy_ratio gauge\n") < 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const lw_monitor_stats *s = &snaps[i];
+        const char *bus = mons[i]->label;
+        rc |= fprintf(out, "linux_wire_bus_busy_ratio{bus=\"%s\",window=\"1s\"} %.6f\n", bus, s->busy_1s) < 0;
+        rc |= fprintf(out, "linux_wire_bus_busy_ratio{bus=\"%s\",window=\"10s\"} %.6f\n", bus, s->busy_10s) < 0;
+        rc |= fprintf(out, "linux_wire_bus_busy_ratio{bus=\"%s\",window=\"60s\"} %.6f\n", bus, s->busy_60s) < 0;
+    }
+
+    rc |= fprintf(out, "# HELP linux_wire_bus_clock_hz Bus clock used for the occupancy estimate.\n"
+                       "# TYPE linux_wire_bus_clock_hz gauge\n") < 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        rc |= fprintf(out, "linux_wire_bus_clock_hz{bus=\"%s\"} %u\n", mons[i]->label,
+                      __atomic_load_n(&mons[i]->bus_hz, __ATOMIC_RELAXED)) < 0;
+    }
+
+    static const char *const names[4] = {"transactions", "bytes", "errors", "busy_seconds"};
+    static const char *const help[4] = {"Transactions issued, including failed ones.",
+                                        "Payload bytes transferred.",
+                                        "Transactions that failed.",
+                                        "Estimated on-wire time."};
+    for (size_t m = 0; m < 4; ++m)
+    {
+        rc |= fprintf(out, "# HELP linux_wire_bus_%s_total %s\n# TYPE linux_wire_bus_%s_total counter\n",
+                      names[m], help[m], names[m]) < 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const lw_monitor_stats *s = &snaps[i];
+            const char *bus = mons[i]->label;
+            if (m == 3)
+            {
+                rc |= fprintf(out, "linux_wire_bus_busy_seconds_total{bus=\"%s\"} %.9f\n",
+                              bus, (double)s->busy_ns / 1e9) < 0;
+            }
+            else
+            {
+                const uint64_t v = (m == 0) ? s->transactions : (m == 1) ? s->bytes : s->errors;
+                rc |= fprintf(out, "linux_wire_bus_%s_total{bus=\"%s\"} %llu\n",
+                              names[m], bus, (unsigned long long)v) < 0;
+            }
+        }
+    }
+    free(snaps);
+
+    if (rc)
+    {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+int lw_monitor_dump_prometheus(lw_monitor *const *mons, size_t count, const char *path)
+{
+    if (!path || path[0] == '\0')
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    char tmp[PATH_MAX];
+    const int len = snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if (len < 0 || (size_t)len >= sizeof(tmp))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    FILE *out = fopen(tmp, "w");
+    if (!out)
+    {
+        return -1;
+    }
+
+    int rc = lw_monitor_write_prometheus(mons, count, out);
+    int saved_errno = errno;
+    if (fclose(out) != 0 && rc == 0)
+    {
+        rc = -1;
+        saved_errno = errno;
+    }
+    if (rc == 0 && rename(tmp, path) != 0)
+    {
+        rc = -1;
+        saved_errno = errno;
+    }
+    if (rc != 0)
+    {
+        remove(tmp);
+        errno = saved_errno;
+    }
+    return rc;
+}
+
+void lw_monitor_destroy(lw_monitor *mon)
+{
+    /* Nothing is held: recording is lock-free */
+    (void)mon;
+}
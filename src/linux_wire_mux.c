@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_mux.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int lw_mux_init(lw_mux *mux, lw_i2c_bus *bus, uint16_t addr, uint8_t channels)
+{
+    if (!mux || !bus || addr > 0x7F || channels == 0 || channels > LINUX_WIRE_MUX_MAX_CHANNELS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(mux, 0, sizeof(*mux));
+    mux->bus = bus;
+    mux->addr = addr;
+    mux->channels = channels;
+    mux->current = LW_MUX_UNKNOWN;
+    return 0;
+}
+
+void lw_mux_invalidate(lw_mux *mux)
+{
+    if (mux)
+    {
+        mux->current = LW_MUX_UNKNOWN;
+    }
+}
+
+static int lw_mux_valid_channel(const lw_mux *mux, int channel)
+{
+    return channel == LW_MUX_NONE || (channel >= 0 && channel < mux->channels);
+}
+
+int lw_mux_select(lw_mux *mux, int channel)
+{
+    if (!mux || !lw_mux_valid_channel(mux, channel))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (mux->current == channel)
+    {
+        ++mux->skipped;
+        return 0;
+    }
+
+    const uint8_t control = (channel == LW_MUX_NONE) ? 0 : (uint8_t)(1U << channel);
+    ++mux->switches;
+    if (lw_ioctl_write(mux->bus, mux->addr, NULL, 0, &control, 1, 0) < 0)
+    {
+        mux->current = LW_MUX_UNKNOWN;
+        return -1;
+    }
+    mux->current = channel;
+    return 0;
+}
+
+int lw_mux_transfer(lw_mux *mux, uint8_t channel, const lw_msg *msgs, size_t count)
+{
+    if (!mux || !msgs || count == 0 || !lw_mux_valid_channel(mux, channel))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (mux->current != channel && (mux->flags & LW_MUX_SELECT_ON_ACK))
+    {
+        if (count + 1 > LW_MAX_MSGS)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+
+        /* Control byte first, device messages after a repeated START */
+        lw_msg folded[LW_MAX_MSGS];
+        mux->control = (uint8_t)(1U << channel);
+        folded[0].addr = mux->addr;
+        folded[0].flags = 0;
+        folded[0].len = 1;
+        folded[0].buf = &mux->control;
+        memcpy(&folded[1], msgs, count * sizeof(*msgs));
+
+        ++mux->switches;
+        if (lw_transfer(mux->bus, folded, count + 1) < 0)
+        {
+            mux->current = LW_MUX_UNKNOWN;
+            return -1;
+        }
+        mux->current = channel;
+        return (int)count;
+    }
+
+    if (lw_mux_select(mux, channel) != 0)
+    {
+        return -1;
+    }
+
+    const int rc = lw_transfer(mux->bus, msgs, count);
+    if (rc < 0)
+    {
+        /* A stuck or reset segment may have disturbed the switch too */
+        mux->current = LW_MUX_UNKNOWN;
+    }
+    return rc;
+}
+
+ssize_t lw_mux_read_reg(lw_mux *mux,
+                        uint8_t channel,
+                        uint16_t addr,
+                        uint32_t reg,
+                        uint8_t reg_len,
+                        uint8_t *dst,
+                        uint16_t len)
+{
+    if (reg_len < 1 || reg_len > 4 || !dst || len == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint8_t reg_bytes[4];
+    for (uint8_t b = 0; b < reg_len; ++b)
+    {
+        reg_bytes[b] = (uint8_t)(reg >> (8U * (reg_len - 1U - b)));
+    }
+
+    lw_msg msgs[2];
+    msgs[0].addr = addr;
+    msgs[0].flags = 0;
+    msgs[0].len = reg_len;
+    msgs[0].buf = reg_bytes;
+    msgs[1].addr = addr;
+    msgs[1].flags = LW_MSG_RD;
+    msgs[1].len = len;
+    msgs[1].buf = dst;
+
+    if (lw_mux_transfer(mux, channel, msgs, 2) < 0)
+    {
+        return -1;
+    }
+    return (ssize_t)len;
+}
+
+static void lw_mux_run_channel(lw_mux *mux, lw_mux_job *jobs, size_t count, int channel, int *failed)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (jobs[i].channel != channel)
+        {
+            continue;
+        }
+        errno = 0;
+        jobs[i].result = lw_mux_transfer(mux, jobs[i].channel, jobs[i].msgs, jobs[i].count);
+        jobs[i].error = jobs[i].result < 0 ? errno : 0;
+        *failed += jobs[i].result < 0;
+    }
+}
+
+int lw_mux_run(lw_mux *mux, lw_mux_job *jobs, size_t count)
+{
+    if (!mux || (!jobs && count > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (jobs[i].channel >= mux->channels)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    int failed = 0;
+    const int first = mux->current;
+    if (first >= 0)
+    {
+        lw_mux_run_channel(mux, jobs, count, first, &failed);
+    }
+    for (int ch = 0; ch < mux->channels; ++ch)
+    {
+        if (ch != first)
+        {
+            lw_mux_run_channel(mux, jobs, count, ch, &failed);
+        }
+    }
+    return failed;
+}
+
+/* Last path component of the symlink at `path`, or NULL */
+static const char *lw_mux_link_name(const char *path, char *buf, size_t size)
+{
+    const ssize_t n = readlink(path, buf, size - 1);
+    if (n <= 0)
+    {
+        return NULL;
+    }
+    buf[n] = '\0';
+    const char *slash = strrchr(buf, '/');
+    return slash ? slash + 1 : buf;
+}
+
+int lw_mux_find_parent(unsigned int adapter, const char *sysfs_root, lw_mux_adapter *info)
+{
+    if (!info)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!sysfs_root)
+    {
+        sysfs_root = LINUX_WIRE_SYSFS_I2C_ROOT;
+    }
+
+    /* mux_device -> the switch's client device, named "<parent>-<addr>" */
+    char path[PATH_MAX];
+    char link[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/i2c-%u/mux_device", sysfs_root, adapter);
+    const char *client = lw_mux_link_name(path, link, sizeof(link));
+    unsigned int parent = 0;
+    unsigned int addr = 0;
+    if (!client || sscanf(client, "%u-%x", &parent, &addr) != 2)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    info->parent = parent;
+    info->addr = (uint16_t)addr;
+    info->channel = -1;
+
+    /* The switch lists its channels as channel-K -> i2c-N links */
+    char self[32];
+    snprintf(self, sizeof(self), "i2c-%u", adapter);
+    snprintf(path, sizeof(path), "%s/i2c-%u/mux_device", sysfs_root, adapter);
+    DIR *dir = opendir(path);
+    if (!dir)
+    {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        int channel = 0;
+        if (sscanf(entry->d_name, "channel-%d", &channel) != 1)
+        {
+            continue;
+        }
+        char target[PATH_MAX];
+        const int len = snprintf(target, sizeof(target), "%s/%s", path, entry->d_name);
+        if (len < 0 || (size_t)len >= sizeof(target))
+        {
+            continue;
+        }
+        const char *name = lw_mux_link_name(target, link, sizeof(link));
+        if (name && strcmp(name, self) == 0)
+        {
+            info->channel = channel;
+            break;
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+int lw_mux_kernel_owned(unsigned int parent, uint16_t addr, const char *sysfs_root)
+{
+    if (!sysfs_root)
+    {
+        sysfs_root = LINUX_WIRE_SYSFS_I2C_ROOT;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%u-%04x/driver", sysfs_root, parent, (unsigned int)addr);
+    struct stat st;
+    return stat(path, &st) == 0 ? 1 : 0;
+}
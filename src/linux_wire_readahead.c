@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_readahead.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+static void lw_readahead_reset(lw_readahead_device *dev)
+{
+    dev->has_next = 0;
+    dev->valid = 0;
+}
+
+static lw_readahead_device *lw_readahead_find(lw_readahead *ra, uint16_t addr)
+{
+    for (size_t i = 0; i < ra->device_count; ++i)
+    {
+        if (ra->devices[i].addr == addr)
+        {
+            return &ra->devices[i];
+        }
+    }
+    return NULL;
+}
+
+static ssize_t lw_readahead_fetch(lw_i2c_bus *bus,
+                                  uint16_t addr,
+                                  uint32_t reg,
+                                  uint8_t reg_len,
+                                  uint8_t *dst,
+                                  size_t len)
+{
+    uint8_t iaddr[4];
+    for (uint8_t i = 0; i < reg_len; ++i)
+    {
+        iaddr[i] = (uint8_t)(reg >> (8u * (reg_len - 1u - i)));
+    }
+    return lw_ioctl_read(bus, addr, iaddr, reg_len, dst, len, 0);
+}
+
+int lw_readahead_init(lw_readahead *ra)
+{
+    if (!ra)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(ra, 0, sizeof(*ra));
+    return 0;
+}
+
+int lw_readahead_add_device(lw_readahead *ra,
+                            uint16_t addr,
+                            uint8_t reg_len,
+                            uint32_t autoinc,
+                            uint16_t block,
+                            uint32_t max_age_us)
+{
+    if (!ra || reg_len < 1 || reg_len > 4 ||
+        (reg_len < 4 && (autoinc >> (8u * reg_len)) != 0) ||
+        block < 1 || block > LINUX_WIRE_READAHEAD_BLOCK_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_readahead_device *dev = lw_readahead_find(ra, addr);
+    if (!dev)
+    {
+        if (ra->device_count == LINUX_WIRE_READAHEAD_MAX_DEVICES)
+        {
+            errno = ENOSPC;
+            return -1;
+        }
+        dev = &ra->devices[ra->device_count++];
+    }
+    dev->addr = addr;
+    dev->reg_len = reg_len;
+    dev->autoinc = autoinc;
+    dev->block = block;
+    dev->max_age_us = max_age_us;
+    lw_readahead_reset(dev);
+    return 0;
+}
+
+ssize_t lw_readahead_read(lw_i2c_bus *bus,
+                          lw_readahead *ra,
+                          uint16_t addr,
+                          uint32_t reg,
+                          uint8_t reg_len,
+                          uint8_t *dst,
+                          size_t len)
+{
+    if (!bus || !ra || !dst || len == 0 || reg_len > 4)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ++ra->reads;
+    lw_readahead_device *dev = lw_readahead_find(ra, addr);
+    if (!dev || dev->reg_len != reg_len || len > LINUX_WIRE_READAHEAD_BLOCK_MAX)
+    {
+        if (dev)
+        {
+            lw_readahead_reset(dev);
+        }
+        return lw_readahead_fetch(bus, addr, reg, reg_len, dst, len);
+    }
+
+    /* 64-bit arithmetic: 4-byte register addresses must not wrap */
+    const uint64_t start = reg & ~dev->autoinc;
+    const uint64_t now = lw_monotonic_us();
+    const int fresh = dev->valid > 0 &&
+                      (dev->max_age_us == 0 || now - dev->fetched_us <= dev->max_age_us);
+    if (fresh && dev->has_next && start >= dev->next && start >= dev->base &&
+        start + len <= (uint64_t)dev->base + dev->valid)
+    {
+        memcpy(dst, dev->data + (start - dev->base), len);
+        dev->next = (uint32_t)(start + len);
+        ++ra->hits;
+        return (ssize_t)len;
+    }
+
+    /* Continuing the previous read: fetch a whole block */
+    const int sequential = dev->has_next && start == dev->next && dev->block > len;
+    const size_t fetch = sequential ? dev->block : len;
+    const ssize_t got = lw_readahead_fetch(bus,
+                                           addr,
+                                           sequential ? (uint32_t)start | dev->autoinc : reg,
+                                           reg_len,
+                                           dev->data,
+                                           fetch);
+    if (got < 0)
+    {
+        lw_readahead_reset(dev);
+        return -1;
+    }
+    if (sequential)
+    {
+        ++ra->fetches;
+    }
+
+    const size_t served = (size_t)got < len ? (size_t)got : len;
+    memcpy(dst, dev->data, served);
+    dev->base = (uint32_t)start;
+    dev->valid = (uint16_t)got;
+    dev->fetched_us = now;
+    dev->next = (uint32_t)(start + served);
+    dev->has_next = 1;
+    return (ssize_t)served;
+}
+
+void lw_readahead_invalidate(lw_readahead *ra, uint16_t addr)
+{
+    if (!ra)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < ra->device_count; ++i)
+    {
+        if (addr == LW_READAHEAD_ALL || ra->devices[i].addr == addr)
+        {
+            lw_readahead_reset(&ra->devices[i]);
+        }
+    }
+}
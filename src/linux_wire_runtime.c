@@ -0,0 +1,330 @@
+#define _GNU_SOURCE /* CPU_SET, pthread_attr_setaffinity_np */
+
+#include "linux_wire_runtime.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static lw_worker *lw_runtime_find(lw_runtime *rt, unsigned int adapter)
+{
+    for (size_t i = 0; i < rt->count; ++i)
+    {
+        if (rt->workers[i].config.adapter == adapter)
+        {
+            return &rt->workers[i];
+        }
+    }
+    return NULL;
+}
+
+static void *lw_worker_main(void *arg)
+{
+    lw_worker *w = (lw_worker *)arg;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;)
+    {
+        while (!w->head && !w->stopping)
+        {
+            pthread_cond_wait(&w->work_cond, &w->lock);
+        }
+        if (!w->head)
+        {
+            break; /* stopping and the queue is drained */
+        }
+
+        lw_job *job = w->head;
+        w->head = job->next;
+        if (!w->head)
+        {
+            w->tail = NULL;
+        }
+        --w->queue_depth;
+        pthread_mutex_unlock(&w->lock);
+
+        /* Only this thread touches w->bus, so the job runs unlocked */
+        const uint64_t t0 = lw_monotonic_us();
+        errno = 0;
+        const int rc = job->fn(&w->bus, job->arg);
+        const int err = (rc < 0) ? errno : 0;
+        const uint64_t t1 = lw_monotonic_us();
+
+        pthread_mutex_lock(&w->lock);
+        w->busy_us += t1 - t0;
+        ++w->jobs;
+        job->result = rc;
+        job->error = err;
+        job->done = 1;
+        pthread_cond_broadcast(&w->done_cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+int lw_runtime_init(lw_runtime *rt)
+{
+    if (!rt)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(rt, 0, sizeof(*rt));
+    return 0;
+}
+
+/* Build thread attributes for the requested CPU and SCHED_FIFO priority. */
+static int lw_worker_attr(pthread_attr_t *attr, const lw_worker_config *config)
+{
+    int rc = pthread_attr_init(attr);
+    if (rc != 0)
+    {
+        return rc;
+    }
+
+    if (config->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config->cpu, &set);
+        rc = pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+    }
+
+    if (rc == 0 && config->priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = config->priority;
+        rc = pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        if (rc == 0)
+        {
+            rc = pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+        }
+        if (rc == 0)
+        {
+            rc = pthread_attr_setschedparam(attr, &param);
+        }
+    }
+
+    if (rc != 0)
+    {
+        pthread_attr_destroy(attr);
+    }
+    return rc;
+}
+
+int lw_runtime_add_worker(lw_runtime *rt, const lw_worker_config *config)
+{
+    if (!rt || !config || config->priority < 0 ||
+        config->cpu >= CPU_SETSIZE ||
+        (config->priority > 0 && config->priority > sched_get_priority_max(SCHED_FIFO)))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lw_runtime_find(rt, config->adapter))
+    {
+        errno = EEXIST;
+        return -1;
+    }
+
+    if (rt->count >= LINUX_WIRE_RUNTIME_MAX_WORKERS)
+    {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    lw_worker *w = &rt->workers[rt->count];
+    memset(w, 0, sizeof(*w));
+    w->config = *config;
+
+    char path[LINUX_WIRE_DEVICE_PATH_MAX];
+    snprintf(path, sizeof(path), "/dev/i2c-%u", config->adapter);
+    if (lw_open_bus(&w->bus, path) != 0)
+    {
+        return -1;
+    }
+
+    int rc = pthread_mutex_init(&w->lock, NULL);
+    if (rc == 0)
+    {
+        rc = pthread_cond_init(&w->work_cond, NULL);
+        if (rc == 0)
+        {
+            rc = pthread_cond_init(&w->done_cond, NULL);
+            if (rc != 0)
+            {
+                pthread_cond_destroy(&w->work_cond);
+            }
+        }
+        if (rc != 0)
+        {
+            pthread_mutex_destroy(&w->lock);
+        }
+    }
+    if (rc != 0)
+    {
+        lw_close_bus(&w->bus);
+        errno = rc;
+        return -1;
+    }
+
+    pthread_attr_t attr;
+    rc = lw_worker_attr(&attr, config);
+    if (rc == 0)
+    {
+        w->started_us = lw_monotonic_us();
+        rc = pthread_create(&w->thread, &attr, lw_worker_main, w);
+        pthread_attr_destroy(&attr);
+    }
+    if (rc != 0)
+    {
+        pthread_cond_destroy(&w->done_cond);
+        pthread_cond_destroy(&w->work_cond);
+        pthread_mutex_destroy(&w->lock);
+        lw_close_bus(&w->bus);
+        errno = rc;
+        return -1;
+    }
+
+    ++rt->count;
+    return 0;
+}
+
+int lw_runtime_submit(lw_runtime *rt, unsigned int adapter, lw_job *job)
+{
+    if (!rt || !job || !job->fn)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_worker *w = lw_runtime_find(rt, adapter);
+    if (!w)
+    {
+        errno = ENODEV;
+        return -1;
+    }
+
+    job->result = 0;
+    job->error = 0;
+    job->done = 0;
+    job->owner = w;
+    job->next = NULL;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->stopping)
+    {
+        pthread_mutex_unlock(&w->lock);
+        errno = ESHUTDOWN;
+        return -1;
+    }
+    if (w->tail)
+    {
+        w->tail->next = job;
+    }
+    else
+    {
+        w->head = job;
+    }
+    w->tail = job;
+    ++w->queue_depth;
+    pthread_cond_signal(&w->work_cond);
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
+
+int lw_runtime_wait(lw_job *job)
+{
+    if (!job || !job->owner)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_worker *w = job->owner;
+    pthread_mutex_lock(&w->lock);
+    while (!job->done)
+    {
+        pthread_cond_wait(&w->done_cond, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    if (job->result < 0)
+    {
+        errno = job->error;
+    }
+    return job->result;
+}
+
+int lw_runtime_call(lw_runtime *rt, unsigned int adapter, lw_job_fn fn, void *arg)
+{
+    lw_job job;
+    memset(&job, 0, sizeof(job));
+    job.fn = fn;
+    job.arg = arg;
+
+    if (lw_runtime_submit(rt, adapter, &job) != 0)
+    {
+        return -1;
+    }
+    return lw_runtime_wait(&job);
+}
+
+int lw_runtime_get_stats(lw_runtime *rt, unsigned int adapter, lw_worker_stats *stats)
+{
+    if (!rt || !stats)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_worker *w = lw_runtime_find(rt, adapter);
+    if (!w)
+    {
+        errno = ENODEV;
+        return -1;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    stats->jobs = w->jobs;
+    stats->busy_us = w->busy_us;
+    stats->queue_depth = w->queue_depth;
+    pthread_mutex_unlock(&w->lock);
+    stats->elapsed_us = lw_monotonic_us() - w->started_us;
+    return 0;
+}
+
+void lw_runtime_shutdown(lw_runtime *rt)
+{
+    if (!rt)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < rt->count; ++i)
+    {
+        lw_worker *w = &rt->workers[i];
+        pthread_mutex_lock(&w->lock);
+        w->stopping = 1;
+        pthread_cond_signal(&w->work_cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    for (size_t i = 0; i < rt->count; ++i)
+    {
+        lw_worker *w = &rt->workers[i];
+        pthread_join(w->thread, NULL);
+        pthread_cond_destroy(&w->done_cond);
+        pthread_cond_destroy(&w->work_cond);
+        pthread_mutex_destroy(&w->lock);
+        lw_close_bus(&w->bus);
+    }
+
+    rt->count = 0;
+}
@@ -0,0 +1,372 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_sched.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/* Largest internal address the chunker can advance (bytes) */
+#define LW_SCHED_IADDR_MAX 8
+
+struct lw_sched_waiter
+{
+    struct lw_sched_waiter *next;
+    int priority;
+    uint64_t deadline_abs_us; /* 0 = no deadline */
+    uint64_t ticket;
+};
+
+static uint64_t lw_sched_deadline_from_tag(const lw_sched_tag *tag)
+{
+    if (!tag || tag->deadline_us == 0)
+    {
+        return 0;
+    }
+    return lw_monotonic_us() + tag->deadline_us;
+}
+
+/* Returns non-zero when `a` should run before `b` under `policy`. */
+static int lw_sched_before(lw_sched_policy policy,
+                           const struct lw_sched_waiter *a,
+                           const struct lw_sched_waiter *b)
+{
+    if (policy == LW_SCHED_EDF)
+    {
+        if (a->deadline_abs_us != b->deadline_abs_us)
+        {
+            if (a->deadline_abs_us == 0)
+            {
+                return 0;
+            }
+            if (b->deadline_abs_us == 0)
+            {
+                return 1;
+            }
+            return a->deadline_abs_us < b->deadline_abs_us;
+        }
+    }
+    else if (a->priority != b->priority)
+    {
+        return a->priority > b->priority;
+    }
+
+    return a->ticket < b->ticket;
+}
+
+static const struct lw_sched_waiter *lw_sched_best(const lw_sched *sched)
+{
+    const struct lw_sched_waiter *best = sched->waiters;
+    for (const struct lw_sched_waiter *w = sched->waiters; w; w = w->next)
+    {
+        if (lw_sched_before(sched->policy, w, best))
+        {
+            best = w;
+        }
+    }
+    return best;
+}
+
+static void lw_sched_unlink(lw_sched *sched, struct lw_sched_waiter *node)
+{
+    struct lw_sched_waiter **link = &sched->waiters;
+    while (*link && *link != node)
+    {
+        link = &(*link)->next;
+    }
+    if (*link)
+    {
+        *link = node->next;
+    }
+}
+
+static int lw_sched_acquire_abs(lw_sched *sched, int priority, uint64_t deadline_abs_us)
+{
+    pthread_mutex_lock(&sched->lock);
+
+    if (!sched->busy && !sched->waiters)
+    {
+        sched->busy = 1;
+        pthread_mutex_unlock(&sched->lock);
+        return 0;
+    }
+
+    struct lw_sched_waiter self;
+    self.priority = priority;
+    self.deadline_abs_us = deadline_abs_us;
+    self.ticket = sched->next_ticket++;
+    self.next = sched->waiters;
+    sched->waiters = &self;
+
+    while (sched->busy || lw_sched_best(sched) != &self)
+    {
+        pthread_cond_wait(&sched->cond, &sched->lock);
+    }
+
+    lw_sched_unlink(sched, &self);
+    sched->busy = 1;
+    pthread_mutex_unlock(&sched->lock);
+    return 0;
+}
+
+int lw_sched_init(lw_sched *sched, lw_i2c_bus *bus, lw_sched_policy policy)
+{
+    if (!sched || !bus || (policy != LW_SCHED_PRIORITY && policy != LW_SCHED_EDF))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(sched, 0, sizeof(*sched));
+    sched->bus = bus;
+    sched->policy = policy;
+    sched->chunk_size = LINUX_WIRE_SCHED_DEFAULT_CHUNK;
+
+    int rc = pthread_mutex_init(&sched->lock, NULL);
+    if (rc != 0)
+    {
+        errno = rc;
+        return -1;
+    }
+
+    rc = pthread_cond_init(&sched->cond, NULL);
+    if (rc != 0)
+    {
+        pthread_mutex_destroy(&sched->lock);
+        errno = rc;
+        return -1;
+    }
+
+    return 0;
+}
+
+void lw_sched_destroy(lw_sched *sched)
+{
+    if (!sched || !sched->bus)
+    {
+        return;
+    }
+    pthread_cond_destroy(&sched->cond);
+    pthread_mutex_destroy(&sched->lock);
+    sched->bus = NULL;
+}
+
+int lw_sched_set_chunk_size(lw_sched *sched, size_t chunk_size)
+{
+    if (!sched || chunk_size == 0 || chunk_size > UINT16_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Transfers in flight keep the size they started with */
+    __atomic_store_n(&sched->chunk_size, chunk_size, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int lw_sched_acquire(lw_sched *sched, const lw_sched_tag *tag)
+{
+    if (!sched || !sched->bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return lw_sched_acquire_abs(sched,
+                                tag ? tag->priority : 0,
+                                lw_sched_deadline_from_tag(tag));
+}
+
+void lw_sched_release(lw_sched *sched)
+{
+    if (!sched)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&sched->lock);
+    sched->busy = 0;
+    if (sched->waiters)
+    {
+        pthread_cond_broadcast(&sched->cond);
+    }
+    pthread_mutex_unlock(&sched->lock);
+}
+
+size_t lw_sched_waiting(lw_sched *sched)
+{
+    if (!sched)
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    pthread_mutex_lock(&sched->lock);
+    for (const struct lw_sched_waiter *w = sched->waiters; w; w = w->next)
+    {
+        ++count;
+    }
+    pthread_mutex_unlock(&sched->lock);
+    return count;
+}
+
+/* Add `delta` to a big-endian counter of `len` bytes (wraps silently). */
+static void lw_sched_advance_iaddr(uint8_t *iaddr, size_t len, size_t delta)
+{
+    uint64_t carry = delta;
+    for (size_t i = len; i > 0 && carry; --i)
+    {
+        uint64_t sum = (uint64_t)iaddr[i - 1] + (carry & 0xFF);
+        iaddr[i - 1] = (uint8_t)sum;
+        carry = (carry >> 8) + (sum >> 8);
+    }
+}
+
+static int lw_sched_validate(lw_sched *sched,
+                             size_t chunk_size,
+                             const uint8_t *iaddr,
+                             size_t iaddr_len,
+                             const void *data,
+                             size_t len)
+{
+    if (!sched || !sched->bus || !data || len == 0 || (iaddr_len > 0 && !iaddr))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Advancing the address is only needed (and only supported) when the
+       transfer actually spans several chunks. */
+    if (len > chunk_size && iaddr_len > LW_SCHED_IADDR_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+ssize_t lw_sched_ioctl_read(lw_sched *sched,
+                            const lw_sched_tag *tag,
+                            uint16_t addr,
+                            const uint8_t *iaddr,
+                            size_t iaddr_len,
+                            uint8_t *data,
+                            size_t len,
+                            uint16_t flags)
+{
+    const size_t chunk_size = sched ? __atomic_load_n(&sched->chunk_size, __ATOMIC_RELAXED) : 0;
+    if (lw_sched_validate(sched, chunk_size, iaddr, iaddr_len, data, len) != 0)
+    {
+        return -1;
+    }
+
+    if (len <= chunk_size)
+    {
+        lw_sched_acquire(sched, tag);
+        ssize_t r = lw_ioctl_read(sched->bus, addr, iaddr, iaddr_len, data, len, flags);
+        int saved_errno = errno;
+        lw_sched_release(sched);
+        errno = saved_errno;
+        return r;
+    }
+
+    const int priority = tag ? tag->priority : 0;
+    const uint64_t deadline = lw_sched_deadline_from_tag(tag);
+    uint8_t cursor[LW_SCHED_IADDR_MAX];
+    if (iaddr_len > 0)
+    {
+        memcpy(cursor, iaddr, iaddr_len);
+    }
+
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t chunk = len - done;
+        if (chunk > chunk_size)
+        {
+            chunk = chunk_size;
+        }
+
+        lw_sched_acquire_abs(sched, priority, deadline);
+        ssize_t r = lw_ioctl_read(sched->bus, addr,
+                                  iaddr_len > 0 ? cursor : NULL, iaddr_len,
+                                  data + done, chunk, flags);
+        int saved_errno = errno;
+        lw_sched_release(sched);
+
+        if (r < 0 || (size_t)r != chunk)
+        {
+            errno = (r < 0) ? saved_errno : EIO;
+            return -1;
+        }
+
+        done += chunk;
+        lw_sched_advance_iaddr(cursor, iaddr_len, chunk);
+    }
+
+    return (ssize_t)done;
+}
+
+ssize_t lw_sched_ioctl_write(lw_sched *sched,
+                             const lw_sched_tag *tag,
+                             uint16_t addr,
+                             const uint8_t *iaddr,
+                             size_t iaddr_len,
+                             const uint8_t *data,
+                             size_t len,
+                             uint16_t flags)
+{
+    const size_t chunk_size = sched ? __atomic_load_n(&sched->chunk_size, __ATOMIC_RELAXED) : 0;
+    if (lw_sched_validate(sched, chunk_size, iaddr, iaddr_len, data, len) != 0)
+    {
+        return -1;
+    }
+
+    if (len <= chunk_size)
+    {
+        lw_sched_acquire(sched, tag);
+        ssize_t w = lw_ioctl_write(sched->bus, addr, iaddr, iaddr_len, data, len, flags);
+        int saved_errno = errno;
+        lw_sched_release(sched);
+        errno = saved_errno;
+        return w;
+    }
+
+    const int priority = tag ? tag->priority : 0;
+    const uint64_t deadline = lw_sched_deadline_from_tag(tag);
+    uint8_t cursor[LW_SCHED_IADDR_MAX];
+    if (iaddr_len > 0)
+    {
+        memcpy(cursor, iaddr, iaddr_len);
+    }
+
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t chunk = len - done;
+        if (chunk > chunk_size)
+        {
+            chunk = chunk_size;
+        }
+
+        lw_sched_acquire_abs(sched, priority, deadline);
+        ssize_t w = lw_ioctl_write(sched->bus, addr,
+                                   iaddr_len > 0 ? cursor : NULL, iaddr_len,
+                                   data + done, chunk, flags);
+        int saved_errno = errno;
+        lw_sched_release(sched);
+
+        if (w < 0 || (size_t)w != chunk)
+        {
+            errno = (w < 0) ? saved_errno : EIO;
+            return -1;
+        }
+
+        done += chunk;
+        lw_sched_advance_iaddr(cursor, iaddr_len, chunk);
+    }
+
+    return (ssize_t)done;
+}
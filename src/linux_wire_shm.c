@@ -0,0 +1,334 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_shm.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Reader retries before reporting a stalled publisher */
+#define LW_SHM_READ_RETRIES 10000
+
+static lw_shm_slot *lw_shm_slots(lw_shm_segment *seg)
+{
+    return (lw_shm_slot *)(void *)(seg + 1);
+}
+
+static const lw_shm_slot *lw_shm_slots_const(const lw_shm_segment *seg)
+{
+    return (const lw_shm_slot *)(const void *)(seg + 1);
+}
+
+static size_t lw_shm_size(size_t count)
+{
+    return sizeof(lw_shm_segment) + count * sizeof(lw_shm_slot);
+}
+
+static int lw_shm_valid_name(const char *name)
+{
+    if (!name || name[0] != '/' || name[1] == '\0' || strchr(name + 1, '/'))
+    {
+        return 0;
+    }
+    return strlen(name) < LINUX_WIRE_SHM_NAME_MAX;
+}
+
+int lw_shm_publisher_open(lw_shm_publisher *pub,
+                          const char *name,
+                          const lw_shm_reg *regs,
+                          size_t count)
+{
+    if (!pub || !lw_shm_valid_name(name) || !regs || count == 0 || count > LINUX_WIRE_SHM_MAX_SLOTS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (regs[i].reg_len < 1 || regs[i].reg_len > 4 ||
+            regs[i].len == 0 || regs[i].len > LINUX_WIRE_SHM_VALUE_MAX)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    memset(pub, 0, sizeof(*pub));
+    const size_t size = lw_shm_size(count);
+
+    /* Replace any stale segment so readers never see a half-initialized one */
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        const int saved_errno = errno;
+        close(fd);
+        shm_unlink(name);
+        errno = saved_errno;
+        return -1;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int saved_errno = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        shm_unlink(name);
+        errno = saved_errno;
+        return -1;
+    }
+
+    lw_shm_segment *seg = (lw_shm_segment *)map;
+    lw_shm_slot *slots = lw_shm_slots(seg);
+    for (size_t i = 0; i < count; ++i)
+    {
+        slots[i].addr = regs[i].addr;
+        slots[i].reg = regs[i].reg;
+        slots[i].reg_len = regs[i].reg_len;
+        slots[i].len = regs[i].len;
+    }
+    seg->version = LINUX_WIRE_SHM_VERSION;
+    seg->slot_count = (uint32_t)count;
+    seg->slot_size = (uint32_t)sizeof(lw_shm_slot);
+    /* Magic last: a reader that sees it sees a complete layout */
+    __atomic_store_n(&seg->magic, LINUX_WIRE_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    strncpy(pub->name, name, sizeof(pub->name) - 1);
+    pub->seg = seg;
+    pub->map_size = size;
+    return 0;
+}
+
+/* Seqlock write: odd sequence while the slot is inconsistent */
+static void lw_shm_write_slot(lw_shm_slot *slot, const uint8_t *value, size_t len, int err, uint64_t now_us)
+{
+    const uint32_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (err == 0)
+    {
+        memcpy(slot->value, value, len);
+    }
+    slot->err = err;
+    slot->timestamp_us = now_us;
+    ++slot->updates;
+
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+int lw_shm_publish(lw_shm_publisher *pub, size_t slot, const uint8_t *value, size_t len, int err)
+{
+    if (!pub || !pub->seg || slot >= pub->seg->slot_count)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_shm_slot *s = &lw_shm_slots(pub->seg)[slot];
+    if (err == 0 && (!value || len != s->len))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_shm_write_slot(s, value, len, err, lw_monotonic_us());
+    return 0;
+}
+
+int lw_shm_publisher_poll(lw_shm_publisher *pub, lw_i2c_bus *bus)
+{
+    if (!pub || !pub->seg || !bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_shm_slot *slots = lw_shm_slots(pub->seg);
+    const size_t count = pub->seg->slot_count;
+    uint8_t values[LW_GATHER_MAX][LINUX_WIRE_SHM_VALUE_MAX];
+    lw_gather_item items[LW_GATHER_MAX];
+    int failed = 0;
+
+    size_t i = 0;
+    while (i < count)
+    {
+        /* Group consecutive slots of one device into a single transaction */
+        size_t n = 0;
+        while (i + n < count && n < LW_GATHER_MAX && slots[i + n].addr == slots[i].addr)
+        {
+            items[n].reg = slots[i + n].reg;
+            items[n].reg_len = slots[i + n].reg_len;
+            items[n].len = slots[i + n].len;
+            items[n].dst = values[n];
+            ++n;
+        }
+
+        const int err = lw_gather_read(bus, slots[i].addr, items, n) < 0 ? errno : 0;
+        const uint64_t now = lw_monotonic_us();
+        for (size_t k = 0; k < n; ++k)
+        {
+            lw_shm_write_slot(&slots[i + k], values[k], slots[i + k].len, err, now);
+        }
+        if (err)
+        {
+            failed += (int)n;
+        }
+        i += n;
+    }
+    return failed;
+}
+
+void lw_shm_publisher_close(lw_shm_publisher *pub, int unlink_segment)
+{
+    if (!pub || !pub->seg)
+    {
+        return;
+    }
+    munmap(pub->seg, pub->map_size);
+    if (unlink_segment)
+    {
+        shm_unlink(pub->name);
+    }
+    pub->seg = NULL;
+    pub->map_size = 0;
+}
+
+int lw_shm_reader_open(lw_shm_reader *reader, const char *name)
+{
+    if (!reader || !lw_shm_valid_name(name))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    reader->seg = NULL;
+    reader->map_size = 0;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        const int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+    const size_t size = (size_t)st.st_size;
+    if (size < sizeof(lw_shm_segment))
+    {
+        close(fd);
+        errno = EPROTO;
+        return -1;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int saved_errno = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        errno = saved_errno;
+        return -1;
+    }
+
+    const lw_shm_segment *seg = (const lw_shm_segment *)map;
+    if (__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != LINUX_WIRE_SHM_MAGIC ||
+        seg->version != LINUX_WIRE_SHM_VERSION ||
+        seg->slot_size != sizeof(lw_shm_slot) ||
+        seg->slot_count > LINUX_WIRE_SHM_MAX_SLOTS ||
+        lw_shm_size(seg->slot_count) > size)
+    {
+        munmap(map, size);
+        errno = EPROTO;
+        return -1;
+    }
+
+    reader->seg = seg;
+    reader->map_size = size;
+    return 0;
+}
+
+size_t lw_shm_reader_slots(const lw_shm_reader *reader)
+{
+    return (reader && reader->seg) ? reader->seg->slot_count : 0;
+}
+
+int lw_shm_find(const lw_shm_reader *reader, uint16_t addr, uint32_t reg)
+{
+    const size_t count = lw_shm_reader_slots(reader);
+    if (count > 0)
+    {
+        const lw_shm_slot *slots = lw_shm_slots_const(reader->seg);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (slots[i].addr == addr && slots[i].reg == reg)
+            {
+                return (int)i;
+            }
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int lw_shm_read(const lw_shm_reader *reader, size_t slot, lw_shm_sample *sample)
+{
+    if (!sample || slot >= lw_shm_reader_slots(reader))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const lw_shm_slot *s = &lw_shm_slots_const(reader->seg)[slot];
+    for (int attempt = 0; attempt < LW_SHM_READ_RETRIES; ++attempt)
+    {
+        const uint32_t before = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (before & 1U)
+        {
+            continue; /* update in progress */
+        }
+
+        sample->addr = s->addr;
+        sample->reg = s->reg;
+        sample->len = s->len;
+        sample->err = s->err;
+        sample->timestamp_us = s->timestamp_us;
+        sample->updates = s->updates;
+        memcpy(sample->value, s->value, sizeof(sample->value));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == before)
+        {
+            return 0;
+        }
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+void lw_shm_reader_close(lw_shm_reader *reader)
+{
+    if (!reader || !reader->seg)
+    {
+        return;
+    }
+    munmap((void *)reader->seg, reader->map_size);
+    reader->seg = NULL;
+    reader->map_size = 0;
+}
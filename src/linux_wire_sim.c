@@ -0,0 +1,615 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_sim.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#define LW_SIM_DEFAULT_HZ 100000u
+
+/* ---- Models -------------------------------------------------------------- */
+
+static int lw_sim_eeprom_write(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_eeprom *m = (lw_sim_eeprom *)dev;
+    (void)stretch_ns;
+    if (now_ns < m->busy_until_ns)
+    {
+        return -1;
+    }
+
+    size_t i = 0;
+    if (len > 0)
+    {
+        uint32_t ptr = 0;
+        for (; i < len && i < m->addr_bytes; ++i)
+        {
+            ptr = (ptr << 8) | data[i];
+        }
+        m->ptr = (uint32_t)(ptr % m->size);
+    }
+    for (; i < len; ++i)
+    {
+        /* Bytes wrap within the page the pointer was set in */
+        const uint32_t page = m->ptr / m->page_size;
+        if (m->latched > 0 && page != m->latch_page)
+        {
+            memset(m->latch_set, 0, sizeof(m->latch_set));
+            m->latched = 0;
+        }
+        const uint32_t offset = m->ptr % m->page_size;
+        m->latch_page = page;
+        m->latch[offset] = data[i];
+        if (!m->latch_set[offset])
+        {
+            m->latch_set[offset] = 1;
+            ++m->latched;
+        }
+        m->ptr = page * m->page_size + (offset + 1) % m->page_size;
+    }
+    return 0;
+}
+
+static int lw_sim_eeprom_read(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_eeprom *m = (lw_sim_eeprom *)dev;
+    (void)stretch_ns;
+    if (now_ns < m->busy_until_ns)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        data[i] = m->mem[m->ptr];
+        m->ptr = (uint32_t)((m->ptr + 1) % m->size);
+    }
+    return 0;
+}
+
+static void lw_sim_eeprom_stop(lw_sim_device *dev, uint64_t now_ns)
+{
+    lw_sim_eeprom *m = (lw_sim_eeprom *)dev;
+    if (m->latched == 0)
+    {
+        return;
+    }
+
+    const size_t base = (size_t)m->latch_page * m->page_size;
+    for (uint16_t i = 0; i < m->page_size; ++i)
+    {
+        if (m->latch_set[i])
+        {
+            m->mem[base + i] = m->latch[i];
+        }
+    }
+    memset(m->latch_set, 0, sizeof(m->latch_set));
+    m->latched = 0;
+    m->busy_until_ns = now_ns + (uint64_t)m->write_cycle_us * 1000ULL;
+    ++m->writes;
+}
+
+static const lw_sim_ops lw_sim_eeprom_ops = {lw_sim_eeprom_write, lw_sim_eeprom_read, lw_sim_eeprom_stop};
+
+static int lw_sim_regs_write(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_regs *m = (lw_sim_regs *)dev;
+    (void)now_ns;
+    (void)stretch_ns;
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    m->inc = m->inc_bit == 0 || (data[0] & m->inc_bit);
+    m->ptr = (uint8_t)(data[0] & ~m->inc_bit);
+    for (size_t i = 1; i < len; ++i)
+    {
+        m->regs[m->ptr % m->count] = data[i];
+        m->ptr = (uint8_t)(m->ptr + m->inc);
+    }
+    return 0;
+}
+
+static int lw_sim_regs_read(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_regs *m = (lw_sim_regs *)dev;
+    (void)now_ns;
+    (void)stretch_ns;
+    for (size_t i = 0; i < len; ++i)
+    {
+        data[i] = m->regs[m->ptr % m->count];
+        m->ptr = (uint8_t)(m->ptr + m->inc);
+    }
+    return 0;
+}
+
+static const lw_sim_ops lw_sim_regs_ops = {lw_sim_regs_write, lw_sim_regs_read, NULL};
+
+/* Queue every frame sampled up to `now_ns` */
+static void lw_sim_imu_sample(lw_sim_imu *m, uint64_t now_ns)
+{
+    if (m->sample_hz == 0)
+    {
+        return;
+    }
+
+    const uint64_t due = (now_ns / 1000ULL) * m->sample_hz / 1000000ULL;
+    while (m->frames < due)
+    {
+        if (m->head - m->tail + m->frame_size > m->capacity)
+        {
+            /* Nothing drains the FIFO meanwhile: the rest are lost too */
+            m->overflows += due - m->frames;
+            m->frames = due;
+            break;
+        }
+        for (uint16_t i = 0; i < m->frame_size; ++i)
+        {
+            m->fifo[m->head++ % m->capacity] = (uint8_t)(m->frames * m->frame_size + i);
+        }
+        ++m->frames;
+    }
+}
+
+static int lw_sim_imu_write(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_imu *m = (lw_sim_imu *)dev;
+    (void)stretch_ns;
+    lw_sim_imu_sample(m, now_ns);
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    m->ptr = data[0];
+    for (size_t i = 1; i < len; ++i)
+    {
+        /* Only sampling fills the FIFO: a byte written to data_reg is dropped */
+        if (m->ptr != m->data_reg)
+        {
+            m->regs[m->ptr] = data[i];
+        }
+        ++m->ptr;
+    }
+    return 0;
+}
+
+static int lw_sim_imu_read(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_imu *m = (lw_sim_imu *)dev;
+    (void)stretch_ns;
+    lw_sim_imu_sample(m, now_ns);
+
+    const size_t level = m->head - m->tail;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (m->ptr == m->data_reg)
+        {
+            data[i] = (m->head != m->tail) ? m->fifo[m->tail++ % m->capacity] : 0;
+            continue;
+        }
+        if (m->ptr == m->count_reg)
+        {
+            data[i] = (uint8_t)(level >> 8);
+        }
+        else if (m->ptr == (uint8_t)(m->count_reg + 1))
+        {
+            data[i] = (uint8_t)level;
+        }
+        else
+        {
+            data[i] = m->regs[m->ptr];
+        }
+        ++m->ptr;
+    }
+    return 0;
+}
+
+static const lw_sim_ops lw_sim_imu_ops = {lw_sim_imu_write, lw_sim_imu_read, NULL};
+
+static int lw_sim_mux_write(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_mux *m = (lw_sim_mux *)dev;
+    (void)now_ns;
+    (void)stretch_ns;
+    if (len > 0)
+    {
+        m->control = data[len - 1];
+        ++m->selects;
+    }
+    return 0;
+}
+
+static int lw_sim_mux_read(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_mux *m = (lw_sim_mux *)dev;
+    (void)now_ns;
+    (void)stretch_ns;
+    memset(data, m->control, len);
+    return 0;
+}
+
+static const lw_sim_ops lw_sim_mux_ops = {lw_sim_mux_write, lw_sim_mux_read, NULL};
+
+static int lw_sim_stretch_write(lw_sim_device *dev, const uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_stretch *m = (lw_sim_stretch *)dev;
+    (void)data;
+    (void)stretch_ns;
+    if (len > 0)
+    {
+        m->converting = 1;
+        m->ready_ns = now_ns + (uint64_t)m->conversion_us * 1000ULL;
+        ++m->conversions;
+    }
+    return 0;
+}
+
+static int lw_sim_stretch_read(lw_sim_device *dev, uint8_t *data, size_t len, uint64_t now_ns, uint64_t *stretch_ns)
+{
+    lw_sim_stretch *m = (lw_sim_stretch *)dev;
+    if (m->converting)
+    {
+        if (m->ready_ns > now_ns)
+        {
+            *stretch_ns += m->ready_ns - now_ns;
+        }
+        m->converting = 0;
+    }
+    for (size_t i = 0; i < len; ++i)
+    {
+        data[i] = m->result[i % m->result_len];
+    }
+    return 0;
+}
+
+static const lw_sim_ops lw_sim_stretch_ops = {lw_sim_stretch_write, lw_sim_stretch_read, NULL};
+
+/* ---- Bus ----------------------------------------------------------------- */
+
+static int lw_sim_visible(const lw_sim_device *dev)
+{
+    for (; dev->parent; dev = dev->parent)
+    {
+        if (!(((const lw_sim_mux *)dev->parent)->control & (1u << dev->channel)))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static lw_sim_device *lw_sim_lookup(lw_sim_bus *sim, uint16_t addr)
+{
+    for (lw_sim_device *dev = sim->devices; dev; dev = dev->next)
+    {
+        if (dev->addr == addr && lw_sim_visible(dev))
+        {
+            return dev;
+        }
+    }
+    return NULL;
+}
+
+static int lw_sim_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    lw_sim_bus *sim = (lw_sim_bus *)arg;
+    lw_sim_device *touched[LW_MAX_MSGS];
+    size_t touched_count = 0;
+    int err = 0;
+
+    pthread_mutex_lock(&sim->lock);
+    if (sim->realtime)
+    {
+        const uint64_t wall = lw_monotonic_ns() - sim->epoch_ns;
+        if (wall > sim->now_ns)
+        {
+            sim->now_ns = wall;
+        }
+    }
+
+    const uint64_t bit_ns = 1000000000ULL / sim->bus_hz;
+    const uint64_t start_ns = sim->now_ns;
+    uint64_t t = start_ns + sim->overhead_ns;
+    for (size_t i = 0; i < count && err == 0; ++i)
+    {
+        /* (Repeated) START plus the address byte and its ACK */
+        t += 10 * bit_ns;
+        lw_sim_device *dev = lw_sim_lookup(sim, msgs[i].addr);
+        if (!dev)
+        {
+            err = ENXIO;
+            break;
+        }
+        if (!dev->touched && touched_count < LW_MAX_MSGS)
+        {
+            dev->touched = 1;
+            touched[touched_count++] = dev;
+        }
+
+        uint64_t stretch = 0;
+        const int rc = (msgs[i].flags & LW_MSG_RD)
+                           ? dev->ops->read(dev, msgs[i].buf, msgs[i].len, t, &stretch)
+                           : dev->ops->write(dev, msgs[i].buf, msgs[i].len, t, &stretch);
+        if (rc != 0)
+        {
+            err = ENXIO;
+            break;
+        }
+        if (sim->timeout_us > 0 && stretch > (uint64_t)sim->timeout_us * 1000ULL)
+        {
+            t += (uint64_t)sim->timeout_us * 1000ULL;
+            err = ETIMEDOUT;
+            break;
+        }
+        t += stretch + 9ULL * bit_ns * msgs[i].len;
+        sim->bytes += msgs[i].len;
+        ++sim->messages;
+    }
+
+    /* STOP */
+    t += bit_ns;
+    for (size_t i = 0; i < touched_count; ++i)
+    {
+        touched[i]->touched = 0;
+        if (touched[i]->ops->stop)
+        {
+            touched[i]->ops->stop(touched[i], t);
+        }
+    }
+
+    sim->now_ns = t;
+    sim->busy_ns += t - start_ns;
+    ++sim->transactions;
+    if (err == ENXIO)
+    {
+        ++sim->nacks;
+    }
+    else if (err == ETIMEDOUT)
+    {
+        ++sim->timeouts;
+    }
+    if (sim->realtime)
+    {
+        lw_sleep_until_ns(sim->epoch_ns + t);
+    }
+    pthread_mutex_unlock(&sim->lock);
+
+    if (err != 0)
+    {
+        errno = err;
+        return -1;
+    }
+    return (int)count;
+}
+
+int lw_sim_init(lw_sim_bus *sim, uint32_t bus_hz)
+{
+    if (!sim)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(sim, 0, sizeof(*sim));
+    const int rc = pthread_mutex_init(&sim->lock, NULL);
+    if (rc != 0)
+    {
+        errno = rc;
+        return -1;
+    }
+    sim->bus_hz = bus_hz ? bus_hz : LW_SIM_DEFAULT_HZ;
+    return 0;
+}
+
+void lw_sim_destroy(lw_sim_bus *sim)
+{
+    if (sim)
+    {
+        pthread_mutex_destroy(&sim->lock);
+    }
+}
+
+int lw_sim_open(lw_sim_bus *sim, lw_i2c_bus *bus, const char *label)
+{
+    if (!sim)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return lw_open_backend(bus, label ? label : "/dev/i2c-sim", lw_sim_transfer, sim);
+}
+
+int lw_sim_attach(lw_sim_bus *sim, lw_sim_device *dev, lw_sim_device *mux, uint8_t channel)
+{
+    if (!sim || !dev || !dev->ops || !dev->ops->write || !dev->ops->read || channel > 7 ||
+        (mux && mux->ops != &lw_sim_mux_ops))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&sim->lock);
+    int mux_found = (mux == NULL);
+    lw_sim_device **tail = &sim->devices;
+    for (; *tail; tail = &(*tail)->next)
+    {
+        if (*tail == dev)
+        {
+            pthread_mutex_unlock(&sim->lock);
+            errno = EEXIST;
+            return -1;
+        }
+        mux_found |= (*tail == mux);
+    }
+    if (!mux_found)
+    {
+        pthread_mutex_unlock(&sim->lock);
+        errno = EINVAL;
+        return -1;
+    }
+
+    dev->next = NULL;
+    dev->parent = mux;
+    dev->channel = channel;
+    dev->touched = 0;
+    *tail = dev;
+    pthread_mutex_unlock(&sim->lock);
+    return 0;
+}
+
+int lw_sim_add(lw_sim_bus *sim, lw_sim_device *dev)
+{
+    return lw_sim_attach(sim, dev, NULL, 0);
+}
+
+void lw_sim_set_realtime(lw_sim_bus *sim, int enable)
+{
+    if (!sim)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&sim->lock);
+    sim->realtime = enable ? 1 : 0;
+    if (sim->realtime)
+    {
+        sim->epoch_ns = lw_monotonic_ns() - sim->now_ns;
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+void lw_sim_advance(lw_sim_bus *sim, uint64_t us)
+{
+    if (!sim)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&sim->lock);
+    sim->now_ns += us * 1000ULL;
+    pthread_mutex_unlock(&sim->lock);
+}
+
+uint64_t lw_sim_now_us(lw_sim_bus *sim)
+{
+    if (!sim)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&sim->lock);
+    uint64_t now = sim->now_ns;
+    if (sim->realtime)
+    {
+        const uint64_t wall = lw_monotonic_ns() - sim->epoch_ns;
+        now = wall > now ? wall : now;
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return now / 1000ULL;
+}
+
+static void lw_sim_device_init(lw_sim_device *dev, uint16_t addr, const lw_sim_ops *ops)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->addr = addr;
+    dev->ops = ops;
+}
+
+int lw_sim_eeprom_init(lw_sim_eeprom *m,
+                       uint16_t addr,
+                       uint8_t *mem,
+                       size_t size,
+                       uint16_t page_size,
+                       uint8_t addr_bytes,
+                       uint32_t write_cycle_us)
+{
+    if (!m || !mem || size == 0 || page_size == 0 || page_size > LINUX_WIRE_SIM_PAGE_MAX ||
+        size % page_size != 0 || addr_bytes < 1 || addr_bytes > 2 ||
+        size > ((size_t)1 << (8u * addr_bytes)))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    lw_sim_device_init(&m->dev, addr, &lw_sim_eeprom_ops);
+    m->mem = mem;
+    m->size = size;
+    m->page_size = page_size;
+    m->addr_bytes = addr_bytes;
+    m->write_cycle_us = write_cycle_us;
+    return 0;
+}
+
+int lw_sim_regs_init(lw_sim_regs *m, uint16_t addr, uint8_t *regs, size_t count, uint8_t inc_bit)
+{
+    if (!m || !regs || count == 0 || count > 256)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    lw_sim_device_init(&m->dev, addr, &lw_sim_regs_ops);
+    m->regs = regs;
+    m->count = count;
+    m->inc_bit = inc_bit;
+    m->inc = 1;
+    return 0;
+}
+
+int lw_sim_imu_init(lw_sim_imu *m, uint16_t addr, uint16_t frame_size, uint32_t sample_hz, uint16_t capacity)
+{
+    if (!m || frame_size == 0 || capacity == 0 || capacity > LINUX_WIRE_SIM_FIFO_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    lw_sim_device_init(&m->dev, addr, &lw_sim_imu_ops);
+    m->count_reg = 0x72;
+    m->data_reg = 0x74;
+    m->frame_size = frame_size;
+    m->sample_hz = sample_hz;
+    m->capacity = capacity;
+    return 0;
+}
+
+int lw_sim_mux_init(lw_sim_mux *m, uint16_t addr)
+{
+    if (!m)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    lw_sim_device_init(&m->dev, addr, &lw_sim_mux_ops);
+    return 0;
+}
+
+int lw_sim_stretch_init(lw_sim_stretch *m,
+                        uint16_t addr,
+                        uint32_t conversion_us,
+                        const uint8_t *result,
+                        uint8_t result_len)
+{
+    if (!m || !result || result_len == 0 || result_len > LINUX_WIRE_SIM_RESULT_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    lw_sim_device_init(&m->dev, addr, &lw_sim_stretch_ops);
+    m->conversion_us = conversion_us;
+    memcpy(m->result, result, result_len);
+    m->result_len = result_len;
+    return 0;
+}
@@ -0,0 +1,283 @@
+#define _GNU_SOURCE /* ppoll */
+
+#include "linux_wire_watch.h"
+#include "linux_wire_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Every register is fetched by a single lw_gather_read() */
+_Static_assert(LINUX_WIRE_WATCH_MAX_REGS <= LW_GATHER_MAX, "LINUX_WIRE_WATCH_MAX_REGS exceeds LW_GATHER_MAX");
+
+/* Bytes drained from the trigger fd per wake-up (16 GPIO v2 line events) */
+#define LW_WATCH_DRAIN_BYTES 768
+
+int lw_watch_init(lw_watcher *watcher, lw_i2c_bus *bus, uint16_t addr)
+{
+    if (!watcher || !bus)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(watcher, 0, sizeof(*watcher));
+    watcher->bus = bus;
+    watcher->addr = addr;
+    watcher->trigger_fd = -1;
+    return 0;
+}
+
+int lw_watch_add(lw_watcher *watcher,
+                 uint32_t reg,
+                 uint8_t reg_len,
+                 uint8_t len,
+                 lw_watch_fn fn,
+                 void *arg)
+{
+    if (!watcher || !fn || reg_len < 1 || reg_len > 4 ||
+        len == 0 || len > LINUX_WIRE_WATCH_VALUE_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (watcher->count >= LINUX_WIRE_WATCH_MAX_REGS)
+    {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    lw_watch_reg *r = &watcher->regs[watcher->count];
+    memset(r, 0, sizeof(*r));
+    r->reg = reg;
+    r->reg_len = reg_len;
+    r->len = len;
+    r->fn = fn;
+    r->arg = arg;
+    return (int)watcher->count++;
+}
+
+int lw_watch_use_gpio(lw_watcher *watcher, const char *chip_path, unsigned int line, unsigned int edges)
+{
+    if (!watcher || !chip_path || strncmp(chip_path, "/dev/gpiochip", 13) != 0 ||
+        edges == 0 || (edges & ~(LW_WATCH_EDGE_RISING | LW_WATCH_EDGE_FALLING)) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    strncpy(req.consumer, "linux-wire", sizeof(req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    if (edges & LW_WATCH_EDGE_RISING)
+    {
+        req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+    }
+    if (edges & LW_WATCH_EDGE_FALLING)
+    {
+        req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    }
+
+    int chip = open(chip_path, O_RDONLY | O_CLOEXEC);
+    if (chip < 0)
+    {
+        return -1;
+    }
+
+    int rc = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req);
+    int saved_errno = errno;
+    close(chip);
+    if (rc < 0)
+    {
+        errno = saved_errno;
+        return -1;
+    }
+
+    lw_watch_close(watcher);
+    watcher->trigger_fd = req.fd;
+    watcher->owns_fd = 1;
+    return 0;
+#else
+    (void)line;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int lw_watch_use_fd(lw_watcher *watcher, int fd)
+{
+    if (!watcher || fd < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_watch_close(watcher);
+    watcher->trigger_fd = fd;
+    watcher->owns_fd = 0;
+    return 0;
+}
+
+int lw_watch_set_period(lw_watcher *watcher, uint32_t period_us)
+{
+    if (!watcher)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    watcher->period_us = period_us;
+    watcher->next_poll_us = 0; /* first poll is due immediately */
+    return 0;
+}
+
+int lw_watch_sample(lw_watcher *watcher)
+{
+    if (!watcher || watcher->count == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lw_gather_item items[LINUX_WIRE_WATCH_MAX_REGS];
+    for (size_t i = 0; i < watcher->count; ++i)
+    {
+        items[i].reg = watcher->regs[i].reg;
+        items[i].reg_len = watcher->regs[i].reg_len;
+        items[i].len = watcher->regs[i].len;
+        items[i].dst = watcher->regs[i].scratch;
+    }
+
+    if (lw_gather_read(watcher->bus, watcher->addr, items, watcher->count) < 0)
+    {
+        return -1;
+    }
+    ++watcher->reads;
+
+    int fired = 0;
+    for (size_t i = 0; i < watcher->count; ++i)
+    {
+        lw_watch_reg *r = &watcher->regs[i];
+        if (r->has_value && memcmp(r->value, r->scratch, r->len) == 0)
+        {
+            continue;
+        }
+        memcpy(r->value, r->scratch, r->len);
+        r->has_value = 1;
+        ++watcher->changes;
+        ++fired;
+        r->fn(watcher, i, r->value, r->len, r->arg);
+    }
+    return fired;
+}
+
+int lw_watch_run_once(lw_watcher *watcher, int timeout_ms)
+{
+    if (!watcher || watcher->count == 0 ||
+        (watcher->trigger_fd < 0 && watcher->period_us == 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Wait for the earlier of the caller's timeout and the next poll */
+    const uint64_t now = lw_monotonic_us();
+    uint64_t wait_us = UINT64_MAX;
+    if (timeout_ms >= 0)
+    {
+        wait_us = (uint64_t)timeout_ms * 1000ULL;
+    }
+    if (watcher->period_us)
+    {
+        const uint64_t until = watcher->next_poll_us > now ? watcher->next_poll_us - now : 0;
+        if (until < wait_us)
+        {
+            wait_us = until;
+        }
+    }
+
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+    if (wait_us != UINT64_MAX)
+    {
+        ts.tv_sec = (time_t)(wait_us / 1000000ULL);
+        ts.tv_nsec = (long)(wait_us % 1000000ULL) * 1000L;
+        tsp = &ts;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = watcher->trigger_fd;
+    pfd.events = POLLIN | POLLPRI;
+    pfd.revents = 0;
+    const nfds_t nfds = watcher->trigger_fd >= 0 ? 1 : 0;
+
+    int rc = ppoll(nfds ? &pfd : NULL, nfds, tsp, NULL);
+    if (rc < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int triggered = 0;
+    if (rc > 0)
+    {
+        if (pfd.revents & (POLLERR | POLLNVAL))
+        {
+            errno = EIO;
+            return -1;
+        }
+        /* Consume the pending edge events (or stand-in bytes) */
+        uint8_t drain[LW_WATCH_DRAIN_BYTES];
+        if (read(watcher->trigger_fd, drain, sizeof(drain)) < 0 && errno != EAGAIN)
+        {
+            return -1;
+        }
+        triggered = 1;
+    }
+
+    if (watcher->period_us)
+    {
+        const uint64_t after = lw_monotonic_us();
+        if (after >= watcher->next_poll_us)
+        {
+            triggered = 1;
+        }
+        if (triggered)
+        {
+            /* Any read restarts the period; an interrupt-driven read makes
+               the next periodic one unnecessary. */
+            watcher->next_poll_us = after + watcher->period_us;
+        }
+    }
+
+    if (!triggered)
+    {
+        return 0;
+    }
+
+    ++watcher->triggers;
+    return lw_watch_sample(watcher);
+}
+
+void lw_watch_close(lw_watcher *watcher)
+{
+    if (!watcher)
+    {
+        return;
+    }
+    if (watcher->owns_fd && watcher->trigger_fd >= 0)
+    {
+        close(watcher->trigger_fd);
+    }
+    watcher->trigger_fd = -1;
+    watcher->owns_fd = 0;
+}
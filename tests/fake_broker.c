@@ -0,0 +1,126 @@
+/*
+ * Test helper for the Python bindings: serves a fake 24C02-style EEPROM
+ * through a broker on each socket path given on the command line, one
+ * broker thread per path. 0x50 answers immediately, 0x51 (same memory)
+ * takes 200 ms per transaction. Prints "ready" once every socket is
+ * listening and exits when stdin is closed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_broker.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FAKE_MAX_BUSES 4
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint8_t regs[256];
+    uint8_t ptr;
+} fake_eeprom;
+
+typedef struct
+{
+    fake_eeprom dev;
+    lw_i2c_bus bus;
+    lw_broker broker;
+    pthread_t thread;
+} fake_bus;
+
+static int fake_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    fake_eeprom *dev = (fake_eeprom *)arg;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (msgs[i].addr != 0x50 && msgs[i].addr != 0x51)
+        {
+            errno = ENXIO;
+            return -1;
+        }
+    }
+    if (msgs[0].addr == 0x51)
+    {
+        struct timespec ts = {0, 200 * 1000000L};
+        nanosleep(&ts, NULL);
+    }
+
+    pthread_mutex_lock(&dev->lock);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (msgs[i].flags & LW_MSG_RD)
+        {
+            for (uint16_t j = 0; j < msgs[i].len; ++j)
+            {
+                msgs[i].buf[j] = dev->regs[dev->ptr++];
+            }
+            continue;
+        }
+        if (msgs[i].len == 0)
+        {
+            continue;
+        }
+        dev->ptr = msgs[i].buf[0];
+        for (uint16_t j = 1; j < msgs[i].len; ++j)
+        {
+            dev->regs[dev->ptr++] = msgs[i].buf[j];
+        }
+    }
+    pthread_mutex_unlock(&dev->lock);
+    return (int)count;
+}
+
+static void *serve(void *arg)
+{
+    lw_broker_run(&((fake_bus *)arg)->broker);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static fake_bus buses[FAKE_MAX_BUSES];
+    const int count = argc - 1;
+    if (count < 1 || count > FAKE_MAX_BUSES)
+    {
+        fprintf(stderr, "usage: %s socket_path ...\n", argv[0]);
+        return 2;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        fake_bus *b = &buses[i];
+        pthread_mutex_init(&b->dev.lock, NULL);
+        for (int r = 0; r < 256; ++r)
+        {
+            b->dev.regs[r] = (uint8_t)r;
+        }
+        if (lw_open_backend(&b->bus, "/dev/i2c-fake", fake_transfer, &b->dev) != 0 ||
+            lw_broker_init(&b->broker, &b->bus, argv[i + 1]) != 0)
+        {
+            fprintf(stderr, "fake_broker: %s: %s\n", argv[i + 1], strerror(errno));
+            return 1;
+        }
+        lw_set_error_logging(&b->bus, 0);
+        pthread_create(&b->thread, NULL, serve, b);
+    }
+    puts("ready");
+    fflush(stdout);
+
+    while (getchar() != EOF)
+    {
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        lw_broker_stop(&buses[i].broker);
+        pthread_join(buses[i].thread, NULL);
+        lw_broker_destroy(&buses[i].broker);
+        lw_close_bus(&buses[i].bus);
+    }
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
+#include <deque>
 
 extern "C"
 {
@@ -21,10 +22,28 @@ namespace
         int failSetSlaveErrno = ENXIO;
         bool failWrite = false;
         int failWriteErrno = EIO;
+        std::deque<std::vector<uint8_t>> transferReadQueue;
+        bool failTransfer = false;
+        int failTransferErrno = EIO;
+        bool failWaitReady = false;
+        int failWaitReadyErrno = ETIMEDOUT;
     };
 
     MockLinuxWireState g_state;
     MockConfig g_config;
+
+    /* Read payload for the next combined transaction: the next queued
+       buffer, or the ioctl read data when nothing is queued */
+    std::vector<uint8_t> nextTransferReadData()
+    {
+        if (g_config.transferReadQueue.empty())
+        {
+            return g_config.ioctlReadData;
+        }
+        std::vector<uint8_t> data = g_config.transferReadQueue.front();
+        g_config.transferReadQueue.pop_front();
+        return data;
+    }
 } // namespace
 
 void mockLinuxWireReset()
@@ -76,6 +95,33 @@ void mockLinuxWireClearWriteError()
     g_config.failWrite = false;
 }
 
+void mockLinuxWireQueueTransferReadData(const std::vector<uint8_t> &data)
+{
+    g_config.transferReadQueue.push_back(data);
+}
+
+void mockLinuxWireForceTransferError(int err)
+{
+    g_config.failTransfer = true;
+    g_config.failTransferErrno = err;
+}
+
+void mockLinuxWireClearTransferError()
+{
+    g_config.failTransfer = false;
+}
+
+void mockLinuxWireForceWaitReadyError(int err)
+{
+    g_config.failWaitReady = true;
+    g_config.failWaitReadyErrno = err;
+}
+
+void mockLinuxWireClearWaitReadyError()
+{
+    g_config.failWaitReady = false;
+}
+
 const MockLinuxWireState &mockLinuxWireState()
 {
     return g_state;
@@ -97,6 +143,15 @@ extern "C"
         bus->device_path[LINUX_WIRE_DEVICE_PATH_MAX - 1] = '\0';
         bus->timeout_us = 0;
         bus->log_errors = 1;
+        bus->pool = nullptr;
+        bus->rt_flags = 0;
+        bus->errors = nullptr;
+        std::memset(&bus->caps, 0, sizeof(bus->caps));
+        bus->observer = nullptr;
+        bus->observer_arg = nullptr;
+        bus->backend = nullptr;
+        bus->backend_arg = nullptr;
+        bus->slave_addr = 0;
         g_state.lastDevicePath = device_path;
         g_state.lastTimeoutUs = 0;
         g_state.logErrors = 1;
@@ -173,6 +228,12 @@ ssize_t lw_write(lw_i2c_bus * /*bus*/, const uint8_t *data, size_t len, int /*se
         g_state.lastIoctlAddr = addr;
         g_state.lastIoctlInternal.assign(iaddr, iaddr + iaddr_len);
 
+        if (g_config.failRead)
+        {
+            errno = g_config.failReadErrno;
+            return -1;
+        }
+
         const size_t to_copy = std::min(len, g_config.ioctlReadData.size());
         if (to_copy > 0)
         {
@@ -195,9 +256,93 @@ ssize_t lw_ioctl_write(lw_i2c_bus * /*bus*/,
     g_state.lastWriteBuffer.insert(g_state.lastWriteBuffer.end(), data, data + len);
     g_state.lastWriteWasIoctl = true;
     g_state.lastWriteSlaveAddr = static_cast<uint8_t>(addr);
+    ++g_state.ioctlWriteCalls;
+    g_state.ioctlWriteAddrs.push_back(addr);
+    g_state.ioctlWrites.push_back(g_state.lastWriteBuffer);
     return static_cast<ssize_t>(len);
 }
 
+int lw_transfer(lw_i2c_bus * /*bus*/, const lw_msg *msgs, size_t count)
+{
+    ++g_state.transferCalls;
+    g_state.lastTransfer.clear();
+    if (g_config.failTransfer)
+    {
+        errno = g_config.failTransferErrno;
+        return -1;
+    }
+
+    /* Read messages are filled in order from one payload */
+    const std::vector<uint8_t> source = nextTransferReadData();
+    size_t readOffset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        MockTransferMsg msg;
+        msg.addr = msgs[i].addr;
+        msg.flags = msgs[i].flags;
+        if (msgs[i].flags & LW_MSG_RD)
+        {
+            msg.data.resize(msgs[i].len);
+            for (uint16_t j = 0; j < msgs[i].len; ++j)
+            {
+                const size_t src = readOffset++;
+                msgs[i].buf[j] = src < source.size() ? source[src] : 0;
+            }
+        }
+        else
+        {
+            msg.data.assign(msgs[i].buf, msgs[i].buf + msgs[i].len);
+        }
+        g_state.lastTransfer.push_back(msg);
+    }
+    return static_cast<int>(count);
+}
+
+ssize_t lw_gather_read(lw_i2c_bus * /*bus*/,
+                       uint16_t addr,
+                       const lw_gather_item *items,
+                       size_t count)
+{
+    ++g_state.gatherReadCalls;
+    g_state.lastGatherAddr = addr;
+    g_state.lastGatherRegs.clear();
+    if (g_config.failTransfer)
+    {
+        errno = g_config.failTransferErrno;
+        return -1;
+    }
+
+    const std::vector<uint8_t> source = nextTransferReadData();
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        g_state.lastGatherRegs.push_back(items[i].reg);
+        for (uint16_t j = 0; j < items[i].len; ++j, ++offset)
+        {
+            items[i].dst[j] = offset < source.size() ? source[offset] : 0;
+        }
+    }
+    return static_cast<ssize_t>(offset);
+}
+
+int lw_wait_ready(lw_i2c_bus * /*bus*/,
+                  uint16_t addr,
+                  uint32_t timeout_us,
+                  uint32_t interval_us,
+                  unsigned int /*options*/)
+{
+    ++g_state.waitReadyCalls;
+    g_state.lastWaitReadyAddr = addr;
+    g_state.lastWaitReadyTimeoutUs = timeout_us;
+    g_state.lastWaitReadyIntervalUs = interval_us;
+    if (g_config.failWaitReady)
+    {
+        errno = g_config.failWaitReadyErrno;
+        return -1;
+    }
+    return 0;
+}
+
 int lw_set_timeout(lw_i2c_bus *bus, uint32_t timeout_us)
 {
     ++g_state.setTimeoutCalls;
@@ -4,6 +4,13 @@
 #include <string>
 #include <vector>
 
+struct MockTransferMsg
+{
+    uint16_t addr = 0;
+    uint16_t flags = 0;
+    std::vector<uint8_t> data; /* payload for writes, requested size for reads */
+};
+
 struct MockLinuxWireState
 {
     int openCalls = 0;
@@ -24,6 +31,18 @@ struct MockLinuxWireState
     int ioctlReadCalls = 0;
     uint16_t lastIoctlAddr = 0;
     std::vector<uint8_t> lastIoctlInternal;
+    int ioctlWriteCalls = 0;
+    std::vector<uint16_t> ioctlWriteAddrs;
+    std::vector<std::vector<uint8_t>> ioctlWrites;
+    int transferCalls = 0;
+    std::vector<MockTransferMsg> lastTransfer;
+    int gatherReadCalls = 0;
+    uint16_t lastGatherAddr = 0;
+    std::vector<uint32_t> lastGatherRegs;
+    int waitReadyCalls = 0;
+    uint16_t lastWaitReadyAddr = 0;
+    uint32_t lastWaitReadyTimeoutUs = 0;
+    uint32_t lastWaitReadyIntervalUs = 0;
 };
 
 void mockLinuxWireReset();
@@ -35,4 +54,9 @@ void mockLinuxWireForceSetSlaveError(int err);
 void mockLinuxWireClearSetSlaveError();
 void mockLinuxWireForceWriteError(int err);
 void mockLinuxWireClearWriteError();
+void mockLinuxWireQueueTransferReadData(const std::vector<uint8_t> &data);
+void mockLinuxWireForceTransferError(int err);
+void mockLinuxWireClearTransferError();
+void mockLinuxWireForceWaitReadyError(int err);
+void mockLinuxWireClearWaitReadyError();
 const MockLinuxWireState &mockLinuxWireState();
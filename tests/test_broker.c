@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_broker.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define EXPECT_ERR(call, err)       \
+    do                              \
+    {                               \
+        errno = 0;                  \
+        assert((call) == -1);       \
+        assert(errno == (err));     \
+    } while (0)
+
+/* 24C02-style device at 0x50 behind the broker's backend bus */
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint8_t regs[256];
+    uint8_t ptr;
+    uint8_t log[64];
+    size_t logged;
+} fake_eeprom;
+
+static int fake_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    fake_eeprom *dev = (fake_eeprom *)arg;
+    pthread_mutex_lock(&dev->lock);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (msgs[i].addr != 0x50)
+        {
+            pthread_mutex_unlock(&dev->lock);
+            errno = ENXIO;
+            return -1;
+        }
+        if (msgs[i].flags & LW_MSG_RD)
+        {
+            for (uint16_t j = 0; j < msgs[i].len; ++j)
+            {
+                msgs[i].buf[j] = dev->regs[dev->ptr++];
+            }
+            continue;
+        }
+        if (msgs[i].len == 0)
+        {
+            continue;
+        }
+        dev->ptr = msgs[i].buf[0];
+        if (msgs[i].len > 1 && dev->logged < sizeof(dev->log))
+        {
+            dev->log[dev->logged++] = msgs[i].buf[0];
+        }
+        for (uint16_t j = 1; j < msgs[i].len; ++j)
+        {
+            dev->regs[dev->ptr++] = msgs[i].buf[j];
+        }
+    }
+    pthread_mutex_unlock(&dev->lock);
+    return (int)count;
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void *serve(void *arg)
+{
+    assert(lw_broker_run((lw_broker *)arg) == 0);
+    return NULL;
+}
+
+typedef struct
+{
+    const char *path;
+    uint8_t reg;
+    uint8_t priority;
+    pthread_barrier_t *barrier;
+    lw_broker_client client;
+} writer_job;
+
+/* Connect, (optionally) meet the test at a barrier, write one byte */
+static void *write_one(void *arg)
+{
+    writer_job *job = (writer_job *)arg;
+    lw_i2c_bus bus;
+    assert(lw_broker_connect(&job->client, &bus, job->path) == 0);
+    job->client.priority = job->priority;
+    if (job->barrier)
+    {
+        pthread_barrier_wait(job->barrier);
+    }
+    const uint8_t value = 0xEE;
+    assert(lw_ioctl_write(&bus, 0x50, &job->reg, 1, &value, 1, 0) == 1);
+    lw_broker_disconnect(&job->client);
+    return NULL;
+}
+
+static void test_round_trip_and_holds(const char *path)
+{
+    fake_eeprom dev;
+    memset(&dev, 0, sizeof(dev));
+    pthread_mutex_init(&dev.lock, NULL);
+    lw_i2c_bus dev_bus;
+    assert(lw_open_backend(&dev_bus, "/dev/i2c-9", fake_transfer, &dev) == 0);
+    lw_set_error_logging(&dev_bus, 0);
+    strcpy(dev_bus.caps.name, "fake adapter");
+    dev_bus.caps.flags = LW_CAPS_NAME;
+
+    lw_broker broker;
+    assert(lw_broker_init(&broker, &dev_bus, path) == 0);
+    broker.hold_us = 50000;
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, serve, &broker) == 0);
+
+    /* Same API as a local adapter, same identity */
+    lw_broker_client client;
+    lw_i2c_bus bus;
+    assert(lw_broker_connect(&client, &bus, path) == 0);
+    assert(strcmp(bus.device_path, "/dev/i2c-9") == 0);
+    assert(strcmp(bus.caps.name, "fake adapter") == 0);
+    lw_set_error_logging(&bus, 0);
+
+    uint8_t reg = 0x10;
+    const uint8_t data[3] = {1, 2, 3};
+    uint8_t back[3] = {0};
+    assert(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 3, 0) == 3);
+    assert(lw_ioctl_read(&bus, 0x50, &reg, 1, back, 3, 0) == 3);
+    assert(memcmp(back, data, 3) == 0);
+
+    assert(lw_set_slave(&bus, 0x50) == 0);
+    reg = 0x11;
+    assert(lw_write(&bus, &reg, 1, 1) == 1);
+    assert(lw_read(&bus, back, 2) == 2);
+    assert(back[0] == 2 && back[1] == 3);
+
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x51, &reg, 1, back, 1, 0), ENXIO);
+
+    static uint8_t big[2][3000];
+    lw_msg too_big[2] = {{0x50, 0, 3000, big[0]}, {0x50, LW_MSG_RD, 3000, big[1]}};
+    EXPECT_ERR(lw_transfer(&bus, too_big, 2), EMSGSIZE);
+
+    /* Sleeping (eventfd) path instead of spinning */
+    client.spin_us = 0;
+    for (int i = 0; i < 50; ++i)
+    {
+        reg = 0x10;
+        assert(lw_ioctl_read(&bus, 0x50, &reg, 1, back, 1, 0) == 1);
+        assert(back[0] == 1);
+    }
+    client.spin_us = LINUX_WIRE_BROKER_SPIN_US;
+
+    /* A held sequence is not interleaved with another client's writes */
+    writer_job other = {path, 0x30, 0, NULL, {0}};
+    assert(lw_broker_begin(&client) == 0);
+    reg = 0x20;
+    assert(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 1, 0) == 1);
+    pthread_t other_thread;
+    assert(pthread_create(&other_thread, NULL, write_one, &other) == 0);
+    sleep_ms(20);
+    reg = 0x21;
+    assert(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 1, 0) == 1);
+    assert(lw_broker_end(&client) == 0);
+    pthread_join(other_thread, NULL);
+    pthread_mutex_lock(&dev.lock);
+    assert(dev.logged >= 3);
+    assert(dev.log[dev.logged - 3] == 0x20);
+    assert(dev.log[dev.logged - 2] == 0x21);
+    assert(dev.log[dev.logged - 1] == 0x30);
+    pthread_mutex_unlock(&dev.lock);
+
+    /* An idle holder loses the bus, and its sequence fails visibly */
+    assert(lw_broker_begin(&client) == 0);
+    reg = 0x22;
+    assert(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 1, 0) == 1);
+    sleep_ms(120);
+    EXPECT_ERR(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 1, 0), ETIMEDOUT);
+    assert(lw_broker_end(&client) == 0);
+    assert(lw_ioctl_write(&bus, 0x50, &reg, 1, data, 1, 0) == 1);
+
+    lw_broker_stop(&broker);
+    pthread_join(thread, NULL);
+    assert(broker.hold_timeouts == 1);
+    assert(broker.failures == 2); /* ENXIO and ETIMEDOUT; EMSGSIZE never leaves the client */
+    assert(broker.requests > 50);
+    lw_broker_destroy(&broker);
+    assert(access(path, F_OK) != 0);
+
+    /* Broker gone: calls fail instead of hanging */
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x50, &reg, 1, back, 1, 0), ECONNRESET);
+    lw_broker_disconnect(&client);
+    assert(bus.backend == NULL);
+
+    lw_close_bus(&dev_bus);
+    pthread_mutex_destroy(&dev.lock);
+}
+
+static void test_priority_order(const char *path)
+{
+    fake_eeprom dev;
+    memset(&dev, 0, sizeof(dev));
+    pthread_mutex_init(&dev.lock, NULL);
+    lw_i2c_bus dev_bus;
+    assert(lw_open_backend(&dev_bus, "/dev/i2c-9", fake_transfer, &dev) == 0);
+
+    lw_broker broker;
+    assert(lw_broker_init(&broker, &dev_bus, path) == 0);
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 3);
+    writer_job low = {path, 0x40, 1, &barrier, {0}};
+    writer_job high = {path, 0x41, 200, &barrier, {0}};
+    pthread_t threads[2];
+    assert(pthread_create(&threads[0], NULL, write_one, &low) == 0);
+    assert(pthread_create(&threads[1], NULL, write_one, &high) == 0);
+
+    for (int i = 0; i < 100 && broker.clients < 2; ++i)
+    {
+        assert(lw_broker_run_once(&broker, 100) == 0);
+    }
+    assert(broker.clients == 2);
+    pthread_barrier_wait(&barrier);
+
+    /* Both requests queued before the broker looks at either */
+    struct pollfd pfd[2] = {{low.client.req_fd, POLLIN, 0}, {high.client.req_fd, POLLIN, 0}};
+    for (int i = 0; i < 2; ++i)
+    {
+        assert(poll(&pfd[i], 1, 5000) == 1);
+    }
+    assert(lw_broker_run_once(&broker, 0) == 2);
+    assert(broker.wakeups == 1);
+
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    assert(dev.logged == 2 && dev.log[0] == 0x41 && dev.log[1] == 0x40);
+
+    pthread_barrier_destroy(&barrier);
+    lw_broker_destroy(&broker);
+    lw_close_bus(&dev_bus);
+    pthread_mutex_destroy(&dev.lock);
+}
+
+int main(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/lw_broker_%ld.sock", (long)getpid());
+
+    lw_broker broker;
+    lw_i2c_bus closed;
+    memset(&closed, 0, sizeof(closed));
+    closed.fd = -1;
+    EXPECT_ERR(lw_broker_init(&broker, &closed, path), EINVAL);
+    lw_broker_client client;
+    lw_i2c_bus bus;
+    EXPECT_ERR(lw_broker_connect(&client, &bus, path), ENOENT);
+    EXPECT_ERR(lw_broker_begin(&client), EINVAL);
+
+    test_round_trip_and_holds(path);
+    test_priority_order(path);
+
+    puts("linux_wire broker tests passed");
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "linux_wire_combine.h"
+#include "mock_linux_wire.h"
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static void testFrameMergesConsecutiveRegisters()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb; // PCA9685: LED0_ON_L 0x06 .. LED15_OFF_H 0x45
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    assert(lw_combine_begin(&comb) == 0);
+    for (uint8_t i = 0; i < 64; ++i)
+    {
+        const uint8_t value = static_cast<uint8_t>(0xA0 + i);
+        assert(lw_combine_write(&bus, &comb, 0x40, 0x06 + i, 1, &value, 1) == 0);
+    }
+    assert(mockLinuxWireState().transferCalls == 0);
+    assert(lw_combine_pending(&comb) == 1);
+
+    assert(lw_combine_commit(&bus, &comb) == 0);
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 1);
+    assert(state.lastTransfer[0].addr == 0x40);
+    assert(state.lastTransfer[0].data.size() == 65);
+    assert(state.lastTransfer[0].data[0] == 0x06);
+    assert(state.lastTransfer[0].data[1] == 0xA0);
+    assert(state.lastTransfer[0].data[64] == 0xDF);
+    assert(comb.writes == 64 && comb.merged == 63 && comb.transactions == 1);
+    assert(lw_combine_pending(&comb) == 0);
+}
+
+static void testOnlyContiguousTailWritesMerge()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb; // LIS3DH-style: bit 7 of the sub-address enables increment
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x19, 1, 0x80) == 0);
+
+    const uint8_t a = 0x57, b = 0x08, c = 0x01, d = 0x02;
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x20, 1, &a, 1) == 0);
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x21, 1, &b, 1) == 0); // merged
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x21, 1, &c, 1) == 0); // overlap: new run
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x23, 1, &d, 1) == 0); // gap: new run
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x22, 1, &d, 1) == 0); // not the tail
+    assert(lw_combine_pending(&comb) == 4);
+    assert(lw_combine_flush(&bus, &comb) == 0);
+
+    const auto &msgs = mockLinuxWireState().lastTransfer;
+    assert(msgs.size() == 4);
+    assert(msgs[0].data == std::vector<uint8_t>({0xA0, 0x57, 0x08}));
+    assert(msgs[1].data == std::vector<uint8_t>({0x21, 0x01}));
+    assert(msgs[2].data == std::vector<uint8_t>({0x23, 0x02}));
+    assert(msgs[3].data == std::vector<uint8_t>({0x22, 0x02}));
+    assert(comb.merged == 1);
+}
+
+static void testUndeclaredDeviceWritesKeepTheirStop()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x19, 1, 0) == 0);
+
+    // A PCA9548 channel select only takes effect on STOP
+    const uint8_t a = 0x57, channel = 0x04;
+    assert(lw_combine_write(&bus, &comb, 0x19, 0x20, 1, &a, 1) == 0);
+    assert(lw_combine_write_msg(&bus, &comb, 0x70, &channel, 1) == 0);
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1 && state.lastTransfer.size() == 1);
+    assert(state.lastTransfer[0].addr == 0x19);
+    assert(state.ioctlWriteCalls == 1);
+    assert(state.ioctlWrites[0] == std::vector<uint8_t>({0x04}));
+
+    // Register form too, with nothing buffered: no flush transaction
+    assert(lw_combine_write(&bus, &comb, 0x50, 0x0010, 2, &a, 1) == 0);
+    assert(state.transferCalls == 1 && state.ioctlWriteCalls == 2);
+    assert(state.ioctlWrites[1] == std::vector<uint8_t>({0x00, 0x10, 0x57}));
+    assert(lw_combine_pending(&comb) == 0);
+    assert(comb.writes == 3 && comb.transactions == 3);
+}
+
+static void testRawMessagesParseDeclaredRegister()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x50, 2, 0) == 0);
+
+    const uint8_t first[] = {0x01, 0x00, 0xAA, 0xBB};
+    const uint8_t second[] = {0x01, 0x02, 0xCC};
+    const uint8_t pointer[] = {0x01, 0x03};
+    assert(lw_combine_write_msg(&bus, &comb, 0x50, first, sizeof(first)) == 0);
+    assert(lw_combine_write_msg(&bus, &comb, 0x50, second, sizeof(second)) == 0);
+    assert(lw_combine_write_msg(&bus, &comb, 0x50, pointer, sizeof(pointer)) == 0);
+    assert(lw_combine_flush(&bus, &comb) == 0);
+
+    const auto &msgs = mockLinuxWireState().lastTransfer;
+    assert(msgs.size() == 2);
+    assert(msgs[0].data == std::vector<uint8_t>({0x01, 0x00, 0xAA, 0xBB, 0xCC}));
+    assert(msgs[1].data == std::vector<uint8_t>({0x01, 0x03}));
+}
+
+static void testReadSendsWritesInSameTransaction()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x68, 1, 0) == 0);
+
+    const uint8_t cfg[] = {0x03, 0x18};
+    assert(lw_combine_write(&bus, &comb, 0x68, 0x1A, 1, cfg, 1) == 0);
+    assert(lw_combine_write(&bus, &comb, 0x68, 0x1B, 1, cfg + 1, 1) == 0);
+
+    mockLinuxWireQueueTransferReadData({0x12, 0x34});
+    uint8_t out[2] = {0, 0};
+    assert(lw_combine_read(&bus, &comb, 0x68, 0x3B, 1, out, sizeof(out)) == 2);
+    assert(out[0] == 0x12 && out[1] == 0x34);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 3);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0x1A, 0x03, 0x18}));
+    assert(state.lastTransfer[1].data == std::vector<uint8_t>({0x3B}));
+    assert(state.lastTransfer[2].flags == LW_MSG_RD);
+    assert(lw_combine_pending(&comb) == 0);
+}
+
+static void testWindowDeadlineAndFrames()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 2000) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    const uint8_t v = 0x10;
+    assert(lw_combine_write(&bus, &comb, 0x40, 0x00, 1, &v, 1) == 0);
+    assert(lw_combine_poll(&bus, &comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    assert(lw_combine_poll(&bus, &comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 1);
+
+    /* A late write flushes the expired batch before buffering itself */
+    assert(lw_combine_write(&bus, &comb, 0x40, 0x01, 1, &v, 1) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    assert(lw_combine_write(&bus, &comb, 0x40, 0x02, 1, &v, 1) == 0);
+    assert(mockLinuxWireState().transferCalls == 2);
+    assert(lw_combine_pending(&comb) == 1);
+
+    /* An open frame holds writes past the window */
+    assert(lw_combine_begin(&comb) == 0);
+    assert(lw_combine_begin(&comb) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    assert(lw_combine_poll(&bus, &comb) == 0);
+    assert(lw_combine_commit(&bus, &comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 2);
+    assert(lw_combine_commit(&bus, &comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 3);
+
+    errno = 0;
+    assert(lw_combine_commit(&bus, &comb) == -1);
+    assert(errno == EINVAL);
+}
+
+static void testFullBufferAndOversizedWrites()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x20, 1, 0) == 0);
+
+    const uint8_t v = 0x55;
+    for (int i = 0; i <= LINUX_WIRE_COMBINE_MAX_RUNS; ++i)
+    {
+        assert(lw_combine_write(&bus, &comb, 0x20, 0x00, 1, &v, 1) == 0);
+    }
+    assert(mockLinuxWireState().transferCalls == 1);
+    assert(mockLinuxWireState().lastTransfer.size() == LINUX_WIRE_COMBINE_MAX_RUNS);
+    assert(lw_combine_pending(&comb) == 1);
+
+    std::vector<uint8_t> big(LINUX_WIRE_COMBINE_RUN_MAX + 1, 0xEE);
+    assert(lw_combine_write(&bus, &comb, 0x50, 0x0010, 2, big.data(), big.size()) == 0);
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 2);
+    assert(state.ioctlWriteCalls == 1);
+    assert(state.ioctlWrites[0].size() == big.size() + 2);
+    assert(state.ioctlWrites[0][0] == 0x00 && state.ioctlWrites[0][1] == 0x10);
+    assert(lw_combine_pending(&comb) == 0);
+}
+
+static void testFailedFlushDropsBatch()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    const uint8_t v = 0x01;
+    assert(lw_combine_write(&bus, &comb, 0x40, 0x00, 1, &v, 1) == 0);
+    mockLinuxWireForceTransferError(EIO);
+    errno = 0;
+    assert(lw_combine_flush(&bus, &comb) == -1);
+    assert(errno == EIO);
+    assert(lw_combine_pending(&comb) == 0);
+    mockLinuxWireClearTransferError();
+
+    assert(lw_combine_flush(&bus, &comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 1);
+}
+
+static void testInvalidArguments()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_combiner comb;
+    assert(lw_combine_init(nullptr, 0) == -1);
+    assert(lw_combine_init(&comb, 0) == 0);
+
+    errno = 0;
+    assert(lw_combine_add_device(&comb, 0x40, 0, 0) == -1);
+    assert(errno == EINVAL);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0x100) == -1);
+    for (uint16_t addr = 0; addr < LINUX_WIRE_COMBINE_MAX_DEVICES; ++addr)
+    {
+        assert(lw_combine_add_device(&comb, addr, 1, 0) == 0);
+    }
+    assert(lw_combine_add_device(&comb, 0x00, 2, 0) == 0); // redeclare
+    errno = 0;
+    assert(lw_combine_add_device(&comb, 0x77, 1, 0) == -1);
+    assert(errno == ENOSPC);
+
+    const uint8_t v = 0;
+    assert(lw_combine_write(&bus, &comb, 0x40, 0, 5, &v, 1) == -1);
+    assert(lw_combine_write(&bus, &comb, 0x40, 0, 1, &v, 0) == -1);
+    assert(lw_combine_write_msg(&bus, &comb, 0x40, nullptr, 1) == -1);
+    uint8_t out;
+    assert(lw_combine_read(&bus, &comb, 0x40, 0, 5, &out, 1) == -1);
+    assert(lw_combine_pending(&comb) == 0);
+    assert(mockLinuxWireState().transferCalls == 0);
+}
+
+int main()
+{
+    testFrameMergesConsecutiveRegisters();
+    testOnlyContiguousTailWritesMerge();
+    testUndeclaredDeviceWritesKeepTheirStop();
+    testRawMessagesParseDeclaredRegister();
+    testReadSendsWritesInSameTransaction();
+    testWindowDeadlineAndFrames();
+    testFullBufferAndOversizedWrites();
+    testFailedFlushDropsBatch();
+    testInvalidArguments();
+
+    std::puts("linux_wire combine tests passed");
+    return 0;
+}
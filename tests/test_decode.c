@@ -0,0 +1,142 @@
+#include "linux_wire_decode.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_SAMPLES 37
+
+static int16_t reference_i16(const uint8_t *p, lw_endian endian)
+{
+    return (int16_t)(endian == LW_BIG_ENDIAN ? (p[0] << 8) | p[1] : (p[1] << 8) | p[0]);
+}
+
+static void test_i16_matches_reference_for_all_tails(void)
+{
+    uint8_t buf[2 * MAX_SAMPLES];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+    {
+        buf[i] = (uint8_t)rand();
+    }
+    buf[0] = 0x80; /* make sure the most negative value is covered */
+    buf[1] = 0x00;
+
+    for (int e = 0; e < 2; ++e)
+    {
+        const lw_endian endian = (lw_endian)e;
+        for (size_t count = 0; count <= MAX_SAMPLES; ++count)
+        {
+            int16_t ints[MAX_SAMPLES];
+            float floats[MAX_SAMPLES];
+            assert(lw_decode_i16(buf, count, endian, ints) == 0);
+            assert(lw_decode_i16_to_float(buf, count, endian, 0.5f, floats) == 0);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const int16_t expected = reference_i16(buf + 2 * i, endian);
+                assert(ints[i] == expected);
+                assert(floats[i] == (float)expected * 0.5f);
+            }
+        }
+    }
+}
+
+static void test_generic_formats(void)
+{
+    /* 24-bit big-endian signed (pressure/ADC style) */
+    const uint8_t be24[6] = {0xFF, 0xFF, 0xFE, 0x12, 0x34, 0x56};
+    lw_sample_format fmt24 = {3, LW_BIG_ENDIAN, 0, 0, 1, 1.0f, 0.0f};
+    int32_t out[4];
+    assert(lw_decode_samples(&fmt24, be24, 2, out) == 0);
+    assert(out[0] == -2);
+    assert(out[1] == 0x123456);
+
+    /* 12-bit left-justified little-endian accelerometer words */
+    const uint8_t le12[4] = {0xF0, 0xFF, 0x10, 0x00}; /* -1, +1 */
+    lw_sample_format fmt12 = {2, LW_LITTLE_ENDIAN, 12, 4, 1, 0.001f, 0.0f};
+    assert(lw_decode_samples(&fmt12, le12, 2, out) == 0);
+    assert(out[0] == -1);
+    assert(out[1] == 1);
+
+    /* 32-bit little-endian unsigned into float with offset */
+    const uint8_t le32[4] = {0x10, 0x00, 0x00, 0x00};
+    lw_sample_format fmt32 = {4, LW_LITTLE_ENDIAN, 0, 0, 0, 2.0f, -1.0f};
+    float f;
+    assert(lw_decode_samples_float(&fmt32, le32, 1, &f) == 0);
+    assert(f == 31.0f);
+
+    /* Plain i16 takes the vector path and still applies the offset */
+    uint8_t words[2 * 9];
+    for (size_t i = 0; i < 9; ++i)
+    {
+        words[2 * i] = 0x00;
+        words[2 * i + 1] = (uint8_t)i;
+    }
+    lw_sample_format fmt16 = {2, LW_BIG_ENDIAN, 0, 0, 1, 0.25f, 10.0f};
+    float floats[9];
+    assert(lw_decode_samples_float(&fmt16, words, 9, floats) == 0);
+    for (size_t i = 0; i < 9; ++i)
+    {
+        assert(fabsf(floats[i] - ((float)i * 0.25f + 10.0f)) < 1e-6f);
+    }
+}
+
+static void test_strided_frames(void)
+{
+    /* Frame: 1 header byte, X/Y/Z big-endian i16, 1 trailing byte */
+    uint8_t fifo[2 * 8];
+    const int16_t xyz[2][3] = {{100, -200, 300}, {-1, 0, 32767}};
+    for (int f = 0; f < 2; ++f)
+    {
+        uint8_t *frame = fifo + f * 8;
+        frame[0] = 0xAA;
+        for (int c = 0; c < 3; ++c)
+        {
+            frame[1 + 2 * c] = (uint8_t)((uint16_t)xyz[f][c] >> 8);
+            frame[2 + 2 * c] = (uint8_t)((uint16_t)xyz[f][c] & 0xFF);
+        }
+        frame[7] = 0x55;
+    }
+
+    lw_sample_format fmt = {2, LW_BIG_ENDIAN, 0, 0, 1, 1.0f, 0.0f};
+    float out[6];
+    assert(lw_decode_frames_float(&fmt, fifo + 1, 2, 8, 3, out) == 0);
+    for (int f = 0; f < 2; ++f)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            assert(out[f * 3 + c] == (float)xyz[f][c]);
+        }
+    }
+
+    errno = 0;
+    assert(lw_decode_frames_float(&fmt, fifo, 2, 4, 3, out) == -1);
+    assert(errno == EINVAL);
+}
+
+static void test_invalid_arguments(void)
+{
+    int16_t out;
+    lw_sample_format bad = {5, LW_BIG_ENDIAN, 0, 0, 1, 1.0f, 0.0f};
+    int32_t wide;
+    errno = 0;
+    assert(lw_decode_i16(NULL, 1, LW_BIG_ENDIAN, &out) == -1 && errno == EINVAL);
+    assert(lw_decode_samples(&bad, (const uint8_t *)"", 1, &wide) == -1);
+    bad.width = 2;
+    bad.shift = 4;
+    bad.bits = 13;
+    assert(lw_decode_samples(&bad, (const uint8_t *)"ab", 1, &wide) == -1);
+}
+
+int main(void)
+{
+    test_i16_matches_reference_for_all_tails();
+    test_generic_formats();
+    test_strided_frames();
+    test_invalid_arguments();
+
+    puts("linux_wire decode tests passed");
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "linux_wire_eeprom.h"
+#include "mock_linux_wire.h"
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static void testWriteSplitsAtPageBoundaries()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 2, 32, 4096) == 0);
+    dev.poll_interval_us = 0;
+
+    std::vector<uint8_t> image(80);
+    for (std::size_t i = 0; i < image.size(); ++i)
+    {
+        image[i] = static_cast<uint8_t>(i);
+    }
+
+    assert(lw_eeprom_write(&bus, &dev, 0x001C, image.data(), image.size()) == 80);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlWriteCalls == 4);
+    const std::size_t expectedSizes[4] = {4, 32, 32, 12};
+    const uint16_t expectedAddrs[4] = {0x001C, 0x0020, 0x0040, 0x0060};
+    for (int i = 0; i < 4; ++i)
+    {
+        const auto &frame = state.ioctlWrites[i];
+        assert(frame.size() == 2 + expectedSizes[i]);
+        assert(frame[0] == (expectedAddrs[i] >> 8));
+        assert(frame[1] == (expectedAddrs[i] & 0xFF));
+        assert(state.ioctlWriteAddrs[i] == 0x50);
+    }
+    assert(state.ioctlWrites[1][2] == 4); // first byte of the second page
+
+    // One ACK poll before each follow-on page plus one for the final cycle.
+    assert(state.waitReadyCalls == 4);
+    assert(state.ioctlReadCalls == 0);
+}
+
+static void testAckPollingUsesDeviceTiming()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 2, 64, 0) == 0);
+    dev.write_cycle_us = 3000;
+    dev.poll_interval_us = 25;
+
+    const uint8_t byte = 0xA5;
+    assert(lw_eeprom_write(&bus, &dev, 0x0100, &byte, 1) == 1);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.waitReadyCalls == 1);
+    assert(state.lastWaitReadyAddr == 0x50);
+    assert(state.lastWaitReadyTimeoutUs == 3000);
+    assert(state.lastWaitReadyIntervalUs == 25);
+}
+
+static void testAckPollingTimesOut()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 2, 16, 0) == 0);
+
+    mockLinuxWireForceWaitReadyError(ETIMEDOUT);
+    const uint8_t data[20] = {0};
+    errno = 0;
+    assert(lw_eeprom_write(&bus, &dev, 0, data, sizeof(data)) == -1);
+    assert(errno == ETIMEDOUT);
+    assert(mockLinuxWireState().ioctlWriteCalls == 1); // second page never sent
+    mockLinuxWireClearWaitReadyError();
+}
+
+static void testBlockSelectSpillBits()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_eeprom dev; // 24C16: 8 blocks of 256 bytes, 16-byte pages
+    assert(lw_eeprom_init(&dev, 0x50, 1, 16, 2048) == 0);
+    dev.addr_spill_bits = 3;
+    dev.poll_interval_us = 0;
+
+    const uint8_t data[4] = {1, 2, 3, 4};
+    assert(lw_eeprom_write(&bus, &dev, 0x3FE, data, sizeof(data)) == 4);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlWriteCalls == 2);
+    assert(state.ioctlWriteAddrs[0] == 0x53);
+    assert(state.ioctlWrites[0][0] == 0xFE);
+    assert(state.ioctlWriteAddrs[1] == 0x54);
+    assert(state.ioctlWrites[1][0] == 0x00);
+
+    assert(lw_eeprom_write(&bus, &dev, 2046, data, sizeof(data)) == -1);
+    assert(errno == EINVAL);
+}
+
+static void testReadSplitsAtTransferAndBlockLimits()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(std::vector<uint8_t>(128, 0xEE));
+    lw_i2c_bus bus = openMockBus();
+
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 1, 16, 2048) == 0);
+    dev.addr_spill_bits = 3;
+    dev.max_transfer = 128;
+
+    std::vector<uint8_t> out(300);
+    assert(lw_eeprom_read(&bus, &dev, 0xF0, out.data(), out.size()) == 300);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlReadCalls == 4); // 16 + 128 + 128 + 28
+    assert(state.lastIoctlAddr == 0x52); // last chunk starts at 0x200
+    assert(state.lastIoctlInternal.size() == 1);
+    assert(state.lastIoctlInternal[0] == 0x00);
+    assert(out[299] == 0xEE);
+}
+
+static void testInitRejectsBadGeometry()
+{
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 3, 32, 0) == -1);
+    assert(lw_eeprom_init(&dev, 0x50, 2, 0, 0) == -1);
+    assert(lw_eeprom_init(&dev, 0x50, 2, LINUX_WIRE_EEPROM_PAGE_MAX + 1, 0) == -1);
+    assert(lw_eeprom_init(nullptr, 0x50, 2, 32, 0) == -1);
+}
+
+int main()
+{
+    testWriteSplitsAtPageBoundaries();
+    testAckPollingUsesDeviceTiming();
+    testAckPollingTimesOut();
+    testBlockSelectSpillBits();
+    testReadSplitsAtTransferAndBlockLimits();
+    testInitRejectsBadGeometry();
+
+    std::puts("linux_wire eeprom tests passed");
+    return 0;
+}
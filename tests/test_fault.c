@@ -0,0 +1,373 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_fault.h"
+#include "linux_wire_sim.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define EXPECT_ERR(call, err)       \
+    do                              \
+    {                               \
+        errno = 0;                  \
+        assert((call) == -1);       \
+        assert(errno == (err));     \
+    } while (0)
+
+/* Two register devices on a simulated bus, reached through an injector */
+typedef struct
+{
+    lw_sim_bus sim;
+    uint8_t regs_a[16];
+    uint8_t regs_b[16];
+    lw_sim_regs dev_a;
+    lw_sim_regs dev_b;
+    lw_i2c_bus lower;
+    lw_fault fault;
+    lw_i2c_bus bus;
+} fixture;
+
+static void fixture_open(fixture *f, uint64_t seed)
+{
+    memset(f, 0, sizeof(*f));
+    assert(lw_sim_init(&f->sim, 400000) == 0);
+    assert(lw_sim_regs_init(&f->dev_a, 0x48, f->regs_a, sizeof(f->regs_a), 0) == 0);
+    assert(lw_sim_regs_init(&f->dev_b, 0x68, f->regs_b, sizeof(f->regs_b), 0) == 0);
+    assert(lw_sim_add(&f->sim, &f->dev_a.dev) == 0);
+    assert(lw_sim_add(&f->sim, &f->dev_b.dev) == 0);
+    assert(lw_sim_open(&f->sim, &f->lower, "/dev/i2c-3") == 0);
+    assert(lw_fault_init(&f->fault, &f->lower, seed) == 0);
+    assert(lw_fault_open(&f->fault, &f->bus, NULL) == 0);
+    f->lower.log_errors = 0;
+    f->bus.log_errors = 0;
+}
+
+static void fixture_close(fixture *f)
+{
+    lw_close_bus(&f->bus);
+    lw_fault_destroy(&f->fault);
+    lw_close_bus(&f->lower);
+    lw_sim_destroy(&f->sim);
+}
+
+static int read_reg(fixture *f, uint16_t addr)
+{
+    const uint8_t reg = 0x00;
+    uint8_t value = 0;
+    return (int)lw_ioctl_read(&f->bus, addr, &reg, 1, &value, 1, 0);
+}
+
+static uint64_t mono_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void test_pass_through(void)
+{
+    fixture f;
+    fixture_open(&f, 1);
+    assert(strcmp(f.bus.device_path, "/dev/i2c-3") == 0);
+
+    const uint8_t cfg[2] = {0x02, 0x5A};
+    assert(lw_ioctl_write(&f.bus, 0x48, NULL, 0, cfg, sizeof(cfg), 0) == 2);
+    assert(f.regs_a[2] == 0x5A);
+    assert(read_reg(&f, 0x48) == 1);
+    assert(f.sim.transactions == 2);
+
+    /* Errors of the lower bus come through unchanged and count as clean */
+    EXPECT_ERR(read_reg(&f, 0x49), ENXIO);
+
+    lw_fault_cost c;
+    assert(lw_fault_summary(&f.fault, LW_FAULT_CLEAN, &c) == 0);
+    assert(c.count == 3 && c.share == 1.0 && c.time_share == 1.0);
+    assert(lw_fault_summary(&f.fault, LW_FAULT_NACK, &c) == 0);
+    assert(c.count == 0);
+    fixture_close(&f);
+}
+
+static void test_error_classes(void)
+{
+    fixture f;
+    fixture_open(&f, 2);
+
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = 0x48;
+    const struct
+    {
+        uint32_t *ppm;
+        int err;
+        lw_fault_class cls;
+    } cases[] = {
+        {&rule.nack_ppm, ENXIO, LW_FAULT_NACK},
+        {&rule.eio_ppm, EIO, LW_FAULT_EIO},
+        {&rule.timeout_ppm, ETIMEDOUT, LW_FAULT_TIMEOUT},
+        {&rule.arbitration_ppm, EAGAIN, LW_FAULT_ARBITRATION},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        memset(&rule, 0, sizeof(rule));
+        rule.addr = 0x48;
+        *cases[i].ppm = LW_FAULT_PPM;
+        assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+        EXPECT_ERR(read_reg(&f, 0x48), cases[i].err);
+
+        lw_fault_cost c;
+        assert(lw_fault_summary(&f.fault, cases[i].cls, &c) == 0);
+        assert(c.count == 1);
+    }
+    assert(f.fault.rule_count == 1);
+
+    /* Injected errors never reach the device; other addresses are untouched */
+    assert(f.sim.transactions == 0);
+    assert(read_reg(&f, 0x68) == 1);
+    assert(f.sim.transactions == 1);
+
+    /* A message to a faulty device fails the whole combined transaction */
+    uint8_t value = 0;
+    const uint8_t reg = 0x00;
+    lw_msg msgs[2] = {
+        {0x68, 0, 1, (uint8_t *)&reg},
+        {0x48, LW_MSG_RD, 1, &value},
+    };
+    EXPECT_ERR(lw_transfer(&f.bus, msgs, 2), EAGAIN);
+
+    /* Timeouts take the adapter timeout before failing */
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = LW_FAULT_ANY;
+    rule.timeout_ppm = LW_FAULT_PPM;
+    lw_fault_clear_rules(&f.fault);
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    f.fault.timeout_us = 3000;
+    const uint64_t t0 = mono_us();
+    EXPECT_ERR(read_reg(&f, 0x68), ETIMEDOUT);
+    assert(mono_us() - t0 >= 3000);
+
+    /* Disabled: everything passes */
+    f.fault.enabled = 0;
+    assert(read_reg(&f, 0x68) == 1);
+    fixture_close(&f);
+}
+
+static void test_exact_rule_beats_any(void)
+{
+    fixture f;
+    fixture_open(&f, 5);
+
+    /* Catch-all first, then an override for one device */
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = LW_FAULT_ANY;
+    rule.eio_ppm = LW_FAULT_PPM;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = 0x68;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+
+    assert(read_reg(&f, 0x68) == 1);
+    EXPECT_ERR(read_reg(&f, 0x48), EIO);
+
+    /* Replacing the catch-all keeps the override in force */
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = LW_FAULT_ANY;
+    rule.nack_ppm = LW_FAULT_PPM;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    assert(f.fault.rule_count == 2);
+    assert(read_reg(&f, 0x68) == 1);
+    EXPECT_ERR(read_reg(&f, 0x48), ENXIO);
+    fixture_close(&f);
+}
+
+static void test_stuck_bus(void)
+{
+    fixture f;
+    fixture_open(&f, 3);
+
+    lw_fault_stick(&f.fault, 20000);
+    EXPECT_ERR(read_reg(&f, 0x48), EBUSY);
+    EXPECT_ERR(read_reg(&f, 0x68), EBUSY);
+    lw_fault_stick(&f.fault, 0);
+    assert(read_reg(&f, 0x48) == 1);
+
+    /* A device that grabs the bus takes every address down for stuck_us */
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = 0x48;
+    rule.stuck_ppm = LW_FAULT_PPM;
+    rule.stuck_us = 5000;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    EXPECT_ERR(read_reg(&f, 0x48), EBUSY);
+    EXPECT_ERR(read_reg(&f, 0x68), EBUSY);
+    const uint64_t t0 = mono_us();
+    while (read_reg(&f, 0x68) < 0)
+    {
+        assert(errno == EBUSY);
+        assert(mono_us() - t0 < 1000000);
+    }
+
+    lw_fault_cost c;
+    assert(lw_fault_summary(&f.fault, LW_FAULT_STUCK, &c) == 0);
+    assert(c.count >= 3);
+
+    lw_fault_stick(&f.fault, 1000000);
+    lw_fault_clear_rules(&f.fault);
+    assert(read_reg(&f, 0x48) == 1);
+    fixture_close(&f);
+}
+
+/* Outcome of 2000 reads as a string of class initials */
+static void run_sequence(uint64_t seed, char *out, size_t n)
+{
+    fixture f;
+    fixture_open(&f, seed);
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = LW_FAULT_ANY;
+    rule.nack_ppm = 100000;
+    rule.eio_ppm = 50000;
+    rule.arbitration_ppm = 50000;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        errno = 0;
+        const int rc = read_reg(&f, 0x48);
+        out[i] = rc == 1 ? '.' : errno == ENXIO ? 'n' : errno == EIO ? 'e' : errno == EAGAIN ? 'a' : '?';
+    }
+
+    /* Chances apply per message: a register read is two, so 0.8^2 pass */
+    lw_fault_cost nack, clean;
+    assert(lw_fault_summary(&f.fault, LW_FAULT_NACK, &nack) == 0);
+    assert(lw_fault_summary(&f.fault, LW_FAULT_CLEAN, &clean) == 0);
+    assert(nack.share > 0.15 && nack.share < 0.21);
+    assert(clean.share > 0.60 && clean.share < 0.68);
+    assert(f.sim.transactions == clean.count);
+    fixture_close(&f);
+}
+
+static void test_seeded_and_reproducible(void)
+{
+    enum { N = 2000 };
+    static char a[N], b[N], c[N];
+    run_sequence(42, a, N);
+    run_sequence(42, b, N);
+    run_sequence(43, c, N);
+    assert(memchr(a, '?', N) == NULL);
+    assert(memcmp(a, b, N) == 0);
+    assert(memcmp(a, c, N) != 0);
+}
+
+static void test_latency_and_report(void)
+{
+    fixture f;
+    fixture_open(&f, 5);
+
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.addr = 0x48;
+    rule.delay_ppm = LW_FAULT_PPM;
+    rule.delay_kind = LW_FAULT_DELAY_UNIFORM;
+    rule.delay_min_us = 1000;
+    rule.delay_max_us = 1500;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    for (int i = 0; i < 10; ++i)
+    {
+        const uint64_t t0 = mono_us();
+        assert(read_reg(&f, 0x48) == 1);
+        assert(mono_us() - t0 >= 1000);
+        assert(read_reg(&f, 0x68) == 1);
+    }
+
+    lw_fault_cost delay, clean;
+    assert(lw_fault_summary(&f.fault, LW_FAULT_DELAY, &delay) == 0);
+    assert(lw_fault_summary(&f.fault, LW_FAULT_CLEAN, &clean) == 0);
+    assert(delay.count == 10 && clean.count == 10);
+    assert(delay.mean_us >= 1000.0 && delay.p50_us >= 1000 && delay.p99_us <= delay.max_us);
+    assert(delay.time_share > clean.time_share);
+    assert(delay.time_share + clean.time_share > 0.999);
+
+    /* Exponential tail: two messages per read, so about twice the mean */
+    lw_fault_reset_stats(&f.fault);
+    rule.delay_kind = LW_FAULT_DELAY_EXPONENTIAL;
+    rule.delay_min_us = 0;
+    rule.delay_max_us = 200;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    for (int i = 0; i < 200; ++i)
+    {
+        assert(read_reg(&f, 0x48) == 1);
+    }
+    assert(lw_fault_summary(&f.fault, LW_FAULT_DELAY, &delay) == 0);
+    assert(delay.count <= 200 && delay.count > 150);
+    assert(delay.mean_us > 300.0 && delay.mean_us < 2000.0);
+    assert(delay.p99_us > delay.p50_us);
+
+    FILE *out = tmpfile();
+    assert(out);
+    assert(lw_fault_write_report(&f.fault, out) == 0);
+    rewind(out);
+    char text[1024];
+    const size_t len = fread(text, 1, sizeof(text) - 1, out);
+    text[len] = '\0';
+    fclose(out);
+    assert(strstr(text, "p99_us") != NULL);
+    assert(strstr(text, "\ndelay ") != NULL);
+    assert(strstr(text, "nack") == NULL);
+    fixture_close(&f);
+}
+
+static void test_invalid_arguments(void)
+{
+    fixture f;
+    fixture_open(&f, 6);
+
+    lw_fault_rule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.nack_ppm = 600000;
+    rule.eio_ppm = 500000;
+    EXPECT_ERR(lw_fault_add_rule(&f.fault, &rule), EINVAL);
+    memset(&rule, 0, sizeof(rule));
+    rule.delay_kind = LW_FAULT_DELAY_UNIFORM;
+    rule.delay_min_us = 10;
+    rule.delay_max_us = 5;
+    EXPECT_ERR(lw_fault_add_rule(&f.fault, &rule), EINVAL);
+    rule.delay_kind = (lw_fault_delay_kind)7;
+    EXPECT_ERR(lw_fault_add_rule(&f.fault, &rule), EINVAL);
+
+    memset(&rule, 0, sizeof(rule));
+    for (uint16_t addr = 0; addr < LINUX_WIRE_FAULT_MAX_RULES; ++addr)
+    {
+        rule.addr = addr;
+        assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+    }
+    rule.addr = 0x77;
+    EXPECT_ERR(lw_fault_add_rule(&f.fault, &rule), ENOSPC);
+    rule.addr = 0;
+    assert(lw_fault_add_rule(&f.fault, &rule) == 0);
+
+    lw_fault_cost c;
+    EXPECT_ERR(lw_fault_summary(&f.fault, LW_FAULT_CLASS_COUNT, &c), EINVAL);
+    assert(lw_fault_class_name(LW_FAULT_ARBITRATION) != NULL);
+    assert(lw_fault_class_name(LW_FAULT_CLASS_COUNT) == NULL);
+    EXPECT_ERR(lw_fault_init(&f.fault, NULL, 0), EINVAL);
+    EXPECT_ERR(lw_fault_open(NULL, &f.bus, NULL), EINVAL);
+    fixture_close(&f);
+}
+
+int main(void)
+{
+    test_pass_through();
+    test_error_classes();
+    test_exact_rule_beats_any();
+    test_stuck_bus();
+    test_seeded_and_reproducible();
+    test_latency_and_report();
+    test_invalid_arguments();
+
+    puts("linux_wire fault tests passed");
+    return 0;
+}
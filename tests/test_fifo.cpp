@@ -0,0 +1,197 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "linux_wire_fifo.h"
+#include "mock_linux_wire.h"
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static std::vector<uint8_t> sequence(std::size_t n, uint8_t first)
+{
+    std::vector<uint8_t> v(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        v[i] = static_cast<uint8_t>(first + i);
+    }
+    return v;
+}
+
+static void testDrainReadsCountThenFrames()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_fifo fifo; // MPU-6050 style: FIFO_COUNTH 0x72, FIFO_R_W 0x74
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.frame_size = 6;
+
+    uint8_t storage[60];
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage, sizeof(storage)) == 0);
+
+    mockLinuxWireQueueTransferReadData({0x00, 0x0E}); // 14 bytes: two frames + partial
+    mockLinuxWireQueueTransferReadData(sequence(12, 1));
+
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 12);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 2);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0x74}));
+    assert(state.lastTransfer[1].flags == LW_MSG_RD);
+    assert(state.lastTransfer[1].data.size() == 12);
+
+    uint8_t out[12];
+    assert(lw_fifo_ring_pop(&ring, out, sizeof(out)) == 12);
+    assert(out[0] == 1 && out[11] == 12);
+    assert(lw_fifo_ring_used(&ring) == 0);
+}
+
+static void testChunksAreBatchedPerTransfer()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_fifo fifo;
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.max_chunk = 16;
+    fifo.count_le = 1;
+    fifo.count_mask = 0x0FFF;
+
+    std::vector<uint8_t> storage(2048);
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage.data(), storage.size()) == 0);
+
+    mockLinuxWireQueueTransferReadData({0xE8, 0xF3}); // 0x3E8 & 0xFFF = 1000 bytes
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 1000);
+
+    // 63 chunks of <= 16 bytes, 21 (write, read) pairs per I2C_RDWR call
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1 + 3);
+    assert(state.lastTransfer.size() == 42);
+    assert(state.lastTransfer[41].data.size() == 1000 - 62 * 16);
+}
+
+static void testRingWrapAndBackPressure()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_fifo fifo;
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.frame_size = 6;
+
+    uint8_t storage[24];
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage, sizeof(storage)) == 0);
+
+    mockLinuxWireQueueTransferReadData({0x00, 18});
+    mockLinuxWireQueueTransferReadData(sequence(18, 0));
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 18);
+
+    uint8_t out[24];
+    assert(lw_fifo_ring_pop(&ring, out, 13) == 13); // consumer leaves a partial frame
+
+    // 30 bytes pending but only 19 free, i.e. room for three whole frames
+    mockLinuxWireQueueTransferReadData({0x00, 30});
+    mockLinuxWireQueueTransferReadData(sequence(18, 100));
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 18);
+
+    // Split at the wrap point: 6 bytes at the end, 12 at the start
+    const auto &state = mockLinuxWireState();
+    assert(state.lastTransfer.size() == 4);
+    assert(state.lastTransfer[1].data.size() == 6);
+    assert(state.lastTransfer[3].data.size() == 12);
+
+    assert(lw_fifo_ring_used(&ring) == 23);
+    assert(lw_fifo_ring_pop(&ring, out, sizeof(out)) == 23);
+    assert(out[0] == 13 && out[4] == 17);
+    assert(out[5] == 100 && out[22] == 117);
+}
+
+static void testPrefetchSharesCountTransaction()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_fifo fifo;
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.frame_size = 6;
+    fifo.prefetch = 12;
+
+    uint8_t storage[60];
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage, sizeof(storage)) == 0);
+
+    std::vector<uint8_t> first = {0x00, 18};
+    const std::vector<uint8_t> frames = sequence(12, 1);
+    first.insert(first.end(), frames.begin(), frames.end());
+    mockLinuxWireQueueTransferReadData(first);
+    mockLinuxWireQueueTransferReadData(sequence(6, 13));
+
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 18);
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 2);
+    assert(state.lastTransfer[1].data.size() == 6);
+    assert(fifo.overreads == 0);
+
+    uint8_t out[18];
+    assert(lw_fifo_ring_pop(&ring, out, sizeof(out)) == 18);
+    for (int i = 0; i < 18; ++i)
+    {
+        assert(out[i] == i + 1);
+    }
+
+    // Level below the prefetch: only the counted frames are kept
+    mockLinuxWireQueueTransferReadData({0x00, 6, 9, 9, 9, 9, 9, 9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 6);
+    assert(state.transferCalls == 3);
+    assert(fifo.overreads == 1);
+    assert(lw_fifo_ring_used(&ring) == 6);
+}
+
+static void testInvalidConfiguration()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_fifo fifo;
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.frame_size = 6;
+
+    uint8_t storage[32]; // not a whole number of frames
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage, sizeof(storage)) == 0);
+
+    errno = 0;
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == -1);
+    assert(errno == EINVAL);
+
+    assert(lw_fifo_ring_init(&ring, storage, 30) == 0);
+    fifo.prefetch = 4;
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == -1);
+    fifo.prefetch = 0;
+    fifo.count_width = 3;
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == -1);
+    assert(mockLinuxWireState().transferCalls == 0);
+}
+
+int main()
+{
+    testDrainReadsCountThenFrames();
+    testChunksAreBatchedPerTransfer();
+    testRingWrapAndBackPressure();
+    testPrefetchSharesCountTransaction();
+    testInvalidConfiguration();
+
+    std::puts("linux_wire fifo tests passed");
+    return 0;
+}
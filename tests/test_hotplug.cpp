@@ -0,0 +1,250 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "linux_wire_hotplug.h"
+#include "mock_linux_wire.h"
+
+/* Fake sysfs and /dev: i2c-1 is the SoC controller, USB bridges come and go */
+struct FakeTree
+{
+    std::string root;
+    std::string sys;
+    std::string dev;
+
+    FakeTree()
+    {
+        char dir[] = "/tmp/lw_hotplug_XXXXXX";
+        assert(mkdtemp(dir) != nullptr);
+        root = dir;
+        sys = root + "/sys/bus";
+        dev = root + "/dev";
+        std::filesystem::create_directories(sys);
+        std::filesystem::create_directories(dev);
+        addAdapter(1, "", "bcm2835 (i2c@7e804000)");
+    }
+
+    ~FakeTree()
+    {
+        std::filesystem::remove_all(root);
+    }
+
+    /* `port` empty: a plain platform adapter; otherwise a CP2112 on that USB port */
+    void addAdapter(unsigned int n, const std::string &port, const std::string &name)
+    {
+        const std::string node = "i2c-" + std::to_string(n);
+        if (port.empty())
+        {
+            std::filesystem::create_directories(sys + "/" + node);
+            std::ofstream(sys + "/" + node + "/name") << name << "\n";
+        }
+        else
+        {
+            const std::string target = root + "/sys/devices/usb1/" + port + "/" + port + ":1.0/0003:10C4:EA90." +
+                                       std::to_string(n) + "/" + node;
+            std::filesystem::create_directories(target);
+            std::ofstream(target + "/name") << name << "\n";
+            assert(symlink(target.c_str(), (sys + "/" + node).c_str()) == 0);
+        }
+        std::ofstream(dev + "/" + node).put('\0');
+    }
+
+    void removeAdapter(unsigned int n)
+    {
+        const std::string node = "i2c-" + std::to_string(n);
+        std::filesystem::remove(dev + "/" + node);
+        std::filesystem::remove(sys + "/" + node);
+    }
+};
+
+static void countEvent(void *arg, const lw_xfer_event *)
+{
+    ++*static_cast<int *>(arg);
+}
+
+static void testFindByIdentity()
+{
+    FakeTree tree;
+    tree.addAdapter(5, "1-1.2", "CP2112 SMBus Bridge on hidraw0");
+    tree.addAdapter(6, "1-1.3", "MCP2221 usb-i2c bridge");
+
+    unsigned int n = 0;
+    assert(lw_adapter_find("CP2112", nullptr, tree.sys.c_str(), &n) == 0 && n == 5);
+    assert(lw_adapter_find(nullptr, "/1-1.3:", tree.sys.c_str(), &n) == 0 && n == 6);
+    assert(lw_adapter_find("bcm2835", "", tree.sys.c_str(), &n) == 0 && n == 1);
+    assert(lw_adapter_find(nullptr, nullptr, tree.sys.c_str(), &n) == 0 && n == 1);
+
+    // Both parts must match
+    errno = 0;
+    assert(lw_adapter_find("CP2112", "/1-1.3:", tree.sys.c_str(), &n) == -1);
+    assert(errno == ENOENT);
+    assert(lw_adapter_find("SMBus", nullptr, tree.sys.c_str(), &n) == -1);
+    assert(lw_adapter_find("CP2112", nullptr, tree.sys.c_str(), nullptr) == -1);
+}
+
+static void testReplugUnderNewNumber()
+{
+    mockLinuxWireReset();
+    FakeTree tree;
+    tree.addAdapter(5, "1-1.2", "CP2112 SMBus Bridge on hidraw0");
+
+    lw_hotplug hp;
+    assert(lw_hotplug_init(&hp, tree.dev.c_str(), tree.sys.c_str(), 0) == 0);
+    const int usb = lw_hotplug_add(&hp, "CP2112", "/1-1.2:");
+    const int soc = lw_hotplug_add(&hp, "bcm2835", nullptr);
+    assert(usb == 0 && soc == 1);
+    assert(lw_hotplug_generation(&hp, 0) == 1 && lw_hotplug_generation(&hp, 1) == 1);
+
+    lw_i2c_bus bus;
+    bus.fd = -1;
+    uint64_t generation = 0;
+    const auto &state = mockLinuxWireState();
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == 1);
+    assert(state.lastDevicePath == tree.dev + "/i2c-5");
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == 0);
+    assert(state.openCalls == 1);
+    int events = 0;
+    lw_pool pool{};
+    bus.observer = countEvent;
+    bus.observer_arg = &events;
+    bus.pool = &pool;
+    bus.timeout_us = 2500;
+
+    // Unplugged: the event arrives without waiting for a poll interval
+    tree.removeAdapter(5);
+    assert(lw_hotplug_run_once(&hp, 1000) == 1);
+    assert(lw_hotplug_generation(&hp, 0) == 2 && lw_hotplug_generation(&hp, 1) == 1);
+    char path[LINUX_WIRE_DEVICE_PATH_MAX];
+    errno = 0;
+    assert(lw_hotplug_path(&hp, 0, path, sizeof(path)) == -1 && errno == ENODEV);
+    errno = 0;
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == -1 && errno == ENODEV);
+    assert(state.closeCalls == 1 && bus.fd == -1);
+
+    // Back on the same port as i2c-7 (a new HID instance)
+    tree.addAdapter(7, "1-1.2", "CP2112 SMBus Bridge on hidraw1");
+    while (lw_hotplug_generation(&hp, 0) == 2)
+    {
+        assert(lw_hotplug_run_once(&hp, 1000) >= 0);
+    }
+    assert(lw_hotplug_path(&hp, 0, path, sizeof(path)) == 0);
+    assert(tree.dev + "/i2c-7" == path);
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == 1);
+    assert(state.lastDevicePath == tree.dev + "/i2c-7");
+    // Configured before the unplug, still in place on the new adapter
+    assert(bus.observer == countEvent && bus.observer_arg == &events);
+    assert(bus.pool == &pool && bus.timeout_us == 2500);
+
+    // Nothing else happening: the wait times out
+    assert(lw_hotplug_run_once(&hp, 0) == 0);
+    assert(hp.changes == 2);
+    lw_hotplug_close(&hp);
+}
+
+static void testFastReplugSameNumber()
+{
+    mockLinuxWireReset();
+    FakeTree tree;
+    tree.addAdapter(5, "1-1.2", "CP2112 SMBus Bridge on hidraw0");
+
+    lw_hotplug hp;
+    assert(lw_hotplug_init(&hp, tree.dev.c_str(), tree.sys.c_str(), 0) == 0);
+    assert(lw_hotplug_add(&hp, "CP2112", nullptr) == 0);
+    lw_i2c_bus bus;
+    bus.fd = -1;
+    uint64_t generation = 0;
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == 1);
+
+    // Gone and back as i2c-5 before the monitor looked: still a new adapter
+    tree.removeAdapter(5);
+    tree.addAdapter(5, "1-1.2", "CP2112 SMBus Bridge on hidraw2");
+    assert(lw_hotplug_run_once(&hp, 1000) == 1);
+    assert(lw_hotplug_reopen(&hp, 0, &bus, &generation) == 1);
+    assert(mockLinuxWireState().openCalls == 2);
+
+    // Unrelated nodes do not trigger a rescan
+    std::ofstream(tree.dev + "/ttyUSB0").put('\0');
+    assert(lw_hotplug_run_once(&hp, 50) == 0);
+    assert(hp.events == 1);
+    lw_hotplug_close(&hp);
+}
+
+static void testNodeWithoutAccessIsAbsent()
+{
+    if (geteuid() == 0)
+    {
+        return; // root can open anything
+    }
+
+    FakeTree tree;
+    tree.addAdapter(5, "1-1.2", "CP2112 SMBus Bridge on hidraw0");
+    const std::string node = tree.dev + "/i2c-5";
+    assert(chmod(node.c_str(), 0) == 0);
+
+    lw_hotplug hp;
+    assert(lw_hotplug_init(&hp, tree.dev.c_str(), tree.sys.c_str(), 0) == 0);
+    assert(lw_hotplug_add(&hp, "CP2112", nullptr) == 0);
+    char path[LINUX_WIRE_DEVICE_PATH_MAX];
+    assert(lw_hotplug_path(&hp, 0, path, sizeof(path)) == -1);
+
+    // udev fixing the mode makes it usable
+    assert(chmod(node.c_str(), 0600) == 0);
+    assert(lw_hotplug_run_once(&hp, 1000) == 1);
+    assert(lw_hotplug_path(&hp, 0, path, sizeof(path)) == 0);
+    lw_hotplug_close(&hp);
+}
+
+static void testInvalidArguments()
+{
+    FakeTree tree;
+    lw_hotplug hp;
+    assert(lw_hotplug_init(nullptr, nullptr, nullptr, 0) == -1);
+    const std::string longRoot(LINUX_WIRE_DEVICE_PATH_MAX, 'd');
+    errno = 0;
+    assert(lw_hotplug_init(&hp, longRoot.c_str(), tree.sys.c_str(), 0) == -1 && errno == EINVAL);
+    assert(lw_hotplug_init(&hp, (tree.root + "/missing").c_str(), tree.sys.c_str(), 0) == -1);
+
+    // The uevent socket is optional
+    assert(lw_hotplug_init(&hp, tree.dev.c_str(), tree.sys.c_str(), LW_HOTPLUG_UEVENT) == 0);
+    const std::string longName(LINUX_WIRE_HOTPLUG_MATCH_MAX, 'n');
+    assert(lw_hotplug_add(&hp, longName.c_str(), nullptr) == -1);
+    for (int i = 0; i < LINUX_WIRE_HOTPLUG_MAX_SLOTS; ++i)
+    {
+        assert(lw_hotplug_add(&hp, "bcm2835", nullptr) == i);
+    }
+    errno = 0;
+    assert(lw_hotplug_add(&hp, "bcm2835", nullptr) == -1 && errno == ENOSPC);
+
+    lw_i2c_bus bus;
+    bus.fd = -1;
+    uint64_t generation = 0;
+    assert(lw_hotplug_generation(&hp, LINUX_WIRE_HOTPLUG_MAX_SLOTS) == 0);
+    assert(lw_hotplug_reopen(&hp, LINUX_WIRE_HOTPLUG_MAX_SLOTS, &bus, &generation) == -1);
+
+    // Every error but a NULL bus leaves the bus closed
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    assert(lw_hotplug_reopen(&hp, LINUX_WIRE_HOTPLUG_MAX_SLOTS, &bus, &generation) == -1);
+    assert(bus.fd == -1);
+    assert(lw_hotplug_reopen(nullptr, 0, &bus, &generation) == -1);
+    assert(lw_hotplug_reopen(&hp, 0, &bus, nullptr) == -1);
+    lw_hotplug_close(&hp);
+    lw_hotplug_close(&hp);
+}
+
+int main()
+{
+    testFindByIdentity();
+    testReplugUnderNewNumber();
+    testFastReplugSameNumber();
+    testNodeWithoutAccessIsAbsent();
+    testInvalidArguments();
+
+    std::puts("linux_wire hotplug tests passed");
+    return 0;
+}
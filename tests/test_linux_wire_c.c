@@ -1,9 +1,18 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "linux_wire.h"
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define EXPECT_ERR(call, err)       \
     do                              \
@@ -13,6 +22,36 @@
         assert(errno == (err));     \
     } while (0)
 
+/* Backend double: records the transaction layout and answers reads */
+typedef struct
+{
+    size_t calls;
+    size_t count;
+    lw_msg msgs[LW_MAX_MSGS];
+    int fail_errno;
+} fake_backend;
+
+static int fake_transfer(void *arg, lw_msg *msgs, size_t count)
+{
+    fake_backend *fake = (fake_backend *)arg;
+    ++fake->calls;
+    fake->count = count;
+    memcpy(fake->msgs, msgs, count * sizeof(*msgs));
+    if (fake->fail_errno)
+    {
+        errno = fake->fail_errno;
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (msgs[i].flags & LW_MSG_RD)
+        {
+            memset(msgs[i].buf, 0x5A, msgs[i].len);
+        }
+    }
+    return (int)count;
+}
+
 int main(void)
 {
     lw_i2c_bus bus;
@@ -52,9 +91,12 @@ int main(void)
 
     EXPECT_ERR(lw_ioctl_read(&bus, 0x10, &byte, 1, buf, 1, 0), EBADF);
     EXPECT_ERR(lw_ioctl_write(&bus, 0x10, &byte, 1, &byte, 1, 0), EBADF);
+    EXPECT_ERR(lw_wait_ready(&bus, 0x50, 1000, 10, 0), EBADF);
+    EXPECT_ERR(lw_wait_ready(NULL, 0x50, 1000, 10, 0), EINVAL);
 
     bus.fd = 0; /* bypass fd check to hit other validation branches */
     EXPECT_ERR(lw_set_slave(&bus, 0x80), EINVAL);
+    EXPECT_ERR(lw_wait_ready(&bus, 0x80, 1000, 10, LW_WAIT_SPIN), EINVAL);
 
     EXPECT_ERR(lw_ioctl_write(&bus, 0x20, NULL, 1, &byte, 1, 0), EINVAL);
     EXPECT_ERR(lw_ioctl_write(&bus, 0x20, &byte, 1, NULL, 1, 0), EINVAL);
@@ -65,5 +107,296 @@ int main(void)
     lw_set_error_logging(&bus, 1);
     assert(bus.log_errors == 1);
 
+    lw_msg msgs[LW_MAX_MSGS + 1];
+    memset(msgs, 0, sizeof(msgs));
+    EXPECT_ERR(lw_transfer(&bus, NULL, 1), EINVAL);
+    EXPECT_ERR(lw_transfer(&bus, msgs, 0), EINVAL);
+    EXPECT_ERR(lw_transfer(&bus, msgs, LW_MAX_MSGS + 1), EINVAL);
+    msgs[0].len = 1;
+    EXPECT_ERR(lw_transfer(&bus, msgs, 1), EINVAL);
+    msgs[0].len = 0;
+
+    /* Pool accounting: /dev/null accepts the fd but rejects I2C_RDWR, so
+       every call stages its buffers and then fails in the ioctl. */
+    static uint8_t arena[1024];
+    lw_pool pool;
+    lw_pool_stats stats;
+    EXPECT_ERR(lw_pool_init(&pool, NULL, sizeof(arena)), EINVAL);
+    assert(lw_pool_init(&pool, arena, sizeof(arena)) == 0);
+
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    lw_set_error_logging(&bus, 0);
+    assert(lw_bus_attach_pool(&bus, &pool) == 0);
+
+    uint8_t payload[600];
+    memset(payload, 0xA5, sizeof(payload));
+    assert(lw_ioctl_write(&bus, 0x50, &byte, 1, payload, 600, 0) == -1);
+    assert(lw_ioctl_write(&bus, 0x50, &byte, 1, payload, 16, 0) == -1);
+    assert(lw_transfer(&bus, msgs, 20) == -1);
+    lw_pool_get_stats(&pool, &stats);
+    assert(stats.hits == 2);
+    assert(stats.misses == 0);
+    assert(stats.capacity == sizeof(arena));
+    assert(stats.high_water >= 601);
+    assert(pool.used == 0);
+
+    assert(lw_ioctl_write(&bus, 0x50, &byte, 1, payload, 300, 0) == -1);
+    assert(lw_ioctl_write(&bus, 0x50, NULL, 0, payload, 600, 0) == -1);
+    uint8_t big[2048];
+    memset(big, 0, sizeof(big));
+    assert(lw_ioctl_write(&bus, 0x50, NULL, 0, big, sizeof(big), 0) == -1);
+    lw_pool_get_stats(&pool, &stats);
+    assert(stats.hits == 4);
+    assert(stats.misses == 1);
+
+    lw_pool_reset_stats(&pool);
+    lw_pool_get_stats(&pool, &stats);
+    assert(stats.hits == 0 && stats.misses == 0);
+
+    /* A misaligned arena: hand-outs are aligned by address, not offset */
+    static _Alignas(16) uint8_t aligned_arena[1024 + 1];
+    lw_pool skewed;
+    assert(lw_pool_init(&skewed, aligned_arena + 1, sizeof(aligned_arena) - 1) == 0);
+    assert(lw_bus_attach_pool(&bus, &skewed) == 0);
+    assert(lw_ioctl_write(&bus, 0x50, &byte, 1, payload, 600, 0) == -1);
+    assert(skewed.hits == 1 && skewed.high_water == 15 + 601);
+    assert(lw_transfer(&bus, msgs, 20) == -1);
+    assert(skewed.hits == 2 && skewed.used == 0);
+    assert(lw_bus_attach_pool(&bus, NULL) == 0);
+    close(bus.fd);
+    bus.fd = 0;
+
+    /* Gather reads: validated up front, then one combined transfer */
+    uint8_t status_reg = 0, xyz[6], temp[2];
+    lw_gather_item regs[3] = {{0x00, 1, 1, &status_reg}, {0x28, 1, 6, xyz}, {0x41, 1, 2, temp}};
+    bus.fd = -1;
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, 3), EBADF);
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, NULL, 3), EINVAL);
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, 0), EINVAL);
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, LW_GATHER_MAX + 1), EINVAL);
+    regs[1].reg_len = 5;
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, 3), EINVAL);
+    regs[1].reg_len = 1;
+    regs[2].dst = NULL;
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, 3), EINVAL);
+    regs[2].dst = temp;
+    EXPECT_ERR(lw_gather_read(&bus, 0x19, regs, 3), ENOTTY);
+    close(bus.fd);
+    bus.fd = -1;
+
+    /* Realtime mode: failures go to the error ring, nothing is printed */
+    static lw_error_ring ring;
+    lw_error_record rec;
+    lw_error_ring_init(&ring);
+    lw_rt_config rt = {NULL, 0, &ring, 0};
+
+    EXPECT_ERR(lw_open_bus_rt(&bus, "/dev/i2c-999", &rt), ENOENT);
+    assert(bus.fd == -1);
+    assert(bus.pool == NULL && bus.rt_flags == 0);
+    assert(lw_error_ring_pop(&ring, &rec) == 1);
+    assert(rec.op == LW_OP_OPEN && rec.err == ENOENT);
+    assert(lw_error_ring_pop(&ring, &rec) == 0);
+
+    EXPECT_ERR(lw_bus_enable_rt(&bus, &rt), EBADF);
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    lw_set_error_logging(&bus, 1); /* must still stay silent */
+    assert(lw_bus_enable_rt(&bus, &rt) == 0);
+    assert(bus.pool != NULL && bus.pool->capacity == LINUX_WIRE_RT_DEFAULT_POOL);
+
+    EXPECT_ERR(lw_ioctl_write(&bus, 0x51, &byte, 1, big, sizeof(big), 0), ENOTTY);
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x52, &byte, 1, payload, 4, 0), ENOTTY);
+    EXPECT_ERR(lw_transfer(&bus, msgs, 20), ENOTTY);
+    assert(bus.pool->misses == 0 && bus.pool->used == 0);
+
+    assert(lw_error_ring_pop(&ring, &rec) == 1);
+    assert(rec.op == LW_OP_IOCTL_WRITE && rec.addr == 0x51 && rec.err == ENOTTY);
+    assert(lw_error_ring_pop(&ring, &rec) == 1);
+    assert(rec.op == LW_OP_IOCTL_READ && rec.addr == 0x52);
+    const uint32_t seq = rec.seq;
+    assert(lw_error_ring_pop(&ring, &rec) == 1);
+    assert(rec.op == LW_OP_TRANSFER && rec.seq == seq + 1);
+
+    /* A full ring drops new records instead of blocking */
+    for (int i = 0; i < LINUX_WIRE_ERROR_RING_SIZE + 5; ++i)
+    {
+        assert(lw_ioctl_read(&bus, 0x52, &byte, 1, payload, 1, 0) == -1);
+    }
+    assert(ring.dropped == 5);
+
+    /* Heap fallback is a realtime violation: assert in debug builds,
+       ENOMEM without allocating otherwise. The child's assertion message
+       in debug test logs is expected. */
+    static uint8_t tiny_arena[64];
+    lw_pool tiny;
+    assert(lw_pool_init(&tiny, tiny_arena, sizeof(tiny_arena)) == 0);
+    lw_rt_config tiny_rt = {&tiny, 0, NULL, 0};
+    assert(lw_bus_enable_rt(&bus, &tiny_rt) == 0);
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0)
+    {
+        errno = 0;
+        ssize_t r = lw_ioctl_write(&bus, 0x50, NULL, 0, big, sizeof(big), 0);
+        _exit(r == -1 && errno == ENOMEM ? 0 : 1);
+    }
+    int status = 0;
+    assert(waitpid(child, &status, 0) == child);
+#ifdef NDEBUG
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+#else
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+#endif
+
+    lw_close_bus(&bus);
+    assert(bus.fd == -1 && bus.rt_flags == 0);
+
+    /* Attaching a caller pool to a realtime bus frees the library's pool;
+       closing must not free the caller's static one */
+    static uint8_t rt_arena[4096];
+    static lw_pool rt_pool;
+    assert(lw_pool_init(&rt_pool, rt_arena, sizeof(rt_arena)) == 0);
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    assert(lw_bus_enable_rt(&bus, NULL) == 0);
+    assert(bus.pool != NULL && bus.pool != &rt_pool);
+    assert(lw_bus_attach_pool(&bus, &rt_pool) == 0);
+    EXPECT_ERR(lw_ioctl_write(&bus, 0x51, &byte, 1, big, 1024, 0), ENOTTY);
+    assert(rt_pool.hits == 1 && rt_pool.misses == 0);
+    lw_close_bus(&bus);
+    assert(bus.fd == -1 && bus.rt_flags == 0 && bus.pool == &rt_pool);
+
+    /* Detaching from a realtime bus frees the owned pool too */
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    assert(lw_bus_enable_rt(&bus, NULL) == 0);
+    assert(lw_bus_attach_pool(&bus, NULL) == 0);
+    assert(bus.pool == NULL);
+    lw_close_bus(&bus);
+
+    /* Capability probe against a fake sysfs tree; /dev/null rejects
+       I2C_FUNCS, so the functionality bits stay unknown. */
+    EXPECT_ERR(lw_bus_probe_caps(&bus, NULL), EBADF);
+    char root[] = "/tmp/lw_sysfs_XXXXXX";
+    assert(mkdtemp(root) != NULL);
+    char path[128];
+    snprintf(path, sizeof(path), "%s/i2c-7", root);
+    assert(mkdir(path, 0700) == 0);
+    snprintf(path, sizeof(path), "%s/i2c-7/of_node", root);
+    assert(mkdir(path, 0700) == 0);
+    snprintf(path, sizeof(path), "%s/i2c-7/name", root);
+    FILE *f = fopen(path, "w");
+    assert(f);
+    fputs("Synopsys DesignWare I2C adapter\n", f);
+    fclose(f);
+    snprintf(path, sizeof(path), "%s/i2c-7/of_node/clock-frequency", root);
+    f = fopen(path, "wb");
+    assert(f);
+    const uint8_t cell[4] = {0x00, 0x06, 0x1A, 0x80}; /* 400000 */
+    fwrite(cell, 1, sizeof(cell), f);
+    fclose(f);
+
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    lw_set_error_logging(&bus, 0);
+    strcpy(bus.device_path, "/dev/i2c-7");
+    assert(lw_bus_probe_caps(&bus, root) == 0);
+    assert(bus.caps.flags == (LW_CAPS_NAME | LW_CAPS_BUS_HZ));
+    assert(strcmp(bus.caps.name, "Synopsys DesignWare I2C adapter") == 0);
+    assert(bus.caps.bus_hz == 400000);
+    assert(lw_bus_supports(&bus, LW_FUNC_I2C | LW_FUNC_10BIT_ADDR)); /* unknown */
+
+    /* Known SMBus-only controller: combined transactions fail up front */
+    bus.caps.flags |= LW_CAPS_FUNCS;
+    bus.caps.funcs = LW_FUNC_SMBUS_QUICK | LW_FUNC_SMBUS_READ_I2C_BLOCK;
+    assert(!lw_bus_supports(&bus, LW_FUNC_I2C));
+    assert(lw_bus_supports(&bus, LW_FUNC_SMBUS_QUICK));
+    uint8_t reg = 0x10;
+    uint8_t value = 0;
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x40, &reg, 1, &value, 1, 0), EOPNOTSUPP);
+    EXPECT_ERR(lw_ioctl_write(&bus, 0x40, &reg, 1, &value, 1, 0), EOPNOTSUPP);
+    EXPECT_ERR(lw_wait_ready(&bus, 0x50, 0, 0, 0), EOPNOTSUPP);
+    lw_msg probe = {0x40, 0, 1, &reg};
+    EXPECT_ERR(lw_transfer(&bus, &probe, 1), EOPNOTSUPP);
+
+    /* Plain I2C without 10-bit addressing */
+    bus.caps.funcs = LW_FUNC_I2C;
+    EXPECT_ERR(lw_transfer(&bus, &probe, 1), ENOTTY);
+    probe.flags = 0x0010; /* I2C_M_TEN */
+    EXPECT_ERR(lw_transfer(&bus, &probe, 1), EOPNOTSUPP);
+
+    lw_close_bus(&bus);
+    assert(bus.caps.flags == 0 && bus.caps.name[0] == '\0');
+    snprintf(path, sizeof(path), "%s/i2c-7/of_node/clock-frequency", root);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/i2c-7/of_node", root);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/i2c-7/name", root);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/i2c-7", root);
+    rmdir(path);
+    rmdir(root);
+
+    /* Prepared transactions: validated once, then executed as-is */
+    lw_prepared prep;
+    uint8_t sample[6];
+    EXPECT_ERR(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 1, sample, sizeof(sample)), EBADF);
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    lw_set_error_logging(&bus, 0);
+    EXPECT_ERR(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 5, sample, sizeof(sample)), EINVAL);
+    EXPECT_ERR(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 1, NULL, sizeof(sample)), EINVAL);
+    EXPECT_ERR(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 1, sample, 0), EINVAL);
+    EXPECT_ERR(lw_prepare_transfer(&prep, &bus, msgs, 0), EINVAL);
+    EXPECT_ERR(lw_prepare_transfer(&prep, &bus, msgs, LW_PREPARED_MAX_MSGS + 1), EINVAL);
+
+    assert(lw_prepare_read(&prep, &bus, 0x68, 0x123B, 2, sample, sizeof(sample)) == 0);
+    assert(prep.count == 2);
+    assert(prep.msgs[0].len == 2 && prep.msgs[0].buf == prep.reg);
+    assert(prep.reg[0] == 0x12 && prep.reg[1] == 0x3B);
+    assert(prep.msgs[1].flags == LW_MSG_RD && prep.msgs[1].buf == sample);
+    EXPECT_ERR(lw_prepared_exec(&prep), ENOTTY);
+    EXPECT_ERR(lw_prepared_exec(&prep), ENOTTY);
+
+    bus.caps.flags = LW_CAPS_FUNCS;
+    bus.caps.funcs = LW_FUNC_SMBUS_QUICK;
+    EXPECT_ERR(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 1, sample, sizeof(sample)), EOPNOTSUPP);
+
+    lw_close_bus(&bus);
+
+    /* Backend bus: every call reaches the transport instead of an fd */
+    fake_backend fake;
+    memset(&fake, 0, sizeof(fake));
+    EXPECT_ERR(lw_open_backend(&bus, "/dev/i2c-3", NULL, &fake), EINVAL);
+    assert(lw_open_backend(&bus, "/dev/i2c-3", fake_transfer, &fake) == 0);
+    assert(bus.fd == -1 && strcmp(bus.device_path, "/dev/i2c-3") == 0);
+    lw_set_error_logging(&bus, 0);
+
+    assert(lw_set_slave(&bus, 0x48) == 0);
+    assert(lw_write(&bus, &reg, 1, 1) == 1);
+    assert(fake.count == 1 && fake.msgs[0].addr == 0x48 && fake.msgs[0].flags == 0);
+    assert(lw_read(&bus, sample, 2) == 2);
+    assert(fake.msgs[0].flags == LW_MSG_RD && sample[0] == 0x5A && sample[1] == 0x5A);
+
+    memset(sample, 0, sizeof(sample));
+    assert(lw_ioctl_read(&bus, 0x68, &reg, 1, sample, 6, 0) == 6);
+    assert(fake.count == 2 && fake.msgs[0].addr == 0x68 && fake.msgs[1].len == 6);
+    assert(sample[5] == 0x5A);
+    assert(lw_prepare_read(&prep, &bus, 0x68, 0x3B, 1, sample, sizeof(sample)) == 0);
+    assert(lw_prepared_exec(&prep) == 0);
+    assert(lw_wait_ready(&bus, 0x50, 0, 0, 0) == 0);
+    assert(fake.calls == 5);
+
+    fake.fail_errno = ENXIO;
+    EXPECT_ERR(lw_transfer(&bus, &probe, 1), ENXIO);
+    EXPECT_ERR(lw_write(&bus, &reg, 1, 1), ENXIO);
+
+    lw_close_bus(&bus);
+    assert(bus.backend == NULL);
+    EXPECT_ERR(lw_transfer(&bus, &probe, 1), EBADF);
+
     return 0;
 }
@@ -0,0 +1,191 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_monitor.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static lw_xfer_event make_event(uint16_t msgs, uint32_t bytes, int err)
+{
+    lw_xfer_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.op = LW_OP_TRANSFER;
+    ev.addr = 0x50;
+    ev.msgs = msgs;
+    ev.bytes = bytes;
+    ev.err = err;
+    return ev;
+}
+
+static void test_wire_time_estimate(void)
+{
+    /* Register read of 6 bytes: 2 x (START + addr) + 7 bytes x 9 + STOP = 84 bits */
+    lw_xfer_event ev = make_event(2, 7, 0);
+    assert(lw_monitor_wire_ns(100000, &ev) == 840000);
+    assert(lw_monitor_wire_ns(400000, &ev) == 210000);
+
+    ev.ten_bit_msgs = 2; /* second address byte per message */
+    assert(lw_monitor_wire_ns(100000, &ev) == 1020000);
+
+    /* NACK: START, address, STOP only */
+    ev = make_event(2, 7, ENXIO);
+    assert(lw_monitor_wire_ns(100000, &ev) == 110000);
+    assert(lw_monitor_wire_ns(0, &ev) == 0);
+}
+
+static void test_sliding_windows(void)
+{
+    lw_monitor mon;
+    assert(lw_monitor_init(&mon, NULL, 100000) == 0); /* 100 ms slots */
+    assert(strcmp(mon.label, "i2c") == 0);
+    assert(mon.bus_hz == LINUX_WIRE_MONITOR_DEFAULT_HZ);
+
+    /* 10 ms of traffic per 100 ms slot for 20 s (10% load) */
+    const uint64_t t0 = (mon.started_us / 100000 + 1) * 100000;
+    lw_xfer_event ev = make_event(1, 110, 0); /* 1001 bits = 10.01 ms at 100 kHz */
+    for (uint64_t t = 0; t < 20000000; t += 100000)
+    {
+        lw_monitor_record_at(&mon, &ev, t0 + t + 50000);
+    }
+    const uint64_t now = t0 + 20000000;
+    assert(fabs(lw_monitor_busy_ratio(&mon, 1000000, now) - 0.1) < 0.01);
+    assert(fabs(lw_monitor_busy_ratio(&mon, 10000000, now) - 0.1) < 0.01);
+    /* Window longer than the monitor's age is clipped to the age */
+    assert(fabs(lw_monitor_busy_ratio(&mon, 60000000, now) - 0.1) < 0.01);
+
+    /* Burst to saturation in the last second, idle before it */
+    for (uint64_t t = 0; t < 1000000; t += 10000)
+    {
+        lw_monitor_record_at(&mon, &ev, now + 1000000 + t);
+    }
+    const uint64_t later = now + 2000000;
+    assert(lw_monitor_busy_ratio(&mon, 1000000, later) > 0.95);
+    assert(lw_monitor_busy_ratio(&mon, 10000000, later) < 0.2);
+
+    /* Slots older than the history are forgotten */
+    const uint64_t much_later = later + (uint64_t)LINUX_WIRE_MONITOR_SLOTS * 100000 + 1000000;
+    assert(lw_monitor_busy_ratio(&mon, 60000000, much_later) == 0.0);
+
+    lw_monitor_stats stats;
+    assert(lw_monitor_get_stats(&mon, &stats) == 0);
+    assert(stats.transactions == 300 && stats.errors == 0);
+    assert(stats.bytes == 300 * 110);
+    assert(stats.busy_ns == 300ULL * 10010000ULL);
+
+    lw_monitor_destroy(&mon);
+}
+
+static void test_observer_and_prometheus(void)
+{
+    lw_i2c_bus bus;
+    memset(&bus, 0, sizeof(bus));
+    bus.fd = open("/dev/null", O_RDWR);
+    assert(bus.fd >= 0);
+    strcpy(bus.device_path, "/dev/i2c-3");
+    bus.caps.bus_hz = 400000;
+    lw_set_error_logging(&bus, 0);
+
+    lw_monitor mon;
+    assert(lw_monitor_init(&mon, &bus, 0) == 0);
+    assert(strcmp(mon.label, "i2c-3") == 0);
+    assert(mon.bus_hz == 400000);
+    assert(lw_monitor_attach(&mon, &bus) == 0);
+
+    /* /dev/null rejects I2C_RDWR: every call is seen as a failed transaction */
+    uint8_t reg = 0x00;
+    uint8_t data[4];
+    assert(lw_ioctl_read(&bus, 0x68, &reg, 1, data, sizeof(data), 0) == -1);
+    assert(errno == ENOTTY);
+    assert(lw_write(&bus, data, sizeof(data), 1) == 4);
+
+    lw_monitor_stats stats;
+    assert(lw_monitor_get_stats(&mon, &stats) == 0);
+    assert(stats.transactions == 2 && stats.errors == 1 && stats.bytes == 4);
+
+    lw_bus_set_observer(&bus, NULL, NULL);
+    assert(lw_write(&bus, data, sizeof(data), 1) == 4);
+    assert(lw_monitor_get_stats(&mon, &stats) == 0 && stats.transactions == 2);
+
+    char path[] = "/tmp/lw_prom_XXXXXX";
+    const int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    lw_monitor *const mons[1] = {&mon};
+    assert(lw_monitor_dump_prometheus(mons, 1, path) == 0);
+
+    FILE *f = fopen(path, "r");
+    assert(f);
+    char text[4096];
+    const size_t n = fread(text, 1, sizeof(text) - 1, f);
+    text[n] = '\0';
+    fclose(f);
+    unlink(path);
+
+    assert(strstr(text, "# TYPE linux_wire_bus_busy_ratio gauge\n"));
+    assert(strstr(text, "linux_wire_bus_busy_ratio{bus=\"i2c-3\",window=\"10s\"} "));
+    assert(strstr(text, "linux_wire_bus_clock_hz{bus=\"i2c-3\"} 400000\n"));
+    assert(strstr(text, "linux_wire_bus_transactions_total{bus=\"i2c-3\"} 2\n"));
+    assert(strstr(text, "linux_wire_bus_errors_total{bus=\"i2c-3\"} 1\n"));
+    assert(strstr(text, "# TYPE linux_wire_bus_busy_seconds_total counter\n"));
+
+    errno = 0;
+    assert(lw_monitor_dump_prometheus(mons, 1, "") == -1 && errno == EINVAL);
+
+    lw_close_bus(&bus);
+    lw_monitor_destroy(&mon);
+}
+
+static void *record_loop(void *arg)
+{
+    lw_monitor *mon = (lw_monitor *)arg;
+    const lw_xfer_event ev = make_event(1, 1, 0);
+    for (uint64_t t = 0; t < 200000; ++t)
+    {
+        lw_monitor_record_at(mon, &ev, mon->started_us + t * 50); /* new slot every 2000 */
+    }
+    return NULL;
+}
+
+static void test_lock_free_recording(void)
+{
+    lw_monitor mon;
+    assert(lw_monitor_init(&mon, NULL, 100000) == 0);
+
+    /* Queries race with the recorder; they only ever see whole slots */
+    pthread_t recorder;
+    assert(pthread_create(&recorder, NULL, record_loop, &mon) == 0);
+    uint64_t seen = 0;
+    for (int i = 0; i < 2000; ++i)
+    {
+        lw_monitor_stats stats;
+        assert(lw_monitor_get_stats(&mon, &stats) == 0);
+        assert(stats.transactions >= seen);
+        seen = stats.transactions;
+        const double r = lw_monitor_busy_ratio(&mon, 10000000, mon.started_us + 10000000);
+        assert(r >= 0.0 && r <= 1.0);
+    }
+    assert(pthread_join(recorder, NULL) == 0);
+
+    lw_monitor_stats stats;
+    assert(lw_monitor_get_stats(&mon, &stats) == 0);
+    assert(stats.transactions == 200000 && stats.bytes == 200000);
+    lw_monitor_destroy(&mon);
+}
+
+int main(void)
+{
+    test_wire_time_estimate();
+    test_sliding_windows();
+    test_observer_and_prometheus();
+    test_lock_free_recording();
+
+    puts("linux_wire monitor tests passed");
+    return 0;
+}
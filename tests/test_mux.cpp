@@ -0,0 +1,195 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "linux_wire_mux.h"
+#include "mock_linux_wire.h"
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static void testSelectionIsCached()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x70, 8) == 0);
+    assert(mux.current == LW_MUX_UNKNOWN);
+
+    uint8_t data[2];
+    mockLinuxWireSetIoctlReadData({0x12, 0x34});
+    assert(lw_mux_read_reg(&mux, 2, 0x48, 0x00, 1, data, sizeof(data)) == 2);
+    assert(lw_mux_read_reg(&mux, 2, 0x48, 0x00, 1, data, sizeof(data)) == 2);
+    assert(data[0] == 0x12 && data[1] == 0x34);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlWriteCalls == 1); // one switch for both reads
+    assert(state.ioctlWriteAddrs[0] == 0x70);
+    assert(state.ioctlWrites[0] == std::vector<uint8_t>({0x04}));
+    assert(state.transferCalls == 2);
+    assert(state.lastTransfer.size() == 2 && state.lastTransfer[0].addr == 0x48);
+    assert(mux.current == 2 && mux.switches == 1 && mux.skipped == 1);
+
+    assert(lw_mux_read_reg(&mux, 5, 0x48, 0x00, 1, data, sizeof(data)) == 2);
+    assert(state.ioctlWrites.back() == std::vector<uint8_t>({0x20}));
+
+    assert(lw_mux_select(&mux, LW_MUX_NONE) == 0);
+    assert(state.ioctlWrites.back() == std::vector<uint8_t>({0x00}));
+    assert(state.ioctlWriteCalls == 3);
+}
+
+static void testFailureInvalidatesCache()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x71, 4) == 0);
+    uint8_t data[1];
+    assert(lw_mux_read_reg(&mux, 1, 0x40, 0x10, 1, data, 1) == 1);
+
+    mockLinuxWireForceTransferError(EREMOTEIO);
+    errno = 0;
+    assert(lw_mux_read_reg(&mux, 1, 0x40, 0x10, 1, data, 1) == -1);
+    assert(errno == EREMOTEIO);
+    assert(mux.current == LW_MUX_UNKNOWN);
+    mockLinuxWireClearTransferError();
+
+    assert(lw_mux_read_reg(&mux, 1, 0x40, 0x10, 1, data, 1) == 1);
+    assert(mockLinuxWireState().ioctlWriteCalls == 2); // reselected after the failure
+
+    lw_mux_invalidate(&mux);
+    assert(lw_mux_read_reg(&mux, 1, 0x40, 0x10, 1, data, 1) == 1);
+    assert(mockLinuxWireState().ioctlWriteCalls == 3);
+}
+
+static void testSelectionFoldedIntoTransfer()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x70, 8) == 0);
+    mux.flags = LW_MUX_SELECT_ON_ACK;
+
+    uint8_t data[2];
+    assert(lw_mux_read_reg(&mux, 1, 0x48, 0x00, 1, data, sizeof(data)) == 2);
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlWriteCalls == 0);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 3);
+    assert(state.lastTransfer[0].addr == 0x70);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0x02}));
+    assert(state.lastTransfer[1].addr == 0x48);
+
+    // Already selected: plain device transfer
+    assert(lw_mux_read_reg(&mux, 1, 0x48, 0x00, 1, data, sizeof(data)) == 2);
+    assert(state.lastTransfer.size() == 2);
+}
+
+static void testBatchGroupedByChannel()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x70, 8) == 0);
+    assert(lw_mux_select(&mux, 3) == 0);
+
+    uint8_t buf[5][1];
+    lw_msg msgs[5];
+    lw_mux_job jobs[5];
+    const uint8_t channels[5] = {1, 3, 0, 3, 1};
+    for (int i = 0; i < 5; ++i)
+    {
+        msgs[i] = {static_cast<uint16_t>(0x40 + i), LW_MSG_RD, 1, buf[i]};
+        jobs[i] = {channels[i], &msgs[i], 1, 0, 0};
+    }
+
+    assert(lw_mux_run(&mux, jobs, 5) == 0);
+    const auto &state = mockLinuxWireState();
+    // Channel 3 (current) first, then 0, then 1: two switches instead of four
+    assert(state.ioctlWrites.size() == 3);
+    assert(state.ioctlWrites[1] == std::vector<uint8_t>({0x01}));
+    assert(state.ioctlWrites[2] == std::vector<uint8_t>({0x02}));
+    assert(state.lastTransfer[0].addr == 0x44); // last job on channel 1
+    for (const auto &job : jobs)
+    {
+        assert(job.result == 1 && job.error == 0);
+    }
+
+    jobs[0].channel = 8;
+    errno = 0;
+    assert(lw_mux_run(&mux, jobs, 5) == -1 && errno == EINVAL);
+}
+
+static void testInvalidArguments()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x70, 0) == -1);
+    assert(lw_mux_init(&mux, &bus, 0x70, 9) == -1);
+    assert(lw_mux_init(&mux, &bus, 0x80, 8) == -1);
+    assert(lw_mux_init(&mux, &bus, 0x70, 4) == 0);
+    errno = 0;
+    assert(lw_mux_select(&mux, 4) == -1 && errno == EINVAL);
+    uint8_t data[1];
+    assert(lw_mux_read_reg(&mux, 4, 0x40, 0, 1, data, 1) == -1);
+    assert(lw_mux_read_reg(&mux, 0, 0x40, 0, 5, data, 1) == -1);
+    assert(mockLinuxWireState().ioctlWriteCalls == 0);
+}
+
+static void testKernelMuxMapping()
+{
+    char root[] = "/tmp/lw_mux_XXXXXX";
+    assert(mkdtemp(root) != nullptr);
+    const std::string r = root;
+
+    // i2c-1 has a kernel-driven PCA9548 at 0x70 exposing i2c-4 as channel 2
+    assert(mkdir((r + "/1-0070").c_str(), 0700) == 0);
+    assert(mkdir((r + "/i2c-4").c_str(), 0700) == 0);
+    assert(mkdir((r + "/i2c-1").c_str(), 0700) == 0);
+    assert(symlink("../1-0070", (r + "/i2c-4/mux_device").c_str()) == 0);
+    assert(symlink("../i2c-3", (r + "/1-0070/channel-1").c_str()) == 0);
+    assert(symlink("../i2c-4", (r + "/1-0070/channel-2").c_str()) == 0);
+    assert(mkdir((r + "/1-0070/driver").c_str(), 0700) == 0);
+
+    lw_mux_adapter info;
+    assert(lw_mux_find_parent(4, root, &info) == 0);
+    assert(info.parent == 1 && info.addr == 0x70 && info.channel == 2);
+
+    errno = 0;
+    assert(lw_mux_find_parent(1, root, &info) == -1 && errno == ENOENT);
+
+    assert(lw_mux_kernel_owned(1, 0x70, root) == 1);
+    assert(lw_mux_kernel_owned(1, 0x71, root) == 0);
+
+    std::filesystem::remove_all(r);
+}
+
+int main()
+{
+    testSelectionIsCached();
+    testFailureInvalidatesCache();
+    testSelectionFoldedIntoTransfer();
+    testBatchGroupedByChannel();
+    testInvalidArguments();
+    testKernelMuxMapping();
+
+    std::puts("linux_wire mux tests passed");
+    return 0;
+}
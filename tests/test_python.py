@@ -0,0 +1,148 @@
+"""Tests for the linux_wire Python module, run against tests/fake_broker.c.
+
+The fake serves an EEPROM at 0x50 (register r initially holds r) and the
+same memory at 0x51 with 200 ms per transaction.
+"""
+
+import array
+import errno
+import os
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import unittest
+
+import linux_wire
+
+FAKE_BROKER = os.environ["LINUX_WIRE_FAKE_BROKER"]
+
+
+class BindingsTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.tmp = tempfile.TemporaryDirectory()
+        cls.paths = [os.path.join(cls.tmp.name, name) for name in ("a.sock", "b.sock")]
+        cls.broker = subprocess.Popen(
+            [FAKE_BROKER] + cls.paths, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True
+        )
+        assert cls.broker.stdout.readline().strip() == "ready"
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.broker.stdin.close()
+        cls.broker.wait(timeout=10)
+        cls.tmp.cleanup()
+
+    def setUp(self):
+        self.bus = linux_wire.Bus.connect(self.paths[0])
+        self.bus.write(0x50, bytes(range(16)), reg=0x00)
+
+    def tearDown(self):
+        self.bus.close()
+
+    def test_read_into_caller_buffers(self):
+        buf = bytearray(4)
+        self.assertEqual(self.bus.read_into(0x50, buf, reg=0x04), 4)
+        self.assertEqual(buf, bytes([4, 5, 6, 7]))
+
+        # A slice of a larger buffer is filled in place
+        frame = bytearray(8)
+        self.bus.read_into(0x50, memoryview(frame)[2:5], reg=0x0A)
+        self.assertEqual(frame, bytes([0, 0, 10, 11, 12, 0, 0, 0]))
+
+        words = array.array("H", [0, 0])
+        self.bus.read_into(0x50, words, reg=0x02)
+        self.assertEqual(words.tobytes(), bytes([2, 3, 4, 5]))
+
+        self.assertEqual(self.bus.read(0x50, 2, reg=0x0E), bytes([14, 15]))
+
+    def test_write_accepts_any_bytes_like(self):
+        self.assertEqual(self.bus.write(0x50, memoryview(b"\xaa\xbb"), reg=0x20), 2)
+        self.assertEqual(self.bus.write(0x50, array.array("B", [0xCC]), reg=0x22), 1)
+        self.assertEqual(self.bus.read(0x50, 3, reg=0x20), b"\xaa\xbb\xcc")
+
+    def test_transfer_and_gather(self):
+        out = bytearray(3)
+        msgs = [(0x50, 0, b"\x05"), (0x50, linux_wire.MSG_RD, out)]
+        self.assertEqual(self.bus.transfer(msgs), 2)
+        self.assertEqual(out, bytes([5, 6, 7]))
+
+        a, b = bytearray(2), bytearray(1)
+        self.assertEqual(self.bus.gather_read(0x50, [(0x01, a), (0x09, b)]), 3)
+        self.assertEqual((a, b), (bytes([1, 2]), bytes([9])))
+
+        with self.assertRaises(ValueError):
+            self.bus.transfer([(0x50, 0, b"")] * (linux_wire.MAX_MSGS + 1))
+
+    def test_prepared_read(self):
+        buf = bytearray(2)
+        prep = self.bus.prepare_read(0x50, 0x06, buf)
+        prep.exec()
+        self.assertEqual(buf, bytes([6, 7]))
+        self.bus.write(0x50, b"\x60\x70", reg=0x06)
+        prep.exec()
+        self.assertEqual(buf, bytes([0x60, 0x70]))
+        # The buffer stays exported while the prepared read exists
+        with self.assertRaises(BufferError):
+            buf.append(0)
+        del prep
+        buf.append(0)
+
+    def test_scan_and_wait_ready(self):
+        self.assertEqual(self.bus.scan(0x48, 0x4F), [])
+        self.assertEqual(self.bus.scan(0x50, 0x50), [0x50])
+        self.bus.wait_ready(0x50, 1000)
+        with self.assertRaises(TimeoutError):
+            self.bus.wait_ready(0x52, 2000, 500)
+
+    def test_errors(self):
+        with self.assertRaises(OSError) as ctx:
+            self.bus.read_into(0x60, bytearray(1), reg=0)
+        self.assertEqual(ctx.exception.errno, errno.ENXIO)
+        with self.assertRaises(TypeError):
+            self.bus.read_into(0x50, b"immutable", reg=0)
+        with self.assertRaises(ValueError):
+            self.bus.read_into(0x50, bytearray(1), reg=0x100)
+        with self.assertRaises(ValueError):
+            self.bus.read_into(0x10000, bytearray(1))
+        with self.assertRaises(FileNotFoundError):
+            linux_wire.Bus("/dev/i2c-250")
+
+        with self.assertRaises(FileNotFoundError):
+            linux_wire.Bus.connect(os.path.join(self.tmp.name, "missing.sock"))
+
+        with linux_wire.Bus.connect(self.paths[0]) as other:
+            self.assertEqual(other.path, "/dev/i2c-fake")
+        self.assertTrue(other.closed)
+        with self.assertRaises(ValueError):
+            other.read(0x50, 1)
+
+    def test_buses_run_in_parallel(self):
+        # Each slow read holds its adapter for 200 ms; with the GIL held
+        # the two would take 400 ms
+        other = linux_wire.Bus.connect(self.paths[1])
+        bufs = [bytearray(1), bytearray(1)]
+
+        def slow_read(bus, buf):
+            bus.read_into(0x51, buf, reg=0x03)
+
+        threads = [
+            threading.Thread(target=slow_read, args=(bus, buf))
+            for bus, buf in zip((self.bus, other), bufs)
+        ]
+        start = time.monotonic()
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        elapsed = time.monotonic() - start
+        other.close()
+
+        self.assertEqual(bufs, [bytearray([3]), bytearray([3])])
+        self.assertLess(elapsed, 0.35)
+
+
+if __name__ == "__main__":
+    unittest.main(argv=sys.argv[:1], verbosity=2)
@@ -0,0 +1,233 @@
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "linux_wire_readahead.h"
+#include "mock_linux_wire.h"
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+/* The mock answers every read with the leading bytes of this block */
+static std::vector<uint8_t> block16()
+{
+    std::vector<uint8_t> v(16);
+    for (std::size_t i = 0; i < v.size(); ++i)
+    {
+        v[i] = static_cast<uint8_t>(0x10 + i);
+    }
+    return v;
+}
+
+static void testSequentialReadsFetchBlocks()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra;
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 16, 0) == 0);
+
+    const auto &state = mockLinuxWireState();
+    uint8_t value = 0;
+
+    // The first read cannot be told apart from a one-off
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x03, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 1);
+
+    // The second one continues it: one block covers the next 16 registers
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x04, 1, &value, 1) == 1);
+    assert(value == 0x10);
+    assert(state.ioctlReadCalls == 2);
+    assert(state.lastIoctlInternal == std::vector<uint8_t>({0x04}));
+    for (uint8_t reg = 0x05; reg < 0x14; ++reg)
+    {
+        assert(lw_readahead_read(&bus, &ra, 0x1E, reg, 1, &value, 1) == 1);
+        assert(value == 0x10 + (reg - 0x04));
+    }
+    assert(state.ioctlReadCalls == 2);
+
+    // Past the block the sequence continues with the next one
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x14, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 3);
+    assert(state.lastIoctlInternal == std::vector<uint8_t>({0x14}));
+
+    // Forward skips within the block are hits; multi-byte reads too
+    uint8_t pair[2] = {0, 0};
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x17, 1, pair, 2) == 2);
+    assert(pair[0] == 0x13 && pair[1] == 0x14);
+    assert(state.ioctlReadCalls == 3);
+    assert(ra.reads == 19 && ra.hits == 16 && ra.fetches == 2);
+}
+
+static void testBackwardReadsGoToDevice()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra;
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 16, 0) == 0);
+
+    uint8_t value = 0;
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x00, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x01, 1, &value, 1) == 1);
+    assert(mockLinuxWireState().ioctlReadCalls == 2);
+
+    // Polling the same register again must see the device
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x01, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x01, 1, &value, 1) == 1);
+    assert(mockLinuxWireState().ioctlReadCalls == 4);
+    assert(ra.hits == 0);
+}
+
+static void testAutoIncrementBitOnBlockFetch()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra; // LIS3DH-style: OUT_X_L 0x28 .. OUT_Z_H 0x2D
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x19, 1, 0x80, 6, 0) == 0);
+
+    uint8_t value = 0;
+    assert(lw_readahead_read(&bus, &ra, 0x19, 0x28, 1, &value, 1) == 1);
+    assert(mockLinuxWireState().lastIoctlInternal == std::vector<uint8_t>({0x28}));
+    assert(lw_readahead_read(&bus, &ra, 0x19, 0x29, 1, &value, 1) == 1);
+    assert(mockLinuxWireState().lastIoctlInternal == std::vector<uint8_t>({0xA9}));
+
+    // The driver's own increment bit is ignored when matching registers
+    assert(lw_readahead_read(&bus, &ra, 0x19, 0xAA, 1, &value, 1) == 1);
+    assert(value == 0x11);
+    assert(mockLinuxWireState().ioctlReadCalls == 2);
+}
+
+static void testAgeLimitAndInvalidation()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra;
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 8, 2000) == 0);
+    assert(lw_readahead_add_device(&ra, 0x68, 1, 0, 8, 0) == 0);
+
+    const auto &state = mockLinuxWireState();
+    uint8_t value = 0;
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x00, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x01, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x02, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 2);
+
+    // A stale block is refetched; the sequence itself survives
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x03, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 3);
+    assert(ra.fetches == 2);
+
+    // A write ends the sequence: the next read is a plain one
+    lw_readahead_invalidate(&ra, 0x1E);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x04, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x05, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 5);
+    assert(ra.fetches == 3);
+
+    // Other devices are unaffected unless every device is invalidated
+    assert(lw_readahead_read(&bus, &ra, 0x68, 0x3B, 1, &value, 1) == 1);
+    assert(lw_readahead_read(&bus, &ra, 0x68, 0x3C, 1, &value, 1) == 1);
+    lw_readahead_invalidate(&ra, 0x1E);
+    assert(lw_readahead_read(&bus, &ra, 0x68, 0x3D, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 7);
+    lw_readahead_invalidate(&ra, LW_READAHEAD_ALL);
+    assert(lw_readahead_read(&bus, &ra, 0x68, 0x3E, 1, &value, 1) == 1);
+    assert(state.ioctlReadCalls == 8);
+}
+
+static void testFailedFetchDropsState()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra;
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 8, 0) == 0);
+
+    uint8_t value = 0;
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x00, 1, &value, 1) == 1);
+    mockLinuxWireForceReadError(ENXIO);
+    errno = 0;
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x01, 1, &value, 1) == -1);
+    assert(errno == ENXIO);
+    mockLinuxWireClearReadError();
+
+    // The sequence is gone: this is a one-off read, not a block fetch
+    assert(lw_readahead_read(&bus, &ra, 0x1E, 0x02, 1, &value, 1) == 1);
+    assert(ra.fetches == 0);
+}
+
+static void testPassThroughAndInvalidArguments()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData(block16());
+    lw_i2c_bus bus = openMockBus();
+
+    lw_readahead ra;
+    assert(lw_readahead_init(nullptr) == -1);
+    assert(lw_readahead_init(&ra) == 0);
+
+    errno = 0;
+    assert(lw_readahead_add_device(&ra, 0x1E, 0, 0, 8, 0) == -1);
+    assert(errno == EINVAL);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0x100, 8, 0) == -1);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 0, 0) == -1);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, LINUX_WIRE_READAHEAD_BLOCK_MAX + 1, 0) == -1);
+    for (uint16_t addr = 0; addr < LINUX_WIRE_READAHEAD_MAX_DEVICES; ++addr)
+    {
+        assert(lw_readahead_add_device(&ra, addr, 1, 0, 8, 0) == 0);
+    }
+    errno = 0;
+    assert(lw_readahead_add_device(&ra, 0x77, 1, 0, 8, 0) == -1);
+    assert(errno == ENOSPC);
+
+    // Undeclared devices and other register sizes are read as requested
+    uint8_t value = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        assert(lw_readahead_read(&bus, &ra, 0x50, static_cast<uint32_t>(i), 1, &value, 1) == 1);
+        assert(lw_readahead_read(&bus, &ra, 0x01, static_cast<uint32_t>(i), 2, &value, 1) == 1);
+    }
+    assert(mockLinuxWireState().ioctlReadCalls == 6);
+    assert(mockLinuxWireState().lastIoctlInternal == std::vector<uint8_t>({0x00, 0x02}));
+    assert(ra.fetches == 0);
+
+    assert(lw_readahead_read(&bus, &ra, 0x01, 0, 5, &value, 1) == -1);
+    assert(lw_readahead_read(&bus, &ra, 0x01, 0, 1, &value, 0) == -1);
+    assert(lw_readahead_read(&bus, &ra, 0x01, 0, 1, nullptr, 1) == -1);
+    lw_readahead_invalidate(nullptr, LW_READAHEAD_ALL);
+}
+
+int main()
+{
+    testSequentialReadsFetchBlocks();
+    testBackwardReadsGoToDevice();
+    testAutoIncrementBitOnBlockFetch();
+    testAgeLimitAndInvalidation();
+    testFailedFetchDropsState();
+    testPassThroughAndInvalidArguments();
+
+    std::puts("linux_wire readahead tests passed");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <sched.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "linux_wire_runtime.h"
+#include "mock_linux_wire.h"
+
+struct JobProbe
+{
+    const char *expectedPath;
+    int expectedCpu;
+    std::atomic<int> runs{0};
+    std::atomic<int> wrongBus{0};
+    std::atomic<int> wrongCpu{0};
+};
+
+static int probeJob(lw_i2c_bus *bus, void *arg)
+{
+    auto *probe = static_cast<JobProbe *>(arg);
+    if (std::strcmp(bus->device_path, probe->expectedPath) != 0)
+    {
+        ++probe->wrongBus;
+    }
+    if (probe->expectedCpu >= 0 && sched_getcpu() != probe->expectedCpu)
+    {
+        ++probe->wrongCpu;
+    }
+    return ++probe->runs;
+}
+
+static int failingJob(lw_i2c_bus * /*bus*/, void * /*arg*/)
+{
+    errno = EREMOTEIO;
+    return -1;
+}
+
+static void testJobsRouteToPinnedWorkers()
+{
+    mockLinuxWireReset();
+
+    lw_runtime rt;
+    assert(lw_runtime_init(&rt) == 0);
+
+    lw_worker_config cfg1 = {1, 0, 0};
+    lw_worker_config cfg3 = {3, -1, 0};
+    assert(lw_runtime_add_worker(&rt, &cfg1) == 0);
+    assert(lw_runtime_add_worker(&rt, &cfg3) == 0);
+    assert(mockLinuxWireState().openCalls == 2);
+
+    errno = 0;
+    assert(lw_runtime_add_worker(&rt, &cfg1) == -1);
+    assert(errno == EEXIST);
+
+    JobProbe probe1;
+    probe1.expectedPath = "/dev/i2c-1";
+    probe1.expectedCpu = 0;
+    JobProbe probe3;
+    probe3.expectedPath = "/dev/i2c-3";
+    probe3.expectedCpu = -1;
+
+    // Several producer threads submit to both adapters concurrently
+    constexpr int kPerThread = 50;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t)
+    {
+        producers.emplace_back([&rt, &probe1, &probe3]() {
+            std::vector<lw_job> jobs(2 * kPerThread);
+            for (int i = 0; i < kPerThread; ++i)
+            {
+                lw_job &a = jobs[2 * i];
+                lw_job &b = jobs[2 * i + 1];
+                std::memset(&a, 0, sizeof(a));
+                std::memset(&b, 0, sizeof(b));
+                a.fn = probeJob;
+                a.arg = &probe1;
+                b.fn = probeJob;
+                b.arg = &probe3;
+                assert(lw_runtime_submit(&rt, 1, &a) == 0);
+                assert(lw_runtime_submit(&rt, 3, &b) == 0);
+            }
+            for (lw_job &job : jobs)
+            {
+                assert(lw_runtime_wait(&job) > 0);
+            }
+        });
+    }
+    for (std::thread &t : producers)
+    {
+        t.join();
+    }
+
+    assert(probe1.runs == 4 * kPerThread);
+    assert(probe3.runs == 4 * kPerThread);
+    assert(probe1.wrongBus == 0 && probe3.wrongBus == 0);
+    assert(probe1.wrongCpu == 0);
+
+    lw_worker_stats stats;
+    assert(lw_runtime_get_stats(&rt, 1, &stats) == 0);
+    assert(stats.jobs == 4 * kPerThread);
+    assert(stats.queue_depth == 0);
+    assert(stats.busy_us <= stats.elapsed_us);
+
+    lw_runtime_shutdown(&rt);
+    assert(mockLinuxWireState().closeCalls == 2);
+}
+
+static void testCallReportsErrorsAndUnknownAdapters()
+{
+    mockLinuxWireReset();
+
+    lw_runtime rt;
+    assert(lw_runtime_init(&rt) == 0);
+    lw_worker_config cfg = {2, -1, 0};
+    assert(lw_runtime_add_worker(&rt, &cfg) == 0);
+
+    errno = 0;
+    assert(lw_runtime_call(&rt, 2, failingJob, nullptr) == -1);
+    assert(errno == EREMOTEIO);
+
+    errno = 0;
+    assert(lw_runtime_call(&rt, 7, failingJob, nullptr) == -1);
+    assert(errno == ENODEV);
+
+    lw_worker_stats stats;
+    assert(lw_runtime_get_stats(&rt, 7, &stats) == -1);
+
+    lw_worker_config bad = {4, -1, -1};
+    errno = 0;
+    assert(lw_runtime_add_worker(&rt, &bad) == -1);
+    assert(errno == EINVAL);
+
+    lw_runtime_shutdown(&rt);
+}
+
+static void testShutdownFinishesQueuedJobs()
+{
+    mockLinuxWireReset();
+
+    lw_runtime rt;
+    assert(lw_runtime_init(&rt) == 0);
+    lw_worker_config cfg = {5, -1, 0};
+    assert(lw_runtime_add_worker(&rt, &cfg) == 0);
+
+    JobProbe probe;
+    probe.expectedPath = "/dev/i2c-5";
+    probe.expectedCpu = -1;
+    std::vector<lw_job> jobs(32);
+    for (lw_job &job : jobs)
+    {
+        std::memset(&job, 0, sizeof(job));
+        job.fn = probeJob;
+        job.arg = &probe;
+        assert(lw_runtime_submit(&rt, 5, &job) == 0);
+    }
+
+    lw_runtime_shutdown(&rt);
+    assert(probe.runs == 32);
+    for (const lw_job &job : jobs)
+    {
+        assert(job.done);
+    }
+}
+
+int main()
+{
+    testJobsRouteToPinnedWorkers();
+    testCallReportsErrorsAndUnknownAdapters();
+    testShutdownFinishesQueuedJobs();
+
+    std::puts("linux_wire runtime tests passed");
+    return 0;
+}
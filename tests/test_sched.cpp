@@ -0,0 +1,157 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "linux_wire_sched.h"
+#include "mock_linux_wire.h"
+
+static void waitForWaiters(lw_sched *sched, std::size_t count)
+{
+    while (lw_sched_waiting(sched) < count)
+    {
+        std::this_thread::yield();
+    }
+}
+
+static void testChunkedWriteAdvancesAddress()
+{
+    mockLinuxWireReset();
+
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+
+    lw_sched sched;
+    assert(lw_sched_init(&sched, &bus, LW_SCHED_PRIORITY) == 0);
+    assert(lw_sched_set_chunk_size(&sched, 32) == 0);
+
+    std::vector<uint8_t> payload(100, 0x5A);
+    const uint8_t iaddr[2] = {0x00, 0xF0};
+    ssize_t written = lw_sched_ioctl_write(&sched, nullptr, 0x50, iaddr, 2,
+                                           payload.data(), payload.size(), 0);
+    assert(written == 100);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.writeCalls == 4);
+    assert(state.lastWriteBuffer.size() == 2 + 4);
+    assert(state.lastWriteBuffer[0] == 0x01); // 0x00F0 + 96
+    assert(state.lastWriteBuffer[1] == 0x50);
+
+    lw_sched_destroy(&sched);
+}
+
+static void testChunkedReadFillsBuffer()
+{
+    mockLinuxWireReset();
+    std::vector<uint8_t> chunk(16);
+    for (std::size_t i = 0; i < chunk.size(); ++i)
+    {
+        chunk[i] = static_cast<uint8_t>(i);
+    }
+    mockLinuxWireSetIoctlReadData(chunk);
+
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+
+    lw_sched sched;
+    assert(lw_sched_init(&sched, &bus, LW_SCHED_EDF) == 0);
+    assert(lw_sched_set_chunk_size(&sched, 16) == 0);
+
+    uint8_t out[40] = {0};
+    const uint8_t reg = 0x10;
+    assert(lw_sched_ioctl_read(&sched, nullptr, 0x68, &reg, 1, out, sizeof(out), 0) == 40);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlReadCalls == 3);
+    assert(state.lastIoctlInternal.size() == 1);
+    assert(state.lastIoctlInternal[0] == 0x30);
+    assert(out[16] == 0 && out[39] == 7);
+
+    lw_sched_destroy(&sched);
+}
+
+static void testRunOrder(lw_sched_policy policy,
+                         const lw_sched_tag &first,
+                         const lw_sched_tag &second,
+                         int expectedFirst)
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+
+    lw_sched sched;
+    assert(lw_sched_init(&sched, &bus, policy) == 0);
+
+    std::vector<int> order;
+    assert(lw_sched_acquire(&sched, nullptr) == 0);
+
+    auto client = [&](const lw_sched_tag *tag, int id) {
+        lw_sched_acquire(&sched, tag);
+        order.push_back(id);
+        lw_sched_release(&sched);
+    };
+
+    std::thread a(client, &first, 1);
+    waitForWaiters(&sched, 1);
+    std::thread b(client, &second, 2);
+    waitForWaiters(&sched, 2);
+
+    lw_sched_release(&sched);
+    a.join();
+    b.join();
+
+    assert(order.size() == 2);
+    assert(order[0] == expectedFirst);
+
+    lw_sched_destroy(&sched);
+}
+
+static void testStrictPriorityPreemptsFifo()
+{
+    mockLinuxWireReset();
+    lw_sched_tag bulk = {0, 0};
+    lw_sched_tag control = {10, 0};
+    testRunOrder(LW_SCHED_PRIORITY, bulk, control, 2);
+    testRunOrder(LW_SCHED_PRIORITY, bulk, bulk, 1);
+}
+
+static void testEdfPrefersEarliestDeadline()
+{
+    mockLinuxWireReset();
+    lw_sched_tag background = {100, 0};
+    lw_sched_tag imu = {0, 1000};
+    lw_sched_tag relaxed = {0, 1000000};
+    testRunOrder(LW_SCHED_EDF, background, imu, 2);
+    testRunOrder(LW_SCHED_EDF, relaxed, imu, 2);
+}
+
+static void testInvalidArguments()
+{
+    lw_sched sched;
+    lw_i2c_bus bus;
+    assert(lw_sched_init(nullptr, &bus, LW_SCHED_PRIORITY) == -1);
+    assert(lw_sched_init(&sched, nullptr, LW_SCHED_PRIORITY) == -1);
+
+    mockLinuxWireReset();
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    assert(lw_sched_init(&sched, &bus, LW_SCHED_PRIORITY) == 0);
+    assert(lw_sched_set_chunk_size(&sched, 0) == -1);
+
+    uint8_t buf[4] = {0};
+    assert(lw_sched_ioctl_read(&sched, nullptr, 0x10, nullptr, 1, buf, 4, 0) == -1);
+    assert(lw_sched_ioctl_write(&sched, nullptr, 0x10, nullptr, 0, nullptr, 4, 0) == -1);
+    lw_sched_destroy(&sched);
+}
+
+int main()
+{
+    testChunkedWriteAdvancesAddress();
+    testChunkedReadFillsBuffer();
+    testStrictPriorityPreemptsFifo();
+    testEdfPrefersEarliestDeadline();
+    testInvalidArguments();
+
+    std::puts("linux_wire sched tests passed");
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linux_wire_shm.h"
+#include "mock_linux_wire.h"
+
+static std::string segmentName(const char *tag)
+{
+    return "/lw_test_" + std::string(tag) + "_" + std::to_string(getpid());
+}
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static void testPollPublishesToReaders()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+    const std::string name = segmentName("poll");
+
+    const lw_shm_reg regs[3] = {
+        {0x68, 0x3B, 1, 6}, // accel XYZ
+        {0x68, 0x41, 1, 2}, // temperature
+        {0x76, 0xF7, 1, 3}, // pressure on another device
+    };
+    lw_shm_publisher pub;
+    assert(lw_shm_publisher_open(&pub, name.c_str(), regs, 3) == 0);
+
+    lw_shm_reader reader;
+    assert(lw_shm_reader_open(&reader, name.c_str()) == 0);
+    assert(lw_shm_reader_slots(&reader) == 3);
+
+    lw_shm_sample sample;
+    assert(lw_shm_read(&reader, 1, &sample) == 0);
+    assert(sample.updates == 0);
+
+    mockLinuxWireQueueTransferReadData({1, 2, 3, 4, 5, 6, 0x0A, 0x0B});
+    mockLinuxWireQueueTransferReadData({0x50, 0x60, 0x70});
+    assert(lw_shm_publisher_poll(&pub, &bus) == 0);
+
+    // Same-device slots share one gather transaction
+    const auto &state = mockLinuxWireState();
+    assert(state.gatherReadCalls == 2);
+    assert(state.lastGatherAddr == 0x76);
+
+    const int temp = lw_shm_find(&reader, 0x68, 0x41);
+    assert(temp == 1);
+    assert(lw_shm_read(&reader, static_cast<size_t>(temp), &sample) == 0);
+    assert(sample.addr == 0x68 && sample.reg == 0x41 && sample.len == 2);
+    assert(sample.err == 0 && sample.updates == 1 && sample.timestamp_us > 0);
+    assert(sample.value[0] == 0x0A && sample.value[1] == 0x0B);
+
+    assert(lw_shm_read(&reader, 2, &sample) == 0);
+    assert(std::memcmp(sample.value, "\x50\x60\x70", 3) == 0);
+
+    errno = 0;
+    assert(lw_shm_find(&reader, 0x68, 0x43) == -1);
+    assert(errno == ENOENT);
+
+    // A failed read keeps the last value and reports the error
+    mockLinuxWireForceTransferError(EREMOTEIO);
+    assert(lw_shm_publisher_poll(&pub, &bus) == 3);
+    assert(lw_shm_read(&reader, 1, &sample) == 0);
+    assert(sample.err == EREMOTEIO && sample.updates == 2);
+    assert(sample.value[0] == 0x0A && sample.value[1] == 0x0B);
+    mockLinuxWireClearTransferError();
+
+    const uint8_t temp_value[2] = {0x0C, 0x0D};
+    assert(lw_shm_publish(&pub, 1, temp_value, 2, 0) == 0);
+    assert(lw_shm_read(&reader, 1, &sample) == 0);
+    assert(sample.err == 0 && sample.value[0] == 0x0C && sample.value[1] == 0x0D);
+
+    lw_shm_reader_close(&reader);
+    lw_shm_publisher_close(&pub, 1);
+
+    errno = 0;
+    assert(lw_shm_reader_open(&reader, name.c_str()) == -1);
+    assert(errno == ENOENT);
+}
+
+static void testReadersSeeConsistentSnapshots()
+{
+    const std::string name = segmentName("race");
+    const lw_shm_reg reg = {0x10, 0x00, 1, LINUX_WIRE_SHM_VALUE_MAX};
+    lw_shm_publisher pub;
+    assert(lw_shm_publisher_open(&pub, name.c_str(), &reg, 1) == 0);
+
+    lw_shm_reader reader;
+    assert(lw_shm_reader_open(&reader, name.c_str()) == 0);
+
+    // Every published value has all bytes equal; a torn copy would not
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        uint8_t value[LINUX_WIRE_SHM_VALUE_MAX];
+        for (unsigned int i = 0; i < 200000; ++i)
+        {
+            std::memset(value, static_cast<int>(i & 0xFF), sizeof(value));
+            assert(lw_shm_publish(&pub, 0, value, sizeof(value), 0) == 0);
+        }
+        done = true;
+    });
+
+    uint64_t last_updates = 0;
+    size_t reads = 0;
+    while (!done || reads == 0)
+    {
+        lw_shm_sample sample;
+        if (lw_shm_read(&reader, 0, &sample) != 0)
+        {
+            assert(errno == EAGAIN);
+            continue;
+        }
+        for (size_t i = 1; i < sizeof(sample.value); ++i)
+        {
+            assert(sample.value[i] == sample.value[0]);
+        }
+        if (sample.updates > 0)
+        {
+            assert(static_cast<uint8_t>((sample.updates - 1) & 0xFF) == sample.value[0]);
+        }
+        assert(sample.updates >= last_updates);
+        last_updates = sample.updates;
+        ++reads;
+    }
+    writer.join();
+
+    lw_shm_reader_close(&reader);
+    lw_shm_publisher_close(&pub, 1);
+}
+
+static void testInvalidConfiguration()
+{
+    const lw_shm_reg good = {0x10, 0x00, 1, 2};
+    lw_shm_publisher pub;
+    lw_shm_reader reader;
+
+    const char *bad_names[] = {"noslash", "/", "/a/b", nullptr};
+    for (const char *name : bad_names)
+    {
+        errno = 0;
+        assert(lw_shm_publisher_open(&pub, name, &good, 1) == -1);
+        assert(errno == EINVAL);
+        errno = 0;
+        assert(lw_shm_reader_open(&reader, name) == -1);
+        assert(errno == EINVAL);
+    }
+
+    const std::string name = segmentName("bad");
+    const lw_shm_reg bad_regs[] = {
+        {0x10, 0x00, 0, 2},
+        {0x10, 0x00, 5, 2},
+        {0x10, 0x00, 1, 0},
+        {0x10, 0x00, 1, LINUX_WIRE_SHM_VALUE_MAX + 1},
+    };
+    for (const lw_shm_reg &reg : bad_regs)
+    {
+        errno = 0;
+        assert(lw_shm_publisher_open(&pub, name.c_str(), &reg, 1) == -1);
+        assert(errno == EINVAL);
+    }
+    assert(lw_shm_publisher_open(&pub, name.c_str(), &good, 0) == -1);
+
+    assert(lw_shm_publisher_open(&pub, name.c_str(), &good, 1) == 0);
+    const uint8_t value[3] = {1, 2, 3};
+    assert(lw_shm_publish(&pub, 0, value, 3, 0) == -1); // wrong length
+    assert(lw_shm_publish(&pub, 1, value, 2, 0) == -1); // no such slot
+    assert(lw_shm_publish(&pub, 0, nullptr, 0, EIO) == 0);
+    lw_shm_publisher_close(&pub, 1);
+}
+
+int main()
+{
+    testPollPublishesToReaders();
+    testReadersSeeConsistentSnapshots();
+    testInvalidConfiguration();
+
+    std::puts("linux_wire shm tests passed");
+    return 0;
+}
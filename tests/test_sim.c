@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "linux_wire_eeprom.h"
+#include "linux_wire_fifo.h"
+#include "linux_wire_mux.h"
+#include "linux_wire_sim.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define EXPECT_ERR(call, err)       \
+    do                              \
+    {                               \
+        errno = 0;                  \
+        assert((call) == -1);       \
+        assert(errno == (err));     \
+    } while (0)
+
+static void test_wire_timing(void)
+{
+    lw_sim_bus sim;
+    lw_i2c_bus bus;
+    uint8_t regs[16] = {0};
+    lw_sim_regs dev;
+    assert(lw_sim_init(&sim, 0) == 0);
+    assert(lw_sim_regs_init(&dev, 0x48, regs, sizeof(regs), 0) == 0);
+    assert(lw_sim_add(&sim, &dev.dev) == 0);
+    assert(lw_sim_open(&sim, &bus, NULL) == 0);
+    assert(strcmp(bus.device_path, "/dev/i2c-sim") == 0);
+
+    /* 100 kHz: START + address (10 bits) + 2 data bytes (18) + STOP (1) */
+    const uint8_t cfg[2] = {0x01, 0x60};
+    assert(lw_ioctl_write(&bus, 0x48, NULL, 0, cfg, sizeof(cfg), 0) == 2);
+    assert(sim.busy_ns == 290000);
+    assert(lw_sim_now_us(&sim) == 290);
+    assert(regs[1] == 0x60);
+
+    /* Register read as one combined transaction: two STARTs, one STOP */
+    sim.bus_hz = 400000;
+    sim.overhead_ns = 50000;
+    uint8_t out[2];
+    const uint8_t reg = 0x00;
+    assert(lw_ioctl_read(&bus, 0x48, &reg, 1, out, sizeof(out), 0) == 2);
+    assert(out[1] == 0x60);
+    assert(sim.busy_ns == 290000 + 50000 + (10 + 9 + 10 + 18 + 1) * 2500);
+    assert(sim.transactions == 2 && sim.messages == 3 && sim.bytes == 5);
+
+    /* Nobody at 0x49: the address NACK fails the whole transaction */
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x49, &reg, 1, out, 1, 0), ENXIO);
+    assert(sim.nacks == 1);
+
+    lw_sim_advance(&sim, 1000);
+    assert(lw_sim_now_us(&sim) >= 1000);
+
+    EXPECT_ERR(lw_sim_add(&sim, &dev.dev), EEXIST);
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+static void test_eeprom_pages_and_write_cycle(void)
+{
+    static uint8_t mem[4096];
+    lw_sim_bus sim;
+    lw_sim_eeprom rom; /* 24C32: 32-byte pages, 2-byte addresses */
+    lw_i2c_bus bus;
+    memset(mem, 0xFF, sizeof(mem));
+    assert(lw_sim_init(&sim, 400000) == 0);
+    assert(lw_sim_eeprom_init(&rom, 0x50, mem, sizeof(mem), 32, 2, 5000) == 0);
+    assert(lw_sim_add(&sim, &rom.dev) == 0);
+    assert(lw_sim_open(&sim, &bus, "/dev/i2c-7") == 0);
+
+    /* A page write wraps within the page and is busy until the cycle ends */
+    uint8_t data[40];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (uint8_t)i;
+    }
+    const uint8_t at_0100[2] = {0x01, 0x00};
+    assert(lw_ioctl_write(&bus, 0x50, at_0100, 2, data, sizeof(data), 0) == 40);
+    assert(rom.writes == 1);
+    assert(mem[0x100] == 32 && mem[0x107] == 39 && mem[0x108] == 8 && mem[0x11F] == 31);
+    uint8_t out[4];
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x50, at_0100, 2, out, sizeof(out), 0), ENXIO);
+    lw_sim_advance(&sim, 5000);
+    assert(lw_ioctl_read(&bus, 0x50, at_0100, 2, out, sizeof(out), 0) == 4);
+    assert(out[0] == 32 && out[3] == 35);
+
+    /* The EEPROM layer splits at pages and ACK-polls the write cycles */
+    lw_sim_set_realtime(&sim, 1);
+    lw_eeprom dev;
+    assert(lw_eeprom_init(&dev, 0x50, 2, 32, sizeof(mem)) == 0);
+    uint8_t block[100];
+    for (size_t i = 0; i < sizeof(block); ++i)
+    {
+        block[i] = (uint8_t)(0xA0 + i);
+    }
+    assert(lw_eeprom_write(&bus, &dev, 0x10, block, sizeof(block)) == (ssize_t)sizeof(block));
+    assert(rom.writes == 5);
+    uint8_t back[100];
+    assert(lw_eeprom_read(&bus, &dev, 0x10, back, sizeof(back)) == (ssize_t)sizeof(back));
+    assert(memcmp(back, block, sizeof(block)) == 0);
+    assert(sim.nacks > 1); /* ACK polls while busy */
+
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+static void test_register_auto_increment(void)
+{
+    lw_sim_bus sim;
+    lw_i2c_bus bus;
+    uint8_t regs[64] = {0};
+    lw_sim_regs acc; /* LIS3DH-style: bit 7 of the sub-address enables increment */
+    regs[0x28] = 0x11;
+    regs[0x29] = 0x22;
+    assert(lw_sim_init(&sim, 400000) == 0);
+    assert(lw_sim_regs_init(&acc, 0x19, regs, sizeof(regs), 0x80) == 0);
+    assert(lw_sim_add(&sim, &acc.dev) == 0);
+    assert(lw_sim_open(&sim, &bus, NULL) == 0);
+
+    uint8_t out[2];
+    uint8_t reg = 0x28;
+    assert(lw_ioctl_read(&bus, 0x19, &reg, 1, out, 2, 0) == 2);
+    assert(out[0] == 0x11 && out[1] == 0x11);
+    reg = 0xA8;
+    assert(lw_ioctl_read(&bus, 0x19, &reg, 1, out, 2, 0) == 2);
+    assert(out[0] == 0x11 && out[1] == 0x22);
+
+    const uint8_t cfg[3] = {0xA0, 0x57, 0x08};
+    assert(lw_ioctl_write(&bus, 0x19, NULL, 0, cfg, sizeof(cfg), 0) == 3);
+    assert(regs[0x20] == 0x57 && regs[0x21] == 0x08);
+
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+static void test_imu_fifo_drain(void)
+{
+    lw_sim_bus sim;
+    lw_i2c_bus bus;
+    lw_sim_imu imu;
+    assert(lw_sim_init(&sim, 400000) == 0);
+    assert(lw_sim_imu_init(&imu, 0x68, 6, 1000, 1020) == 0);
+    assert(lw_sim_add(&sim, &imu.dev) == 0);
+    assert(lw_sim_open(&sim, &bus, NULL) == 0);
+
+    lw_fifo fifo;
+    assert(lw_fifo_init(&fifo, 0x68, 0x72, 0x74) == 0);
+    fifo.frame_size = 6;
+    uint8_t storage[1020];
+    lw_fifo_ring ring;
+    assert(lw_fifo_ring_init(&ring, storage, sizeof(storage)) == 0);
+
+    /* 10 ms at 1 kHz: ten frames, numbered in order */
+    lw_sim_advance(&sim, 10000);
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 60);
+    uint8_t out[60];
+    assert(lw_fifo_ring_pop(&ring, out, sizeof(out)) == 60);
+    for (size_t i = 0; i < sizeof(out); ++i)
+    {
+        assert(out[i] == (uint8_t)i);
+    }
+
+    /* Left alone for a second, the FIFO fills up and drops the rest */
+    lw_sim_advance(&sim, 1000000);
+    assert(lw_fifo_drain(&bus, &fifo, &ring) == 1020);
+    assert(imu.overflows > 800);
+    assert(imu.frames >= 1010);
+
+    /* A write burst across FIFO_R_W drops that byte and carries on */
+    const uint8_t burst[] = {0xAA, 0xBB, 0xCC};
+    const uint8_t at_73 = 0x73;
+    assert(lw_ioctl_write(&bus, 0x68, &at_73, 1, burst, sizeof(burst), 0) == 3);
+    assert(imu.regs[0x73] == 0xAA);
+    assert(imu.regs[0x74] == 0x00);
+    assert(imu.regs[0x75] == 0xCC);
+
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+static void test_mux_channels(void)
+{
+    lw_sim_bus sim;
+    lw_i2c_bus bus;
+    lw_sim_mux sw;
+    uint8_t regs_a[4] = {0xAA, 0, 0, 0};
+    uint8_t regs_b[4] = {0xBB, 0, 0, 0};
+    lw_sim_regs a, b, stray;
+    assert(lw_sim_init(&sim, 0) == 0);
+    assert(lw_sim_mux_init(&sw, 0x70) == 0);
+    assert(lw_sim_regs_init(&a, 0x48, regs_a, sizeof(regs_a), 0) == 0);
+    assert(lw_sim_regs_init(&b, 0x48, regs_b, sizeof(regs_b), 0) == 0);
+    assert(lw_sim_regs_init(&stray, 0x49, regs_b, sizeof(regs_b), 0) == 0);
+    EXPECT_ERR(lw_sim_attach(&sim, &a.dev, &sw.dev, 0), EINVAL); /* switch not on the bus */
+    EXPECT_ERR(lw_sim_attach(&sim, &a.dev, &b.dev, 0), EINVAL);  /* not a switch */
+    assert(lw_sim_add(&sim, &sw.dev) == 0);
+    assert(lw_sim_attach(&sim, &a.dev, &sw.dev, 0) == 0);
+    assert(lw_sim_attach(&sim, &b.dev, &sw.dev, 3) == 0);
+    EXPECT_ERR(lw_sim_attach(&sim, &stray.dev, &sw.dev, 8), EINVAL);
+    assert(lw_sim_open(&sim, &bus, NULL) == 0);
+
+    uint8_t out = 0;
+    const uint8_t reg = 0x00;
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x48, &reg, 1, &out, 1, 0), ENXIO);
+
+    lw_mux mux;
+    assert(lw_mux_init(&mux, &bus, 0x70, 8) == 0);
+    assert(lw_mux_read_reg(&mux, 3, 0x48, 0x00, 1, &out, 1) == 1);
+    assert(out == 0xBB && sw.control == 0x08);
+    assert(lw_mux_read_reg(&mux, 0, 0x48, 0x00, 1, &out, 1) == 1);
+    assert(out == 0xAA && sw.control == 0x01);
+    assert(lw_mux_read_reg(&mux, 0, 0x48, 0x00, 1, &out, 1) == 1);
+    assert(sw.selects == 2); /* cached selection: no switch traffic */
+
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+static void test_clock_stretching(void)
+{
+    lw_sim_bus sim;
+    lw_i2c_bus bus;
+    lw_sim_stretch htu; /* HTU21D hold-master temperature: 50 ms conversion */
+    const uint8_t result[3] = {0x66, 0x5C, 0x7D};
+    assert(lw_sim_init(&sim, 400000) == 0);
+    assert(lw_sim_stretch_init(&htu, 0x40, 50000, result, sizeof(result)) == 0);
+    assert(lw_sim_add(&sim, &htu.dev) == 0);
+    assert(lw_sim_open(&sim, &bus, NULL) == 0);
+
+    const uint8_t cmd = 0xE3;
+    uint8_t out[3];
+    assert(lw_ioctl_read(&bus, 0x40, &cmd, 1, out, sizeof(out), 0) == 3);
+    assert(memcmp(out, result, sizeof(out)) == 0);
+    assert(sim.busy_ns >= 50000000ULL && sim.busy_ns < 51000000ULL);
+
+    /* The adapter gives up on a stretch longer than its timeout */
+    sim.timeout_us = 10000;
+    EXPECT_ERR(lw_ioctl_read(&bus, 0x40, &cmd, 1, out, sizeof(out), 0), ETIMEDOUT);
+    assert(sim.timeouts == 1);
+    assert(htu.conversions == 2);
+
+    lw_close_bus(&bus);
+    lw_sim_destroy(&sim);
+}
+
+int main(void)
+{
+    lw_sim_bus sim;
+    lw_sim_eeprom rom;
+    uint8_t mem[64];
+    EXPECT_ERR(lw_sim_init(NULL, 0), EINVAL);
+    EXPECT_ERR(lw_sim_eeprom_init(&rom, 0x50, mem, sizeof(mem), 48, 1, 0), EINVAL);
+    EXPECT_ERR(lw_sim_eeprom_init(&rom, 0x50, mem, sizeof(mem), 8, 3, 0), EINVAL);
+    assert(lw_sim_init(&sim, 0) == 0);
+    EXPECT_ERR(lw_sim_add(&sim, NULL), EINVAL);
+    lw_sim_destroy(&sim);
+
+    test_wire_timing();
+    test_eeprom_pages_and_write_cycle();
+    test_register_auto_increment();
+    test_imu_fifo_drain();
+    test_mux_channels();
+    test_clock_stretching();
+
+    puts("linux_wire sim tests passed");
+    return 0;
+}
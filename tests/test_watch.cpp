@@ -0,0 +1,155 @@
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "linux_wire_watch.h"
+#include "mock_linux_wire.h"
+
+struct ChangeLog
+{
+    std::vector<size_t> indices;
+    std::vector<std::vector<uint8_t>> values;
+};
+
+static void recordChange(lw_watcher * /*watcher*/, size_t index, const uint8_t *value, size_t len, void *arg)
+{
+    auto *log = static_cast<ChangeLog *>(arg);
+    log->indices.push_back(index);
+    log->values.emplace_back(value, value + len);
+}
+
+static lw_i2c_bus openMockBus()
+{
+    lw_i2c_bus bus;
+    assert(lw_open_bus(&bus, "/dev/i2c-mock") == 0);
+    return bus;
+}
+
+static void testCallbacksOnlyOnChange()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_watcher w;
+    ChangeLog log;
+    assert(lw_watch_init(&w, &bus, 0x19) == 0);
+    assert(lw_watch_add(&w, 0x00, 1, 1, recordChange, &log) == 0);
+    assert(lw_watch_add(&w, 0x28, 1, 2, recordChange, &log) == 1);
+
+    mockLinuxWireQueueTransferReadData({0x01, 0x10, 0x20});
+    assert(lw_watch_sample(&w) == 2); // first read reports initial values
+    const auto &state = mockLinuxWireState();
+    assert(state.gatherReadCalls == 1);
+    assert(state.lastGatherAddr == 0x19);
+    assert(state.lastGatherRegs == std::vector<uint32_t>({0x00, 0x28}));
+
+    mockLinuxWireQueueTransferReadData({0x01, 0x10, 0x20});
+    assert(lw_watch_sample(&w) == 0);
+
+    mockLinuxWireQueueTransferReadData({0x01, 0x10, 0x21});
+    assert(lw_watch_sample(&w) == 1);
+    assert(log.indices == std::vector<size_t>({0, 1, 1}));
+    assert(log.values.back() == std::vector<uint8_t>({0x10, 0x21}));
+    assert(w.reads == 3 && w.changes == 3);
+}
+
+static void testFdTriggerReadsOnlyOnEvent()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+
+    lw_watcher w;
+    ChangeLog log;
+    assert(lw_watch_init(&w, &bus, 0x19) == 0);
+    assert(lw_watch_add(&w, 0x41, 1, 1, recordChange, &log) == 0);
+    assert(lw_watch_use_fd(&w, pipefd[0]) == 0);
+
+    // Idle line: no bus traffic at all
+    assert(lw_watch_run_once(&w, 10) == 0);
+    assert(mockLinuxWireState().gatherReadCalls == 0);
+
+    // Interrupt edge (stand-in: bytes on the pipe), possibly several queued
+    const uint8_t edges[3] = {1, 1, 1};
+    assert(write(pipefd[1], edges, sizeof(edges)) == 3);
+    mockLinuxWireQueueTransferReadData({0x7F});
+    assert(lw_watch_run_once(&w, 1000) == 1);
+    assert(mockLinuxWireState().gatherReadCalls == 1);
+    assert(w.triggers == 1);
+
+    // All pending events were drained by that one wake-up
+    assert(lw_watch_run_once(&w, 0) == 0);
+    assert(mockLinuxWireState().gatherReadCalls == 1);
+
+    lw_watch_close(&w);
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+static void testPeriodicPolling()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_watcher w;
+    ChangeLog log;
+    assert(lw_watch_init(&w, &bus, 0x48) == 0);
+    assert(lw_watch_add(&w, 0x00, 1, 2, recordChange, &log) == 0);
+    assert(lw_watch_set_period(&w, 2000) == 0);
+
+    mockLinuxWireSetIoctlReadData({0x12, 0x34});
+    assert(lw_watch_run_once(&w, -1) == 1); // first poll is due immediately
+    assert(lw_watch_run_once(&w, 0) == 0);  // period not yet elapsed
+    assert(mockLinuxWireState().gatherReadCalls == 1);
+
+    assert(lw_watch_run_once(&w, -1) == 0); // waits one period, value unchanged
+    assert(mockLinuxWireState().gatherReadCalls == 2);
+    assert(w.triggers == 2 && w.changes == 1);
+}
+
+static void testInvalidConfiguration()
+{
+    mockLinuxWireReset();
+    lw_i2c_bus bus = openMockBus();
+
+    lw_watcher w;
+    ChangeLog log;
+    assert(lw_watch_init(&w, &bus, 0x19) == 0);
+
+    errno = 0;
+    assert(lw_watch_run_once(&w, 0) == -1);
+    assert(errno == EINVAL);
+
+    assert(lw_watch_add(&w, 0x00, 0, 1, recordChange, &log) == -1);
+    assert(lw_watch_add(&w, 0x00, 1, LINUX_WIRE_WATCH_VALUE_MAX + 1, recordChange, &log) == -1);
+    assert(lw_watch_add(&w, 0x00, 1, 1, nullptr, &log) == -1);
+    for (int i = 0; i < LINUX_WIRE_WATCH_MAX_REGS; ++i)
+    {
+        assert(lw_watch_add(&w, static_cast<uint32_t>(i), 1, 1, recordChange, &log) == i);
+    }
+    errno = 0;
+    assert(lw_watch_add(&w, 0x50, 1, 1, recordChange, &log) == -1);
+    assert(errno == ENOSPC);
+
+    // Registers but no trigger source
+    assert(lw_watch_run_once(&w, 0) == -1);
+    assert(lw_watch_use_gpio(&w, "/tmp/gpiochip0", 3, LW_WATCH_EDGE_FALLING) == -1);
+    assert(lw_watch_use_gpio(&w, "/dev/gpiochip0", 3, 0) == -1);
+}
+
+int main()
+{
+    testCallbacksOnlyOnChange();
+    testFdTriggerReadsOnlyOnEvent();
+    testPeriodicPolling();
+    testInvalidConfiguration();
+
+    std::puts("linux_wire watch tests passed");
+    return 0;
+}
@@ -2,6 +2,12 @@
 #include <cerrno>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "Wire.h"
@@ -109,7 +115,7 @@ static void testTimeoutFlagOnReadFailure()
     tw.end();
 }
 
-static void testDeferredWriteFlushes()
+static void testDeferredSegmentsChainIntoNextWrite()
 {
     mockLinuxWireReset();
 
@@ -120,20 +126,34 @@ static void testDeferredWriteFlushes()
     tw.write(static_cast<uint8_t>(0x55));
     assert(tw.endTransmission(false) == 0);
 
-    // No requestFrom; starting a new transmission should flush pending data.
+    // A new transmission is the next link of the same transaction.
     tw.beginTransmission(static_cast<uint8_t>(0x33));
-
     const auto &state = mockLinuxWireState();
-    assert(state.writeCalls == 1);
-    assert(state.lastSetSlaveAddr == 0x22);
-    assert(state.lastWriteBuffer.size() == 1);
-    assert(state.lastWriteBuffer[0] == 0x55);
+    assert(state.writeCalls == 0);
+    assert(state.transferCalls == 0);
 
-    tw.endTransmission();
+    assert(tw.write(static_cast<uint8_t>(0x66)) == 1);
+    assert(tw.endTransmission() == 0);
+    assert(state.writeCalls == 0);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].addr == 0x22);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0x55}));
+    assert(state.lastTransfer[1].addr == 0x33 && state.lastTransfer[1].flags == 0);
+    assert(state.lastTransfer[1].data == std::vector<uint8_t>({0x66}));
+
+    // A lone segment left at end() is sent as a plain write.
+    tw.beginTransmission(static_cast<uint8_t>(0x22));
+    tw.write(static_cast<uint8_t>(0x77));
+    assert(tw.endTransmission(false) == 0);
     tw.end();
+    assert(state.writeCalls == 1);
+    assert(state.lastSetSlaveAddr == 0x22);
+    assert(state.lastWriteBuffer == std::vector<uint8_t>({0x77}));
+    assert(state.transferCalls == 1);
 }
 
-static void testInternalAddressRequestFlushesPendingWrite()
+static void testInternalAddressRequestChainsPendingWrite()
 {
     mockLinuxWireReset();
     mockLinuxWireSetIoctlReadData({0x77});
@@ -154,18 +174,20 @@ static void testInternalAddressRequestFlushesPendingWrite()
     assert(tw.read() == 0x77);
 
     const auto &state = mockLinuxWireState();
-    assert(state.writeCalls == 1);
-    assert(!state.lastWriteWasIoctl);
-    assert(state.lastWriteSlaveAddr == 0x10);
-    assert(state.ioctlReadCalls == 1);
-    assert(state.lastIoctlAddr == 0x20);
-    assert(state.lastIoctlInternal.size() == 1);
-    assert(state.lastIoctlInternal[0] == 0x05);
+    assert(state.writeCalls == 0);
+    assert(state.ioctlReadCalls == 0);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 3);
+    assert(state.lastTransfer[0].addr == 0x10);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0xAA}));
+    assert(state.lastTransfer[1].addr == 0x20 && state.lastTransfer[1].flags == 0);
+    assert(state.lastTransfer[1].data == std::vector<uint8_t>({0x05}));
+    assert(state.lastTransfer[2].addr == 0x20 && state.lastTransfer[2].flags == LW_MSG_RD);
 
     tw.end();
 }
 
-static void testDeferredWriteFlushFailureBlocksRequestFrom()
+static void testChainedReadFailureDiscardsSegments()
 {
     mockLinuxWireReset();
 
@@ -176,25 +198,28 @@ static void testDeferredWriteFlushFailureBlocksRequestFrom()
     tw.write(static_cast<uint8_t>(0xAA));
     assert(tw.endTransmission(false) == 0);
 
-    mockLinuxWireForceSetSlaveError(ENXIO);
+    mockLinuxWireForceTransferError(ENXIO);
     uint8_t count = tw.requestFrom(static_cast<uint8_t>(0x20), static_cast<uint8_t>(1));
     assert(count == 0);
     assert(tw.available() == 0);
 
     const auto &state = mockLinuxWireState();
-    assert(state.setSlaveCalls == 1);
+    assert(state.transferCalls == 1);
     assert(state.readCalls == 0);
     assert(state.writeCalls == 0);
 
-    mockLinuxWireClearSetSlaveError();
+    // The failed chain is gone; the next write goes out on its own.
+    mockLinuxWireClearTransferError();
     tw.beginTransmission(static_cast<uint8_t>(0x20));
     assert(tw.write(static_cast<uint8_t>(0x01)) == 1);
     assert(tw.endTransmission() == 0);
+    assert(state.writeCalls == 1);
+    assert(state.transferCalls == 1);
 
     tw.end();
 }
 
-static void testDeferredWriteFlushFailureBlocksNewTransmission()
+static void testChainedWriteFailureReturnsError()
 {
     mockLinuxWireReset();
 
@@ -205,19 +230,21 @@ static void testDeferredWriteFlushFailureBlocksNewTransmission()
     tw.write(static_cast<uint8_t>(0x55));
     assert(tw.endTransmission(false) == 0);
 
-    mockLinuxWireForceWriteError(EIO);
+    mockLinuxWireForceTransferError(EIO);
     tw.beginTransmission(static_cast<uint8_t>(0x33));
-    assert(tw.write(static_cast<uint8_t>(0x66)) == 0);
+    assert(tw.write(static_cast<uint8_t>(0x66)) == 1);
     assert(tw.endTransmission() == 4);
 
     const auto &state = mockLinuxWireState();
-    assert(state.writeCalls == 1);
-    assert(state.lastWriteSlaveAddr == 0x22);
+    assert(state.transferCalls == 1);
+    assert(state.writeCalls == 0);
 
-    mockLinuxWireClearWriteError();
+    mockLinuxWireClearTransferError();
     tw.beginTransmission(static_cast<uint8_t>(0x33));
     assert(tw.write(static_cast<uint8_t>(0x66)) == 1);
     assert(tw.endTransmission() == 0);
+    assert(state.writeCalls == 1);
+    assert(state.lastWriteSlaveAddr == 0x33);
 
     tw.end();
 }
@@ -256,9 +283,10 @@ static void testTxBufferOverflow()
     tw.end();
 }
 
-static void testFlushOnDifferentAddress()
+static void testChainToDifferentAddress()
 {
     mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData({0x5A});
 
     TwoWire tw;
     tw.begin("/dev/i2c-mock");
@@ -267,15 +295,64 @@ static void testFlushOnDifferentAddress()
     tw.write(static_cast<uint8_t>(0xAA));
     assert(tw.endTransmission(false) == 0);
 
-    // Requesting from a different address should flush the pending write.
-    tw.requestFrom(static_cast<uint8_t>(0x20), static_cast<uint8_t>(1));
+    // Reading another device continues the same transaction.
+    assert(tw.requestFrom(static_cast<uint8_t>(0x20), static_cast<uint8_t>(1)) == 1);
+    assert(tw.read() == 0x5A);
 
     const auto &state = mockLinuxWireState();
-    assert(state.writeCalls == 1);
-    assert(!state.lastWriteWasIoctl);
-    assert(state.lastWriteSlaveAddr == 0x10);
-    assert(state.lastWriteBuffer.size() == 1);
-    assert(state.lastWriteBuffer[0] == 0xAA);
+    assert(state.writeCalls == 0);
+    assert(state.readCalls == 0);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].addr == 0x10);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0xAA}));
+    assert(state.lastTransfer[1].addr == 0x20 && state.lastTransfer[1].flags == LW_MSG_RD);
+
+    tw.end();
+}
+
+static void testChainedRestartsUpToQueueLimit()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData({0x12, 0x34});
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+
+    for (int i = 0; i < LINUX_WIRE_MAX_PENDING_SEGMENTS; ++i)
+    {
+        tw.beginTransmission(0x70 + (i % 2));
+        tw.write(static_cast<uint8_t>(i));
+        assert(tw.endTransmission(false) == 0);
+    }
+    // No room for another link; the queued ones are kept.
+    tw.beginTransmission(0x48);
+    tw.write(static_cast<uint8_t>(0xFF));
+    assert(tw.endTransmission(false) == 1);
+
+    assert(tw.requestFrom(0x48, 2) == 2);
+    assert(tw.read() == 0x12 && tw.read() == 0x34);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == LINUX_WIRE_MAX_PENDING_SEGMENTS + 1);
+    for (int i = 0; i < LINUX_WIRE_MAX_PENDING_SEGMENTS; ++i)
+    {
+        assert(state.lastTransfer[i].addr == 0x70 + (i % 2));
+        assert(state.lastTransfer[i].data == std::vector<uint8_t>({static_cast<uint8_t>(i)}));
+    }
+    assert(state.lastTransfer.back().addr == 0x48);
+
+    // A pointer longer than an internal address still forms one read.
+    const uint8_t pointer[6] = {1, 2, 3, 4, 5, 6};
+    tw.beginTransmission(0x50);
+    tw.write(pointer, sizeof(pointer));
+    assert(tw.endTransmission(false) == 0);
+    assert(tw.requestFrom(0x50, 1) == 1);
+    assert(state.transferCalls == 2);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].data.size() == sizeof(pointer));
+    assert(state.ioctlReadCalls == 0 && state.writeCalls == 0);
 
     tw.end();
 }
@@ -320,20 +397,452 @@ static void testErrorLoggingToggle()
     tw.end();
 }
 
+static_assert(std::is_nothrow_move_constructible<TwoWire>::value, "TwoWire must be nothrow-movable");
+static_assert(std::is_nothrow_move_assignable<TwoWire>::value, "TwoWire must be nothrow-movable");
+
+static void testMoveTransfersOpenBusAndPendingWrite()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData({0x42});
+
+    TwoWire source;
+    source.setErrorLogging(false);
+    source.begin("/dev/i2c-mock");
+    source.beginTransmission(static_cast<uint8_t>(0x50));
+    source.write(static_cast<uint8_t>(0x07));
+    assert(source.endTransmission(false) == 0);
+
+    TwoWire moved(std::move(source));
+    assert(moved.isOpen());
+    assert(!source.isOpen());
+    assert(source.requestFrom(static_cast<uint8_t>(0x50), static_cast<uint8_t>(1)) == 0);
+
+    // The deferred register write travelled with the object.
+    assert(moved.requestFrom(static_cast<uint8_t>(0x50), static_cast<uint8_t>(1)) == 1);
+    assert(moved.read() == 0x42);
+    const auto &state = mockLinuxWireState();
+    assert(state.ioctlReadCalls == 1);
+    assert(state.lastIoctlInternal.size() == 1 && state.lastIoctlInternal[0] == 0x07);
+
+    TwoWire assigned;
+    assigned.begin("/dev/i2c-other");
+    assigned = std::move(moved);
+    assert(state.closeCalls == 1); // previous bus of `assigned` closed
+    assert(assigned.isOpen());
+    assert(!moved.isOpen());
+
+    assigned.end();
+    source.end();
+    moved.end();
+    assert(state.closeCalls == 2);
+}
+
+static void testFactoryInstancesInContainer()
+{
+    mockLinuxWireReset();
+
+    std::vector<TwoWire> buses;
+    for (unsigned int adapter = 0; adapter < 4; ++adapter)
+    {
+        buses.push_back(TwoWire::forAdapter(adapter));
+        assert(buses.back().isOpen());
+    }
+
+    const auto &state = mockLinuxWireState();
+    assert(state.openCalls == 4);
+    assert(state.closeCalls == 0); // vector growth moved, never reopened
+    assert(state.lastDevicePath == "/dev/i2c-3");
+
+    TwoWire byPath = TwoWire::forDevice("/dev/i2c-7");
+    assert(byPath.isOpen());
+    assert(state.lastDevicePath == "/dev/i2c-7");
+
+    buses.clear();
+    assert(state.closeCalls == 4);
+}
+
+static void testReadBytesAndRxView()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetReadData({1, 2, 3, 4, 5});
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    assert(tw.requestFrom(static_cast<uint8_t>(0x20), static_cast<uint8_t>(5)) == 5);
+
+    assert(tw.read() == 1);
+    TwoWire::ConstByteSpan view = tw.rxView();
+    assert(view.size() == 4);
+    assert(view[0] == 2 && view[3] == 5);
+
+    uint8_t out[8] = {0};
+    assert(tw.readBytes(out, 2) == 2);
+    assert(out[0] == 2 && out[1] == 3);
+    assert(tw.available() == 2);
+
+    assert(tw.readBytes(nullptr, 1) == 1); // discard
+    assert(tw.readBytes(out, sizeof(out)) == 1);
+    assert(out[0] == 5);
+    assert(tw.readBytes(out, sizeof(out)) == 0);
+    assert(tw.rxView().empty());
+}
+
+static void testTransferFillsCallerBuffer()
+{
+    mockLinuxWireReset();
+    std::vector<uint8_t> payload(64);
+    for (std::size_t i = 0; i < payload.size(); ++i)
+    {
+        payload[i] = static_cast<uint8_t>(i + 1);
+    }
+    mockLinuxWireSetIoctlReadData(payload);
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+
+    const uint8_t reg = 0x3B;
+    std::vector<uint8_t> rx(64); // larger than LINUX_WIRE_BUFFER_LENGTH
+    assert(tw.transfer(0x68, {&reg, 1}, rx));
+    assert(rx == payload);
+
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].addr == 0x68);
+    assert(state.lastTransfer[0].flags == 0);
+    assert(state.lastTransfer[0].data == std::vector<uint8_t>({0x3B}));
+    assert(state.lastTransfer[1].flags == LW_MSG_RD);
+    assert(state.lastTransfer[1].data.size() == 64);
+    assert(state.readCalls == 0 && state.ioctlReadCalls == 0);
+    assert(tw.available() == 0); // RX buffer untouched
+
+    // Write-only and read-only forms issue a single message
+    uint8_t cmd[2] = {0x10, 0x20};
+    assert(tw.transfer(0x68, cmd, {}));
+    assert(state.lastTransfer.size() == 1);
+    assert(state.lastTransfer[0].data.size() == 2);
+
+    assert(!tw.transfer(0x68, {}, {}));
+    assert(state.transferCalls == 2);
+}
+
+static void testTransferFailureAndPendingWrite()
+{
+    mockLinuxWireReset();
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    tw.setWireTimeout(1000, false);
+
+    // A deferred write leads the combined transfer
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x01));
+    assert(tw.endTransmission(0) == 0);
+
+    uint8_t rx[2];
+    assert(tw.transfer(0x41, {}, rx));
+    const auto &state = mockLinuxWireState();
+    assert(state.writeCalls == 0);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 2);
+    assert(state.lastTransfer[0].addr == 0x40);
+    assert(state.lastTransfer[1].addr == 0x41 && state.lastTransfer[1].flags == LW_MSG_RD);
+
+    mockLinuxWireForceTransferError(ETIMEDOUT);
+    assert(!tw.transfer(0x41, {}, rx));
+    assert(tw.getWireTimeoutFlag());
+    mockLinuxWireClearTransferError();
+}
+
+static void testWriteCombinerMergesRegisterWrites()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData({0x5A});
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    tw.setWriteCombiner(&comb);
+
+    for (uint8_t reg = 0x06; reg < 0x46; ++reg)
+    {
+        tw.beginTransmission(0x40);
+        tw.write(reg);
+        tw.write(static_cast<uint8_t>(reg * 2));
+        assert(tw.endTransmission() == 0);
+    }
+    const auto &state = mockLinuxWireState();
+    assert(state.writeCalls == 0 && state.transferCalls == 0);
+
+    // A read sends the buffered writes first
+    assert(tw.requestFrom(0x40, 1, 0x00, 1, 1) == 1);
+    assert(tw.read() == 0x5A);
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 1);
+    assert(state.lastTransfer[0].data.size() == 65);
+    assert(state.lastTransfer[0].data[0] == 0x06);
+    assert(state.lastTransfer[0].data[64] == static_cast<uint8_t>(0x45 * 2));
+    assert(state.ioctlReadCalls == 1);
+
+    // A bare register pointer is buffered unmerged; commitWrites() sends it
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x00));
+    assert(tw.endTransmission() == 0);
+    assert(tw.commitWrites());
+    assert(state.transferCalls == 2);
+    assert(state.lastTransfer.size() == 1);
+
+    // Detaching sends writes directly again
+    tw.setWriteCombiner(nullptr);
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x00));
+    assert(tw.endTransmission() == 0);
+    assert(state.writeCalls == 1);
+}
+
+static void testWriteCombinerSendsUndeclaredWritesAlone()
+{
+    mockLinuxWireReset();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    tw.setWriteCombiner(&comb);
+
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x06));
+    tw.write(static_cast<uint8_t>(0x11));
+    assert(tw.endTransmission() == 0);
+
+    // A mux channel select needs its STOP: pending writes go first, then it alone
+    tw.beginTransmission(0x70);
+    tw.write(static_cast<uint8_t>(0x04));
+    assert(tw.endTransmission() == 0);
+    const auto &state = mockLinuxWireState();
+    assert(state.transferCalls == 1);
+    assert(state.lastTransfer.size() == 1 && state.lastTransfer[0].addr == 0x40);
+    assert(state.ioctlWriteCalls == 1);
+    assert(state.ioctlWrites[0] == std::vector<uint8_t>({0x04}));
+    assert(lw_combine_pending(&comb) == 0);
+
+    // An EEPROM page write: its own transaction, nothing else to flush
+    tw.beginTransmission(0x50);
+    tw.write(static_cast<uint8_t>(0x00));
+    tw.write(static_cast<uint8_t>(0x10));
+    tw.write(static_cast<uint8_t>(0xAB));
+    assert(tw.endTransmission() == 0);
+    assert(state.transferCalls == 1 && state.ioctlWriteCalls == 2);
+    assert(state.ioctlWrites[1] == std::vector<uint8_t>({0x00, 0x10, 0xAB}));
+}
+
+static void testWriteCombinerFlushFailureFailsNextOperation()
+{
+    mockLinuxWireReset();
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    tw.setWriteCombiner(&comb);
+
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x10));
+    assert(tw.endTransmission() == 0);
+
+    // A zero-length probe is not buffered: the batch goes out before it
+    mockLinuxWireForceTransferError(EIO);
+    tw.beginTransmission(0x41);
+    assert(tw.endTransmission() == 4);
+    assert(mockLinuxWireState().writeCalls == 0);
+    mockLinuxWireClearTransferError();
+
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x11));
+    assert(tw.endTransmission() == 0);
+    mockLinuxWireForceTransferError(EIO);
+    assert(tw.requestFrom(0x40, 1) == 0);
+    mockLinuxWireClearTransferError();
+    assert(lw_combine_pending(&comb) == 0);
+
+    // end() flushes what is left
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x12));
+    assert(tw.endTransmission() == 0);
+    tw.end();
+    assert(mockLinuxWireState().transferCalls == 3);
+    assert(mockLinuxWireState().lastTransfer[0].data == std::vector<uint8_t>({0x12}));
+}
+
+static void testReadAheadServesSequentialRegisterReads()
+{
+    mockLinuxWireReset();
+    mockLinuxWireSetIoctlReadData({0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17});
+
+    lw_readahead ra;
+    assert(lw_readahead_init(&ra) == 0);
+    assert(lw_readahead_add_device(&ra, 0x1E, 1, 0, 8, 0) == 0);
+
+    TwoWire tw;
+    tw.begin("/dev/i2c-mock");
+    tw.setReadAhead(&ra);
+
+    const auto &state = mockLinuxWireState();
+    assert(tw.requestFrom(0x1E, 1, 0x00, 1, 1) == 1);
+    assert(tw.requestFrom(0x1E, 1, 0x01, 1, 1) == 1);
+    assert(tw.read() == 0x10);
+    assert(state.ioctlReadCalls == 2);
+
+    // The repeated-start register read is served from the block too
+    tw.beginTransmission(0x1E);
+    tw.write(static_cast<uint8_t>(0x02));
+    assert(tw.endTransmission(false) == 0);
+    assert(tw.requestFrom(0x1E, 1) == 1);
+    assert(tw.read() == 0x11);
+    assert(state.ioctlReadCalls == 2);
+
+    // A write to the device drops its block
+    tw.beginTransmission(0x1E);
+    tw.write(static_cast<uint8_t>(0x20));
+    tw.write(static_cast<uint8_t>(0x01));
+    assert(tw.endTransmission() == 0);
+    assert(tw.requestFrom(0x1E, 1, 0x03, 1, 1) == 1);
+    assert(state.ioctlReadCalls == 3);
+    assert(ra.fetches == 1);
+
+    tw.setReadAhead(nullptr);
+    assert(tw.requestFrom(0x1E, 1, 0x04, 1, 1) == 1);
+    assert(state.ioctlReadCalls == 4);
+    assert(ra.reads == 4);
+}
+
+static void testHotplugReopensOnReturningAdapter()
+{
+    mockLinuxWireReset();
+
+    char dir[] = "/tmp/lw_wire_hotplug_XXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    const std::string root = dir;
+    std::filesystem::create_directories(root + "/dev");
+    auto plug = [&root](int n)
+    {
+        const std::string node = "i2c-" + std::to_string(n);
+        std::filesystem::create_directories(root + "/sys/" + node);
+        std::ofstream(root + "/sys/" + node + "/name") << "CP2112 SMBus Bridge\n";
+        std::ofstream(root + "/dev/" + node).put('\0');
+    };
+    auto unplug = [&root](int n)
+    {
+        const std::string node = "i2c-" + std::to_string(n);
+        std::filesystem::remove(root + "/dev/" + node);
+        std::filesystem::remove_all(root + "/sys/" + node);
+    };
+    plug(5);
+
+    lw_hotplug hp;
+    assert(lw_hotplug_init(&hp, (root + "/dev").c_str(), (root + "/sys").c_str(), 0) == 0);
+    const int slot = lw_hotplug_add(&hp, "CP2112", nullptr);
+
+    TwoWire tw;
+    tw.setErrorLogging(false);
+    tw.setHotplug(&hp, slot);
+    assert(tw.isOpen());
+    const auto &state = mockLinuxWireState();
+    assert(state.lastDevicePath == root + "/dev/i2c-5");
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x01));
+    assert(tw.endTransmission() == 0);
+
+    lw_combiner comb;
+    assert(lw_combine_init(&comb, 0) == 0);
+    assert(lw_combine_add_device(&comb, 0x40, 1, 0) == 0);
+    tw.setWriteCombiner(&comb);
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x02));
+    tw.write(static_cast<uint8_t>(0x20));
+    assert(tw.endTransmission() == 0);
+
+    // Unplugged: operations fail as on a closed bus, buffered writes wait
+    unplug(5);
+    assert(lw_hotplug_run_once(&hp, 1000) == 1);
+    assert(!tw.commitWrites());
+    assert(lw_combine_pending(&comb) == 1 && state.transferCalls == 0);
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x01));
+    assert(tw.endTransmission() == 4);
+    assert(!tw.isOpen());
+
+    // Back as i2c-8: the next operation reopens it with the same settings
+    plug(8);
+    while (lw_hotplug_generation(&hp, static_cast<std::size_t>(slot)) == 2)
+    {
+        assert(lw_hotplug_run_once(&hp, 1000) >= 0);
+    }
+    tw.beginTransmission(0x40);
+    tw.write(static_cast<uint8_t>(0x01));
+    assert(tw.endTransmission() == 0);
+    assert(state.lastDevicePath == root + "/dev/i2c-8");
+    assert(state.openCalls == 2);
+    assert(state.logErrors == 0);
+    assert(tw.commitWrites());
+    assert(state.transferCalls == 1 && state.lastTransfer.size() == 2);
+    tw.setWriteCombiner(nullptr);
+
+    // end() stops following the adapter
+    tw.end();
+    unplug(8);
+    plug(9);
+    while (lw_hotplug_run_once(&hp, 100) > 0)
+    {
+    }
+    assert(tw.requestFrom(0x40, 1) == 0);
+    assert(state.openCalls == 2);
+
+    // An unknown slot closes an open bus rather than leaking its fd
+    tw.begin("/dev/i2c-mock");
+    const int closes = state.closeCalls;
+    tw.setHotplug(&hp, LINUX_WIRE_HOTPLUG_MAX_SLOTS - 1);
+    assert(!tw.isOpen());
+    assert(state.closeCalls == closes + 1);
+    tw.end();
+    assert(state.closeCalls == closes + 1);
+
+    lw_hotplug_close(&hp);
+    std::filesystem::remove_all(root);
+}
+
 int main()
 {
     testPlainReadUsesRead();
     testRepeatedStartUsesIoctl();
     testInternalAddressClamp();
-    testInternalAddressRequestFlushesPendingWrite();
+    testInternalAddressRequestChainsPendingWrite();
     testTimeoutFlagOnReadFailure();
-    testDeferredWriteFlushes();
-    testDeferredWriteFlushFailureBlocksRequestFrom();
-    testDeferredWriteFlushFailureBlocksNewTransmission();
+    testDeferredSegmentsChainIntoNextWrite();
+    testChainedReadFailureDiscardsSegments();
+    testChainedWriteFailureReturnsError();
     testTxBufferOverflow();
-    testFlushOnDifferentAddress();
+    testChainToDifferentAddress();
+    testChainedRestartsUpToQueueLimit();
     testZeroInternalAddressFallback();
     testErrorLoggingToggle();
+    testMoveTransfersOpenBusAndPendingWrite();
+    testFactoryInstancesInContainer();
+    testReadBytesAndRxView();
+    testTransferFillsCallerBuffer();
+    testTransferFailureAndPendingWrite();
+    testWriteCombinerMergesRegisterWrites();
+    testWriteCombinerSendsUndeclaredWritesAlone();
+    testWriteCombinerFlushFailureFailsNextOperation();
+    testReadAheadServesSequentialRegisterReads();
+    testHotplugReopensOnReturningAdapter();
 
     std::puts("linux_wire tests passed");
     return 0;
@@ -0,0 +1,170 @@
+/*
+ * linux-wire-brokerd: owns one or more /dev/i2c-N adapters and serves
+ * their transactions to local clients (see linux_wire_broker.h).
+ *
+ *   linux-wire-brokerd [-d socket_dir] /dev/i2c-1 [/dev/i2c-2 ...]
+ *
+ * Each adapter is served by its own thread on <socket_dir>/i2c-N.sock
+ * (default directory /run/linux-wire).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "linux_wire_broker.h"
+
+#define BROKERD_MAX_BUSES 16
+
+typedef struct
+{
+    lw_i2c_bus bus;
+    lw_broker broker;
+    pthread_t thread;
+    int running;
+} brokerd_bus;
+
+static brokerd_bus g_buses[BROKERD_MAX_BUSES];
+static int g_count;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    for (int i = 0; i < g_count; ++i)
+    {
+        lw_broker_stop(&g_buses[i].broker);
+    }
+}
+
+/* Adapter number of a "/dev/i2c-N" argument, or -1 for anything else */
+static long adapter_number(const char *device)
+{
+    static const char prefix[] = "/dev/i2c-";
+    if (strncmp(device, prefix, sizeof(prefix) - 1) != 0)
+    {
+        return -1;
+    }
+
+    const char *digits = device + sizeof(prefix) - 1;
+    char *end = NULL;
+    errno = 0;
+    const unsigned long n = strtoul(digits, &end, 10);
+    if (digits[0] < '0' || digits[0] > '9' || *end != '\0' || errno != 0 || n > 0xFFFFu)
+    {
+        return -1;
+    }
+    return (long)n;
+}
+
+static void *serve(void *arg)
+{
+    brokerd_bus *b = (brokerd_bus *)arg;
+    if (lw_broker_run(&b->broker) != 0)
+    {
+        fprintf(stderr, "linux-wire-brokerd: %s: %s\n", b->bus.device_path, strerror(errno));
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = "/run/linux-wire";
+    int opt;
+    while ((opt = getopt(argc, argv, "d:")) != -1)
+    {
+        if (opt != 'd')
+        {
+            fprintf(stderr, "usage: %s [-d socket_dir] /dev/i2c-N ...\n", argv[0]);
+            return 2;
+        }
+        dir = optarg;
+    }
+    if (optind >= argc || argc - optind > BROKERD_MAX_BUSES)
+    {
+        fprintf(stderr, "usage: %s [-d socket_dir] /dev/i2c-N ... (at most %d)\n",
+                argv[0], BROKERD_MAX_BUSES);
+        return 2;
+    }
+    for (int i = optind; i < argc; ++i)
+    {
+        if (adapter_number(argv[i]) < 0)
+        {
+            fprintf(stderr, "linux-wire-brokerd: %s: not a /dev/i2c-N device\n", argv[i]);
+            fprintf(stderr, "usage: %s [-d socket_dir] /dev/i2c-N ...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* Block the signals until every broker exists; threads inherit this */
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+
+    int status = 0;
+    for (int i = optind; i < argc; ++i)
+    {
+        brokerd_bus *b = &g_buses[g_count];
+        const char *device = argv[i];
+        if (lw_open_bus(&b->bus, device) != 0)
+        {
+            fprintf(stderr, "linux-wire-brokerd: %s: %s\n", device, strerror(errno));
+            status = 1;
+            break;
+        }
+        lw_set_error_logging(&b->bus, 0); /* client NACKs are not broker errors */
+
+        char path[LINUX_WIRE_BROKER_PATH_MAX];
+        const int len = snprintf(path, sizeof(path), "%s/i2c-%ld.sock", dir, adapter_number(device));
+        if (len < 0 || (size_t)len >= sizeof(path) || lw_broker_init(&b->broker, &b->bus, path) != 0)
+        {
+            fprintf(stderr, "linux-wire-brokerd: %s: %s\n", path,
+                    len < 0 || (size_t)len >= sizeof(path) ? strerror(ENAMETOOLONG) : strerror(errno));
+            lw_close_bus(&b->bus);
+            status = 1;
+            break;
+        }
+        ++g_count;
+        printf("linux-wire-brokerd: serving %s on %s\n", device, path);
+    }
+
+    if (status == 0)
+    {
+        for (int i = 0; i < g_count; ++i)
+        {
+            g_buses[i].running = pthread_create(&g_buses[i].thread, NULL, serve, &g_buses[i]) == 0;
+        }
+
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        pthread_sigmask(SIG_UNBLOCK, &stop_signals, NULL);
+    }
+
+    for (int i = 0; i < g_count; ++i)
+    {
+        brokerd_bus *b = &g_buses[i];
+        if (b->running)
+        {
+            pthread_join(b->thread, NULL);
+        }
+        printf("linux-wire-brokerd: %s: %llu requests, %llu failed, %llu wake-ups, %llu hold timeouts\n",
+               b->bus.device_path,
+               (unsigned long long)b->broker.requests,
+               (unsigned long long)b->broker.failures,
+               (unsigned long long)b->broker.wakeups,
+               (unsigned long long)b->broker.hold_timeouts);
+        lw_broker_destroy(&b->broker);
+        lw_close_bus(&b->bus);
+    }
+    return status;
+}